@@ -0,0 +1,247 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+// autoregressive decoding throughput of a stack of SDPA layers with kv cache
+// one token per step, past key and value are either concatenated into fresh blobs
+// or appended in place into a KVCache with reserved capacity
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "datareader.h"
+#include "kvcache.h"
+#include "net.h"
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const
+    {
+        return 0;
+    }
+    virtual size_t read(void* buf, size_t size) const
+    {
+        memset(buf, 0, size);
+        return size;
+    }
+};
+
+static ncnn::Mat make_random(int w, int h, int c, int seed)
+{
+    ncnn::Mat m(w, h, c);
+    for (int q = 0; q < c; q++)
+    {
+        float* ptr = m.channel(q);
+        for (int i = 0; i < w * h; i++)
+        {
+            ptr[i] = ((seed * 31 + q * 17 + i * 7) % 113) / 113.f - 0.5f;
+        }
+    }
+    return m;
+}
+
+static std::string make_param(int num_layers)
+{
+    // q -> sdpa0 -> sdpa1 -> ... with per layer k v past_key past_value inputs
+    std::string param = "7767517\n";
+
+    char line[256];
+    sprintf(line, "%d %d\n", 1 + num_layers * 5, 1 + num_layers * 7);
+    param += line;
+    param += "Input q 0 1 q\n";
+
+    for (int i = 0; i < num_layers; i++)
+    {
+        sprintf(line, "Input k_%d 0 1 k_%d\n", i, i);
+        param += line;
+        sprintf(line, "Input v_%d 0 1 v_%d\n", i, i);
+        param += line;
+        sprintf(line, "Input past_key_%d 0 1 past_key_%d\n", i, i);
+        param += line;
+        sprintf(line, "Input past_value_%d 0 1 past_value_%d\n", i, i);
+        param += line;
+        char query[32];
+        if (i == 0)
+            sprintf(query, "q");
+        else
+            sprintf(query, "out_%d", i - 1);
+        sprintf(line, "SDPA sdpa_%d 5 3 %s k_%d v_%d past_key_%d past_value_%d out_%d key_%d value_%d 7=1\n", i, query, i, i, i, i, i, i, i);
+        param += line;
+    }
+
+    return param;
+}
+
+struct DecodeState
+{
+    std::vector<ncnn::Mat> past_keys;
+    std::vector<ncnn::Mat> past_values;
+    std::vector<ncnn::KVCache> caches;
+};
+
+// one decode step over all layers, the new key and value blobs become the next past
+static int decode_step(const ncnn::Net& net, int num_layers, int num_heads, int head_dim, bool use_kvcache, DecodeState& state, int step)
+{
+    ncnn::Extractor ex = net.create_extractor();
+
+    ex.input("q", make_random(head_dim, 1, num_heads, step));
+
+    char name[32];
+    for (int i = 0; i < num_layers; i++)
+    {
+        sprintf(name, "k_%d", i);
+        ex.input(name, make_random(head_dim, 1, num_heads, step + i));
+        sprintf(name, "v_%d", i);
+        ex.input(name, make_random(head_dim, 1, num_heads, step - i));
+        sprintf(name, "past_key_%d", i);
+        ex.input(name, use_kvcache ? state.caches[i].key() : state.past_keys[i]);
+        sprintf(name, "past_value_%d", i);
+        ex.input(name, use_kvcache ? state.caches[i].value() : state.past_values[i]);
+    }
+
+    ncnn::Mat out;
+    sprintf(name, "out_%d", num_layers - 1);
+    int ret = ex.extract(name, out);
+    if (ret != 0)
+        return ret;
+
+    for (int i = 0; i < num_layers; i++)
+    {
+        ncnn::Mat key;
+        ncnn::Mat value;
+        sprintf(name, "key_%d", i);
+        ex.extract(name, key);
+        sprintf(name, "value_%d", i);
+        ex.extract(name, value);
+
+        if (use_kvcache)
+        {
+            ret = state.caches[i].update(key, value);
+            if (ret != 0)
+                return ret;
+        }
+        else
+        {
+            state.past_keys[i] = key;
+            state.past_values[i] = value;
+        }
+    }
+
+    return 0;
+}
+
+static double benchmark_decode(const ncnn::Net& net, int num_layers, int num_heads, int head_dim, int context, int loop_count, bool use_kvcache)
+{
+    DecodeState state;
+    state.past_keys.resize(num_layers);
+    state.past_values.resize(num_layers);
+    state.caches.resize(num_layers);
+
+    for (int i = 0; i < num_layers; i++)
+    {
+        ncnn::Mat key = make_random(head_dim, context, num_heads, i);
+        ncnn::Mat value = make_random(head_dim, context, num_heads, -i);
+
+        if (use_kvcache)
+        {
+            // reserve room for the whole run up front
+            state.caches[i].reserve(head_dim, head_dim, num_heads, context + loop_count + 1);
+            state.caches[i].update(key, value);
+        }
+        else
+        {
+            state.past_keys[i] = key;
+            state.past_values[i] = value;
+        }
+    }
+
+    // warm up
+    if (decode_step(net, num_layers, num_heads, head_dim, use_kvcache, state, 0) != 0)
+        return 0;
+
+    double start = ncnn::get_current_time();
+
+    for (int step = 1; step <= loop_count; step++)
+    {
+        if (decode_step(net, num_layers, num_heads, head_dim, use_kvcache, state, step) != 0)
+            return 0;
+    }
+
+    double end = ncnn::get_current_time();
+
+    return loop_count * 1000.0 / (end - start);
+}
+
+static void show_usage()
+{
+    fprintf(stderr, "Usage: benchdecode [loop count] [num threads] [num layers] [num heads] [head dim] [max context]\n");
+}
+
+int main(int argc, char** argv)
+{
+    int loop_count = 32;
+    int num_threads = ncnn::get_physical_big_cpu_count();
+    int num_layers = 8;
+    int num_heads = 8;
+    int head_dim = 64;
+    int max_context = 4096;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && argv[i][1] == 'h')
+        {
+            show_usage();
+            return -1;
+        }
+    }
+
+    if (argc >= 2)
+        loop_count = atoi(argv[1]);
+    if (argc >= 3)
+        num_threads = atoi(argv[2]);
+    if (argc >= 4)
+        num_layers = atoi(argv[3]);
+    if (argc >= 5)
+        num_heads = atoi(argv[4]);
+    if (argc >= 6)
+        head_dim = atoi(argv[5]);
+    if (argc >= 7)
+        max_context = atoi(argv[6]);
+
+    ncnn::UnlockedPoolAllocator blob_pool_allocator;
+    ncnn::PoolAllocator workspace_pool_allocator;
+
+    ncnn::Net net;
+    net.opt.num_threads = num_threads;
+    net.opt.blob_allocator = &blob_pool_allocator;
+    net.opt.workspace_allocator = &workspace_pool_allocator;
+
+    net.load_param_mem(make_param(num_layers).c_str());
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+
+    fprintf(stderr, "loop_count = %d\n", loop_count);
+    fprintf(stderr, "num_threads = %d\n", num_threads);
+    fprintf(stderr, "num_layers = %d\n", num_layers);
+    fprintf(stderr, "num_heads = %d\n", num_heads);
+    fprintf(stderr, "head_dim = %d\n", head_dim);
+
+    fprintf(stderr, "%10s  %14s  %14s\n", "context", "concat tok/s", "kvcache tok/s");
+
+    for (int context = 128; context <= max_context; context *= 2)
+    {
+        double concat_tps = benchmark_decode(net, num_layers, num_heads, head_dim, context, loop_count, false);
+        double kvcache_tps = benchmark_decode(net, num_layers, num_heads, head_dim, context, loop_count, true);
+
+        fprintf(stderr, "%10d  %14.2f  %14.2f\n", context, concat_tps, kvcache_tps);
+    }
+
+    return 0;
+}
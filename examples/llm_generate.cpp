@@ -0,0 +1,101 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+// token generation with a decoder-only model, optionally sped up by a small draft model
+//
+// the model takes token ids at in0, positions at in1 and the causal mask at in2,
+// outputs logits at out0, and every SDPA layer carries kv_cache=1 as described
+// in docs/developer-guide/kvcache.md
+// tokenization is up to the model, this example reads and prints token ids
+
+#include "benchmark.h"
+#include "cpu.h"
+#include "generator.h"
+#include "net.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int load_net(ncnn::Net& net, const char* parampath, const char* modelpath)
+{
+    net.opt.num_threads = ncnn::get_big_cpu_count();
+
+    if (net.load_param(parampath))
+        return -1;
+    if (net.load_model(modelpath))
+        return -1;
+
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 4 && argc != 6)
+    {
+        fprintf(stderr, "Usage: %s [param] [bin] [token ids, like 1,2,3] [draft param] [draft bin]\n", argv[0]);
+        return -1;
+    }
+
+    std::vector<int> prompt;
+    for (const char* p = argv[3]; *p;)
+    {
+        prompt.push_back(atoi(p));
+
+        p = strchr(p, ',');
+        if (!p)
+            break;
+        p++;
+    }
+
+    ncnn::Net model;
+    if (load_net(model, argv[1], argv[2]) != 0)
+        return -1;
+
+    ncnn::Generator generator;
+    if (generator.load(&model, "in0", "out0", "in1", "in2") != 0)
+        return -1;
+
+    ncnn::Net draft;
+    if (argc == 6)
+    {
+        if (load_net(draft, argv[4], argv[5]) != 0)
+            return -1;
+
+        if (generator.load_draft(&draft, "in0", "out0", "in1", "in2") != 0)
+            return -1;
+    }
+
+    ncnn::GenerateOption opt;
+    opt.max_new_tokens = 128;
+    opt.temperature = 0.7f;
+    opt.top_k = 40;
+    opt.top_p = 0.9f;
+    opt.num_draft_tokens = 4;
+
+    std::vector<int> output;
+
+    double start = ncnn::get_current_time();
+    int ret = generator.generate(prompt, output, opt);
+    double end = ncnn::get_current_time();
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "generate failed %d\n", ret);
+        return -1;
+    }
+
+    for (size_t i = 0; i < output.size(); i++)
+    {
+        fprintf(stdout, "%d%s", output[i], i + 1 == output.size() ? "\n" : ",");
+    }
+
+    fprintf(stderr, "%d tokens in %.2f ms, %.2f tokens/s, %d forward passes\n", (int)output.size(), end - start, output.size() * 1000.0 / (end - start), generator.forward_count());
+    if (argc == 6)
+    {
+        fprintf(stderr, "draft accepted %d of %d\n", generator.accept_count(), generator.draft_count());
+    }
+
+    return 0;
+}
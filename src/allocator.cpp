@@ -346,6 +346,933 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     ncnn::fastFree(ptr);
 }
 
+class ArenaAllocatorPrivate
+{
+public:
+    Mutex lock;
+
+    // recording state
+    bool planning;
+    int record_time;
+    std::vector<size_t> record_sizes;
+    std::vector<int> record_alloc_times;
+    std::vector<int> record_free_times;
+    std::list<std::pair<void*, int> > record_payouts;
+
+    // the plan
+    unsigned char* arena;
+    size_t arena_size;
+    std::vector<size_t> slot_offsets;
+    std::vector<size_t> slot_sizes;
+    std::vector<std::vector<int> > slot_overlaps;
+    std::vector<unsigned char> slot_live;
+    int cursor;
+    std::list<std::pair<void*, int> > payouts;
+
+    size_t arena_hit_count;
+    size_t heap_fallback_count;
+};
+
+ArenaAllocator::ArenaAllocator()
+    : Allocator(), d(new ArenaAllocatorPrivate)
+{
+    d->planning = false;
+    d->record_time = 0;
+    d->arena = 0;
+    d->arena_size = 0;
+    d->cursor = 0;
+    d->arena_hit_count = 0;
+    d->heap_fallback_count = 0;
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+    if (!d->payouts.empty())
+    {
+        NCNN_LOGE("FATAL ERROR! arena allocator destroyed too early");
+#if NCNN_STDIO
+        std::list<std::pair<void*, int> >::iterator it = d->payouts.begin();
+        for (; it != d->payouts.end(); ++it)
+        {
+            void* ptr = it->first;
+            NCNN_LOGE("%p still in use", ptr);
+        }
+#endif
+    }
+
+    clear();
+
+    delete d;
+}
+
+ArenaAllocator::ArenaAllocator(const ArenaAllocator&)
+    : d(0)
+{
+}
+
+ArenaAllocator& ArenaAllocator::operator=(const ArenaAllocator&)
+{
+    return *this;
+}
+
+void ArenaAllocator::begin_plan()
+{
+    d->lock.lock();
+
+    d->planning = true;
+    d->record_time = 0;
+    d->record_sizes.clear();
+    d->record_alloc_times.clear();
+    d->record_free_times.clear();
+    d->record_payouts.clear();
+
+    d->lock.unlock();
+}
+
+int ArenaAllocator::end_plan()
+{
+    d->lock.lock();
+
+    if (!d->planning)
+    {
+        d->lock.unlock();
+        NCNN_LOGE("arena allocator end_plan without begin_plan");
+        return -1;
+    }
+
+    if (!d->payouts.empty())
+    {
+        d->lock.unlock();
+        NCNN_LOGE("arena allocator end_plan while arena buffers still in use");
+        return -1;
+    }
+
+    d->planning = false;
+
+    // buffers still alive live until the end
+    std::list<std::pair<void*, int> >::iterator it = d->record_payouts.begin();
+    for (; it != d->record_payouts.end(); ++it)
+    {
+        d->record_free_times[it->second] = d->record_time + 1;
+    }
+    d->record_payouts.clear();
+
+    const int slot_count = (int)d->record_sizes.size();
+
+    d->slot_offsets.resize(slot_count);
+    d->slot_sizes.resize(slot_count);
+    for (int i = 0; i < slot_count; i++)
+    {
+        d->slot_sizes[i] = alignSize(d->record_sizes[i], NCNN_MALLOC_ALIGN);
+    }
+
+    // greedy by size, the largest buffer is placed first at the lowest free offset
+    std::vector<int> order(slot_count);
+    for (int i = 0; i < slot_count; i++)
+    {
+        order[i] = i;
+    }
+    for (int i = 1; i < slot_count; i++)
+    {
+        int key = order[i];
+        int j = i - 1;
+        for (; j >= 0 && d->slot_sizes[order[j]] < d->slot_sizes[key]; j--)
+        {
+            order[j + 1] = order[j];
+        }
+        order[j + 1] = key;
+    }
+
+    size_t arena_size = 0;
+    for (int i = 0; i < slot_count; i++)
+    {
+        const int si = order[i];
+        const size_t size = d->slot_sizes[si];
+
+        size_t offset = 0;
+        bool moved = true;
+        while (moved)
+        {
+            moved = false;
+            for (int j = 0; j < i; j++)
+            {
+                const int sj = order[j];
+
+                // lifetimes disjoint
+                if (d->record_free_times[sj] <= d->record_alloc_times[si] || d->record_free_times[si] <= d->record_alloc_times[sj])
+                    continue;
+
+                // address ranges disjoint
+                if (d->slot_offsets[sj] + d->slot_sizes[sj] <= offset || offset + size <= d->slot_offsets[sj])
+                    continue;
+
+                offset = d->slot_offsets[sj] + d->slot_sizes[sj];
+                moved = true;
+            }
+        }
+
+        d->slot_offsets[si] = offset;
+        arena_size = std::max(arena_size, offset + size);
+    }
+
+    // slots sharing address must not be alive at the same time when replaying
+    d->slot_overlaps.clear();
+    d->slot_overlaps.resize(slot_count);
+    for (int i = 0; i < slot_count; i++)
+    {
+        for (int j = 0; j < slot_count; j++)
+        {
+            if (i == j)
+                continue;
+
+            if (d->slot_offsets[j] + d->slot_sizes[j] <= d->slot_offsets[i] || d->slot_offsets[i] + d->slot_sizes[i] <= d->slot_offsets[j])
+                continue;
+
+            d->slot_overlaps[i].push_back(j);
+        }
+    }
+
+    d->slot_live.clear();
+    d->slot_live.resize(slot_count, 0);
+    d->cursor = 0;
+    d->arena_hit_count = 0;
+    d->heap_fallback_count = 0;
+
+    ncnn::fastFree(d->arena);
+    d->arena = 0;
+    d->arena_size = 0;
+
+    if (arena_size > 0)
+    {
+        d->arena = (unsigned char*)ncnn::fastMalloc(arena_size);
+        if (!d->arena)
+        {
+            d->lock.unlock();
+            NCNN_LOGE("arena allocator out of memory for %lu bytes", (unsigned long)arena_size);
+            return -100;
+        }
+        d->arena_size = arena_size;
+    }
+
+    d->lock.unlock();
+
+    return 0;
+}
+
+size_t ArenaAllocator::planned_size() const
+{
+    return d->arena_size;
+}
+
+size_t ArenaAllocator::arena_hit_count() const
+{
+    return d->arena_hit_count;
+}
+
+size_t ArenaAllocator::heap_fallback_count() const
+{
+    return d->heap_fallback_count;
+}
+
+void ArenaAllocator::clear()
+{
+    d->lock.lock();
+
+    if (!d->payouts.empty())
+    {
+        NCNN_LOGE("arena allocator cleared while arena buffers still in use");
+    }
+
+    ncnn::fastFree(d->arena);
+    d->arena = 0;
+    d->arena_size = 0;
+    d->slot_offsets.clear();
+    d->slot_sizes.clear();
+    d->slot_overlaps.clear();
+    d->slot_live.clear();
+    d->cursor = 0;
+    d->payouts.clear();
+
+    d->lock.unlock();
+}
+
+// the slot matches the planned size and no buffer sharing its address is alive
+static bool arena_slot_usable(const ArenaAllocatorPrivate* d, int slot, size_t aligned_size)
+{
+    if (d->slot_sizes[slot] != aligned_size || d->slot_live[slot])
+        return false;
+
+    for (size_t i = 0; i < d->slot_overlaps[slot].size(); i++)
+    {
+        if (d->slot_live[d->slot_overlaps[slot][i]])
+            return false;
+    }
+
+    return true;
+}
+
+void* ArenaAllocator::fastMalloc(size_t size)
+{
+    d->lock.lock();
+
+    if (d->planning)
+    {
+        void* ptr = ncnn::fastMalloc(size);
+
+        const int slot = (int)d->record_sizes.size();
+        d->record_sizes.push_back(size);
+        d->record_alloc_times.push_back(d->record_time++);
+        d->record_free_times.push_back(0);
+        d->record_payouts.push_back(std::make_pair(ptr, slot));
+
+        d->lock.unlock();
+
+        return ptr;
+    }
+
+    const int slot_count = (int)d->slot_sizes.size();
+    if (slot_count > 0)
+    {
+        // the plan repeats itself inference after inference
+        // when the request does not fit the slot under the cursor, the sequence went astray,
+        // eg. a previous extract stopped early, so look for the next free slot of the same size
+        // nothing in the arena is alive at the start of an inference, search from the first slot then
+        const size_t aligned_size = alignSize(size, NCNN_MALLOC_ALIGN);
+
+        int slot = d->cursor;
+        if (!arena_slot_usable(d, slot, aligned_size))
+        {
+            const int start = d->payouts.empty() ? 0 : d->cursor;
+
+            slot = -1;
+            for (int i = 0; i < slot_count; i++)
+            {
+                const int si = (start + i) % slot_count;
+                if (arena_slot_usable(d, si, aligned_size))
+                {
+                    slot = si;
+                    break;
+                }
+            }
+        }
+
+        if (slot != -1)
+        {
+            void* ptr = d->arena + d->slot_offsets[slot];
+
+            d->cursor = (slot + 1) % slot_count;
+            d->slot_live[slot] = 1;
+            d->payouts.push_back(std::make_pair(ptr, slot));
+            d->arena_hit_count++;
+
+            d->lock.unlock();
+
+            return ptr;
+        }
+
+        if (d->heap_fallback_count == 0)
+        {
+            NCNN_LOGE("arena allocator falls back to heap for %lu bytes, the allocation sequence differs from the plan", (unsigned long)size);
+        }
+
+        d->heap_fallback_count++;
+    }
+
+    d->lock.unlock();
+
+    return ncnn::fastMalloc(size);
+}
+
+void ArenaAllocator::fastFree(void* ptr)
+{
+    d->lock.lock();
+
+    if (d->arena && (unsigned char*)ptr >= d->arena && (unsigned char*)ptr < d->arena + d->arena_size)
+    {
+        std::list<std::pair<void*, int> >::iterator it = d->payouts.begin();
+        for (; it != d->payouts.end(); ++it)
+        {
+            if (it->first == ptr)
+            {
+                d->slot_live[it->second] = 0;
+                d->payouts.erase(it);
+
+                d->lock.unlock();
+
+                return;
+            }
+        }
+
+        d->lock.unlock();
+
+        NCNN_LOGE("FATAL ERROR! arena allocator get wild %p", ptr);
+        return;
+    }
+
+    if (d->planning)
+    {
+        std::list<std::pair<void*, int> >::iterator it = d->record_payouts.begin();
+        for (; it != d->record_payouts.end(); ++it)
+        {
+            if (it->first == ptr)
+            {
+                d->record_free_times[it->second] = d->record_time++;
+                d->record_payouts.erase(it);
+                break;
+            }
+        }
+    }
+
+    d->lock.unlock();
+
+    ncnn::fastFree(ptr);
+}
+
+// lock-free stack primitives for the thread caching allocator depot
+// push uses compare-and-swap, pop always takes the whole list by exchange, so there is no ABA problem
+#if NCNN_THREADS && (defined __GNUC__ || defined __clang__)
+static NCNN_FORCEINLINE bool depot_compare_and_swap(void* volatile* addr, void* oldval, void* newval)
+{
+    return __sync_bool_compare_and_swap(addr, oldval, newval);
+}
+static NCNN_FORCEINLINE void* depot_exchange(void* volatile* addr, void* newval)
+{
+    void* oldval = *addr;
+    while (!__sync_bool_compare_and_swap(addr, oldval, newval))
+    {
+        oldval = *addr;
+    }
+    return oldval;
+}
+#define NCNN_DEPOT_LOCKFREE 1
+#elif NCNN_THREADS && defined _MSC_VER
+static NCNN_FORCEINLINE bool depot_compare_and_swap(void* volatile* addr, void* oldval, void* newval)
+{
+    return InterlockedCompareExchangePointer(addr, newval, oldval) == oldval;
+}
+static NCNN_FORCEINLINE void* depot_exchange(void* volatile* addr, void* newval)
+{
+    return InterlockedExchangePointer(addr, newval);
+}
+#define NCNN_DEPOT_LOCKFREE 1
+#else
+#define NCNN_DEPOT_LOCKFREE 0
+#endif
+
+// size classes in quarter steps of power of two, 64 80 96 112 128 160 192 224 256 320 ...
+#define NCNN_SIZE_CLASS_COUNT 89
+#define NCNN_SIZE_CLASS_MIN 64
+
+static int size_to_class(size_t size)
+{
+    if (size <= NCNN_SIZE_CLASS_MIN)
+        return 0;
+
+    size_t s = size - 1;
+    int msb = 6;
+    while (s >> (msb + 1))
+        msb++;
+
+    int sub = (int)((s >> (msb - 2)) & 3);
+    int c = (msb - 6) * 4 + sub + 1;
+    return c < NCNN_SIZE_CLASS_COUNT ? c : -1;
+}
+
+static size_t class_to_size(int c)
+{
+    if (c == 0)
+        return NCNN_SIZE_CLASS_MIN;
+
+    int msb = (c - 1) / 4 + 6;
+    int sub = (c - 1) % 4;
+    return ((size_t)1 << msb) + ((size_t)(sub + 1) << (msb - 2));
+}
+
+// each buffer is prefixed with a header keeping its size class
+// the header is NCNN_MALLOC_ALIGN bytes so the returned pointer keeps the alignment
+#define NCNN_THREAD_CACHE_HEADER NCNN_MALLOC_ALIGN
+
+static NCNN_FORCEINLINE void*& free_list_next(void* ptr)
+{
+    return *(void**)ptr;
+}
+
+class ThreadCachingAllocatorPrivate;
+
+class ThreadCache
+{
+public:
+    ThreadCache(ThreadCachingAllocatorPrivate* _owner)
+        : owner(_owner)
+    {
+        for (int i = 0; i < NCNN_SIZE_CLASS_COUNT; i++)
+        {
+            bins[i] = 0;
+        }
+        bytes = 0;
+        hit_count = 0;
+        depot_hit_count = 0;
+        heap_count = 0;
+    }
+
+    ThreadCachingAllocatorPrivate* owner;
+
+    void* bins[NCNN_SIZE_CLASS_COUNT];
+
+    // plain counters written by the owner thread only
+    // statistics read them under caches_lock, so a running thread may be a few counts ahead
+    size_t bytes;
+    size_t hit_count;
+    size_t depot_hit_count;
+    size_t heap_count;
+};
+
+// thread local slot whose value is handed to a callback when the thread exits
+#if NCNN_THREADS && defined _WIN32 && _WIN32_WINNT >= 0x0600
+class ThreadExitLocalStorage
+{
+public:
+    ThreadExitLocalStorage(PFLS_CALLBACK_FUNCTION callback)
+    {
+        key = FlsAlloc(callback);
+    }
+    ~ThreadExitLocalStorage()
+    {
+        // the callback is invoked for the values still set
+        FlsFree(key);
+    }
+    void set(void* value)
+    {
+        FlsSetValue(key, (PVOID)value);
+    }
+    void* get()
+    {
+        return (void*)FlsGetValue(key);
+    }
+
+private:
+    DWORD key;
+};
+#elif NCNN_THREADS && !defined _WIN32
+class ThreadExitLocalStorage
+{
+public:
+    ThreadExitLocalStorage(void (*callback)(void*))
+    {
+        pthread_key_create(&key, callback);
+    }
+    ~ThreadExitLocalStorage()
+    {
+        pthread_key_delete(key);
+    }
+    void set(void* value)
+    {
+        pthread_setspecific(key, value);
+    }
+    void* get()
+    {
+        return pthread_getspecific(key);
+    }
+
+private:
+    pthread_key_t key;
+};
+#else
+// no exit notification, caches are reclaimed by clear() and the destructor
+class ThreadExitLocalStorage : public ThreadLocalStorage
+{
+public:
+    ThreadExitLocalStorage(void (*)(void*))
+    {
+    }
+};
+#endif
+
+class ThreadCachingAllocatorPrivate
+{
+public:
+    ThreadCache* get_thread_cache();
+
+    // move the buffers of an exited thread to the depot and drop its cache
+    void retire_thread_cache(ThreadCache* tc);
+
+    void depot_push(int c, void* first, void* last, int count);
+    void* depot_take(int c);
+
+    void free_list(void* ptr);
+
+    size_t thread_cache_limit;
+
+    ThreadExitLocalStorage* tls;
+
+    // caches of running threads, for statistics and cleanup
+    Mutex caches_lock;
+    std::vector<ThreadCache*> caches;
+
+    // statistics of the retired caches
+    size_t retired_hit_count;
+    size_t retired_depot_hit_count;
+    size_t retired_heap_count;
+
+    void* volatile depot[NCNN_SIZE_CLASS_COUNT];
+    int depot_counts[NCNN_SIZE_CLASS_COUNT];
+#if !NCNN_DEPOT_LOCKFREE
+    Mutex depot_lock;
+#endif
+};
+
+static void thread_cache_exit(void* ptr)
+{
+    ThreadCache* tc = (ThreadCache*)ptr;
+    tc->owner->retire_thread_cache(tc);
+}
+
+#if NCNN_THREADS && defined _WIN32 && _WIN32_WINNT >= 0x0600
+static VOID NTAPI thread_cache_exit_fls(PVOID ptr)
+{
+    thread_cache_exit((void*)ptr);
+}
+#endif
+
+ThreadCache* ThreadCachingAllocatorPrivate::get_thread_cache()
+{
+    ThreadCache* tc = (ThreadCache*)tls->get();
+    if (tc)
+        return tc;
+
+    tc = new ThreadCache(this);
+    tls->set(tc);
+
+    caches_lock.lock();
+    caches.push_back(tc);
+    caches_lock.unlock();
+
+    return tc;
+}
+
+void ThreadCachingAllocatorPrivate::retire_thread_cache(ThreadCache* tc)
+{
+    for (int c = 0; c < NCNN_SIZE_CLASS_COUNT; c++)
+    {
+        void* first = tc->bins[c];
+        if (!first)
+            continue;
+
+        void* last = first;
+        int count = 1;
+        while (free_list_next(last))
+        {
+            last = free_list_next(last);
+            count++;
+        }
+        depot_push(c, first, last, count);
+    }
+
+    caches_lock.lock();
+
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        if (caches[i] == tc)
+        {
+            caches.erase(caches.begin() + i);
+            break;
+        }
+    }
+
+    retired_hit_count += tc->hit_count;
+    retired_depot_hit_count += tc->depot_hit_count;
+    retired_heap_count += tc->heap_count;
+
+    caches_lock.unlock();
+
+    delete tc;
+}
+
+void ThreadCachingAllocatorPrivate::depot_push(int c, void* first, void* last, int count)
+{
+#if NCNN_DEPOT_LOCKFREE
+    for (;;)
+    {
+        void* head = depot[c];
+        free_list_next(last) = head;
+        if (depot_compare_and_swap(&depot[c], head, first))
+            break;
+    }
+#else
+    depot_lock.lock();
+    free_list_next(last) = depot[c];
+    depot[c] = first;
+    depot_lock.unlock();
+#endif
+
+    NCNN_XADD(&depot_counts[c], count);
+}
+
+void* ThreadCachingAllocatorPrivate::depot_take(int c)
+{
+    if (!depot[c])
+        return 0;
+
+#if NCNN_DEPOT_LOCKFREE
+    void* list = depot_exchange(&depot[c], 0);
+#else
+    depot_lock.lock();
+    void* list = depot[c];
+    depot[c] = 0;
+    depot_lock.unlock();
+#endif
+
+    int count = 0;
+    for (void* p = list; p; p = free_list_next(p))
+    {
+        count++;
+    }
+    NCNN_XADD(&depot_counts[c], -count);
+
+    return list;
+}
+
+void ThreadCachingAllocatorPrivate::free_list(void* ptr)
+{
+    while (ptr)
+    {
+        void* next = free_list_next(ptr);
+        ncnn::fastFree((unsigned char*)ptr - NCNN_THREAD_CACHE_HEADER);
+        ptr = next;
+    }
+}
+
+ThreadCachingAllocator::ThreadCachingAllocator()
+    : Allocator(), d(new ThreadCachingAllocatorPrivate)
+{
+    d->thread_cache_limit = 32 * 1024 * 1024;
+
+#if NCNN_THREADS && defined _WIN32 && _WIN32_WINNT >= 0x0600
+    d->tls = new ThreadExitLocalStorage(thread_cache_exit_fls);
+#else
+    d->tls = new ThreadExitLocalStorage(thread_cache_exit);
+#endif
+
+    d->retired_hit_count = 0;
+    d->retired_depot_hit_count = 0;
+    d->retired_heap_count = 0;
+
+    for (int i = 0; i < NCNN_SIZE_CLASS_COUNT; i++)
+    {
+        d->depot[i] = 0;
+        d->depot_counts[i] = 0;
+    }
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator()
+{
+    // no exit callback after this, the caches left are those of running threads
+    delete d->tls;
+
+    clear();
+
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        delete d->caches[i];
+    }
+
+    delete d;
+}
+
+ThreadCachingAllocator::ThreadCachingAllocator(const ThreadCachingAllocator&)
+    : d(0)
+{
+}
+
+ThreadCachingAllocator& ThreadCachingAllocator::operator=(const ThreadCachingAllocator&)
+{
+    return *this;
+}
+
+void ThreadCachingAllocator::set_thread_cache_limit(size_t limit)
+{
+    d->thread_cache_limit = limit;
+}
+
+void ThreadCachingAllocator::clear()
+{
+    d->caches_lock.lock();
+
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        ThreadCache* tc = d->caches[i];
+        for (int c = 0; c < NCNN_SIZE_CLASS_COUNT; c++)
+        {
+            d->free_list(tc->bins[c]);
+            tc->bins[c] = 0;
+        }
+        tc->bytes = 0;
+    }
+
+    d->caches_lock.unlock();
+
+    for (int c = 0; c < NCNN_SIZE_CLASS_COUNT; c++)
+    {
+        d->free_list(d->depot_take(c));
+    }
+}
+
+size_t ThreadCachingAllocator::thread_cache_hit_count() const
+{
+    d->caches_lock.lock();
+    size_t count = d->retired_hit_count;
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        count += d->caches[i]->hit_count;
+    }
+    d->caches_lock.unlock();
+
+    return count;
+}
+
+size_t ThreadCachingAllocator::depot_hit_count() const
+{
+    d->caches_lock.lock();
+    size_t count = d->retired_depot_hit_count;
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        count += d->caches[i]->depot_hit_count;
+    }
+    d->caches_lock.unlock();
+
+    return count;
+}
+
+size_t ThreadCachingAllocator::heap_alloc_count() const
+{
+    d->caches_lock.lock();
+    size_t count = d->retired_heap_count;
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        count += d->caches[i]->heap_count;
+    }
+    d->caches_lock.unlock();
+
+    return count;
+}
+
+size_t ThreadCachingAllocator::cached_bytes() const
+{
+    size_t bytes = 0;
+
+    d->caches_lock.lock();
+    for (size_t i = 0; i < d->caches.size(); i++)
+    {
+        bytes += d->caches[i]->bytes;
+    }
+    d->caches_lock.unlock();
+
+    for (int c = 0; c < NCNN_SIZE_CLASS_COUNT; c++)
+    {
+        bytes += (size_t)d->depot_counts[c] * class_to_size(c);
+    }
+
+    return bytes;
+}
+
+void* ThreadCachingAllocator::fastMalloc(size_t size)
+{
+    ThreadCache* tc = d->get_thread_cache();
+
+    const int c = size_to_class(size);
+    if (c == -1)
+    {
+        // too large to be cached
+        unsigned char* raw = (unsigned char*)ncnn::fastMalloc(size + NCNN_THREAD_CACHE_HEADER);
+        if (!raw)
+            return 0;
+
+        *(int*)raw = -1;
+        tc->heap_count++;
+        return raw + NCNN_THREAD_CACHE_HEADER;
+    }
+
+    const size_t class_size = class_to_size(c);
+
+    // thread local bin, no synchronization at all
+    void* ptr = tc->bins[c];
+    if (ptr)
+    {
+        tc->bins[c] = free_list_next(ptr);
+        tc->bytes -= class_size;
+        tc->hit_count++;
+        return ptr;
+    }
+
+    // refill from the shared depot in one batch
+    void* list = d->depot_take(c);
+    if (list)
+    {
+        ptr = list;
+        list = free_list_next(list);
+
+        // keep what fits into the local budget and hand the rest back
+        while (list && tc->bytes + class_size <= d->thread_cache_limit)
+        {
+            void* next = free_list_next(list);
+            free_list_next(list) = tc->bins[c];
+            tc->bins[c] = list;
+            tc->bytes += class_size;
+            list = next;
+        }
+
+        if (list)
+        {
+            void* last = list;
+            int count = 1;
+            while (free_list_next(last))
+            {
+                last = free_list_next(last);
+                count++;
+            }
+            d->depot_push(c, list, last, count);
+        }
+
+        tc->depot_hit_count++;
+        return ptr;
+    }
+
+    unsigned char* raw = (unsigned char*)ncnn::fastMalloc(class_size + NCNN_THREAD_CACHE_HEADER);
+    if (!raw)
+        return 0;
+
+    *(int*)raw = c;
+    tc->heap_count++;
+    return raw + NCNN_THREAD_CACHE_HEADER;
+}
+
+void ThreadCachingAllocator::fastFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    const int c = *(int*)((unsigned char*)ptr - NCNN_THREAD_CACHE_HEADER);
+    if (c == -1)
+    {
+        ncnn::fastFree((unsigned char*)ptr - NCNN_THREAD_CACHE_HEADER);
+        return;
+    }
+
+    const size_t class_size = class_to_size(c);
+
+    ThreadCache* tc = d->get_thread_cache();
+    if (tc->bytes + class_size <= d->thread_cache_limit)
+    {
+        free_list_next(ptr) = tc->bins[c];
+        tc->bins[c] = ptr;
+        tc->bytes += class_size;
+        return;
+    }
+
+    // bounded hoarding, overflow to the shared depot
+    d->depot_push(c, ptr, ptr, 1);
+}
+
 #if NCNN_VULKAN
 VkAllocator::VkAllocator(const VulkanDevice* _vkdev)
     : vkdev(_vkdev)
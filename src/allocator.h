@@ -205,6 +205,87 @@ private:
     UnlockedPoolAllocatorPrivate* const d;
 };
 
+class ArenaAllocatorPrivate;
+class NCNN_EXPORT ArenaAllocator : public Allocator
+{
+public:
+    ArenaAllocator();
+    ~ArenaAllocator();
+
+    // start recording buffer lifetimes
+    // run one inference with fixed input shapes between begin_plan() and end_plan()
+    void begin_plan();
+
+    // pack the recorded buffers into one arena by lifetime, greedy by size
+    // the following inferences replay the same allocation sequence without malloc
+    // return 0 if success
+    int end_plan();
+
+    // planned arena size in bytes, which is the peak memory of one inference
+    // return 0 if not planned
+    size_t planned_size() const;
+
+    // number of requests served from arena and from heap since end_plan()
+    // a request not matching the next planned slot takes the next free slot of the same size,
+    // searched from the first slot when no arena buffer is alive, eg. after an extract stopped early
+    // heap fallback happens when no such slot is free, the first one is reported in the log
+    size_t arena_hit_count() const;
+    size_t heap_fallback_count() const;
+
+    // release the arena and the plan
+    // all buffers must have been returned
+    void clear();
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    ArenaAllocator(const ArenaAllocator&);
+    ArenaAllocator& operator=(const ArenaAllocator&);
+
+private:
+    ArenaAllocatorPrivate* const d;
+};
+
+class ThreadCachingAllocatorPrivate;
+class NCNN_EXPORT ThreadCachingAllocator : public Allocator
+{
+public:
+    ThreadCachingAllocator();
+    ~ThreadCachingAllocator();
+
+    // max bytes each thread keeps in its local cache
+    // freed buffers beyond the limit go to the shared depot
+    // the cache of an exited thread is handed to the depot as well
+    // default limit = 32M
+    void set_thread_cache_limit(size_t limit);
+
+    // release all cached buffers in thread caches and depot
+    // must not be called while other threads are using this allocator
+    void clear();
+
+    // statistics, summed over all threads
+    // a thread allocating concurrently may not be counted up to its latest request yet
+    // requests served from the thread local cache
+    size_t thread_cache_hit_count() const;
+    // requests served from the shared depot
+    size_t depot_hit_count() const;
+    // requests served by system malloc
+    size_t heap_alloc_count() const;
+    // bytes held in thread caches and depot
+    size_t cached_bytes() const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+private:
+    ThreadCachingAllocator(const ThreadCachingAllocator&);
+    ThreadCachingAllocator& operator=(const ThreadCachingAllocator&);
+
+private:
+    ThreadCachingAllocatorPrivate* const d;
+};
+
 #if NCNN_VULKAN
 
 class VulkanDevice;
@@ -26,6 +26,10 @@
 #include <unistd.h>   // sleep()
 #endif                // _WIN32
 
+#if NCNN_STDIO
+#include <stdio.h>
+#endif // NCNN_STDIO
+
 #if NCNN_BENCHMARK
 #include "layer/convolution.h"
 #include "layer/convolutiondepthwise.h"
@@ -84,6 +88,184 @@ void sleep(unsigned long long int milliseconds)
 #endif
 }
 
+LayerProfile::LayerProfile()
+{
+    layer_index = -1;
+    typeindex = -1;
+    start = 0.0;
+    end = 0.0;
+    lane = 0;
+    num_threads = 1;
+    bytes_allocated = 0;
+}
+
+class ProfilerPrivate
+{
+public:
+    Mutex lock;
+    std::vector<LayerProfile> records;
+};
+
+Profiler::Profiler()
+    : d(new ProfilerPrivate)
+{
+}
+
+Profiler::~Profiler()
+{
+    delete d;
+}
+
+Profiler::Profiler(const Profiler&)
+    : d(0)
+{
+}
+
+Profiler& Profiler::operator=(const Profiler&)
+{
+    return *this;
+}
+
+void Profiler::clear()
+{
+    d->lock.lock();
+    d->records.clear();
+    d->lock.unlock();
+}
+
+void Profiler::record(const LayerProfile& profile)
+{
+    d->lock.lock();
+    d->records.push_back(profile);
+    d->lock.unlock();
+}
+
+const std::vector<LayerProfile>& Profiler::records() const
+{
+    return d->records;
+}
+
+#if NCNN_STDIO
+// 56x56x16 pack4 style, in storage layout
+static void print_shapes(FILE* fp, const std::vector<Mat>& shapes)
+{
+    for (size_t i = 0; i < shapes.size(); i++)
+    {
+        const Mat& m = shapes[i];
+
+        if (i != 0)
+            fprintf(fp, " ");
+
+        if (m.dims == 1)
+            fprintf(fp, "%d", m.w);
+        if (m.dims == 2)
+            fprintf(fp, "%dx%d", m.w, m.h);
+        if (m.dims == 3)
+            fprintf(fp, "%dx%dx%d", m.w, m.h, m.c);
+        if (m.dims == 4)
+            fprintf(fp, "%dx%dx%dx%d", m.w, m.h, m.d, m.c);
+
+        fprintf(fp, " pack%d", m.elempack);
+        if (m.elempack != 0)
+            fprintf(fp, " %dbit", (int)(m.elemsize * 8 / m.elempack));
+    }
+}
+
+#if NCNN_STRING
+static void print_json_string(FILE* fp, const std::string& str)
+{
+    fprintf(fp, "\"");
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        const char ch = str[i];
+        if (ch == '"' || ch == '\\')
+            fprintf(fp, "\\%c", ch);
+        else if ((unsigned char)ch < 0x20)
+            fprintf(fp, "\\u%04x", (unsigned char)ch);
+        else
+            fprintf(fp, "%c", ch);
+    }
+    fprintf(fp, "\"");
+}
+#endif // NCNN_STRING
+
+int Profiler::save_chrome_trace(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", path);
+        return -1;
+    }
+
+    // timestamps relative to the first layer in us
+    double origin = 0.0;
+    for (size_t i = 0; i < d->records.size(); i++)
+    {
+        if (i == 0 || d->records[i].start < origin)
+            origin = d->records[i].start;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < d->records.size(); i++)
+    {
+        const LayerProfile& p = d->records[i];
+
+        fprintf(fp, "{\"name\":");
+#if NCNN_STRING
+        print_json_string(fp, p.name);
+        fprintf(fp, ",\"cat\":");
+        print_json_string(fp, p.type);
+#else
+        fprintf(fp, "\"%d\",\"cat\":\"%d\"", p.layer_index, p.typeindex);
+#endif // NCNN_STRING
+        fprintf(fp, ",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", p.lane, (p.start - origin) * 1000.0, (p.end - p.start) * 1000.0);
+        fprintf(fp, ",\"args\":{\"layer_index\":%d,\"num_threads\":%d,\"bytes_allocated\":%lu,\"bottoms\":\"", p.layer_index, p.num_threads, (unsigned long)p.bytes_allocated);
+        print_shapes(fp, p.bottom_shapes);
+        fprintf(fp, "\",\"tops\":\"");
+        print_shapes(fp, p.top_shapes);
+        fprintf(fp, "\"}}%s\n", i + 1 == d->records.size() ? "" : ",");
+    }
+    fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+
+    fclose(fp);
+
+    return 0;
+}
+
+int Profiler::save_csv(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", path);
+        return -1;
+    }
+
+    fprintf(fp, "layer_index,type,name,start_ms,duration_ms,lane,num_threads,bytes_allocated,bottoms,tops\n");
+    for (size_t i = 0; i < d->records.size(); i++)
+    {
+        const LayerProfile& p = d->records[i];
+
+#if NCNN_STRING
+        // layer names in ncnn param never contain commas or quotes
+        fprintf(fp, "%d,%s,%s", p.layer_index, p.type.c_str(), p.name.c_str());
+#else
+        fprintf(fp, "%d,%d,", p.layer_index, p.typeindex);
+#endif // NCNN_STRING
+        fprintf(fp, ",%.3f,%.3f,%d,%d,%lu,\"", p.start, p.end - p.start, p.lane, p.num_threads, (unsigned long)p.bytes_allocated);
+        print_shapes(fp, p.bottom_shapes);
+        fprintf(fp, "\",\"");
+        print_shapes(fp, p.top_shapes);
+        fprintf(fp, "\"\n");
+    }
+
+    fclose(fp);
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
 #if NCNN_BENCHMARK
 
 void benchmark(const Layer* layer, double start, double end)
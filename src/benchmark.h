@@ -16,6 +16,73 @@ NCNN_EXPORT double get_current_time();
 // sleep milliseconds
 NCNN_EXPORT void sleep(unsigned long long int milliseconds = 1000);
 
+// timing and blob shapes of one layer forward
+class NCNN_EXPORT LayerProfile
+{
+public:
+    LayerProfile();
+
+    int layer_index;
+    int typeindex;
+#if NCNN_STRING
+    std::string type;
+    std::string name;
+#endif // NCNN_STRING
+
+    // wall time in ms, same clock as get_current_time
+    double start;
+    double end;
+
+    // worker that ran the layer, layers on different lanes may overlap in branch parallel mode
+    int lane;
+
+    // threads handed to the layer
+    int num_threads;
+
+    // bytes of the top blobs allocated by the layer, zero for inplace forward
+    size_t bytes_allocated;
+
+    // blob shapes in storage layout with elempack and elemsize, no data
+    std::vector<Mat> bottom_shapes;
+    std::vector<Mat> top_shapes;
+};
+
+// collect per-layer records from Extractor::set_profiler
+// records are appended in completion order
+class ProfilerPrivate;
+class NCNN_EXPORT Profiler
+{
+public:
+    Profiler();
+    virtual ~Profiler();
+
+    // drop all records
+    void clear();
+
+    // append one record, thread-safe
+    virtual void record(const LayerProfile& profile);
+
+    // recorded layers, do not call while an extract is running
+    const std::vector<LayerProfile>& records() const;
+
+#if NCNN_STDIO
+    // write records as chrome trace event json, load it in chrome://tracing or perfetto
+    // return 0 if success
+    int save_chrome_trace(const char* path) const;
+
+    // write records as csv, one row per layer
+    // return 0 if success
+    int save_csv(const char* path) const;
+#endif // NCNN_STDIO
+
+private:
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+
+private:
+    ProfilerPrivate* const d;
+};
+
 #if NCNN_BENCHMARK
 
 NCNN_EXPORT void benchmark(const Layer* layer, double start, double end);
@@ -186,6 +186,13 @@ static ncnn::CpuSet g_cpu_affinity_mask_all;
 static ncnn::CpuSet g_cpu_affinity_mask_little;
 static ncnn::CpuSet g_cpu_affinity_mask_big;
 
+// cores reserved by acquire_cpu_partition
+static ncnn::CpuSet g_cpu_partition_reserved;
+#if NCNN_THREADS
+static ncnn::Mutex g_cpu_partition_lock;
+static ncnn::ConditionVariable g_cpu_partition_condition;
+#endif // NCNN_THREADS
+
 // isa info
 #if defined _WIN32
 #if __aarch64__
@@ -3107,6 +3114,145 @@ int set_cpu_thread_affinity(const CpuSet& thread_affinity_mask)
 #endif
 }
 
+#if defined __ANDROID__ || defined __linux__ || defined _WIN32 || __APPLE__
+// affinity of the calling thread, falls back to the powersave mask when it can not be queried
+static void get_calling_thread_affinity(CpuSet& thread_affinity_mask)
+{
+#if defined __ANDROID__ || defined __linux__
+#if defined(__BIONIC__) && !defined(__OHOS__)
+    pid_t pid = gettid();
+#else
+    pid_t pid = syscall(SYS_gettid);
+#endif
+
+    thread_affinity_mask.disable_all();
+
+    int syscallret = syscall(__NR_sched_getaffinity, pid, sizeof(cpu_set_t), &thread_affinity_mask.cpu_set);
+    if (syscallret > 0)
+        return;
+#elif defined _WIN32
+    // there is no GetThreadAffinityMask, SetThreadAffinityMask returns the previous one
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
+    {
+        DWORD_PTR prev_mask = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+        if (prev_mask != 0)
+        {
+            SetThreadAffinityMask(GetCurrentThread(), prev_mask);
+            thread_affinity_mask.mask = prev_mask;
+            return;
+        }
+    }
+#elif __APPLE__
+    mach_port_t tid = pthread_mach_thread_np(pthread_self());
+
+    thread_affinity_policy_data_t policy_data;
+    mach_msg_type_number_t count = THREAD_AFFINITY_POLICY_COUNT;
+    boolean_t get_default = FALSE;
+    int ret = thread_policy_get(tid, THREAD_AFFINITY_POLICY, (thread_policy_t)&policy_data, &count, &get_default);
+    if (ret == KERN_SUCCESS)
+    {
+        // the affinity tag is a hint, no tag maps to an empty set
+        thread_affinity_mask.disable_all();
+        if (policy_data.affinity_tag != THREAD_AFFINITY_TAG_NULL)
+            thread_affinity_mask.enable(policy_data.affinity_tag - 1);
+        return;
+    }
+#endif
+
+    thread_affinity_mask = get_cpu_thread_affinity_mask(get_cpu_powersave());
+}
+#endif // defined __ANDROID__ || defined __linux__ || defined _WIN32 || __APPLE__
+
+int acquire_cpu_partition(int num_threads, CpuSet& partition, CpuSet& previous_affinity_mask)
+{
+    try_initialize_global_cpu_info();
+
+    partition.disable_all();
+    previous_affinity_mask.disable_all();
+
+#if defined __ANDROID__ || defined __linux__ || defined _WIN32 || __APPLE__
+    const CpuSet& thread_affinity_mask = get_cpu_thread_affinity_mask(get_cpu_powersave());
+    if (thread_affinity_mask.num_enabled() == 0)
+        return num_threads;
+
+    int num_reserved = 0;
+
+#if NCNN_THREADS
+    g_cpu_partition_lock.lock();
+#endif
+    for (;;)
+    {
+        // lowest free cores first, neighbor cores tend to share cache
+        for (int i = 0; i < g_cpucount && num_reserved < num_threads; i++)
+        {
+            if (thread_affinity_mask.is_enabled(i) && !g_cpu_partition_reserved.is_enabled(i))
+            {
+                partition.enable(i);
+                g_cpu_partition_reserved.enable(i);
+                num_reserved++;
+            }
+        }
+
+        if (num_reserved > 0)
+            break;
+
+#if NCNN_THREADS
+        g_cpu_partition_condition.wait(g_cpu_partition_lock);
+#else
+        // nobody else can hold cores
+        break;
+#endif
+    }
+#if NCNN_THREADS
+    g_cpu_partition_lock.unlock();
+#endif
+
+    if (num_reserved == 0)
+        return num_threads;
+
+    get_calling_thread_affinity(previous_affinity_mask);
+
+#if NCNN_SIMPLEOMP || !defined(_OPENMP)
+    set_sched_affinity(partition);
+#else
+    set_cpu_thread_affinity(partition);
+#endif
+
+    return num_reserved;
+#else
+    return num_threads;
+#endif
+}
+
+void release_cpu_partition(const CpuSet& partition, const CpuSet& previous_affinity_mask)
+{
+#if defined __ANDROID__ || defined __linux__ || defined _WIN32 || __APPLE__
+    if (partition.num_enabled() == 0)
+        return;
+
+    // the openmp workers stay on the partition until they are pinned again
+    set_sched_affinity(previous_affinity_mask);
+
+#if NCNN_THREADS
+    g_cpu_partition_lock.lock();
+#endif
+    for (int i = 0; i < g_cpucount; i++)
+    {
+        if (partition.is_enabled(i))
+            g_cpu_partition_reserved.disable(i);
+    }
+#if NCNN_THREADS
+    g_cpu_partition_condition.broadcast();
+    g_cpu_partition_lock.unlock();
+#endif
+#else
+    (void)partition;
+    (void)previous_affinity_mask;
+#endif
+}
+
 int is_current_thread_running_on_a53_a55()
 {
     try_initialize_global_cpu_info();
@@ -148,6 +148,16 @@ NCNN_EXPORT const CpuSet& get_cpu_thread_affinity_mask(int powersave);
 // set explicit thread affinity
 NCNN_EXPORT int set_cpu_thread_affinity(const CpuSet& thread_affinity_mask);
 
+// process-wide partition of the cores in the current powersave mask among concurrent inferences
+// acquire reserves up to num_threads free cores into partition and pins the calling thread
+// and its openmp workers to them, it blocks while every core is reserved by others
+// with simpleomp the worker pool is shared by all threads, only the calling thread is pinned
+// the affinity of the calling thread before pinning is saved into previous_affinity_mask
+// release gives the cores back and restores the calling thread to previous_affinity_mask
+// return the number of cores reserved, num_threads unchanged if pinning is not supported
+NCNN_EXPORT int acquire_cpu_partition(int num_threads, CpuSet& partition, CpuSet& previous_affinity_mask);
+NCNN_EXPORT void release_cpu_partition(const CpuSet& partition, const CpuSet& previous_affinity_mask);
+
 // runtime thread affinity info
 NCNN_EXPORT int is_current_thread_running_on_a53_a55();
 
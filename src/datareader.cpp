@@ -5,6 +5,18 @@
 
 #include <string.h>
 
+#if NCNN_STDIO
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined __unix__ || defined __APPLE__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif // NCNN_STDIO
+
 namespace ncnn {
 
 DataReader::DataReader()
@@ -138,6 +150,147 @@ size_t DataReaderFromMemory::reference(size_t size, const void** buf) const
     return size;
 }
 
+#if NCNN_STDIO
+class DataReaderFromMmapPrivate
+{
+public:
+    DataReaderFromMmapPrivate()
+    {
+        mem = 0;
+        size = 0;
+        offset = 0;
+#if _WIN32
+        mapping = 0;
+#endif
+    }
+
+    const unsigned char* mem;
+    size_t size;
+    mutable size_t offset;
+#if _WIN32
+    HANDLE mapping;
+#endif
+};
+
+DataReaderFromMmap::DataReaderFromMmap(const char* filepath)
+    : DataReader(), d(new DataReaderFromMmapPrivate)
+{
+#if _WIN32
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        NCNN_LOGE("CreateFile %s failed", filepath);
+        return;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        NCNN_LOGE("GetFileSizeEx %s failed", filepath);
+        CloseHandle(file);
+        return;
+    }
+
+    d->mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+    CloseHandle(file);
+    if (!d->mapping)
+    {
+        NCNN_LOGE("CreateFileMapping %s failed", filepath);
+        return;
+    }
+
+    void* mem = MapViewOfFile(d->mapping, FILE_MAP_COPY, 0, 0, 0);
+    if (!mem)
+    {
+        NCNN_LOGE("MapViewOfFile %s failed", filepath);
+        CloseHandle(d->mapping);
+        d->mapping = 0;
+        return;
+    }
+
+    d->mem = (const unsigned char*)mem;
+    d->size = (size_t)file_size.QuadPart;
+#elif defined __unix__ || defined __APPLE__
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0)
+    {
+        NCNN_LOGE("open %s failed", filepath);
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        NCNN_LOGE("fstat %s failed", filepath);
+        close(fd);
+        return;
+    }
+
+    // private writable mapping, layers are free to modify weights in place
+    void* mem = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        NCNN_LOGE("mmap %s failed", filepath);
+        return;
+    }
+
+    d->mem = (const unsigned char*)mem;
+    d->size = (size_t)st.st_size;
+#else
+    NCNN_LOGE("mmap %s not supported on this platform", filepath);
+#endif
+}
+
+DataReaderFromMmap::~DataReaderFromMmap()
+{
+    if (d->mem)
+    {
+#if _WIN32
+        UnmapViewOfFile(d->mem);
+        CloseHandle(d->mapping);
+#elif defined __unix__ || defined __APPLE__
+        munmap((void*)d->mem, d->size);
+#endif
+    }
+
+    delete d;
+}
+
+DataReaderFromMmap::DataReaderFromMmap(const DataReaderFromMmap&)
+    : d(0)
+{
+}
+
+DataReaderFromMmap& DataReaderFromMmap::operator=(const DataReaderFromMmap&)
+{
+    return *this;
+}
+
+bool DataReaderFromMmap::mapped() const
+{
+    return d->mem != 0;
+}
+
+size_t DataReaderFromMmap::read(void* buf, size_t size) const
+{
+    size_t nread = std::min(size, d->size - d->offset);
+    memcpy(buf, d->mem + d->offset, nread);
+    d->offset += nread;
+    return nread;
+}
+
+size_t DataReaderFromMmap::reference(size_t size, const void** buf) const
+{
+    if (size > d->size - d->offset)
+        return 0;
+
+    *buf = d->mem + d->offset;
+    d->offset += size;
+    return size;
+}
+#endif // NCNN_STDIO
+
 #if NCNN_PLATFORM_API
 #if __ANDROID_API__ >= 9
 class DataReaderFromAndroidAssetPrivate
@@ -82,6 +82,31 @@ private:
     DataReaderFromMemoryPrivate* const d;
 };
 
+#if NCNN_STDIO
+class DataReaderFromMmapPrivate;
+class NCNN_EXPORT DataReaderFromMmap : public DataReader
+{
+public:
+    // map the whole file with copy-on-write pages
+    // the mapping is shared among processes until any page gets written
+    explicit DataReaderFromMmap(const char* filepath);
+    virtual ~DataReaderFromMmap();
+
+    // return true if the file is mapped
+    bool mapped() const;
+
+    virtual size_t read(void* buf, size_t size) const;
+    virtual size_t reference(size_t size, const void** buf) const;
+
+private:
+    DataReaderFromMmap(const DataReaderFromMmap&);
+    DataReaderFromMmap& operator=(const DataReaderFromMmap&);
+
+private:
+    DataReaderFromMmapPrivate* const d;
+};
+#endif // NCNN_STDIO
+
 #if NCNN_PLATFORM_API
 #if __ANDROID_API__ >= 9
 class DataReaderFromAndroidAssetPrivate;
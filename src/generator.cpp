@@ -0,0 +1,762 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "generator.h"
+
+#include "kvcache.h"
+#include "layer_type.h"
+#include "net.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace ncnn {
+
+GenerateOption::GenerateOption()
+{
+    max_new_tokens = 64;
+    eos_token = -1;
+    temperature = 0.f;
+    top_k = 0;
+    top_p = 1.f;
+    seed = 7767517;
+    num_draft_tokens = 4;
+}
+
+// one decoder net with the kv cache of its attention layers
+class GeneratorModel
+{
+public:
+    GeneratorModel();
+
+    int load(const Net* net, int input_ids, int logits, int positions, int attn_mask);
+
+    // run tokens[seqlen, end) and take the logits of them
+    // nets without kv cache run the whole sequence every time
+    int forward(const std::vector<int>& tokens, int end, int capacity, Mat& logits);
+
+    void truncate(int seqlen);
+
+public:
+    const Net* net;
+    int input_ids;
+    int logits;
+    int positions;
+    int attn_mask;
+
+    // blob indexes of every SDPA layer with kv_cache=1
+    std::vector<int> past_keys;
+    std::vector<int> past_values;
+    std::vector<int> keys;
+    std::vector<int> values;
+
+    std::vector<KVCache> caches;
+
+    // number of tokens in the caches
+    int seqlen;
+};
+
+GeneratorModel::GeneratorModel()
+{
+    net = 0;
+    input_ids = -1;
+    logits = -1;
+    positions = -1;
+    attn_mask = -1;
+    seqlen = 0;
+}
+
+int GeneratorModel::load(const Net* _net, int _input_ids, int _logits, int _positions, int _attn_mask)
+{
+    const int blob_count = (int)_net->blobs().size();
+    if (_input_ids < 0 || _input_ids >= blob_count || _logits < 0 || _logits >= blob_count || _positions >= blob_count || _attn_mask >= blob_count)
+    {
+        NCNN_LOGE("Generator invalid blob index input_ids=%d logits=%d positions=%d attn_mask=%d", _input_ids, _logits, _positions, _attn_mask);
+        return -1;
+    }
+
+    net = _net;
+    input_ids = _input_ids;
+    logits = _logits;
+    positions = _positions;
+    attn_mask = _attn_mask;
+
+    past_keys.clear();
+    past_values.clear();
+    keys.clear();
+    values.clear();
+
+    const std::vector<Layer*>& layers = net->layers();
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const Layer* sdpa = layers[i];
+        if (sdpa->typeindex != LayerType::SDPA)
+            continue;
+
+        // kv_cache=1 has key and value as extra outputs
+        const size_t input_count = sdpa->bottoms.size();
+        if (sdpa->tops.size() != 3)
+            continue;
+
+        past_keys.push_back(sdpa->bottoms[input_count - 2]);
+        past_values.push_back(sdpa->bottoms[input_count - 1]);
+        keys.push_back(sdpa->tops[1]);
+        values.push_back(sdpa->tops[2]);
+    }
+
+    caches.clear();
+    caches.resize(keys.size());
+    seqlen = 0;
+
+    return 0;
+}
+
+int GeneratorModel::forward(const std::vector<int>& tokens, int end, int capacity, Mat& out_logits)
+{
+    const int past = caches.empty() ? 0 : seqlen;
+    const int count = end - past;
+
+    Extractor ex = net->create_extractor();
+
+    Mat ids(count, (size_t)4u);
+    {
+        int* p = ids;
+        for (int i = 0; i < count; i++)
+        {
+            p[i] = tokens[past + i];
+        }
+    }
+    ex.input(input_ids, ids);
+
+    if (positions != -1)
+    {
+        Mat pos(count, (size_t)4u);
+        int* p = pos;
+        for (int i = 0; i < count; i++)
+        {
+            p[i] = past + i;
+        }
+        ex.input(positions, pos);
+    }
+
+    if (attn_mask != -1)
+    {
+        Mat mask(past + count, count);
+        for (int i = 0; i < count; i++)
+        {
+            float* p = mask.row(i);
+            for (int j = 0; j < past + count; j++)
+            {
+                p[j] = j > past + i ? -FLT_MAX : 0.f;
+            }
+        }
+        ex.input(attn_mask, mask);
+    }
+
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        ex.input(past_keys[i], caches[i].key());
+        ex.input(past_values[i], caches[i].value());
+    }
+
+    int ret = ex.extract(logits, out_logits);
+    if (ret != 0)
+        return ret;
+
+    // extract every layer before touching the caches so that a failure leaves them unchanged
+    std::vector<Mat> new_keys(caches.size());
+    std::vector<Mat> new_values(caches.size());
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        ret = ex.extract(keys[i], new_keys[i]);
+        if (ret != 0)
+            return ret;
+
+        ret = ex.extract(values[i], new_values[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        const Mat& key = new_keys[i];
+        const Mat& value = new_values[i];
+
+        KVCache& cache = caches[i];
+        if (cache.capacity == 0)
+        {
+            // size the storage for the whole generation upfront
+            ret = cache.reserve(key.w, value.w, key.c, std::max(capacity, key.h));
+            if (ret != 0)
+                return ret;
+        }
+
+        ret = cache.update(key, value);
+        if (ret != 0)
+            return ret;
+    }
+
+    seqlen = end;
+
+    return 0;
+}
+
+void GeneratorModel::truncate(int _seqlen)
+{
+    if (_seqlen >= seqlen)
+        return;
+
+    for (size_t i = 0; i < caches.size(); i++)
+    {
+        caches[i].truncate(_seqlen);
+    }
+
+    seqlen = _seqlen;
+}
+
+struct TokenProb
+{
+    float prob;
+    int id;
+};
+
+static void qsort_descent_inplace(TokenProb* v, int left, int right)
+{
+    int i = left;
+    int j = right;
+    float p = v[(left + right) / 2].prob;
+
+    while (i <= j)
+    {
+        while (v[i].prob > p)
+            i++;
+
+        while (v[j].prob < p)
+            j--;
+
+        if (i <= j)
+        {
+            TokenProb t = v[i];
+            v[i] = v[j];
+            v[j] = t;
+
+            i++;
+            j--;
+        }
+    }
+
+    if (left < j) qsort_descent_inplace(v, left, j);
+    if (i < right) qsort_descent_inplace(v, i, right);
+}
+
+// move the k most probable tokens to the front in no particular order
+static void select_top_k(TokenProb* v, int n, int k)
+{
+    int left = 0;
+    int right = n - 1;
+    while (left < right)
+    {
+        int i = left;
+        int j = right;
+        float p = v[(left + right) / 2].prob;
+
+        while (i <= j)
+        {
+            while (v[i].prob > p)
+                i++;
+
+            while (v[j].prob < p)
+                j--;
+
+            if (i <= j)
+            {
+                TokenProb t = v[i];
+                v[i] = v[j];
+                v[j] = t;
+
+                i++;
+                j--;
+            }
+        }
+
+        if (k - 1 <= j)
+            right = j;
+        else if (k - 1 >= i)
+            left = i;
+        else
+            break;
+    }
+}
+
+class GeneratorPrivate
+{
+public:
+    GeneratorPrivate();
+
+    int argmax(const float* logits) const;
+
+    // probabilities after temperature, top-k and top-p, zero for dropped tokens
+    void compute_probs(const float* logits, const GenerateOption& opt, float* probs);
+
+    // pick a token proportionally to probs
+    int draw(const float* probs, float sum);
+
+    int sample(const float* logits, const GenerateOption& opt, float* probs);
+
+    float rand_uniform();
+
+    int check_logits(const Mat& m, int rows) const;
+
+    GeneratorModel model;
+    GeneratorModel draft;
+    bool has_draft;
+
+    std::vector<int> tokens;
+
+    int vocab;
+    unsigned int rng;
+
+    int forward_count;
+    int draft_count;
+    int accept_count;
+
+    // scratch
+    std::vector<TokenProb> candidates;
+    std::vector<float> probs;
+    Mat draft_probs;
+};
+
+GeneratorPrivate::GeneratorPrivate()
+{
+    has_draft = false;
+    vocab = 0;
+    rng = 0;
+    forward_count = 0;
+    draft_count = 0;
+    accept_count = 0;
+}
+
+int GeneratorPrivate::argmax(const float* logits) const
+{
+    int id = 0;
+    for (int i = 1; i < vocab; i++)
+    {
+        if (logits[i] > logits[id])
+            id = i;
+    }
+
+    return id;
+}
+
+void GeneratorPrivate::compute_probs(const float* logits, const GenerateOption& opt, float* p)
+{
+    float max = logits[argmax(logits)];
+
+    const float inv_temperature = 1.f / opt.temperature;
+    for (int i = 0; i < vocab; i++)
+    {
+        p[i] = expf((logits[i] - max) * inv_temperature);
+    }
+
+    const bool use_top_k = opt.top_k > 0 && opt.top_k < vocab;
+    const bool use_top_p = opt.top_p > 0.f && opt.top_p < 1.f;
+
+    if (use_top_k || use_top_p)
+    {
+        candidates.resize(vocab);
+        TokenProb* v = candidates.data();
+        for (int i = 0; i < vocab; i++)
+        {
+            v[i].prob = p[i];
+            v[i].id = i;
+        }
+
+        int count = vocab;
+        if (use_top_k)
+        {
+            select_top_k(v, vocab, opt.top_k);
+            count = opt.top_k;
+        }
+
+        if (use_top_p)
+        {
+            qsort_descent_inplace(v, 0, count - 1);
+
+            float total = 0.f;
+            for (int i = 0; i < count; i++)
+            {
+                total += v[i].prob;
+            }
+
+            float cumsum = 0.f;
+            for (int i = 0; i < count; i++)
+            {
+                cumsum += v[i].prob;
+                if (cumsum >= total * opt.top_p)
+                {
+                    count = i + 1;
+                    break;
+                }
+            }
+        }
+
+        for (int i = 0; i < vocab; i++)
+        {
+            p[i] = 0.f;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            p[v[i].id] = v[i].prob;
+        }
+    }
+
+    float sum = 0.f;
+    for (int i = 0; i < vocab; i++)
+    {
+        sum += p[i];
+    }
+
+    const float inv_sum = 1.f / sum;
+    for (int i = 0; i < vocab; i++)
+    {
+        p[i] *= inv_sum;
+    }
+}
+
+int GeneratorPrivate::draw(const float* p, float sum)
+{
+    const float r = rand_uniform() * sum;
+
+    int last = 0;
+    float cumsum = 0.f;
+    for (int i = 0; i < vocab; i++)
+    {
+        if (p[i] == 0.f)
+            continue;
+
+        cumsum += p[i];
+        if (r < cumsum)
+            return i;
+
+        last = i;
+    }
+
+    // rounding left r beyond the total
+    return last;
+}
+
+int GeneratorPrivate::sample(const float* logits, const GenerateOption& opt, float* p)
+{
+    if (opt.temperature <= 0.f)
+        return argmax(logits);
+
+    compute_probs(logits, opt, p);
+    return draw(p, 1.f);
+}
+
+float GeneratorPrivate::rand_uniform()
+{
+    // xorshift32
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (rng >> 8) * (1.f / 16777216.f);
+}
+
+int GeneratorPrivate::check_logits(const Mat& m, int rows) const
+{
+    if (m.elempack != 1 || m.elemsize != 4u || (m.dims != 1 && m.dims != 2))
+    {
+        NCNN_LOGE("Generator expects fp32 logits of w=vocab h=count");
+        return -1;
+    }
+
+    if (m.w != vocab)
+    {
+        NCNN_LOGE("Generator logits vocab %d mismatch %d", m.w, vocab);
+        return -1;
+    }
+
+    if (m.h < rows)
+    {
+        NCNN_LOGE("Generator needs logits of the last %d tokens but got %d", rows, m.h);
+        return -1;
+    }
+
+    return 0;
+}
+
+Generator::Generator()
+    : d(new GeneratorPrivate)
+{
+}
+
+Generator::~Generator()
+{
+    delete d;
+}
+
+Generator::Generator(const Generator&)
+    : d(0)
+{
+}
+
+Generator& Generator::operator=(const Generator&)
+{
+    return *this;
+}
+
+#if NCNN_STRING
+static int find_blob_index(const Net* net, const char* name)
+{
+    const std::vector<Blob>& blobs = net->blobs();
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        if (strcmp(blobs[i].name.c_str(), name) == 0)
+            return (int)i;
+    }
+
+    NCNN_LOGE("Generator find_blob_index %s failed", name);
+    return -1;
+}
+
+int Generator::load(const Net* net, const char* input_ids, const char* logits, const char* positions, const char* attn_mask)
+{
+    return load(net, find_blob_index(net, input_ids), find_blob_index(net, logits), positions ? find_blob_index(net, positions) : -1, attn_mask ? find_blob_index(net, attn_mask) : -1);
+}
+
+int Generator::load_draft(const Net* net, const char* input_ids, const char* logits, const char* positions, const char* attn_mask)
+{
+    return load_draft(net, find_blob_index(net, input_ids), find_blob_index(net, logits), positions ? find_blob_index(net, positions) : -1, attn_mask ? find_blob_index(net, attn_mask) : -1);
+}
+#endif // NCNN_STRING
+
+int Generator::load(const Net* net, int input_ids, int logits, int positions, int attn_mask)
+{
+    clear();
+    return d->model.load(net, input_ids, logits, positions, attn_mask);
+}
+
+int Generator::load_draft(const Net* net, int input_ids, int logits, int positions, int attn_mask)
+{
+    clear();
+
+    int ret = d->draft.load(net, input_ids, logits, positions, attn_mask);
+    d->has_draft = ret == 0;
+    return ret;
+}
+
+void Generator::clear()
+{
+    d->model.truncate(0);
+    d->draft.truncate(0);
+    d->tokens.clear();
+    d->vocab = 0;
+    d->forward_count = 0;
+    d->draft_count = 0;
+    d->accept_count = 0;
+}
+
+int Generator::generate(const std::vector<int>& prompt, std::vector<int>& output, const GenerateOption& opt)
+{
+    if (!d->model.net)
+    {
+        NCNN_LOGE("Generator has no net loaded");
+        return -1;
+    }
+
+    std::vector<int>& tokens = d->tokens;
+    tokens.insert(tokens.end(), prompt.begin(), prompt.end());
+
+    if (tokens.empty())
+    {
+        NCNN_LOGE("Generator needs a non-empty prompt");
+        return -1;
+    }
+
+    d->rng = opt.seed ? opt.seed : 1;
+
+    const bool speculative = d->has_draft && opt.num_draft_tokens > 0;
+    const int num_draft_tokens = speculative ? opt.num_draft_tokens : 0;
+    const int capacity = (int)tokens.size() + opt.max_new_tokens + num_draft_tokens + 1;
+
+    GeneratorModel& model = d->model;
+    GeneratorModel& draft = d->draft;
+
+    int produced = 0;
+    while (produced < opt.max_new_tokens)
+    {
+        const int committed = (int)tokens.size();
+
+        // leave room for the token the verification adds
+        const int k = std::min(num_draft_tokens, opt.max_new_tokens - produced - 1);
+
+        if (k == 0)
+        {
+            Mat logits;
+            int ret = model.forward(tokens, committed, capacity, logits);
+            if (ret != 0)
+                return ret;
+
+            d->forward_count++;
+
+            if (d->vocab == 0)
+            {
+                d->vocab = logits.w;
+                d->probs.resize(d->vocab);
+            }
+
+            ret = d->check_logits(logits, 1);
+            if (ret != 0)
+                return ret;
+
+            const int token = d->sample(logits.row(logits.h - 1), opt, d->probs.data());
+            tokens.push_back(token);
+            output.push_back(token);
+            produced++;
+
+            if (token == opt.eos_token)
+                break;
+
+            continue;
+        }
+
+        // draft proposes k tokens
+        for (int i = 0; i < k; i++)
+        {
+            Mat logits;
+            int ret = draft.forward(tokens, committed + i, capacity, logits);
+            if (ret != 0)
+                return ret;
+
+            if (d->vocab == 0)
+            {
+                d->vocab = logits.w;
+                d->probs.resize(d->vocab);
+            }
+
+            ret = d->check_logits(logits, 1);
+            if (ret != 0)
+                return ret;
+
+            if (d->draft_probs.w != d->vocab || d->draft_probs.h < num_draft_tokens)
+                d->draft_probs.create(d->vocab, num_draft_tokens);
+
+            tokens.push_back(d->sample(logits.row(logits.h - 1), opt, d->draft_probs.row(i)));
+        }
+
+        // verify all of them in one pass
+        Mat logits;
+        int ret = model.forward(tokens, committed + k, capacity, logits);
+        if (ret != 0)
+            return ret;
+
+        d->forward_count++;
+        d->draft_count += k;
+
+        ret = d->check_logits(logits, k + 1);
+        if (ret != 0)
+            return ret;
+
+        const int row0 = logits.h - (k + 1);
+        float* p = d->probs.data();
+
+        int accepted = 0;
+        int token = -1;
+        for (; accepted < k; accepted++)
+        {
+            const float* row = logits.row(row0 + accepted);
+            const int proposal = tokens[committed + accepted];
+
+            if (opt.temperature <= 0.f)
+            {
+                token = d->argmax(row);
+                if (token != proposal)
+                    break;
+
+                continue;
+            }
+
+            // accept with probability min(1, p / q)
+            d->compute_probs(row, opt, p);
+            const float* q = d->draft_probs.row(accepted);
+            if (d->rand_uniform() * q[proposal] < p[proposal])
+                continue;
+
+            // otherwise sample from the residual max(0, p - q)
+            float sum = 0.f;
+            for (int j = 0; j < d->vocab; j++)
+            {
+                p[j] = std::max(p[j] - q[j], 0.f);
+                sum += p[j];
+            }
+
+            if (sum > 0.f)
+                token = d->draw(p, sum);
+            else
+                token = d->sample(row, opt, p);
+            break;
+        }
+
+        if (accepted == k)
+        {
+            // every proposal accepted, the last row gives one more token for free
+            token = d->sample(logits.row(row0 + k), opt, p);
+        }
+
+        d->accept_count += accepted;
+
+        tokens.resize(committed + accepted);
+        tokens.push_back(token);
+
+        // roll back the caches over the rejected proposals
+        model.truncate(committed + accepted);
+        draft.truncate(committed + accepted);
+
+        bool eos = false;
+        for (int i = committed; i < (int)tokens.size(); i++)
+        {
+            output.push_back(tokens[i]);
+            produced++;
+
+            if (tokens[i] == opt.eos_token)
+            {
+                tokens.resize(i + 1);
+                eos = true;
+                break;
+            }
+        }
+
+        if (eos)
+        {
+            model.truncate((int)tokens.size());
+            draft.truncate((int)tokens.size());
+            break;
+        }
+    }
+
+    return 0;
+}
+
+const std::vector<int>& Generator::tokens() const
+{
+    return d->tokens;
+}
+
+int Generator::forward_count() const
+{
+    return d->forward_count;
+}
+
+int Generator::draft_count() const
+{
+    return d->draft_count;
+}
+
+int Generator::accept_count() const
+{
+    return d->accept_count;
+}
+
+} // namespace ncnn
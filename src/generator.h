@@ -0,0 +1,100 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NCNN_GENERATOR_H
+#define NCNN_GENERATOR_H
+
+#include "mat.h"
+#include "platform.h"
+
+namespace ncnn {
+
+class Net;
+
+class NCNN_EXPORT GenerateOption
+{
+public:
+    GenerateOption();
+
+    // stop after this many new tokens
+    int max_new_tokens;
+
+    // stop after emitting this token, -1 to disable
+    int eos_token;
+
+    // 0 picks the most probable token
+    float temperature;
+
+    // sample among the k most probable tokens, 0 to disable
+    int top_k;
+
+    // sample among the most probable tokens whose probabilities add up to p, 1 to disable
+    float top_p;
+
+    unsigned int seed;
+
+    // tokens proposed by the draft model per verification step
+    int num_draft_tokens;
+};
+
+// drives the token loop of decoder-only nets
+//
+// the net takes int32 token ids of w=count and produces logits of w=vocab and
+// h=count, or only the row of the last token, an optional int32 blob takes the
+// absolute positions of the tokens and an optional attention mask blob takes a
+// causal mask of w=past+count h=count
+// every SDPA layer with kv_cache=1 is found automatically, its past key and
+// value are fed from a KVCache that is extended in place step by step
+//
+// with a draft model sharing the vocabulary, the draft proposes tokens one by one
+// and the net verifies all of them in a single forward pass, the caches of both
+// roll back over rejected tokens, greedy decoding yields exactly the tokens of
+// the net alone and sampling keeps its distribution
+// the net must output the logits of every token for verification
+class GeneratorPrivate;
+class NCNN_EXPORT Generator
+{
+public:
+    Generator();
+    ~Generator();
+
+#if NCNN_STRING
+    // blob names of the net, positions and attn_mask may be null
+    // return 0 if success
+    int load(const Net* net, const char* input_ids, const char* logits, const char* positions = 0, const char* attn_mask = 0);
+    int load_draft(const Net* net, const char* input_ids, const char* logits, const char* positions = 0, const char* attn_mask = 0);
+#endif // NCNN_STRING
+
+    // blob indexes of the net, positions and attn_mask may be -1
+    // return 0 if success
+    int load(const Net* net, int input_ids, int logits, int positions = -1, int attn_mask = -1);
+    int load_draft(const Net* net, int input_ids, int logits, int positions = -1, int attn_mask = -1);
+
+    // forget all tokens, the next generate starts a new sequence
+    void clear();
+
+    // append prompt to the sequence and generate new tokens after it
+    // new tokens are appended to output and stay in the sequence, so a following
+    // generate continues the conversation
+    // return 0 if success
+    int generate(const std::vector<int>& prompt, std::vector<int>& output, const GenerateOption& opt);
+
+    // tokens of the sequence so far
+    const std::vector<int>& tokens() const;
+
+    // forward passes of the net and draft tokens proposed and accepted, since clear()
+    int forward_count() const;
+    int draft_count() const;
+    int accept_count() const;
+
+private:
+    Generator(const Generator&);
+    Generator& operator=(const Generator&);
+
+private:
+    GeneratorPrivate* const d;
+};
+
+} // namespace ncnn
+
+#endif // NCNN_GENERATOR_H
@@ -0,0 +1,548 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "kvcache.h"
+
+#include <string.h>
+
+namespace ncnn {
+
+static bool kvcache_has_room(const Mat& past, const Mat& cur)
+{
+    if (past.data == 0 || past.dims != 3 || past.elempack != 1)
+        return false;
+
+    if (past.w != cur.w || past.c != cur.c || past.elemsize != cur.elemsize)
+        return false;
+
+    // a plain blob has at most alignment padding after its rows
+    const size_t elemsize = past.elemsize;
+    const size_t cstep_plain = alignSize((size_t)past.w * past.h * elemsize, 16) / elemsize;
+    if (past.cstep <= cstep_plain)
+        return false;
+
+    return past.cstep >= (size_t)past.w * (past.h + cur.h);
+}
+
+static void kvcache_copy_rows(const Mat& src, Mat& dst, int row_offset, int num_threads)
+{
+    // rows of dst width
+    const size_t size = (size_t)dst.w * src.h * src.elemsize;
+
+    #pragma omp parallel for num_threads(num_threads)
+    for (int q = 0; q < src.c; q++)
+    {
+        Mat dst_head = dst.channel(q);
+        memcpy(dst_head.row<unsigned char>(row_offset), src.channel(q), size);
+    }
+}
+
+KVCache::KVCache()
+{
+    seqlen = 0;
+    capacity = 0;
+    allocator = 0;
+}
+
+int KVCache::reserve(int embed_dim, int out_embed_dim, int num_group, int _capacity, Allocator* _allocator)
+{
+    allocator = _allocator;
+
+    key_storage.create(embed_dim, _capacity, num_group, 4u, allocator);
+    if (key_storage.empty())
+        return -100;
+
+    value_storage.create(out_embed_dim, _capacity, num_group, 4u, allocator);
+    if (value_storage.empty())
+        return -100;
+
+    seqlen = 0;
+    capacity = _capacity;
+
+    return 0;
+}
+
+void KVCache::release()
+{
+    key_storage.release();
+    value_storage.release();
+
+    seqlen = 0;
+    capacity = 0;
+}
+
+void KVCache::truncate(int _seqlen)
+{
+    if (_seqlen < seqlen)
+        seqlen = _seqlen < 0 ? 0 : _seqlen;
+}
+
+int KVCache::update(const Mat& key, const Mat& value)
+{
+    if (key.h != value.h)
+    {
+        NCNN_LOGE("KVCache key seqlen %d and value seqlen %d mismatch", key.h, value.h);
+        return -1;
+    }
+
+    // views into storage were appended in place
+    bool key_inplace = key.data == key_storage.data;
+    bool value_inplace = value.data == value_storage.data;
+
+    if (key.h > capacity || key.w != key_storage.w || key.c != key_storage.c || value.w != value_storage.w || key.elemsize != key_storage.elemsize)
+    {
+        const int new_capacity = std::max(capacity * 2, key.h);
+
+        Mat new_key_storage;
+        new_key_storage.create(key.w, new_capacity, key.c, key.elemsize, allocator);
+        if (new_key_storage.empty())
+            return -100;
+
+        Mat new_value_storage;
+        new_value_storage.create(value.w, new_capacity, value.c, value.elemsize, allocator);
+        if (new_value_storage.empty())
+            return -100;
+
+        // key and value still hold the old storage alive
+        key_storage = new_key_storage;
+        value_storage = new_value_storage;
+        capacity = new_capacity;
+
+        key_inplace = false;
+        value_inplace = false;
+    }
+
+    if (!key_inplace)
+        kvcache_copy_rows(key, key_storage, 0, 1);
+    if (!value_inplace)
+        kvcache_copy_rows(value, value_storage, 0, 1);
+
+    seqlen = key.h;
+
+    return 0;
+}
+
+Mat KVCache::key() const
+{
+    Mat m = key_storage;
+    m.h = seqlen;
+    return m;
+}
+
+Mat KVCache::value() const
+{
+    Mat m = value_storage;
+    m.h = seqlen;
+    return m;
+}
+
+class PagedKVCachePrivate
+{
+public:
+    int alloc_block();
+    void release_block(int block);
+    void copy_block(int src, int dst, int rows);
+    bool is_valid(int seq) const;
+
+    struct Sequence
+    {
+        bool alive;
+        int seqlen;
+        std::vector<int> blocks;
+    };
+
+    int block_size;
+    Mat key_pool;
+    Mat value_pool;
+
+    // number of sequences referring to each block, 0 for free blocks
+    std::vector<int> block_refcount;
+    std::vector<int> free_blocks;
+
+    std::vector<Sequence> sequences;
+
+    mutable Mutex lock;
+};
+
+int PagedKVCachePrivate::alloc_block()
+{
+    const int count = (int)free_blocks.size();
+    if (count == 0)
+        return -1;
+
+    const int block = free_blocks[count - 1];
+    free_blocks.resize(count - 1);
+
+    block_refcount[block] = 1;
+    return block;
+}
+
+void PagedKVCachePrivate::release_block(int block)
+{
+    block_refcount[block]--;
+    if (block_refcount[block] == 0)
+        free_blocks.push_back(block);
+}
+
+void PagedKVCachePrivate::copy_block(int src, int dst, int rows)
+{
+    for (int q = 0; q < key_pool.c; q++)
+    {
+        Mat key_head = key_pool.channel(q);
+        memcpy(key_head.row(dst * block_size), key_head.row(src * block_size), key_pool.w * rows * key_pool.elemsize);
+
+        Mat value_head = value_pool.channel(q);
+        memcpy(value_head.row(dst * block_size), value_head.row(src * block_size), value_pool.w * rows * value_pool.elemsize);
+    }
+}
+
+bool PagedKVCachePrivate::is_valid(int seq) const
+{
+    return seq >= 0 && seq < (int)sequences.size() && sequences[seq].alive;
+}
+
+PagedKVCache::PagedKVCache()
+    : d(new PagedKVCachePrivate)
+{
+    d->block_size = 0;
+}
+
+PagedKVCache::~PagedKVCache()
+{
+    delete d;
+}
+
+PagedKVCache::PagedKVCache(const PagedKVCache&)
+    : d(0)
+{
+}
+
+PagedKVCache& PagedKVCache::operator=(const PagedKVCache&)
+{
+    return *this;
+}
+
+int PagedKVCache::create(int embed_dim, int out_embed_dim, int num_group, int block_size, int num_blocks, Allocator* allocator)
+{
+    MutexLockGuard guard(d->lock);
+
+    d->key_pool.create(embed_dim, block_size * num_blocks, num_group, 4u, allocator);
+    if (d->key_pool.empty())
+        return -100;
+
+    d->value_pool.create(out_embed_dim, block_size * num_blocks, num_group, 4u, allocator);
+    if (d->value_pool.empty())
+        return -100;
+
+    d->block_size = block_size;
+    d->sequences.clear();
+    d->block_refcount.resize(num_blocks);
+    d->free_blocks.resize(num_blocks);
+    for (int i = 0; i < num_blocks; i++)
+    {
+        d->block_refcount[i] = 0;
+
+        // hand out low blocks first
+        d->free_blocks[i] = num_blocks - 1 - i;
+    }
+
+    return 0;
+}
+
+int PagedKVCache::add_sequence()
+{
+    MutexLockGuard guard(d->lock);
+
+    for (int i = 0; i < (int)d->sequences.size(); i++)
+    {
+        if (!d->sequences[i].alive)
+        {
+            d->sequences[i].alive = true;
+            d->sequences[i].seqlen = 0;
+            d->sequences[i].blocks.clear();
+            return i;
+        }
+    }
+
+    PagedKVCachePrivate::Sequence sequence;
+    sequence.alive = true;
+    sequence.seqlen = 0;
+    d->sequences.push_back(sequence);
+
+    return (int)d->sequences.size() - 1;
+}
+
+int PagedKVCache::fork_sequence(int seq)
+{
+    int new_seq = add_sequence();
+
+    MutexLockGuard guard(d->lock);
+
+    if (!d->is_valid(seq))
+    {
+        d->sequences[new_seq].alive = false;
+        return -1;
+    }
+
+    const PagedKVCachePrivate::Sequence& sequence = d->sequences[seq];
+    PagedKVCachePrivate::Sequence& new_sequence = d->sequences[new_seq];
+
+    new_sequence.seqlen = sequence.seqlen;
+    new_sequence.blocks = sequence.blocks;
+    for (size_t i = 0; i < new_sequence.blocks.size(); i++)
+    {
+        d->block_refcount[new_sequence.blocks[i]]++;
+    }
+
+    return new_seq;
+}
+
+void PagedKVCache::remove_sequence(int seq)
+{
+    MutexLockGuard guard(d->lock);
+
+    if (!d->is_valid(seq))
+        return;
+
+    PagedKVCachePrivate::Sequence& sequence = d->sequences[seq];
+    for (size_t i = 0; i < sequence.blocks.size(); i++)
+    {
+        d->release_block(sequence.blocks[i]);
+    }
+
+    sequence.alive = false;
+    sequence.seqlen = 0;
+    sequence.blocks.clear();
+}
+
+int PagedKVCache::prepare(int seq, int count, Mat& block_table)
+{
+    MutexLockGuard guard(d->lock);
+
+    if (!d->is_valid(seq))
+    {
+        NCNN_LOGE("PagedKVCache invalid sequence %d", seq);
+        return -1;
+    }
+
+    PagedKVCachePrivate::Sequence& sequence = d->sequences[seq];
+
+    const int tail_index = sequence.seqlen / d->block_size;
+    const int tail_rows = sequence.seqlen % d->block_size;
+    const bool copy_tail = tail_rows != 0 && count > 0 && d->block_refcount[sequence.blocks[tail_index]] > 1;
+
+    const int block_count = (sequence.seqlen + count + d->block_size - 1) / d->block_size;
+    const int old_block_count = (int)sequence.blocks.size();
+
+    // fail before touching the sequence when the free blocks are not enough
+    const int new_block_count = (copy_tail ? 1 : 0) + std::max(block_count - old_block_count, 0);
+    if (new_block_count > (int)d->free_blocks.size())
+        return -100;
+
+    block_table.create(2 + block_count, (size_t)4u);
+    if (block_table.empty())
+        return -100;
+
+    // copy on write for the shared tail block
+    if (copy_tail)
+    {
+        const int tail_block = sequence.blocks[tail_index];
+        const int block = d->alloc_block();
+        if (block < 0)
+            return -100;
+
+        d->copy_block(tail_block, block, tail_rows);
+        d->release_block(tail_block);
+        sequence.blocks[tail_index] = block;
+    }
+
+    while ((int)sequence.blocks.size() < block_count)
+    {
+        const int block = d->alloc_block();
+        if (block < 0)
+        {
+            // give back the blocks appended so far
+            for (int i = old_block_count; i < (int)sequence.blocks.size(); i++)
+            {
+                d->release_block(sequence.blocks[i]);
+            }
+            sequence.blocks.resize(old_block_count);
+            return -100;
+        }
+
+        sequence.blocks.push_back(block);
+    }
+
+    int* ptr = block_table;
+    ptr[0] = sequence.seqlen;
+    ptr[1] = d->block_size;
+    for (int i = 0; i < block_count; i++)
+    {
+        ptr[2 + i] = sequence.blocks[i];
+    }
+
+    return 0;
+}
+
+void PagedKVCache::advance(int seq, int count)
+{
+    MutexLockGuard guard(d->lock);
+
+    if (!d->is_valid(seq))
+        return;
+
+    PagedKVCachePrivate::Sequence& sequence = d->sequences[seq];
+    sequence.seqlen = std::min(sequence.seqlen + count, (int)sequence.blocks.size() * d->block_size);
+}
+
+void PagedKVCache::truncate(int seq, int seqlen)
+{
+    MutexLockGuard guard(d->lock);
+
+    if (!d->is_valid(seq))
+        return;
+
+    PagedKVCachePrivate::Sequence& sequence = d->sequences[seq];
+    if (seqlen >= sequence.seqlen)
+        return;
+
+    sequence.seqlen = std::max(seqlen, 0);
+
+    const int block_count = (sequence.seqlen + d->block_size - 1) / d->block_size;
+    for (int i = block_count; i < (int)sequence.blocks.size(); i++)
+    {
+        d->release_block(sequence.blocks[i]);
+    }
+    sequence.blocks.resize(block_count);
+}
+
+int PagedKVCache::seqlen(int seq) const
+{
+    MutexLockGuard guard(d->lock);
+
+    return d->is_valid(seq) ? d->sequences[seq].seqlen : 0;
+}
+
+int PagedKVCache::block_size() const
+{
+    return d->block_size;
+}
+
+int PagedKVCache::free_block_count() const
+{
+    MutexLockGuard guard(d->lock);
+
+    return (int)d->free_blocks.size();
+}
+
+Mat PagedKVCache::key_pool() const
+{
+    return d->key_pool;
+}
+
+Mat PagedKVCache::value_pool() const
+{
+    return d->value_pool;
+}
+
+int kvcache_append(const Mat& past, const Mat& cur, Mat& out, const Option& opt)
+{
+    const bool has_room = kvcache_has_room(past, cur);
+
+    const int past_seqlen = past.data ? past.h : 0;
+    if (past_seqlen == 0 && !has_room)
+    {
+        out = cur;
+        return 0;
+    }
+
+    if (has_room)
+    {
+        out = past;
+        out.h = past_seqlen + cur.h;
+
+        kvcache_copy_rows(cur, out, past_seqlen, opt.num_threads);
+        return 0;
+    }
+
+    out.create(past.w, past_seqlen + cur.h, cur.c, cur.elemsize, opt.blob_allocator);
+    if (out.empty())
+        return -100;
+
+    kvcache_copy_rows(past, out, 0, opt.num_threads);
+    kvcache_copy_rows(cur, out, past_seqlen, opt.num_threads);
+
+    return 0;
+}
+
+int kvcache_check_paged(const Mat& pool, const Mat& block_table, const Mat& cur)
+{
+    if (block_table.dims != 1 || block_table.elemsize != 4u || block_table.w < 2)
+    {
+        NCNN_LOGE("paged kvcache block table must be int32 with past_seqlen and block_size header");
+        return -1;
+    }
+
+    const int* table = block_table;
+    const int past_seqlen = table[0];
+    const int block_size = table[1];
+    const int block_count = block_table.w - 2;
+
+    if (past_seqlen < 0 || block_size <= 0 || pool.h % block_size != 0)
+    {
+        NCNN_LOGE("paged kvcache invalid past_seqlen %d block_size %d", past_seqlen, block_size);
+        return -1;
+    }
+
+    if (pool.w != cur.w || pool.c != cur.c || pool.elemsize != cur.elemsize || pool.elempack != 1)
+    {
+        NCNN_LOGE("paged kvcache pool does not match the new tokens");
+        return -1;
+    }
+
+    if (block_count != (past_seqlen + cur.h + block_size - 1) / block_size)
+    {
+        NCNN_LOGE("paged kvcache block table lists %d blocks for %d tokens", block_count, past_seqlen + cur.h);
+        return -1;
+    }
+
+    const int pool_block_count = pool.h / block_size;
+    for (int i = 0; i < block_count; i++)
+    {
+        const int block = table[2 + i];
+        if (block < 0 || block >= pool_block_count)
+        {
+            NCNN_LOGE("paged kvcache block %d out of pool range %d", block, pool_block_count);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void kvcache_write_paged(const Mat& pool, const Mat& block_table, const Mat& cur, const Option& opt)
+{
+    const int* table = block_table;
+    const int past_seqlen = table[0];
+    const int block_size = table[1];
+    const int* blocks = table + 2;
+
+    const size_t row_size = (size_t)cur.w * cur.elemsize;
+
+    // the pool is shared with the cache, new tokens land in their blocks
+    Mat pool_storage = pool;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < cur.c; q++)
+    {
+        const Mat cur_head = cur.channel(q);
+        Mat pool_head = pool_storage.channel(q);
+
+        for (int i = 0; i < cur.h; i++)
+        {
+            memcpy(pool_head.row<unsigned char>(kvcache_paged_row(blocks, block_size, past_seqlen + i)), cur_head.row<const unsigned char>(i), row_size);
+        }
+    }
+}
+
+} // namespace ncnn
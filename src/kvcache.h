@@ -0,0 +1,145 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NCNN_KVCACHE_H
+#define NCNN_KVCACHE_H
+
+#include "mat.h"
+#include "option.h"
+#include "platform.h"
+
+namespace ncnn {
+
+// key and value storage of one attention layer with capacity reserved along the sequence axis
+//
+// key() and value() return views of the cached tokens whose channel step spans the
+// whole capacity, an SDPA layer with kv_cache enabled writes the new tokens right
+// after them instead of copying the past into a fresh blob
+// the key and value blobs extracted after a decode step are views into the same
+// storage, hand them to update() and feed key() and value() to the next step
+//
+// the views of one cache must not be fed to two extractors running at the same time
+class NCNN_EXPORT KVCache
+{
+public:
+    KVCache();
+
+    // allocate room for capacity tokens, key is embed_dim x capacity x num_group
+    // and value is out_embed_dim x capacity x num_group, the cache starts empty
+    // return 0 if success
+    int reserve(int embed_dim, int out_embed_dim, int num_group, int capacity, Allocator* allocator = 0);
+
+    // release storage
+    void release();
+
+    // drop cached tokens from seqlen on, for rolling back rejected tokens
+    void truncate(int seqlen);
+
+    // take the key and value blobs produced by a step
+    // blobs that outgrew the capacity are copied into storage grown geometrically
+    // return 0 if success
+    int update(const Mat& key, const Mat& value);
+
+    // views of the cached tokens
+    Mat key() const;
+    Mat value() const;
+
+public:
+    // number of cached tokens
+    int seqlen;
+
+    // number of tokens the storage holds
+    int capacity;
+
+    Mat key_storage;
+    Mat value_storage;
+
+    Allocator* allocator;
+};
+
+// key and value blocks shared by many sequences
+//
+// the pools hold num_blocks blocks of block_size tokens, key pool is
+// embed_dim x (num_blocks * block_size) x num_group and value pool likewise
+// each sequence owns a block table, a forked sequence shares the blocks of its parent
+// and copies the partially filled tail block on its first append
+//
+// feed key_pool(), value_pool() and the block table from prepare() to an SDPA layer
+// with kv_cache=2, it writes the new tokens into their blocks and reads the past
+// through the table, then advance() the sequence by the tokens of that step
+//
+// the block table blob is int32 [past_seqlen, block_size, block0, block1, ...]
+class PagedKVCachePrivate;
+class NCNN_EXPORT PagedKVCache
+{
+public:
+    PagedKVCache();
+    ~PagedKVCache();
+
+    // allocate the block pools, all sequences are dropped
+    // return 0 if success
+    int create(int embed_dim, int out_embed_dim, int num_group, int block_size, int num_blocks, Allocator* allocator = 0);
+
+    // start an empty sequence
+    // return sequence id
+    int add_sequence();
+
+    // start a sequence sharing all cached tokens of seq, for common prompt prefixes
+    // return sequence id, -1 if seq is invalid
+    int fork_sequence(int seq);
+
+    // drop a sequence and release the blocks nobody else refers to
+    void remove_sequence(int seq);
+
+    // make room for count new tokens of seq and return its block table
+    // a shared tail block is copied before it gets written
+    // return 0 if success, -100 if the pool runs out of blocks
+    int prepare(int seq, int count, Mat& block_table);
+
+    // account count tokens written by the step that used the block table of prepare()
+    void advance(int seq, int count);
+
+    // drop tokens of seq from seqlen on, for rolling back rejected tokens
+    void truncate(int seq, int seqlen);
+
+    // number of cached tokens of seq
+    int seqlen(int seq) const;
+
+    int block_size() const;
+    int free_block_count() const;
+
+    Mat key_pool() const;
+    Mat value_pool() const;
+
+private:
+    PagedKVCache(const PagedKVCache&);
+    PagedKVCache& operator=(const PagedKVCache&);
+
+private:
+    PagedKVCachePrivate* const d;
+};
+
+// concat cur after past along h
+// past is extended in place when its channel step leaves room for the new rows,
+// out is then a view of the past storage
+// return 0 if success
+NCNN_EXPORT int kvcache_append(const Mat& past, const Mat& cur, Mat& out, const Option& opt);
+
+// check that block_table from PagedKVCache::prepare() covers the past tokens plus cur
+// and that every block it lists lies inside the pool
+// return 0 if valid, -1 otherwise
+NCNN_EXPORT int kvcache_check_paged(const Mat& pool, const Mat& block_table, const Mat& cur);
+
+// write cur into its blocks of the pool, the block table must pass kvcache_check_paged
+// attention reads the sequence in place through kvcache_paged_row
+NCNN_EXPORT void kvcache_write_paged(const Mat& pool, const Mat& block_table, const Mat& cur, const Option& opt);
+
+// pool row of token pos, blocks is the block table past its two header entries
+static inline int kvcache_paged_row(const int* blocks, int block_size, int pos)
+{
+    return blocks[pos / block_size] * block_size + pos % block_size;
+}
+
+} // namespace ncnn
+
+#endif // NCNN_KVCACHE_H
@@ -61,6 +61,16 @@ int Layer::destroy_pipeline(const Option& /*opt*/)
     return 0;
 }
 
+int Layer::save_pipeline_weights(std::vector<Mat>& /*weights*/) const
+{
+    return -1;
+}
+
+int Layer::load_pipeline_weights(const std::vector<Mat>& /*weights*/, const Option& /*opt*/)
+{
+    return -1;
+}
+
 int Layer::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
     if (!support_inplace)
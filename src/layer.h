@@ -41,6 +41,15 @@ public:
     // return 0 if success
     virtual int destroy_pipeline(const Option& opt);
 
+    // export the weights transformed in create_pipeline for the weight cache
+    // return 0 if success, -1 if not supported
+    virtual int save_pipeline_weights(std::vector<Mat>& weights) const;
+
+    // layer implementation specific setup from the weights of save_pipeline_weights
+    // called instead of create_pipeline when the weight cache matches
+    // return 0 if success
+    virtual int load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt);
+
 public:
     // one input and one output blob
     bool one_blob_only;
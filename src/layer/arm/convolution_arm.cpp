@@ -470,7 +470,7 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         // NCNN_LOGE("prefer_winograd %d %d %d", prefer_winograd23, prefer_winograd43, prefer_winograd63);
 
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
+        if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
         {
             // force num_threads the same as in create_pipeline
             // so we could use pre-packed A/B from the same tile config
@@ -544,7 +544,7 @@ int Convolution_arm::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
     {
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
+        if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
         {
             // force num_threads the same as in create_pipeline
             // so we could use pre-packed A/B from the same tile config
@@ -1059,7 +1059,7 @@ int Convolution_arm::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const
         // NCNN_LOGE("prefer_winograd %d %d %d", prefer_winograd23, prefer_winograd43, prefer_winograd63);
 
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
+        if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
         {
             // force num_threads the same as in create_pipeline
             // so we could use pre-packed A/B from the same tile config
@@ -1133,7 +1133,7 @@ int Convolution_arm::forward_bf16s(const Mat& bottom_blob, Mat& top_blob, const
     if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
     {
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
+        if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
         {
             // force num_threads the same as in create_pipeline
             // so we could use pre-packed A/B from the same tile config
@@ -1391,7 +1391,7 @@ int Convolution_arm::forward_int8_arm(const Mat& bottom_blob, Mat& top_blob, con
         return -100;
 
     int _nT = nT ? nT : opt.num_threads;
-    if (nT != 0 && opt.num_threads != nT)
+    if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
     {
         // force num_threads the same as in create_pipeline
         // so we could use pre-packed A/B from the same tile config
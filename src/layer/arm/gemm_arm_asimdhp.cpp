@@ -2976,7 +2976,7 @@ int Gemm_arm::forward_fp16sa(const std::vector<Mat>& bottom_blobs, std::vector<M
         return -100;
 
     int _nT = nT ? nT : opt.num_threads;
-    if (nT != 0 && opt.num_threads != nT)
+    if (nT != 0 && opt.num_threads != nT && !opt.use_branch_parallel && !opt.use_cpu_partition)
     {
         // force num_threads the same as in create_pipeline
         // so we could use pre-packed A/B from the same tile config
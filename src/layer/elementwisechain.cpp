@@ -0,0 +1,90 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "elementwisechain.h"
+
+namespace ncnn {
+
+ElementwiseChain::ElementwiseChain()
+{
+    one_blob_only = true;
+    support_inplace = true;
+}
+
+ElementwiseChain::~ElementwiseChain()
+{
+    if (!chain.empty())
+        delete chain[chain.size() - 1];
+}
+
+int ElementwiseChain::create_pipeline(const Option& /*opt*/)
+{
+    if (chain.empty())
+        return 0;
+
+    // tiles are flat views, the packing layout does not matter
+    support_packing = true;
+    support_any_packing = true;
+
+    support_bf16_storage = true;
+    support_fp16_storage = true;
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        support_bf16_storage = support_bf16_storage && chain[i]->support_bf16_storage;
+        support_fp16_storage = support_fp16_storage && chain[i]->support_fp16_storage;
+    }
+
+    featmask = chain[0]->featmask;
+
+    return 0;
+}
+
+int ElementwiseChain::destroy_pipeline(const Option& opt)
+{
+    if (chain.empty())
+        return 0;
+
+    return chain[chain.size() - 1]->destroy_pipeline(opt);
+}
+
+int ElementwiseChain::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+{
+    const size_t elemsize = bottom_top_blob.elemsize / bottom_top_blob.elempack;
+    const int size = bottom_top_blob.w * bottom_top_blob.h * bottom_top_blob.d * bottom_top_blob.elempack;
+
+    // treat the whole blob as one span when there is no channel gap
+    const bool contiguous = bottom_top_blob.cstep == (size_t)bottom_top_blob.w * bottom_top_blob.h * bottom_top_blob.d;
+    const int channels = contiguous ? 1 : bottom_top_blob.c;
+    const int channel_size = contiguous ? size * bottom_top_blob.c : size;
+
+    // 16k bytes per tile stays in l1 on every thread
+    const int tile_size = (int)(16384 / elemsize);
+    const int tile_count = (channel_size + tile_size - 1) / tile_size;
+
+    Option opt1 = opt;
+    opt1.num_threads = 1;
+
+    int ret = 0;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < channels * tile_count; t++)
+    {
+        const int q = t / tile_count;
+        const int i = t % tile_count * tile_size;
+        const int n = std::min(tile_size, channel_size - i);
+
+        unsigned char* ptr = (unsigned char*)bottom_top_blob.data + bottom_top_blob.cstep * q * bottom_top_blob.elemsize + i * elemsize;
+        Mat tile(n, ptr, elemsize, 1);
+
+        for (size_t j = 0; j < chain.size(); j++)
+        {
+            int lret = chain[j]->forward_inplace(tile, opt1);
+            if (lret != 0)
+                ret = lret;
+        }
+    }
+
+    return ret;
+}
+
+} // namespace ncnn
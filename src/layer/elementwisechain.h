@@ -0,0 +1,34 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef LAYER_ELEMENTWISECHAIN_H
+#define LAYER_ELEMENTWISECHAIN_H
+
+#include "layer.h"
+
+namespace ncnn {
+
+// elementwise layers evaluated back to back on cache sized tiles
+// every tile makes one trip through memory instead of one per layer
+// built by the net at load time, there is nothing to load from param
+class ElementwiseChain : public Layer
+{
+public:
+    ElementwiseChain();
+    virtual ~ElementwiseChain();
+
+    virtual int create_pipeline(const Option& opt);
+
+    virtual int destroy_pipeline(const Option& opt);
+
+    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
+
+public:
+    // the fused layers in order, their pipelines are created already
+    // the other layers stay in the net for their own top blobs, the chain owns the last one only
+    std::vector<Layer*> chain;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_ELEMENTWISECHAIN_H
@@ -3,6 +3,8 @@
 
 #include "gemm.h"
 
+#include "cpu.h"
+
 namespace ncnn {
 
 Gemm::Gemm()
@@ -32,6 +34,8 @@ int Gemm::load_param(const ParamDict& pd)
     constant_TILE_M = pd.get(20, 0);
     constant_TILE_N = pd.get(21, 0);
     constant_TILE_K = pd.get(22, 0);
+    weight_quant_bits = pd.get(23, 0);
+    weight_quant_group_size = pd.get(24, 32);
 
     if (int8_scale_term)
     {
@@ -41,6 +45,27 @@ int Gemm::load_param(const ParamDict& pd)
 #endif
     }
 
+    if (weight_quant_bits)
+    {
+        if (weight_quant_bits != 4 && weight_quant_bits != 8)
+        {
+            NCNN_LOGE("weight_quant_bits must be 4 or 8 but got %d", weight_quant_bits);
+            return -1;
+        }
+
+        if (weight_quant_group_size <= 0 || weight_quant_group_size % 2 != 0)
+        {
+            NCNN_LOGE("weight_quant_group_size must be positive and even but got %d", weight_quant_group_size);
+            return -1;
+        }
+
+        if (int8_scale_term || constantA || constantB == 0 || transA || transB == 0 || output_transpose)
+        {
+            NCNN_LOGE("weight_quant_bits requires constantB=1 transB=1 and no int8_scale_term constantA transA output_transpose");
+            return -1;
+        }
+    }
+
     if (constantA == 1 && (constantM == 0 || constantK == 0))
     {
         NCNN_LOGE("constantM and constantK must be non-zero when constantA enabled");
@@ -83,7 +108,22 @@ int Gemm::load_model(const ModelBin& mb)
             return -100;
     }
 
-    if (constantB == 1)
+    if (constantB == 1 && weight_quant_bits)
+    {
+        // int4 packs two K per byte, low nibble first, each N row padded to whole bytes
+        const int B_row_bytes = weight_quant_bits == 4 ? (constantK + 1) / 2 : constantK;
+
+        B_data = mb.load(B_row_bytes, constantN, 0);
+        if (B_data.empty())
+            return -100;
+
+        if (B_data.elemsize != 1)
+        {
+            NCNN_LOGE("weight-only quantized B_data must be stored as int8");
+            return -1;
+        }
+    }
+    else if (constantB == 1)
     {
         if (transB == 0)
             B_data = mb.load(constantN, constantK, 0);
@@ -109,6 +149,15 @@ int Gemm::load_model(const ModelBin& mb)
             return -100;
     }
 
+    if (weight_quant_bits)
+    {
+        // fp32 or fp16 tagged
+        const int num_group = (constantK + weight_quant_group_size - 1) / weight_quant_group_size;
+        B_data_quant_scales = mb.load(num_group * constantN, 0);
+        if (B_data_quant_scales.empty())
+            return -100;
+    }
+
 #if NCNN_INT8
     if (int8_scale_term)
     {
@@ -194,6 +243,85 @@ static void gemm_transB(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob
     }
 }
 
+static int gemm_transB_weight_only(const Mat& A, const Mat& BT_quant, const Mat& BT_quant_scales, int weight_quant_bits, int weight_quant_group_size, const Mat& C, Mat& top_blob, float alpha, float beta, int broadcast_type_C, const Option& opt)
+{
+    const int M = A.dims == 3 ? A.c : A.h;
+    const int N = BT_quant.h;
+    const int K = A.w;
+
+    const int num_group = (K + weight_quant_group_size - 1) / weight_quant_group_size;
+
+    // one dequantized B row per thread, reused by all M rows
+    Mat BT_row(K, 1, opt.num_threads, 4u, opt.workspace_allocator);
+    if (BT_row.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int j = 0; j < N; j++)
+    {
+        const unsigned char* kptr = BT_quant.row<const unsigned char>(j);
+        const float* scales = (const float*)BT_quant_scales + num_group * j;
+        float* ptrBT = BT_row.channel(get_omp_thread_num());
+
+        for (int k = 0; k < K; k++)
+        {
+            int q;
+            if (weight_quant_bits == 4)
+                q = (k % 2 == 0 ? kptr[k / 2] & 15 : kptr[k / 2] >> 4) - 8;
+            else
+                q = ((const signed char*)kptr)[k];
+
+            ptrBT[k] = q * scales[k / weight_quant_group_size];
+        }
+
+        const size_t out_hstep = top_blob.dims == 3 ? top_blob.cstep : (size_t)top_blob.w;
+        const size_t A_hstep = A.dims == 3 ? A.cstep : (size_t)A.w;
+
+        const float* ptrC = C;
+
+        for (int i = 0; i < M; i++)
+        {
+            const float* ptrA = (const float*)A + i * A_hstep;
+
+            float sum = 0.f;
+            if (ptrC)
+            {
+                if (broadcast_type_C == 0)
+                {
+                    sum = ptrC[0];
+                }
+                if (broadcast_type_C == 1)
+                {
+                    sum = ptrC[i];
+                }
+                if (broadcast_type_C == 2)
+                {
+                    sum = ptrC[i];
+                }
+                if (broadcast_type_C == 3)
+                {
+                    sum = ptrC[i * N + j];
+                }
+                if (broadcast_type_C == 4)
+                {
+                    sum = ptrC[j];
+                }
+
+                sum *= beta;
+            }
+
+            for (int k = 0; k < K; k++)
+            {
+                sum += ptrA[k] * ptrBT[k];
+            }
+
+            top_blob[i * out_hstep + j] = sum * alpha;
+        }
+    }
+
+    return 0;
+}
+
 #if NCNN_INT8
 static inline signed char float2int8(float v)
 {
@@ -423,6 +551,12 @@ int Gemm::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     if (top_blob.empty())
         return -100;
 
+    if (weight_quant_bits)
+    {
+        // B stays quantized, each row is dequantized when its outputs are computed
+        return gemm_transB_weight_only(A, BT, B_data_quant_scales, weight_quant_bits, weight_quant_group_size, C, top_blob, alpha, beta, broadcast_type_C, opt);
+    }
+
     gemm_transB(A, BT, C, top_blob, alpha, beta, broadcast_type_C, output_transpose, opt);
 
     return 0;
@@ -46,6 +46,10 @@ public:
 
     int int8_scale_term;
 
+    // 0=off 4=int4 8=int8 weight-only quantized constant B
+    int weight_quant_bits;
+    int weight_quant_group_size;
+
     int constant_TILE_M;
     int constant_TILE_N;
     int constant_TILE_K;
@@ -55,6 +59,9 @@ public:
     Mat B_data;
     Mat C_data;
 
+    // one scale per weight_quant_group_size K of each N row
+    Mat B_data_quant_scales;
+
 #if NCNN_INT8
     Mat A_data_int8_scales;
     float B_data_int8_scale;
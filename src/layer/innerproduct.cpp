@@ -23,6 +23,29 @@ int InnerProduct::load_param(const ParamDict& pd)
     int8_scale_term = pd.get(8, 0);
     activation_type = pd.get(9, 0);
     activation_params = pd.get(10, Mat());
+    weight_quant_bits = pd.get(11, 0);
+    weight_quant_group_size = pd.get(12, 32);
+
+    if (weight_quant_bits)
+    {
+        if (weight_quant_bits != 4 && weight_quant_bits != 8)
+        {
+            NCNN_LOGE("weight_quant_bits must be 4 or 8 but got %d", weight_quant_bits);
+            return -1;
+        }
+
+        if (weight_quant_group_size <= 0 || weight_quant_group_size % 2 != 0)
+        {
+            NCNN_LOGE("weight_quant_group_size must be positive and even but got %d", weight_quant_group_size);
+            return -1;
+        }
+
+        if (int8_scale_term)
+        {
+            NCNN_LOGE("weight_quant_bits can not be used with int8_scale_term");
+            return -1;
+        }
+    }
 
     if (int8_scale_term)
     {
@@ -39,6 +62,39 @@ int InnerProduct::load_param(const ParamDict& pd)
 
 int InnerProduct::load_model(const ModelBin& mb)
 {
+    if (weight_quant_bits)
+    {
+        const int num_input = weight_data_size / num_output;
+        const int num_group = (num_input + weight_quant_group_size - 1) / weight_quant_group_size;
+
+        // int4 packs two inputs per byte, low nibble first, each output row padded to whole bytes
+        const int weight_data_bytes = weight_quant_bits == 4 ? (num_input + 1) / 2 * num_output : weight_data_size;
+
+        weight_data = mb.load(weight_data_bytes, 0);
+        if (weight_data.empty())
+            return -100;
+
+        if (weight_data.elemsize != 1)
+        {
+            NCNN_LOGE("weight-only quantized weight_data must be stored as int8");
+            return -1;
+        }
+
+        if (bias_term)
+        {
+            bias_data = mb.load(num_output, 1);
+            if (bias_data.empty())
+                return -100;
+        }
+
+        // fp32 or fp16 tagged
+        weight_data_quant_scales = mb.load(num_group * num_output, 0);
+        if (weight_data_quant_scales.empty())
+            return -100;
+
+        return 0;
+    }
+
     weight_data = mb.load(weight_data_size, 0);
     if (weight_data.empty())
         return -100;
@@ -83,6 +139,11 @@ int InnerProduct::load_model(const ModelBin& mb)
 
 int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+    if (weight_quant_bits)
+    {
+        return forward_weight_only(bottom_blob, top_blob, opt);
+    }
+
 #if NCNN_INT8
     if (opt.use_int8_inference && weight_data.elemsize == (size_t)1u)
     {
@@ -163,6 +224,64 @@ int InnerProduct::forward(const Mat& bottom_blob, Mat& top_blob, const Option& o
     return 0;
 }
 
+int InnerProduct::forward_weight_only(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int num_input = weight_data_size / num_output;
+    const int num_group = (num_input + weight_quant_group_size - 1) / weight_quant_group_size;
+    const int weight_row_bytes = weight_quant_bits == 4 ? (num_input + 1) / 2 : num_input;
+
+    Mat bottom_blob_flattened = bottom_blob;
+    int h = 1;
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input)
+    {
+        // gemm
+        h = bottom_blob.h;
+        top_blob.create(num_output, h, 4u, opt.blob_allocator);
+    }
+    else
+    {
+        bottom_blob_flattened = bottom_blob.reshape(num_input, opt.workspace_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+
+        top_blob.create(num_output, 4u, opt.blob_allocator);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p = 0; p < num_output; p++)
+    {
+        const unsigned char* kptr = (const unsigned char*)weight_data + weight_row_bytes * p;
+        const float* scales = (const float*)weight_data_quant_scales + num_group * p;
+
+        for (int j = 0; j < h; j++)
+        {
+            const float* m = bottom_blob_flattened.row(j);
+
+            float sum = 0.f;
+
+            if (bias_term)
+                sum = bias_data[p];
+
+            for (int i = 0; i < num_input; i++)
+            {
+                int q;
+                if (weight_quant_bits == 4)
+                    q = (i % 2 == 0 ? kptr[i / 2] & 15 : kptr[i / 2] >> 4) - 8;
+                else
+                    q = ((const signed char*)kptr)[i];
+
+                sum += m[i] * (q * scales[i / weight_quant_group_size]);
+            }
+
+            top_blob.row(j)[p] = activation_ss(sum, activation_type, activation_params);
+        }
+    }
+
+    return 0;
+}
+
 #if NCNN_INT8
 int InnerProduct::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
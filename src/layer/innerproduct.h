@@ -23,6 +23,7 @@ protected:
 #if NCNN_INT8
     int forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 #endif
+    int forward_weight_only(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
 public:
     // param
@@ -37,10 +38,17 @@ public:
     int activation_type;
     Mat activation_params;
 
+    // 0=off 4=int4 8=int8 weight-only quantization
+    int weight_quant_bits;
+    int weight_quant_group_size;
+
     // model
     Mat weight_data;
     Mat bias_data;
 
+    // one scale per weight_quant_group_size inputs of each output
+    Mat weight_data_quant_scales;
+
 #if NCNN_INT8
     Mat weight_data_int8_scales;
     Mat bottom_blob_int8_scales;
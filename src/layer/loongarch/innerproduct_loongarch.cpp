@@ -25,6 +25,15 @@ InnerProduct_loongarch::InnerProduct_loongarch()
 
 int InnerProduct_loongarch::create_pipeline(const Option& opt)
 {
+    if (weight_quant_bits)
+    {
+        // weight-only quantized weights run through the reference implementation
+        support_packing = false;
+        support_bf16_storage = false;
+        support_fp16_storage = false;
+        return 0;
+    }
+
     {
         flatten = ncnn::create_layer_cpu(ncnn::LayerType::Flatten);
 
@@ -108,6 +117,11 @@ int InnerProduct_loongarch::destroy_pipeline(const Option& opt)
 
 int InnerProduct_loongarch::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+    if (weight_quant_bits)
+    {
+        return InnerProduct::forward(bottom_blob, top_blob, opt);
+    }
+
 #if NCNN_INT8
     if (opt.use_int8_inference && int8_scale_term)
     {
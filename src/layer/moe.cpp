@@ -0,0 +1,255 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "moe.h"
+
+#include <float.h>
+#include <math.h>
+
+#include "fused_activation.h"
+
+namespace ncnn {
+
+MoE::MoE()
+{
+    one_blob_only = false;
+    support_inplace = false;
+}
+
+int MoE::load_param(const ParamDict& pd)
+{
+    num_expert = pd.get(0, 0);
+    top_k = pd.get(1, 2);
+    embed_dim = pd.get(2, 0);
+    hidden_dim = pd.get(3, 0);
+    gated = pd.get(4, 1);
+    activation_type = pd.get(5, 0);
+    norm_topk_prob = pd.get(6, 1);
+    bias_term = pd.get(7, 0);
+    activation_params = pd.get(8, Mat());
+
+    if (top_k < 1 || top_k > num_expert)
+    {
+        NCNN_LOGE("MoE top_k %d must be in range [1, num_expert %d]", top_k, num_expert);
+        return -1;
+    }
+
+    return 0;
+}
+
+int MoE::load_model(const ModelBin& mb)
+{
+    const int weight_data_size = num_expert * hidden_dim * embed_dim;
+
+    up_weight_data = mb.load(weight_data_size, 0);
+    if (up_weight_data.empty())
+        return -100;
+
+    if (gated)
+    {
+        gate_weight_data = mb.load(weight_data_size, 0);
+        if (gate_weight_data.empty())
+            return -100;
+    }
+
+    down_weight_data = mb.load(weight_data_size, 0);
+    if (down_weight_data.empty())
+        return -100;
+
+    if (bias_term)
+    {
+        up_bias_data = mb.load(num_expert * hidden_dim, 1);
+        if (up_bias_data.empty())
+            return -100;
+
+        if (gated)
+        {
+            gate_bias_data = mb.load(num_expert * hidden_dim, 1);
+            if (gate_bias_data.empty())
+                return -100;
+        }
+
+        down_bias_data = mb.load(num_expert * embed_dim, 1);
+        if (down_bias_data.empty())
+            return -100;
+    }
+
+    return 0;
+}
+
+static float moe_activation(float v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 7)
+    {
+        // silu
+        return v / (1.f + expf(-v));
+    }
+    if (activation_type == 8)
+    {
+        // gelu
+        return 0.5f * v * erfcf(-0.70710678f * v);
+    }
+
+    return activation_ss(v, activation_type, activation_params);
+}
+
+int MoE::route(const Mat& router_logits, Mat& topk_index, Mat& topk_weight, const Option& opt) const
+{
+    const int num_token = router_logits.dims == 1 ? 1 : router_logits.h;
+
+    topk_index.create(top_k, num_token, (size_t)4u, opt.workspace_allocator);
+    if (topk_index.empty())
+        return -100;
+
+    topk_weight.create(top_k, num_token, (size_t)4u, opt.workspace_allocator);
+    if (topk_weight.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < num_token; t++)
+    {
+        const float* logits = router_logits.row(t);
+        int* index = topk_index.row<int>(t);
+        float* weight = topk_weight.row(t);
+
+        float max = -FLT_MAX;
+        for (int e = 0; e < num_expert; e++)
+        {
+            max = std::max(max, logits[e]);
+        }
+
+        float sum = 0.f;
+        for (int e = 0; e < num_expert; e++)
+        {
+            sum += expf(logits[e] - max);
+        }
+
+        // the first maximum wins ties, selected experts are skipped in later rounds
+        float topk_sum = 0.f;
+        for (int k = 0; k < top_k; k++)
+        {
+            int best = -1;
+            for (int e = 0; e < num_expert; e++)
+            {
+                bool selected = false;
+                for (int j = 0; j < k; j++)
+                {
+                    if (index[j] == e)
+                        selected = true;
+                }
+                if (selected)
+                    continue;
+
+                if (best == -1 || logits[e] > logits[best])
+                    best = e;
+            }
+
+            index[k] = best;
+            weight[k] = expf(logits[best] - max) / sum;
+            topk_sum += weight[k];
+        }
+
+        if (norm_topk_prob)
+        {
+            for (int k = 0; k < top_k; k++)
+            {
+                weight[k] /= topk_sum;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int MoE::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& router_logits = bottom_blobs[1];
+
+    const int num_token = bottom_blob.dims == 1 ? 1 : bottom_blob.h;
+
+    if (bottom_blob.w != embed_dim || router_logits.w != num_expert || (router_logits.dims == 1 ? 1 : router_logits.h) != num_token)
+    {
+        NCNN_LOGE("MoE input shape mismatch, expect %d x %d and %d x %d", embed_dim, num_token, num_expert, num_token);
+        return -1;
+    }
+
+    Mat topk_index;
+    Mat topk_weight;
+    int ret = route(router_logits, topk_index, topk_weight, opt);
+    if (ret != 0)
+        return ret;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create_like(bottom_blob, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    Mat hidden(hidden_dim, num_token, (size_t)4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < num_token; t++)
+    {
+        const float* x = bottom_blob.row(t);
+        float* outptr = top_blob.row(t);
+        float* hptr = hidden.row(t);
+
+        for (int i = 0; i < embed_dim; i++)
+        {
+            outptr[i] = 0.f;
+        }
+
+        for (int k = 0; k < top_k; k++)
+        {
+            const int e = topk_index.row<const int>(t)[k];
+            const float w = topk_weight.row(t)[k];
+
+            for (int i = 0; i < hidden_dim; i++)
+            {
+                const float* up = (const float*)up_weight_data + ((size_t)e * hidden_dim + i) * embed_dim;
+
+                float sum = bias_term ? up_bias_data[e * hidden_dim + i] : 0.f;
+                for (int j = 0; j < embed_dim; j++)
+                {
+                    sum += up[j] * x[j];
+                }
+
+                if (gated)
+                {
+                    const float* gate = (const float*)gate_weight_data + ((size_t)e * hidden_dim + i) * embed_dim;
+
+                    float gsum = bias_term ? gate_bias_data[e * hidden_dim + i] : 0.f;
+                    for (int j = 0; j < embed_dim; j++)
+                    {
+                        gsum += gate[j] * x[j];
+                    }
+
+                    hptr[i] = moe_activation(gsum, activation_type, activation_params) * sum;
+                }
+                else
+                {
+                    hptr[i] = moe_activation(sum, activation_type, activation_params);
+                }
+            }
+
+            for (int i = 0; i < embed_dim; i++)
+            {
+                const float* down = (const float*)down_weight_data + ((size_t)e * embed_dim + i) * hidden_dim;
+
+                float sum = bias_term ? down_bias_data[e * embed_dim + i] : 0.f;
+                for (int j = 0; j < hidden_dim; j++)
+                {
+                    sum += down[j] * hptr[j];
+                }
+
+                outptr[i] += w * sum;
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
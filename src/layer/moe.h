@@ -0,0 +1,50 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef LAYER_MOE_H
+#define LAYER_MOE_H
+
+#include "layer.h"
+
+namespace ncnn {
+
+class MoE : public Layer
+{
+public:
+    MoE();
+
+    virtual int load_param(const ParamDict& pd);
+
+    virtual int load_model(const ModelBin& mb);
+
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+protected:
+    // softmax over router logits then top-k experts per token
+    int route(const Mat& router_logits, Mat& topk_index, Mat& topk_weight, const Option& opt) const;
+
+public:
+    int num_expert;
+    int top_k;
+    int embed_dim;
+    int hidden_dim;
+    int gated;
+    // 0-6 follow the fused activation numbering, 7=silu and 8=gelu are handled by moe only
+    int activation_type;
+    int norm_topk_prob;
+    int bias_term;
+    Mat activation_params;
+
+    // expert major, each expert in the torch linear layout of out x in
+    Mat up_weight_data;   // num_expert x hidden_dim x embed_dim
+    Mat gate_weight_data; // num_expert x hidden_dim x embed_dim, only when gated
+    Mat down_weight_data; // num_expert x embed_dim x hidden_dim
+
+    Mat up_bias_data;
+    Mat gate_bias_data;
+    Mat down_bias_data;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_MOE_H
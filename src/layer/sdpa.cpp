@@ -6,6 +6,7 @@
 #include <float.h>
 
 #include "cpu.h"
+#include "kvcache.h"
 
 namespace ncnn {
 
@@ -39,6 +40,7 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     const Mat& attn_mask_blob = attn_mask ? bottom_blobs[3] : Mat();
     const Mat& past_key = kv_cache ? bottom_blobs[attn_mask ? 4 : 3] : Mat();
     const Mat& past_value = kv_cache ? bottom_blobs[attn_mask ? 5 : 4] : Mat();
+    const Mat& block_table = kv_cache == 2 ? bottom_blobs[attn_mask ? 6 : 5] : Mat();
 
     const int embed_dim = query.w;
     const int src_seqlen = query.h;
@@ -46,9 +48,16 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
     const int cur_seqlen = cur_key.h;
     const int num_group = cur_key.c;
     const int out_embed_dim = cur_value.w;
-    const int past_seqlen = kv_cache ? past_key.h : 0;
+    if (kv_cache == 2 && (kvcache_check_paged(past_key, block_table, cur_key) != 0 || kvcache_check_paged(past_value, block_table, cur_value) != 0))
+        return -1;
+
+    const int past_seqlen = kv_cache == 2 ? ((const int*)block_table)[0] : kv_cache ? past_key.h : 0;
     const int dst_seqlen = past_seqlen + cur_seqlen;
 
+    // paged keys and values are read in place from their pool blocks
+    const int* blocks = kv_cache == 2 ? (const int*)block_table + 2 : 0;
+    const int block_size = kv_cache == 2 ? ((const int*)block_table)[1] : 0;
+
     // assert cur_key.w == embed_dim
     // assert cur_key.h == cur_value.h == cur_seqlen
     // assert cur_value.c == num_group
@@ -67,43 +76,24 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
         return -100;
 
     Mat key = cur_key;
-    if (past_seqlen > 0)
+    Mat value = cur_value;
+    if (kv_cache == 2)
     {
-        key.create(embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (key.empty())
-            return -100;
+        kvcache_write_paged(past_key, block_table, cur_key, opt);
+        kvcache_write_paged(past_value, block_table, cur_value, opt);
 
-        // concat
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_key_head = past_key.channel(q);
-            const Mat cur_key_head = cur_key.channel(q);
-            Mat key_head = key.channel(q);
-
-            memcpy(key_head.row(0), past_key_head, embed_dim * past_seqlen * sizeof(float));
-            memcpy(key_head.row(past_seqlen), cur_key_head, embed_dim * cur_seqlen * sizeof(float));
-        }
+        key = past_key;
+        value = past_value;
     }
-
-    Mat value = cur_value;
-    if (past_seqlen > 0)
+    else if (kv_cache)
     {
-        value.create(out_embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (value.empty())
-            return -100;
-
-        // concat
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_value_head = past_value.channel(q);
-            const Mat cur_value_head = cur_value.channel(q);
-            Mat value_head = value.channel(q);
+        int ret = kvcache_append(past_key, cur_key, key, opt);
+        if (ret != 0)
+            return ret;
 
-            memcpy(value_head.row(0), past_value_head, out_embed_dim * past_seqlen * sizeof(float));
-            memcpy(value_head.row(past_seqlen), cur_value_head, out_embed_dim * cur_seqlen * sizeof(float));
-        }
+        ret = kvcache_append(past_value, cur_value, value, opt);
+        if (ret != 0)
+            return ret;
     }
 
     #pragma omp parallel for num_threads(opt.num_threads)
@@ -124,7 +114,7 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
 
                 for (int j = 0; j < dst_seqlen; j++)
                 {
-                    const float* kptr = key_head.row(j);
+                    const float* kptr = key_head.row(blocks ? kvcache_paged_row(blocks, block_size, j) : j);
 
                     float sum = 0.f;
                     for (int k = 0; k < embed_dim; k++)
@@ -189,7 +179,7 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
                     float sum = 0.f;
                     for (int k = 0; k < dst_seqlen; k++)
                     {
-                        sum += qkptr[k] * value_head.row(k)[j];
+                        sum += qkptr[k] * value_head.row(blocks ? kvcache_paged_row(blocks, block_size, k) : k)[j];
                     }
 
                     outptr[j] = sum;
@@ -198,7 +188,7 @@ int SDPA::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_bl
         }
     }
 
-    if (kv_cache)
+    if (kv_cache == 1)
     {
         // assert top_blobs.size() == 3
         top_blobs[1] = key;
@@ -217,12 +207,13 @@ static inline signed char float2int8(float v)
     return (signed char)int32;
 }
 
-static void dynamic_quantize_2d(const Mat& blob, Mat& blob_int8, float& scale)
+static void dynamic_quantize_2d(const Mat& blob, Mat& blob_int8, float& scale, const int* blocks, int block_size)
 {
+    // paged rows are picked from their pool blocks
     float absmax = 0.f;
     for (int i = 0; i < blob_int8.h; i++)
     {
-        const float* ptr = blob.row(i);
+        const float* ptr = blob.row(blocks ? kvcache_paged_row(blocks, block_size, i) : i);
 
         for (int j = 0; j < blob_int8.w; j++)
         {
@@ -234,7 +225,7 @@ static void dynamic_quantize_2d(const Mat& blob, Mat& blob_int8, float& scale)
 
     for (int i = 0; i < blob_int8.h; i++)
     {
-        const float* ptr = blob.row(i);
+        const float* ptr = blob.row(blocks ? kvcache_paged_row(blocks, block_size, i) : i);
         signed char* outptr = blob_int8.row<signed char>(i);
 
         for (int j = 0; j < blob_int8.w; j++)
@@ -280,6 +271,7 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
     const Mat& attn_mask_blob = attn_mask ? bottom_blobs[3] : Mat();
     const Mat& past_key = kv_cache ? bottom_blobs[attn_mask ? 4 : 3] : Mat();
     const Mat& past_value = kv_cache ? bottom_blobs[attn_mask ? 5 : 4] : Mat();
+    const Mat& block_table = kv_cache == 2 ? bottom_blobs[attn_mask ? 6 : 5] : Mat();
 
     const int embed_dim = query.w;
     const int src_seqlen = query.h;
@@ -287,9 +279,16 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
     const int cur_seqlen = cur_key.h;
     const int num_group = cur_key.c;
     const int out_embed_dim = cur_value.w;
-    const int past_seqlen = kv_cache ? past_key.h : 0;
+    if (kv_cache == 2 && (kvcache_check_paged(past_key, block_table, cur_key) != 0 || kvcache_check_paged(past_value, block_table, cur_value) != 0))
+        return -1;
+
+    const int past_seqlen = kv_cache == 2 ? ((const int*)block_table)[0] : kv_cache ? past_key.h : 0;
     const int dst_seqlen = past_seqlen + cur_seqlen;
 
+    // paged keys and values are read in place from their pool blocks
+    const int* blocks = kv_cache == 2 ? (const int*)block_table + 2 : 0;
+    const int block_size = kv_cache == 2 ? ((const int*)block_table)[1] : 0;
+
     // assert cur_key.w == embed_dim
     // assert cur_key.h == cur_value.h == cur_seqlen
     // assert cur_value.c == num_group
@@ -328,43 +327,24 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
         return -100;
 
     Mat key = cur_key;
-    if (past_seqlen > 0)
+    Mat value = cur_value;
+    if (kv_cache == 2)
     {
-        key.create(embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (key.empty())
-            return -100;
-
-        // concat
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_key_head = past_key.channel(q);
-            const Mat cur_key_head = cur_key.channel(q);
-            Mat key_head = key.channel(q);
+        kvcache_write_paged(past_key, block_table, cur_key, opt);
+        kvcache_write_paged(past_value, block_table, cur_value, opt);
 
-            memcpy(key_head.row(0), past_key_head, embed_dim * past_seqlen * sizeof(float));
-            memcpy(key_head.row(past_seqlen), cur_key_head, embed_dim * cur_seqlen * sizeof(float));
-        }
+        key = past_key;
+        value = past_value;
     }
-
-    Mat value = cur_value;
-    if (past_seqlen > 0)
+    else if (kv_cache)
     {
-        value.create(out_embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (value.empty())
-            return -100;
+        int ret = kvcache_append(past_key, cur_key, key, opt);
+        if (ret != 0)
+            return ret;
 
-        // concat
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_value_head = past_value.channel(q);
-            const Mat cur_value_head = cur_value.channel(q);
-            Mat value_head = value.channel(q);
-
-            memcpy(value_head.row(0), past_value_head, out_embed_dim * past_seqlen * sizeof(float));
-            memcpy(value_head.row(past_seqlen), cur_value_head, out_embed_dim * cur_seqlen * sizeof(float));
-        }
+        ret = kvcache_append(past_value, cur_value, value, opt);
+        if (ret != 0)
+            return ret;
     }
 
     #pragma omp parallel for num_threads(opt.num_threads)
@@ -386,7 +366,7 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
             // dynamic quantize key_head
             Mat key_head_int8 = key_int8.channel(get_omp_thread_num());
             float key_head_int8_scale;
-            dynamic_quantize_2d(key_head, key_head_int8, key_head_int8_scale);
+            dynamic_quantize_2d(key_head, key_head_int8, key_head_int8_scale, blocks, block_size);
 
             for (int i = 0; i < src_seqlen; i++)
             {
@@ -461,7 +441,7 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
             // dynamic quantize value_head
             Mat value_head_int8 = value_int8.channel(get_omp_thread_num());
             float value_head_int8_scale;
-            dynamic_quantize_2d(value_head, value_head_int8, value_head_int8_scale);
+            dynamic_quantize_2d(value_head, value_head_int8, value_head_int8_scale, blocks, block_size);
 
             for (int i = 0; i < src_seqlen; i++)
             {
@@ -485,7 +465,7 @@ int SDPA::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& t
         }
     }
 
-    if (kv_cache)
+    if (kv_cache == 1)
     {
         // assert top_blobs.size() == 3
         top_blobs[1] = key;
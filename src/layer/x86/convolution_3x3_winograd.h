@@ -3156,7 +3156,7 @@ static int conv3x3s1_winograd23(const Mat& bottom_blob, Mat& top_blob, const Mat
 
     const int nn_NK = nn_N * nn_K;
 
-    if (nT > 1 && nn_NK < nT)
+    if (opt.num_threads > 1 && nn_NK < opt.num_threads)
     {
         Mat B_tile(TILE_N * B * TILE_K, 4u, opt.workspace_allocator);
         if (B_tile.empty())
@@ -3174,20 +3174,20 @@ static int conv3x3s1_winograd23(const Mat& bottom_blob, Mat& top_blob, const Mat
             const int max_kk = std::min((K - k), TILE_K);
 
             // transform input
-            conv3x3s1_winograd23_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, nT);
+            conv3x3s1_winograd23_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, opt.num_threads);
 
             Mat BT_tile = BT.channel(j / TILE_N).depth(k / TILE_K);
 
-            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, nT);
+            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, opt.num_threads);
         }
     }
     else
     {
-        Mat B_tileX(TILE_N * B * TILE_K, 1, nT, 4u, opt.workspace_allocator);
+        Mat B_tileX(TILE_N * B * TILE_K, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (B_tileX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppjk = 0; ppjk < nn_NK; ppjk++)
         {
             const int ppj = ppjk / nn_K;
@@ -3210,11 +3210,11 @@ static int conv3x3s1_winograd23(const Mat& bottom_blob, Mat& top_blob, const Mat
         }
     }
 
-    Mat top_tileX(TILE_N * B * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat top_tileX(TILE_N * B * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (top_tileX.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
@@ -5008,7 +5008,7 @@ static int conv3x3s1_winograd43(const Mat& bottom_blob, Mat& top_blob, const Mat
 
     const int nn_NK = nn_N * nn_K;
 
-    if (nT > 1 && nn_NK < nT)
+    if (opt.num_threads > 1 && nn_NK < opt.num_threads)
     {
         Mat B_tile(TILE_N * B * TILE_K, 4u, opt.workspace_allocator);
         if (B_tile.empty())
@@ -5026,20 +5026,20 @@ static int conv3x3s1_winograd43(const Mat& bottom_blob, Mat& top_blob, const Mat
             const int max_kk = std::min((K - k), TILE_K);
 
             // transform input
-            conv3x3s1_winograd43_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, nT);
+            conv3x3s1_winograd43_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, opt.num_threads);
 
             Mat BT_tile = BT.channel(j / TILE_N).depth(k / TILE_K);
 
-            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, nT);
+            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, opt.num_threads);
         }
     }
     else
     {
-        Mat B_tileX(TILE_N * B * TILE_K, 1, nT, 4u, opt.workspace_allocator);
+        Mat B_tileX(TILE_N * B * TILE_K, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (B_tileX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppjk = 0; ppjk < nn_NK; ppjk++)
         {
             const int ppj = ppjk / nn_K;
@@ -5062,11 +5062,11 @@ static int conv3x3s1_winograd43(const Mat& bottom_blob, Mat& top_blob, const Mat
         }
     }
 
-    Mat top_tileX(TILE_N * B * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat top_tileX(TILE_N * B * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (top_tileX.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
@@ -7308,7 +7308,7 @@ static int conv3x3s1_winograd63(const Mat& bottom_blob, Mat& top_blob, const Mat
 
     const int nn_NK = nn_N * nn_K;
 
-    if (nT > 1 && nn_NK < nT)
+    if (opt.num_threads > 1 && nn_NK < opt.num_threads)
     {
         Mat B_tile(TILE_N * B * TILE_K, 4u, opt.workspace_allocator);
         if (B_tile.empty())
@@ -7326,20 +7326,20 @@ static int conv3x3s1_winograd63(const Mat& bottom_blob, Mat& top_blob, const Mat
             const int max_kk = std::min((K - k), TILE_K);
 
             // transform input
-            conv3x3s1_winograd63_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, nT);
+            conv3x3s1_winograd63_transform_input_tile(bottom_blob, B_tile, j, max_jj, k, max_kk, opt.num_threads);
 
             Mat BT_tile = BT.channel(j / TILE_N).depth(k / TILE_K);
 
-            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, nT);
+            transpose_pack_B_tile(B_tile, BT_tile, B, max_jj, max_kk, opt.num_threads);
         }
     }
     else
     {
-        Mat B_tileX(TILE_N * B * TILE_K, 1, nT, 4u, opt.workspace_allocator);
+        Mat B_tileX(TILE_N * B * TILE_K, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (B_tileX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppjk = 0; ppjk < nn_NK; ppjk++)
         {
             const int ppj = ppjk / nn_K;
@@ -7362,11 +7362,11 @@ static int conv3x3s1_winograd63(const Mat& bottom_blob, Mat& top_blob, const Mat
         }
     }
 
-    Mat top_tileX(TILE_N * B * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat top_tileX(TILE_N * B * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (top_tileX.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
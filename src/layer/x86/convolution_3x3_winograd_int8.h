@@ -4337,7 +4337,7 @@ static int conv3x3s1_winograd23_int8(const Mat& bottom_blob, Mat& top_blob, cons
 
     const int nn_NK = nn_N * nn_K;
 
-    if (nT > 1 && nn_NK < nT)
+    if (opt.num_threads > 1 && nn_NK < opt.num_threads)
     {
         Mat B_tile(TILE_N * B * TILE_K, 2u, opt.workspace_allocator);
         if (B_tile.empty())
@@ -4355,20 +4355,20 @@ static int conv3x3s1_winograd23_int8(const Mat& bottom_blob, Mat& top_blob, cons
             const int max_kk = std::min((K - k), TILE_K);
 
             // transform input
-            conv3x3s1_winograd23_transform_input_tile_int8(bottom_blob, B_tile, j, max_jj, k, max_kk, nT);
+            conv3x3s1_winograd23_transform_input_tile_int8(bottom_blob, B_tile, j, max_jj, k, max_kk, opt.num_threads);
 
             Mat BT_tile = BT.channel(j / TILE_N).depth(k / TILE_K);
 
-            transpose_pack_B_tile_int8(B_tile, BT_tile, B, max_jj, max_kk, nT);
+            transpose_pack_B_tile_int8(B_tile, BT_tile, B, max_jj, max_kk, opt.num_threads);
         }
     }
     else
     {
-        Mat B_tileX(TILE_N * B * TILE_K, 1, nT, 2u, opt.workspace_allocator);
+        Mat B_tileX(TILE_N * B * TILE_K, 1, opt.num_threads, 2u, opt.workspace_allocator);
         if (B_tileX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppjk = 0; ppjk < nn_NK; ppjk++)
         {
             const int ppj = ppjk / nn_K;
@@ -4391,11 +4391,11 @@ static int conv3x3s1_winograd23_int8(const Mat& bottom_blob, Mat& top_blob, cons
         }
     }
 
-    Mat top_tileX(TILE_N * B * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat top_tileX(TILE_N * B * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (top_tileX.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
@@ -6169,7 +6169,7 @@ static int conv3x3s1_winograd43_int8(const Mat& bottom_blob, Mat& top_blob, cons
 
     const int nn_NK = nn_N * nn_K;
 
-    if (nT > 1 && nn_NK < nT)
+    if (opt.num_threads > 1 && nn_NK < opt.num_threads)
     {
         Mat B_tile(TILE_N * B * TILE_K, 4u, opt.workspace_allocator);
         if (B_tile.empty())
@@ -6187,20 +6187,20 @@ static int conv3x3s1_winograd43_int8(const Mat& bottom_blob, Mat& top_blob, cons
             const int max_kk = std::min((K - k), TILE_K);
 
             // transform input
-            conv3x3s1_winograd43_transform_input_tile_int8(bottom_blob, B_tile, j, max_jj, k, max_kk, nT);
+            conv3x3s1_winograd43_transform_input_tile_int8(bottom_blob, B_tile, j, max_jj, k, max_kk, opt.num_threads);
 
             Mat BT_tile = BT.channel(j / TILE_N).depth(k / TILE_K);
 
-            transpose_pack_B_tile_int8(B_tile, BT_tile, B, max_jj, max_kk, nT);
+            transpose_pack_B_tile_int8(B_tile, BT_tile, B, max_jj, max_kk, opt.num_threads);
         }
     }
     else
     {
-        Mat B_tileX(TILE_N * B * TILE_K, 1, nT, 4u, opt.workspace_allocator);
+        Mat B_tileX(TILE_N * B * TILE_K, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (B_tileX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppjk = 0; ppjk < nn_NK; ppjk++)
         {
             const int ppj = ppjk / nn_K;
@@ -6223,11 +6223,11 @@ static int conv3x3s1_winograd43_int8(const Mat& bottom_blob, Mat& top_blob, cons
         }
     }
 
-    Mat top_tileX(TILE_N * B * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat top_tileX(TILE_N * B * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (top_tileX.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
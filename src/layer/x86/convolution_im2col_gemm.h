@@ -4618,7 +4618,7 @@ static int convolution_im2col_gemm(const Mat& bottom_blob, Mat& top_blob, const
 
     const int nn_NK = nn_N * nn_K;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -4639,12 +4639,12 @@ static int convolution_im2col_gemm(const Mat& bottom_blob, Mat& top_blob, const
     Mat topT_tileX;
     if (K > TILE_K)
     {
-        topT_tileX.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+        topT_tileX.create(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (topT_tileX.empty())
             return -100;
     }
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
@@ -4509,7 +4509,7 @@ static int convolution_im2col_gemm_int8(const Mat& bottom_blob, Mat& top_blob, c
 
     const int nn_NK = nn_N * nn_K;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -4527,11 +4527,11 @@ static int convolution_im2col_gemm_int8(const Mat& bottom_blob, Mat& top_blob, c
         convolution_im2col_input_tile_int8(bottom_blob, BT_tile, j, max_jj, k, max_kk, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h);
     }
 
-    Mat topT(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat topT(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (topT.empty())
         return -100;
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppj = 0; ppj < nn_M; ppj++)
     {
         const int i = ppj * TILE_M;
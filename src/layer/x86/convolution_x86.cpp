@@ -501,6 +501,48 @@ int Convolution_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int Convolution_x86::save_pipeline_weights(std::vector<Mat>& weights) const
+{
+    // dilation fallback keeps its weights in the inner convolution
+    if (dynamic_weight || convolution_dilation1)
+        return -1;
+
+    weights.resize(6);
+    weights[0] = weight_data_tm;
+    weights[1] = weight_sgemm_data;
+    weights[2] = weight_winograd23_data;
+    weights[3] = weight_winograd43_data;
+    weights[4] = weight_winograd63_data;
+#if NCNN_INT8
+    weights[5] = scale_in_data;
+#endif
+
+    return 0;
+}
+
+int Convolution_x86::load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt)
+{
+    if (dynamic_weight || weights.size() != 6)
+        return -1;
+
+    activation = create_activation_layer(activation_type, activation_params, opt);
+    nT = opt.num_threads;
+
+    weight_data_tm = weights[0];
+    weight_sgemm_data = weights[1];
+    weight_winograd23_data = weights[2];
+    weight_winograd43_data = weights[3];
+    weight_winograd63_data = weights[4];
+#if NCNN_INT8
+    scale_in_data = weights[5];
+#endif
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
 int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
 #if NCNN_INT8
@@ -639,12 +681,6 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
         }
 
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
-        {
-            // force num_threads the same as in create_pipeline
-            // so we could use pre-packed A/B from the same tile config
-            NCNN_LOGE("opt.num_threads %d changed, convolution winograd will use load-time value %d", opt.num_threads, nT);
-        }
 
         int ret = 0;
         if (prefer_winograd23)
@@ -679,12 +715,6 @@ int Convolution_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option
     if ((opt.use_sgemm_convolution && prefer_sgemm) || (kernel_w == 1 && kernel_h == 1))
     {
         int _nT = nT ? nT : opt.num_threads;
-        if (nT != 0 && opt.num_threads != nT)
-        {
-            // force num_threads the same as in create_pipeline
-            // so we could use pre-packed A/B from the same tile config
-            NCNN_LOGE("opt.num_threads %d changed, convolution gemm will use load-time value %d", opt.num_threads, nT);
-        }
 
         int ret = convolution_im2col_gemm(bottom_blob_bordered, top_blob, weight_sgemm_data, bias_data, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, _nT, opt);
         if (ret != 0)
@@ -1030,12 +1060,6 @@ int Convolution_x86::forward_int8_x86(const Mat& bottom_blob, Mat& top_blob, con
         return -100;
 
     int _nT = nT ? nT : opt.num_threads;
-    if (nT != 0 && opt.num_threads != nT)
-    {
-        // force num_threads the same as in create_pipeline
-        // so we could use pre-packed A/B from the same tile config
-        NCNN_LOGE("opt.num_threads %d changed, convolution gemm will use load-time value %d", opt.num_threads, nT);
-    }
 
     int ret = 0;
     if (opt.use_winograd_convolution && prefer_winograd && kernel_w == 3 && kernel_h == 3 && dilation_w == 1 && dilation_h == 1 && stride_w == 1 && stride_h == 1)
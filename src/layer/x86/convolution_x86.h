@@ -16,6 +16,9 @@ public:
     virtual int create_pipeline(const Option& opt);
     virtual int destroy_pipeline(const Option& opt);
 
+    virtual int save_pipeline_weights(std::vector<Mat>& weights) const;
+    virtual int load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt);
+
     virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
 
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
@@ -30,6 +33,7 @@ protected:
 public:
     Layer* activation;
 
+    // thread count the winograd and sgemm weights are packed for, only picks the tile config
     int nT;
     Mat weight_data_tm;
     Mat weight_sgemm_data;
@@ -0,0 +1,526 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "einsum_x86.h"
+
+#include "layer_type.h"
+
+#include <string.h>
+
+namespace ncnn {
+
+Einsum_x86::Einsum_x86()
+{
+    support_packing = true;
+
+    plan_valid = 0;
+    gemm = 0;
+}
+
+static bool has_letter(const std::string& s, char c)
+{
+    return s.find(c) != std::string::npos;
+}
+
+int Einsum_x86::create_pipeline(const Option& opt)
+{
+    plan_valid = 0;
+    plan_batch.clear();
+    plan_m.clear();
+    plan_n.clear();
+    plan_k.clear();
+    plan_letters.clear();
+
+    // trace and repeated letters take the generic path
+    if (lhs_tokens.empty())
+        return 0;
+
+    for (size_t i = 0; i <= lhs_tokens.size(); i++)
+    {
+        const std::string& token = i == lhs_tokens.size() ? rhs_token : lhs_tokens[i];
+        for (size_t j = 0; j < token.size(); j++)
+        {
+            if (token.find(token[j], j + 1) != std::string::npos)
+                return 0;
+        }
+    }
+
+    for (size_t j = 0; j < rhs_token.size(); j++)
+    {
+        bool found = false;
+        for (size_t i = 0; i < lhs_tokens.size(); i++)
+        {
+            found = found || has_letter(lhs_tokens[i], rhs_token[j]);
+        }
+        if (!found)
+            return 0;
+    }
+
+    // fold operands left to right
+    //   batch  in both sides and needed later
+    //   m      left only and needed later
+    //   n      right only and needed later
+    //   k      in both sides and not needed later
+    // letters on one side that are not needed later are summed out before the gemm
+    std::string acc = lhs_tokens[0];
+    for (size_t s = 1; s < lhs_tokens.size(); s++)
+    {
+        const std::string& b = lhs_tokens[s];
+
+        std::string needed = rhs_token;
+        for (size_t i = s + 1; i < lhs_tokens.size(); i++)
+        {
+            needed += lhs_tokens[i];
+        }
+
+        std::string batch;
+        std::string m;
+        std::string n;
+        std::string k;
+        for (size_t i = 0; i < acc.size(); i++)
+        {
+            const char c = acc[i];
+            if (has_letter(b, c))
+            {
+                if (has_letter(needed, c))
+                    batch += c;
+                else
+                    k += c;
+            }
+            else if (has_letter(needed, c))
+            {
+                m += c;
+            }
+        }
+        for (size_t i = 0; i < b.size(); i++)
+        {
+            const char c = b[i];
+            if (!has_letter(acc, c) && has_letter(needed, c))
+                n += c;
+        }
+
+        plan_batch.push_back(batch);
+        plan_m.push_back(m);
+        plan_n.push_back(n);
+        plan_k.push_back(k);
+
+        acc = batch + m + n;
+    }
+
+    plan_letters = acc;
+    plan_valid = 1;
+
+    if (lhs_tokens.size() > 1)
+    {
+        gemm = ncnn::create_layer_cpu(ncnn::LayerType::Gemm);
+
+        ncnn::ParamDict pd;
+        pd.set(2, 0);   // transA
+        pd.set(3, 0);   // transB
+        pd.set(4, 0);   // constantA
+        pd.set(5, 0);   // constantB
+        pd.set(6, 1);   // constantC
+        pd.set(7, 0);   // M
+        pd.set(8, 0);   // N
+        pd.set(9, 0);   // K
+        pd.set(10, -1); // constant_broadcast_type_C = null
+        pd.set(11, 0);  // output_N1M
+        pd.set(12, 1);  // output_elempack
+
+        int ret = gemm->load_param(pd);
+        if (ret == 0)
+            ret = gemm->load_model(ModelBinFromMatArray(0));
+        if (ret == 0)
+            ret = gemm->create_pipeline(opt);
+
+        if (ret != 0)
+        {
+            delete gemm;
+            gemm = 0;
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+int Einsum_x86::destroy_pipeline(const Option& opt)
+{
+    if (gemm)
+    {
+        gemm->destroy_pipeline(opt);
+        delete gemm;
+        gemm = 0;
+    }
+
+    return 0;
+}
+
+// a tensor addressed per letter, float offsets of every index along every letter
+struct einsum_tensor
+{
+    Mat data;
+    std::string letters;
+    std::vector<int> sizes;
+    std::vector<std::vector<size_t> > offsets;
+
+    int letter_size(char c) const
+    {
+        return sizes[letters.find(c)];
+    }
+
+    const std::vector<size_t>& letter_offsets(char c) const
+    {
+        return offsets[letters.find(c)];
+    }
+};
+
+// view a blob without unpacking, the outermost axis may be packed
+static void einsum_tensor_from_blob(const Mat& m, const std::string& token, einsum_tensor& t)
+{
+    const int dims = m.dims;
+    const int elempack = m.elempack;
+
+    // axes outermost first, as the equation letters are
+    int sizes[4];
+    size_t strides[4];
+    if (dims == 1)
+    {
+        sizes[0] = m.w * elempack;
+        strides[0] = elempack;
+    }
+    if (dims == 2)
+    {
+        sizes[0] = m.h * elempack;
+        sizes[1] = m.w;
+        strides[0] = (size_t)m.w * elempack;
+        strides[1] = elempack;
+    }
+    if (dims == 3)
+    {
+        sizes[0] = m.c * elempack;
+        sizes[1] = m.h;
+        sizes[2] = m.w;
+        strides[0] = m.cstep * elempack;
+        strides[1] = (size_t)m.w * elempack;
+        strides[2] = elempack;
+    }
+    if (dims == 4)
+    {
+        sizes[0] = m.c * elempack;
+        sizes[1] = m.d;
+        sizes[2] = m.h;
+        sizes[3] = m.w;
+        strides[0] = m.cstep * elempack;
+        strides[1] = (size_t)m.w * m.h * elempack;
+        strides[2] = (size_t)m.w * elempack;
+        strides[3] = elempack;
+    }
+
+    t.data = m;
+    t.letters = token;
+    t.sizes.resize(dims);
+    t.offsets.resize(dims);
+    for (int a = 0; a < dims; a++)
+    {
+        t.sizes[a] = sizes[a];
+        t.offsets[a].resize(sizes[a]);
+        for (int i = 0; i < sizes[a]; i++)
+        {
+            t.offsets[a][i] = a == 0 ? (i / elempack) * strides[0] + i % elempack : i * strides[a];
+        }
+    }
+}
+
+// letters laid out row-major from a base stride
+static void einsum_tensor_append_letters(einsum_tensor& t, const std::string& letters, const std::vector<int>& sizes, size_t stride)
+{
+    const size_t offset = t.letters.size();
+    t.letters += letters;
+    t.sizes.resize(offset + letters.size());
+    t.offsets.resize(offset + letters.size());
+
+    for (int a = (int)letters.size() - 1; a >= 0; a--)
+    {
+        const int size = sizes[a];
+        t.sizes[offset + a] = size;
+        t.offsets[offset + a].resize(size);
+        for (int i = 0; i < size; i++)
+        {
+            t.offsets[offset + a][i] = i * stride;
+        }
+        stride *= size;
+    }
+}
+
+static int einsum_letters_total(const einsum_tensor& t, const std::string& letters, std::vector<int>& sizes)
+{
+    sizes.resize(letters.size());
+
+    int total = 1;
+    for (size_t i = 0; i < letters.size(); i++)
+    {
+        sizes[i] = t.letter_size(letters[i]);
+        total *= sizes[i];
+    }
+
+    return total;
+}
+
+// permute t into row-major target letters, summing over drop letters
+static void einsum_gather(const einsum_tensor& t, const std::string& target, const std::string& drop, float* outptr, const Option& opt)
+{
+    const float* ptr = t.data;
+
+    std::vector<int> target_sizes;
+    std::vector<int> drop_sizes;
+    einsum_letters_total(t, target, target_sizes);
+    const int drop_total = einsum_letters_total(t, drop, drop_sizes);
+
+    std::vector<const size_t*> target_offsets(target.size());
+    for (size_t i = 0; i < target.size(); i++)
+    {
+        target_offsets[i] = &t.letter_offsets(target[i])[0];
+    }
+
+    std::vector<const size_t*> drop_offsets(drop.size());
+    for (size_t i = 0; i < drop.size(); i++)
+    {
+        drop_offsets[i] = &t.letter_offsets(drop[i])[0];
+    }
+
+    // flatten the summed letters once, they are walked for every output
+    std::vector<size_t> drop_table(drop_total);
+    for (int i = 0; i < drop_total; i++)
+    {
+        size_t offset = 0;
+        int j = i;
+        for (int a = (int)drop.size() - 1; a >= 0; a--)
+        {
+            offset += drop_offsets[a][j % drop_sizes[a]];
+            j /= drop_sizes[a];
+        }
+        drop_table[i] = offset;
+    }
+
+    // innermost target letter is walked in the inner loop
+    const int inner = target.empty() ? 1 : target_sizes[target.size() - 1];
+    const size_t zero = 0;
+    const size_t* inner_offsets = target.empty() ? &zero : target_offsets[target.size() - 1];
+
+    int outer_total = 1;
+    for (int a = 0; a + 1 < (int)target.size(); a++)
+    {
+        outer_total *= target_sizes[a];
+    }
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int i = 0; i < outer_total; i++)
+    {
+        size_t base = 0;
+        int j = i;
+        for (int a = (int)target.size() - 2; a >= 0; a--)
+        {
+            base += target_offsets[a][j % target_sizes[a]];
+            j /= target_sizes[a];
+        }
+
+        const float* ptr0 = ptr + base;
+        float* outptr0 = outptr + (size_t)i * inner;
+
+        if (drop_total == 1)
+        {
+            const float* ptr1 = ptr0 + drop_table[0];
+            for (int x = 0; x < inner; x++)
+            {
+                outptr0[x] = ptr1[inner_offsets[x]];
+            }
+        }
+        else
+        {
+            for (int x = 0; x < inner; x++)
+            {
+                const float* ptr1 = ptr0 + inner_offsets[x];
+
+                float sum = 0.f;
+                for (int k = 0; k < drop_total; k++)
+                {
+                    sum += ptr1[drop_table[k]];
+                }
+                outptr0[x] = sum;
+            }
+        }
+    }
+}
+
+static std::string einsum_letters_except(const std::string& letters, const std::string& keep)
+{
+    std::string s;
+    for (size_t i = 0; i < letters.size(); i++)
+    {
+        if (!has_letter(keep, letters[i]))
+            s += letters[i];
+    }
+
+    return s;
+}
+
+int Einsum_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    bool fallback = !plan_valid;
+
+    // every letter must have one size across operands
+    std::vector<einsum_tensor> inputs(bottom_blobs.size());
+    int letter_sizes[16] = {0};
+    for (size_t b = 0; b < bottom_blobs.size() && !fallback; b++)
+    {
+        const std::string& lhs_token = lhs_tokens[b];
+
+        if (bottom_blobs[b].dims != (int)lhs_token.size())
+        {
+            fallback = true;
+            break;
+        }
+
+        einsum_tensor_from_blob(bottom_blobs[b], lhs_token, inputs[b]);
+        for (size_t s = 0; s < lhs_token.size(); s++)
+        {
+            const int index = lhs_token[s] - 'i';
+            if (letter_sizes[index] != 0 && letter_sizes[index] != inputs[b].sizes[s])
+                fallback = true;
+            letter_sizes[index] = inputs[b].sizes[s];
+        }
+    }
+
+    if (fallback)
+    {
+        Option opt_pack = opt;
+        opt_pack.blob_allocator = opt.workspace_allocator;
+
+        std::vector<Mat> bottom_blobs_unpacked(bottom_blobs.size());
+        for (size_t b = 0; b < bottom_blobs.size(); b++)
+        {
+            convert_packing(bottom_blobs[b], bottom_blobs_unpacked[b], 1, opt_pack);
+            if (bottom_blobs_unpacked[b].empty())
+                return -100;
+        }
+
+        return Einsum::forward(bottom_blobs_unpacked, top_blobs, opt);
+    }
+
+    einsum_tensor acc = inputs[0];
+
+    for (size_t s = 0; s < plan_batch.size(); s++)
+    {
+        const einsum_tensor& b = inputs[s + 1];
+
+        const std::string& batch = plan_batch[s];
+        const std::string& m = plan_m[s];
+        const std::string& n = plan_n[s];
+        const std::string& k = plan_k[s];
+
+        std::vector<int> batch_sizes;
+        std::vector<int> m_sizes;
+        std::vector<int> n_sizes;
+        std::vector<int> k_sizes;
+        const int batch_size = einsum_letters_total(acc, batch, batch_sizes);
+        const int M = einsum_letters_total(acc, m, m_sizes);
+        const int N = einsum_letters_total(b, n, n_sizes);
+        const int K = einsum_letters_total(acc, k, k_sizes);
+
+        // A as batch x M x K and B as batch x K x N, both row-major
+        Mat A(batch_size * M * K, (size_t)4u, opt.workspace_allocator);
+        Mat B(batch_size * K * N, (size_t)4u, opt.workspace_allocator);
+        if (A.empty() || B.empty())
+            return -100;
+
+        const std::string a_target = batch + m + k;
+        const std::string b_target = batch + k + n;
+        einsum_gather(acc, a_target, einsum_letters_except(acc.letters, a_target), A, opt);
+        einsum_gather(b, b_target, einsum_letters_except(b.letters, b_target), B, opt);
+
+        Mat C(N, M, batch_size, (size_t)4u, opt.workspace_allocator);
+        if (C.empty())
+            return -100;
+
+        Option opt_gemm = opt;
+        opt_gemm.blob_allocator = opt.workspace_allocator;
+
+        for (int p = 0; p < batch_size; p++)
+        {
+            std::vector<Mat> _bottom_blobs(2);
+            _bottom_blobs[0] = Mat(K, M, (float*)A + (size_t)p * M * K);
+            _bottom_blobs[1] = Mat(N, K, (float*)B + (size_t)p * K * N);
+            Mat Cp = C.channel(p);
+            std::vector<Mat> _top_blobs(1);
+            _top_blobs[0] = Cp;
+            int ret = gemm->forward(_bottom_blobs, _top_blobs, opt_gemm);
+            if (ret != 0)
+                return ret;
+
+            // gemm writes into the view in place unless it allocated its own output
+            const Mat& top = _top_blobs[0];
+            if (top.data != Cp.data)
+            {
+                if (top.w != N || top.h != M || top.elemsize != 4u || top.elempack != 1)
+                    return -100;
+
+                memcpy(Cp, (const float*)top, (size_t)M * N * sizeof(float));
+            }
+        }
+
+        // C addressed as batch m n letters, batches are cstep apart
+        einsum_tensor c;
+        c.data = C;
+        einsum_tensor_append_letters(c, batch, batch_sizes, C.cstep);
+        einsum_tensor_append_letters(c, m, m_sizes, N);
+        einsum_tensor_append_letters(c, n, n_sizes, 1);
+
+        acc = c;
+    }
+
+    // permute into the output letters and sum the rest
+    std::vector<int> out_sizes;
+    einsum_letters_total(acc, rhs_token, out_sizes);
+
+    const int out_dims = (int)rhs_token.size();
+
+    Mat& top_blob = top_blobs[0];
+    if (out_dims == 1)
+        top_blob.create(out_sizes[0], (size_t)4u, opt.blob_allocator);
+    if (out_dims == 2)
+        top_blob.create(out_sizes[1], out_sizes[0], (size_t)4u, opt.blob_allocator);
+    if (out_dims == 3)
+        top_blob.create(out_sizes[2], out_sizes[1], out_sizes[0], (size_t)4u, opt.blob_allocator);
+    if (out_dims == 4)
+        top_blob.create(out_sizes[3], out_sizes[2], out_sizes[1], out_sizes[0], (size_t)4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const std::string drop = einsum_letters_except(acc.letters, rhs_token);
+
+    const int channels = out_dims >= 3 ? top_blob.c : 1;
+    const size_t channel_size = (size_t)top_blob.w * top_blob.h * top_blob.d;
+    if (channels == 1 || top_blob.cstep == channel_size)
+    {
+        einsum_gather(acc, rhs_token, drop, top_blob, opt);
+    }
+    else
+    {
+        Mat out((int)channel_size * channels, (size_t)4u, opt.workspace_allocator);
+        if (out.empty())
+            return -100;
+
+        einsum_gather(acc, rhs_token, drop, out, opt);
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < channels; q++)
+        {
+            memcpy(top_blob.channel(q), (const float*)out + channel_size * q, channel_size * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -0,0 +1,36 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef LAYER_EINSUM_X86_H
+#define LAYER_EINSUM_X86_H
+
+#include "einsum.h"
+
+namespace ncnn {
+
+class Einsum_x86 : public Einsum
+{
+public:
+    Einsum_x86();
+
+    virtual int create_pipeline(const Option& opt);
+    virtual int destroy_pipeline(const Option& opt);
+
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+public:
+    // contraction plan, operands are folded left to right into one batched gemm each
+    // the generic path is taken when plan_valid is 0
+    int plan_valid;
+    std::vector<std::string> plan_batch;
+    std::vector<std::string> plan_m;
+    std::vector<std::string> plan_n;
+    std::vector<std::string> plan_k;
+    std::string plan_letters;
+
+    Layer* gemm;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_EINSUM_X86_H
@@ -0,0 +1,241 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "embed_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+Embed_x86::Embed_x86()
+{
+}
+
+int Embed_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        // int8 table is dequantized while gathering
+        return 0;
+    }
+#endif // NCNN_INT8
+
+#if __F16C__
+    if (opt.use_fp16_storage)
+    {
+        cast_float32_to_float16(weight_data, weight_data_tm);
+    }
+    else
+#endif // __F16C__
+#if NCNN_BF16
+    if (opt.use_bf16_storage)
+    {
+        cast_float32_to_bfloat16(weight_data, weight_data_tm);
+    }
+    else
+#endif // NCNN_BF16
+    {
+        return 0;
+    }
+
+    if (weight_data_tm.empty())
+        return -100;
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
+static void embed_add_bias(float* outptr, const float* bias_ptr, int size)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(outptr + i, _mm512_add_ps(_mm512_loadu_ps(outptr + i), _mm512_loadu_ps(bias_ptr + i)));
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_add_ps(_mm256_loadu_ps(outptr + i), _mm256_loadu_ps(bias_ptr + i)));
+    }
+#endif // __AVX__
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(outptr + i, _mm_add_ps(_mm_loadu_ps(outptr + i), _mm_loadu_ps(bias_ptr + i)));
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        outptr[i] += bias_ptr[i];
+    }
+}
+
+#if __F16C__
+static void embed_row_fp16(const unsigned short* em, float* outptr, int size)
+{
+    int i = 0;
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(outptr + i, _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)(em + i))));
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(outptr + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(em + i))));
+    }
+    for (; i < size; i++)
+    {
+        outptr[i] = float16_to_float32(em[i]);
+    }
+}
+#endif // __F16C__
+
+#if NCNN_BF16
+static void embed_row_bf16(const unsigned short* em, float* outptr, int size)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(outptr + i, bfloat2float_avx512(_mm256_loadu_si256((const __m256i*)(em + i))));
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(outptr + i, bfloat2float_avx(_mm_loadu_si128((const __m128i*)(em + i))));
+    }
+#endif // __AVX__
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(outptr + i, bfloat2float_sse(_mm_loadl_epi64((const __m128i*)(em + i))));
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        outptr[i] = bfloat16_to_float32(em[i]);
+    }
+}
+#endif // NCNN_BF16
+
+#if NCNN_INT8
+static void embed_row_int8(const signed char* em, float descale, float* outptr, int size)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _descale_avx512 = _mm512_set1_ps(descale);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512i _v = _mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(em + i)));
+        _mm512_storeu_ps(outptr + i, _mm512_mul_ps(_mm512_cvtepi32_ps(_v), _descale_avx512));
+    }
+#endif // __AVX512F__
+#if __AVX2__
+    __m256 _descale_avx = _mm256_set1_ps(descale);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256i _v = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(em + i)));
+        _mm256_storeu_ps(outptr + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_v), _descale_avx));
+    }
+#endif // __AVX2__
+#endif // __AVX__
+    __m128 _descale = _mm_set1_ps(descale);
+    for (; i + 3 < size; i += 4)
+    {
+        // sign extend four bytes through the top of each lane
+        int v4;
+        memcpy(&v4, em + i, 4);
+        __m128i _v = _mm_cvtsi32_si128(v4);
+        _v = _mm_unpacklo_epi8(_v, _v);
+        _v = _mm_unpacklo_epi16(_v, _v);
+        _v = _mm_srai_epi32(_v, 24);
+        _mm_storeu_ps(outptr + i, _mm_mul_ps(_mm_cvtepi32_ps(_v), _descale));
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        outptr[i] = em[i] * descale;
+    }
+}
+#endif // NCNN_INT8
+
+int Embed_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int words = bottom_blob.w;
+
+    top_blob.create(num_output, words, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int* word_ptr = bottom_blob;
+    const float* bias_ptr = bias_term ? (const float*)bias_data : 0;
+
+#if NCNN_INT8
+    const float descale = int8_scale_term ? 1.f / weight_data_int8_scale : 1.f;
+#endif
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < words; q++)
+    {
+        float* outptr = top_blob.row(q);
+
+        int word_index = word_ptr[q];
+
+        if (word_index < 0)
+            word_index = 0;
+        if (word_index >= input_dim)
+            word_index = input_dim - 1;
+
+        const size_t offset = (size_t)num_output * word_index;
+
+#if NCNN_INT8
+        if (int8_scale_term)
+        {
+            embed_row_int8((const signed char*)weight_data + offset, descale, outptr, num_output);
+        }
+        else
+#endif // NCNN_INT8
+#if __F16C__
+        if (opt.use_fp16_storage)
+        {
+            embed_row_fp16((const unsigned short*)weight_data_tm + offset, outptr, num_output);
+        }
+        else
+#endif // __F16C__
+#if NCNN_BF16
+        if (opt.use_bf16_storage)
+        {
+            embed_row_bf16((const unsigned short*)weight_data_tm + offset, outptr, num_output);
+        }
+        else
+#endif // NCNN_BF16
+        {
+            memcpy(outptr, (const float*)weight_data + offset, num_output * sizeof(float));
+        }
+
+        if (bias_ptr)
+        {
+            embed_add_bias(outptr, bias_ptr, num_output);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
@@ -14,6 +14,7 @@
 #endif // __AVX512F__
 #endif // __AVX__
 #endif // __SSE2__
+#include "x86_activation.h"
 #include "x86_usability.h"
 
 #include "cpu.h"
@@ -23,6 +24,7 @@ namespace ncnn {
 #if NCNN_INT8
 #include "gemm_int8.h"
 #endif
+#include "innerproduct_weight_only.h"
 
 Gemm_x86::Gemm_x86()
 {
@@ -6674,7 +6676,7 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
 
     // pack B
     const int nn_NK = nn_N * nn_K;
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -6701,12 +6703,12 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
     {
-        topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+        topT.create(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (topT.empty())
             return -100;
     }
 
-    if (nT > nn_M)
+    if (opt.num_threads > nn_M)
     {
         Mat AT(TILE_K * TILE_M, nn_K, nn_M, 4u, opt.workspace_allocator);
         if (AT.empty())
@@ -6714,7 +6716,7 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
 
         // pack A
         const int nn_MK = nn_M * nn_K;
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppik = 0; ppik < nn_MK; ppik++)
         {
             const int ppi = ppik / nn_K;
@@ -6739,7 +6741,7 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
         }
 
         const int nn_MN = nn_M * nn_N;
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppij = 0; ppij < nn_MN; ppij++)
         {
             const int ppi = ppij / nn_N;
@@ -6789,11 +6791,11 @@ static int gemm_x86(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob, int
     }
     else
     {
-        Mat ATX(TILE_K * TILE_M, nn_K, nT, 4u, opt.workspace_allocator);
+        Mat ATX(TILE_K * TILE_M, nn_K, opt.num_threads, 4u, opt.workspace_allocator);
         if (ATX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppi = 0; ppi < nn_M; ppi++)
         {
             const int i = ppi * TILE_M;
@@ -6878,7 +6880,7 @@ static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob,
 
     // pack B
     const int nn_NK = nn_N * nn_K;
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -6905,13 +6907,13 @@ static int gemm_AT_x86(const Mat& AT, const Mat& B, const Mat& C, Mat& top_blob,
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
     {
-        topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+        topT.create(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (topT.empty())
             return -100;
     }
 
     const int nn_MN = nn_M * nn_N;
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppij = 0; ppij < nn_MN; ppij++)
     {
         const int ppi = ppij / nn_N;
@@ -6976,12 +6978,12 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
     {
-        topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+        topT.create(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (topT.empty())
             return -100;
     }
 
-    if (nT > nn_M)
+    if (opt.num_threads > nn_M)
     {
         Mat AT(TILE_K * TILE_M, nn_K, nn_M, 4u, opt.workspace_allocator);
         if (AT.empty())
@@ -6989,7 +6991,7 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
 
         // pack A
         const int nn_MK = nn_M * nn_K;
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppik = 0; ppik < nn_MK; ppik++)
         {
             const int ppi = ppik / nn_K;
@@ -7014,7 +7016,7 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
         }
 
         const int nn_MN = nn_M * nn_N;
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppij = 0; ppij < nn_MN; ppij++)
         {
             const int ppi = ppij / nn_N;
@@ -7064,11 +7066,11 @@ static int gemm_BT_x86(const Mat& A, const Mat& BT, const Mat& C, Mat& top_blob,
     }
     else
     {
-        Mat ATX(TILE_K * TILE_M, nn_K, nT, 4u, opt.workspace_allocator);
+        Mat ATX(TILE_K * TILE_M, nn_K, opt.num_threads, 4u, opt.workspace_allocator);
         if (ATX.empty())
             return -100;
 
-        #pragma omp parallel for num_threads(nT)
+        #pragma omp parallel for num_threads(opt.num_threads)
         for (int ppi = 0; ppi < nn_M; ppi++)
         {
             const int i = ppi * TILE_M;
@@ -7147,13 +7149,13 @@ static int gemm_AT_BT_x86(const Mat& AT, const Mat& BT, const Mat& C, Mat& top_b
     Mat topT;
     if (K > TILE_K || broadcast_type_C == 3 || output_transpose)
     {
-        topT.create(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+        topT.create(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
         if (topT.empty())
             return -100;
     }
 
     const int nn_MN = nn_M * nn_N;
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppij = 0; ppij < nn_MN; ppij++)
     {
         const int ppi = ppij / nn_N;
@@ -7253,7 +7255,7 @@ int Gemm_x86::create_pipeline(const Option& opt)
             A_data.release();
     }
 
-    if (constantB)
+    if (constantB && !weight_quant_bits)
     {
         const int N = constantN;
         const int K = constantK;
@@ -7346,6 +7348,49 @@ int Gemm_x86::create_pipeline(const Option& opt)
     return 0;
 }
 
+int Gemm_x86::save_pipeline_weights(std::vector<Mat>& weights) const
+{
+    if (weight_quant_bits)
+    {
+        // quantized B is not transformed
+        return -1;
+    }
+
+    weights.resize(3);
+    weights[0] = AT_data;
+    weights[1] = BT_data;
+    weights[2] = CT_data;
+
+    return 0;
+}
+
+int Gemm_x86::load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt)
+{
+    if (weights.size() != 3)
+        return -1;
+
+    AT_data = weights[0];
+    BT_data = weights[1];
+    CT_data = weights[2];
+
+    if (opt.lightmode)
+    {
+        if (constantA)
+            A_data.release();
+        if (constantB)
+            B_data.release();
+        if (constantC && constant_broadcast_type_C != -1)
+            C_data.release();
+    }
+
+    if (constantA || constantB || constantC)
+    {
+        nT = opt.num_threads;
+    }
+
+    return 0;
+}
+
 int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
 {
 #if NCNN_INT8
@@ -7462,6 +7507,11 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
         }
     }
 
+    if (weight_quant_bits)
+    {
+        return forward_weight_only(bottom_blobs[0], C, broadcast_type_C, top_blobs[0], opt);
+    }
+
     int out_elempack = 1;
 #if __SSE2__
     if (opt.use_packing_layout)
@@ -7499,12 +7549,6 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
         return -100;
 
     int _nT = nT ? nT : opt.num_threads;
-    if (nT != 0 && opt.num_threads != nT)
-    {
-        // force num_threads the same as in create_pipeline
-        // so we could use pre-packed A/B from the same tile config
-        NCNN_LOGE("opt.num_threads %d changed, gemm will use load-time value %d", opt.num_threads, nT);
-    }
 
     int ret = 0;
     if (constantA && constantB)
@@ -7545,6 +7589,120 @@ int Gemm_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     return 0;
 }
 
+int Gemm_x86::forward_weight_only(const Mat& A, const Mat& C, int broadcast_type_C, Mat& top_blob, const Option& opt) const
+{
+    const int N = constantN;
+    const int K = constantK;
+
+    Option opt_unpack = opt;
+    opt_unpack.blob_allocator = opt.workspace_allocator;
+
+    // row-major A and C without packing
+    Mat A_unpacked = A;
+    if (A.elempack != 1)
+    {
+        convert_packing(A, A_unpacked, 1, opt_unpack);
+        if (A_unpacked.empty())
+            return -100;
+    }
+
+    const int M = A_unpacked.dims == 3 ? A_unpacked.c : A_unpacked.h;
+
+    if (A_unpacked.dims == 3)
+    {
+        A_unpacked = A_unpacked.reshape(K, M, opt.workspace_allocator);
+        if (A_unpacked.empty())
+            return -100;
+    }
+
+    Mat C_unpacked = C;
+    if (!C.empty() && C.elempack != 1)
+    {
+        convert_packing(C, C_unpacked, 1, opt_unpack);
+        if (C_unpacked.empty())
+            return -100;
+    }
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = M % 16 == 0 ? 16 : M % 8 == 0 ? 8 : M % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = M % 8 == 0 ? 8 : M % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = M % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+    if (output_elempack)
+        out_elempack = output_elempack;
+
+    Mat top_blob_unpacked;
+    if (out_elempack == 1 && !output_N1M)
+    {
+        top_blob.create(N, M, 4u, opt.blob_allocator);
+        top_blob_unpacked = top_blob;
+    }
+    else
+    {
+        top_blob_unpacked.create(N, M, 4u, opt.workspace_allocator);
+    }
+    if (top_blob_unpacked.empty())
+        return -100;
+
+    // C broadcast along N is the bias of each output when alpha leaves it alone
+    const bool C_as_bias = !C_unpacked.empty() && broadcast_type_C == 4 && alpha == 1.f;
+
+    int ret = innerproduct_weight_only_sse(A_unpacked, top_blob_unpacked, B_data, B_data_quant_scales, C_as_bias ? C_unpacked : Mat(), weight_quant_bits, weight_quant_group_size, 0, Mat(), opt);
+    if (ret != 0)
+        return ret;
+
+    if ((!C_unpacked.empty() && !C_as_bias) || alpha != 1.f)
+    {
+        const float* ptrC = C_as_bias ? 0 : (const float*)C_unpacked;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < M; i++)
+        {
+            float* outptr = top_blob_unpacked.row(i);
+
+            for (int j = 0; j < N; j++)
+            {
+                float sum = outptr[j];
+                if (ptrC)
+                {
+                    // C has been multiplied with beta already
+                    if (broadcast_type_C == 0)
+                        sum += ptrC[0];
+                    if (broadcast_type_C == 1 || broadcast_type_C == 2)
+                        sum += ptrC[i];
+                    if (broadcast_type_C == 3)
+                        sum += ptrC[i * N + j];
+                    if (broadcast_type_C == 4)
+                        sum += ptrC[j];
+                }
+
+                outptr[j] = sum * alpha;
+            }
+        }
+    }
+
+    if (top_blob_unpacked.data != top_blob.data)
+    {
+        Mat top_blob_shaped = output_N1M ? top_blob_unpacked.reshape(N, 1, M, opt.workspace_allocator) : top_blob_unpacked;
+        if (top_blob_shaped.empty())
+            return -100;
+
+        convert_packing(top_blob_shaped, top_blob, out_elempack, opt);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    return 0;
+}
+
 #if NCNN_INT8
 static void compute_A_tile_int8_scales(const Mat& A, Mat& scales, float B_scale, Mat& out_descales, int i, int max_ii)
 {
@@ -7631,12 +7789,12 @@ static int gemm_x86_int8(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob
     if (has_w_shift)
     {
         int w_shift_count = TILE_M >= 16 ? 16 : TILE_M >= 8 ? 8 : TILE_M >= 4 ? 4 : TILE_M >= 2 ? 2 : 1;
-        ATX.create((TILE_K + w_shift_count * 4) * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 1u, opt.workspace_allocator);
+        ATX.create((TILE_K + w_shift_count * 4) * TILE_M, (K + TILE_K - 1) / TILE_K, opt.num_threads, 1u, opt.workspace_allocator);
     }
     else
 #endif // NCNN_AVX512VNNI || NCNN_AVXVNNI
     {
-        ATX.create(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 1u, opt.workspace_allocator);
+        ATX.create(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, opt.num_threads, 1u, opt.workspace_allocator);
     }
     if (ATX.empty())
         return -100;
@@ -7662,7 +7820,7 @@ static int gemm_x86_int8(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob
     // NCNN_LOGE("arm ds %f %f", 1/A_int8_scale, 1/B_int8_scale);
 
     // pack B
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -7682,13 +7840,13 @@ static int gemm_x86_int8(const Mat& A, const Mat& B, const Mat& C, Mat& top_blob
             transpose_pack_B_tile_quantize(B, BT_tile, j, max_jj, k, max_kk, B_int8_scale);
     }
 
-    Mat topT(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat topT(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (topT.empty())
         return -100;
 
     const struct gemm_x86_int8_omp_args args = {TILE_M, TILE_N, TILE_K, broadcast_type_C, transA, output_transpose, alpha, beta};
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppi = 0; ppi < nn_M; ppi++)
     {
         // shadowed variable for less openmp task args
@@ -7794,7 +7952,7 @@ static int gemm_AT_x86_int8(const Mat& AT, const Mat& A_int8_scales, const Mat&
     }
 
     // pack B
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppjk = 0; ppjk < nn_NK; ppjk++)
     {
         const int ppj = ppjk / nn_K;
@@ -7814,13 +7972,13 @@ static int gemm_AT_x86_int8(const Mat& AT, const Mat& A_int8_scales, const Mat&
             transpose_pack_B_tile_quantize(B, BT_tile, j, max_jj, k, max_kk, B_int8_scale);
     }
 
-    Mat topT(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat topT(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (topT.empty())
         return -100;
 
     const struct gemm_x86_int8_omp_args args = {TILE_M, TILE_N, TILE_K, broadcast_type_C, 0, output_transpose, alpha, beta};
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppi = 0; ppi < nn_M; ppi++)
     {
         // shadowed variable for less openmp task args
@@ -7904,23 +8062,23 @@ static int gemm_BT_x86_int8(const Mat& A, const Mat& BT, float B_int8_scale, con
     if (has_w_shift)
     {
         int w_shift_count = TILE_M >= 16 ? 16 : TILE_M >= 8 ? 8 : TILE_M >= 4 ? 4 : TILE_M >= 2 ? 2 : 1;
-        ATX.create((TILE_K + w_shift_count * 4) * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 1u, opt.workspace_allocator);
+        ATX.create((TILE_K + w_shift_count * 4) * TILE_M, (K + TILE_K - 1) / TILE_K, opt.num_threads, 1u, opt.workspace_allocator);
     }
     else
 #endif // NCNN_AVX512VNNI || NCNN_AVXVNNI
     {
-        ATX.create(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, nT, 1u, opt.workspace_allocator);
+        ATX.create(TILE_K * TILE_M, (K + TILE_K - 1) / TILE_K, opt.num_threads, 1u, opt.workspace_allocator);
     }
     if (ATX.empty())
         return -100;
 
-    Mat topT(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat topT(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (topT.empty())
         return -100;
 
     const struct gemm_x86_int8_omp_args args = {TILE_M, TILE_N, TILE_K, broadcast_type_C, transA, output_transpose, alpha, beta};
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppi = 0; ppi < nn_M; ppi++)
     {
         // shadowed variable for less openmp task args
@@ -8011,13 +8169,13 @@ static int gemm_AT_BT_x86_int8(const Mat& AT, const Mat& A_int8_scales, const Ma
         output_descales[i] = 1.f / (A_int8_scales[i] * B_int8_scale);
     }
 
-    Mat topT(TILE_N * TILE_M, 1, nT, 4u, opt.workspace_allocator);
+    Mat topT(TILE_N * TILE_M, 1, opt.num_threads, 4u, opt.workspace_allocator);
     if (topT.empty())
         return -100;
 
     const struct gemm_x86_int8_omp_args args = {TILE_M, TILE_N, TILE_K, broadcast_type_C, 0, output_transpose, alpha, beta};
 
-    #pragma omp parallel for num_threads(nT)
+    #pragma omp parallel for num_threads(opt.num_threads)
     for (int ppi = 0; ppi < nn_M; ppi++)
     {
         // shadowed variable for less openmp task args
@@ -8316,12 +8474,6 @@ int Gemm_x86::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat
         return -100;
 
     int _nT = nT ? nT : opt.num_threads;
-    if (nT != 0 && opt.num_threads != nT)
-    {
-        // force num_threads the same as in create_pipeline
-        // so we could use pre-packed A/B from the same tile config
-        NCNN_LOGE("opt.num_threads %d changed, gemm will use load-time value %d", opt.num_threads, nT);
-    }
 
     int ret = 0;
     if (constantA && constantB)
@@ -15,15 +15,21 @@ public:
 
     virtual int create_pipeline(const Option& opt);
 
+    virtual int save_pipeline_weights(std::vector<Mat>& weights) const;
+    virtual int load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt);
+
     virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 
 protected:
+    int forward_weight_only(const Mat& A, const Mat& C, int broadcast_type_C, Mat& top_blob, const Option& opt) const;
 #if NCNN_INT8
     int create_pipeline_int8(const Option& opt);
     int forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
 #endif
 
 public:
+    // the thread count at load time picks the tile config of the pre-packed A/B
+    // forward passes it to the kernels for tiling only, they run with opt.num_threads
     int nT;
     Mat AT_data;
     Mat BT_data;
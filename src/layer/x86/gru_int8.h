@@ -0,0 +1,595 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+void gru_transform_weight_int8_avx512vnni(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt);
+int gru_int8_avx512vnni(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+void gru_transform_weight_int8_avxvnni(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt);
+int gru_int8_avxvnni(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+void gru_transform_weight_int8_avx2(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt);
+int gru_int8_avx2(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_XOP && __SSE2__ && !__XOP__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+int gru_int8_xop(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+// hidden units are packed in groups of 16, 8 and 4 as far as the integer isa allows
+static int gru_int8_unit_elempack(int remain)
+{
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+    if (remain >= 16)
+        return 16;
+#endif // __AVX512F__
+    if (remain >= 8)
+        return 8;
+#endif // __AVX2__
+    if (remain >= 4)
+        return 4;
+#endif // __SSE2__
+    return 1;
+}
+
+static void gru_transform_weight_int8(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, const Mat& bias_c, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, Mat& bias_c_tm, int size, int num_output, int num_directions, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx512_vnni())
+    {
+        gru_transform_weight_int8_avx512vnni(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, bias_c, weight_data_tm, weight_data_tm_int8_descales, bias_c_tm, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        gru_transform_weight_int8_avxvnni(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, bias_c, weight_data_tm, weight_data_tm_int8_descales, bias_c_tm, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        gru_transform_weight_int8_avx2(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, bias_c, weight_data_tm, weight_data_tm_int8_descales, bias_c_tm, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+    // the group of units starting at q takes row q
+    // each input pair k holds R U N of all units in the group, two consecutive k per unit
+    // odd size and num_output are padded with zero weights
+    const int size2 = size + size % 2;
+    const int num_output2 = num_output + num_output % 2;
+
+    weight_data_tm.create((size2 + num_output2) * 3, num_output, num_directions, (size_t)1u);
+    weight_data_tm_int8_descales.create(6, num_output, num_directions);
+    bias_c_tm.create(4, num_output, num_directions);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc_dr = weight_xc.channel(dr);
+        const Mat weight_hc_dr = weight_hc.channel(dr);
+        const Mat bias_c_dr = bias_c.channel(dr);
+        const float* weight_xc_int8_scales_ptr = weight_xc_int8_scales.row(dr);
+        const float* weight_hc_int8_scales_ptr = weight_hc_int8_scales.row(dr);
+
+        Mat weight_data_tm_dr = weight_data_tm.channel(dr);
+        Mat weight_data_tm_int8_descales_dr = weight_data_tm_int8_descales.channel(dr);
+        Mat bias_c_tm_dr = bias_c_tm.channel(dr);
+
+        for (int q = 0; q < num_output;)
+        {
+            const int elempack = gru_int8_unit_elempack(num_output - q);
+
+            float* bias_c_RUBN = bias_c_tm_dr.row(q);
+            for (int k = 0; k < 4; k++)
+            {
+                const float* bias_c_k = bias_c_dr.row(k);
+                for (int j = 0; j < elempack; j++)
+                {
+                    *bias_c_RUBN++ = bias_c_k[q + j];
+                }
+            }
+
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q);
+            for (int k = 0; k < 3; k++)
+            {
+                for (int j = 0; j < elempack; j++)
+                {
+                    *descales_ptr++ = 1.f / weight_xc_int8_scales_ptr[num_output * k + q + j];
+                }
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                for (int j = 0; j < elempack; j++)
+                {
+                    *descales_ptr++ = 1.f / weight_hc_int8_scales_ptr[num_output * k + q + j];
+                }
+            }
+
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q);
+            for (int i = 0; i < size; i += 2)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    for (int j = 0; j < elempack; j++)
+                    {
+                        const signed char* weight_xc_ptr = weight_xc_dr.row<const signed char>(num_output * k + q + j);
+
+                        kptr[0] = weight_xc_ptr[i];
+                        kptr[1] = i + 1 < size ? weight_xc_ptr[i + 1] : 0;
+                        kptr += 2;
+                    }
+                }
+            }
+            for (int i = 0; i < num_output; i += 2)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    for (int j = 0; j < elempack; j++)
+                    {
+                        const signed char* weight_hc_ptr = weight_hc_dr.row<const signed char>(num_output * k + q + j);
+
+                        kptr[0] = weight_hc_ptr[i];
+                        kptr[1] = i + 1 < num_output ? weight_hc_ptr[i + 1] : 0;
+                        kptr += 2;
+                    }
+                }
+            }
+
+            q += elempack;
+        }
+    }
+}
+
+static float gru_dynamic_quantize_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _absmax_avx512 = _mm512_set1_ps(0.f);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr + i);
+        _absmax_avx512 = _mm512_max_ps(_absmax_avx512, abs512_ps(_p));
+    }
+    absmax = std::max(absmax, _mm512_comp_reduce_max_ps(_absmax_avx512));
+#endif // __AVX512F__
+    __m256 _absmax_avx = _mm256_set1_ps(0.f);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr + i);
+        _absmax_avx = _mm256_max_ps(_absmax_avx, abs256_ps(_p));
+    }
+    absmax = std::max(absmax, _mm256_reduce_max_ps(_absmax_avx));
+#endif // __AVX__
+    __m128 _absmax = _mm_set1_ps(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr + i);
+        _absmax = _mm_max_ps(_absmax, abs_ps(_p));
+    }
+    absmax = std::max(absmax, _mm_reduce_max_ps(_absmax));
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(ptr[i]));
+    }
+
+    return absmax;
+}
+
+// int8 values widened to int16, odd size gets one zero appended
+static void gru_dynamic_quantize_scale2int8(const float* ptr, int size, float scale, short* outptr)
+{
+    for (int i = 0; i < size; i++)
+    {
+        outptr[i] = float2int8(ptr[i] * scale);
+    }
+
+    if (size % 2)
+        outptr[size] = 0;
+}
+
+static int gru_int8(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx512_vnni())
+    {
+        return gru_int8_avx512vnni(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        return gru_int8_avxvnni(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        return gru_int8_avx2(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_XOP && __SSE2__ && !__XOP__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_xop())
+    {
+        return gru_int8_xop(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+    // size is padded to even already
+    const int size = bottom_blob_int8.w;
+    const int T = bottom_blob_int8.h;
+
+    const int num_output = top_blob.w;
+    const int num_output2 = num_output + num_output % 2;
+
+    // U and N of all units
+    Mat gates(num_output, 2, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    Mat hidden_state_int8(num_output2, (size_t)2u, 1, opt.workspace_allocator);
+    if (hidden_state_int8.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        const int ti = reverse ? T - 1 - t : t;
+
+        // dynamic quantize hidden_state
+        const float absmax = gru_dynamic_quantize_get_absmax(hidden_state, num_output);
+        gru_dynamic_quantize_scale2int8(hidden_state, num_output, absmax == 0.f ? 0.f : 127.f / absmax, hidden_state_int8);
+
+        const short* x = bottom_blob_int8.row<const short>(ti);
+        const short* hs = hidden_state_int8;
+        const float descale_x = bottom_blob_int8_descales[ti];
+        const float descale_h = absmax / 127.f;
+
+        float* gates_U = gates.row(0);
+        float* gates_N = gates.row(1);
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 4;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 16;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+                const float* bias_c_RUBN = bias_c.row(q);
+
+                __m512i _Rx = _mm512_setzero_si512();
+                __m512i _Ux = _mm512_setzero_si512();
+                __m512i _Nx = _mm512_setzero_si512();
+                for (int i = 0; i < size; i += 2)
+                {
+                    __m512i _xi = _mm512_set1_epi32(*(const int*)(x + i));
+                    __m512i _w0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    __m512i _w1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 32)));
+                    __m512i _w2 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 64)));
+                    _Rx = _mm512_comp_dpwssd_epi32(_Rx, _w0, _xi);
+                    _Ux = _mm512_comp_dpwssd_epi32(_Ux, _w1, _xi);
+                    _Nx = _mm512_comp_dpwssd_epi32(_Nx, _w2, _xi);
+
+                    kptr += 96;
+                }
+
+                __m512i _Rh = _mm512_setzero_si512();
+                __m512i _Uh = _mm512_setzero_si512();
+                __m512i _Nh = _mm512_setzero_si512();
+                for (int i = 0; i < num_output2; i += 2)
+                {
+                    __m512i _h_cont = _mm512_set1_epi32(*(const int*)(hs + i));
+                    __m512i _w0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    __m512i _w1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 32)));
+                    __m512i _w2 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 64)));
+                    _Rh = _mm512_comp_dpwssd_epi32(_Rh, _w0, _h_cont);
+                    _Uh = _mm512_comp_dpwssd_epi32(_Uh, _w1, _h_cont);
+                    _Nh = _mm512_comp_dpwssd_epi32(_Nh, _w2, _h_cont);
+
+                    kptr += 96;
+                }
+
+                __m512 _descale_x = _mm512_set1_ps(descale_x);
+                __m512 _descale_h = _mm512_set1_ps(descale_h);
+
+                __m512 _R = _mm512_loadu_ps(bias_c_RUBN);
+                __m512 _U = _mm512_loadu_ps(bias_c_RUBN + 16);
+                __m512 _WN = _mm512_loadu_ps(bias_c_RUBN + 32);
+                __m512 _BN = _mm512_loadu_ps(bias_c_RUBN + 48);
+                _R = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Rx), _mm512_mul_ps(_descale_x, _mm512_loadu_ps(descales_ptr)), _R);
+                _U = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Ux), _mm512_mul_ps(_descale_x, _mm512_loadu_ps(descales_ptr + 16)), _U);
+                _WN = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Nx), _mm512_mul_ps(_descale_x, _mm512_loadu_ps(descales_ptr + 32)), _WN);
+                _R = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Rh), _mm512_mul_ps(_descale_h, _mm512_loadu_ps(descales_ptr + 48)), _R);
+                _U = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Uh), _mm512_mul_ps(_descale_h, _mm512_loadu_ps(descales_ptr + 64)), _U);
+                _BN = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_Nh), _mm512_mul_ps(_descale_h, _mm512_loadu_ps(descales_ptr + 80)), _BN);
+
+                _R = sigmoid_avx512(_R);
+                _U = sigmoid_avx512(_U);
+                __m512 _N = tanh_avx512(_mm512_fmadd_ps(_R, _BN, _WN));
+
+                _mm512_storeu_ps(gates_U + q, _U);
+                _mm512_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 4;
+        }
+#endif // __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 3;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 8;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+                const float* bias_c_RUBN = bias_c.row(q);
+
+                __m256i _Rx = _mm256_setzero_si256();
+                __m256i _Ux = _mm256_setzero_si256();
+                __m256i _Nx = _mm256_setzero_si256();
+                for (int i = 0; i < size; i += 2)
+                {
+                    __m256i _xi = _mm256_set1_epi32(*(const int*)(x + i));
+                    __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+                    __m256i _w2 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 32)));
+                    _Rx = _mm256_comp_dpwssd_epi32(_Rx, _w0, _xi);
+                    _Ux = _mm256_comp_dpwssd_epi32(_Ux, _w1, _xi);
+                    _Nx = _mm256_comp_dpwssd_epi32(_Nx, _w2, _xi);
+
+                    kptr += 48;
+                }
+
+                __m256i _Rh = _mm256_setzero_si256();
+                __m256i _Uh = _mm256_setzero_si256();
+                __m256i _Nh = _mm256_setzero_si256();
+                for (int i = 0; i < num_output2; i += 2)
+                {
+                    __m256i _h_cont = _mm256_set1_epi32(*(const int*)(hs + i));
+                    __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+                    __m256i _w2 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 32)));
+                    _Rh = _mm256_comp_dpwssd_epi32(_Rh, _w0, _h_cont);
+                    _Uh = _mm256_comp_dpwssd_epi32(_Uh, _w1, _h_cont);
+                    _Nh = _mm256_comp_dpwssd_epi32(_Nh, _w2, _h_cont);
+
+                    kptr += 48;
+                }
+
+                __m256 _descale_x = _mm256_set1_ps(descale_x);
+                __m256 _descale_h = _mm256_set1_ps(descale_h);
+
+                __m256 _R = _mm256_loadu_ps(bias_c_RUBN);
+                __m256 _U = _mm256_loadu_ps(bias_c_RUBN + 8);
+                __m256 _WN = _mm256_loadu_ps(bias_c_RUBN + 16);
+                __m256 _BN = _mm256_loadu_ps(bias_c_RUBN + 24);
+                _R = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Rx), _mm256_mul_ps(_descale_x, _mm256_loadu_ps(descales_ptr)), _R);
+                _U = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Ux), _mm256_mul_ps(_descale_x, _mm256_loadu_ps(descales_ptr + 8)), _U);
+                _WN = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Nx), _mm256_mul_ps(_descale_x, _mm256_loadu_ps(descales_ptr + 16)), _WN);
+                _R = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Rh), _mm256_mul_ps(_descale_h, _mm256_loadu_ps(descales_ptr + 24)), _R);
+                _U = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Uh), _mm256_mul_ps(_descale_h, _mm256_loadu_ps(descales_ptr + 32)), _U);
+                _BN = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_Nh), _mm256_mul_ps(_descale_h, _mm256_loadu_ps(descales_ptr + 40)), _BN);
+
+                _R = sigmoid_avx(_R);
+                _U = sigmoid_avx(_U);
+                __m256 _N = tanh_avx(_mm256_comp_fmadd_ps(_R, _BN, _WN));
+
+                _mm256_storeu_ps(gates_U + q, _U);
+                _mm256_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 3;
+        }
+#endif // __AVX2__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 2;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 4;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+                const float* bias_c_RUBN = bias_c.row(q);
+
+                __m128i _Rx = _mm_setzero_si128();
+                __m128i _Ux = _mm_setzero_si128();
+                __m128i _Nx = _mm_setzero_si128();
+                for (int i = 0; i < size; i += 2)
+                {
+                    __m128i _xi = _mm_set1_epi32(*(const int*)(x + i));
+                    __m128i _w0 = _mm_loadl_epi64((const __m128i*)kptr);
+                    __m128i _w1 = _mm_loadl_epi64((const __m128i*)(kptr + 8));
+                    __m128i _w2 = _mm_loadl_epi64((const __m128i*)(kptr + 16));
+#if __SSE4_1__
+                    _w0 = _mm_cvtepi8_epi16(_w0);
+                    _w1 = _mm_cvtepi8_epi16(_w1);
+                    _w2 = _mm_cvtepi8_epi16(_w2);
+#else
+                    _w0 = _mm_unpacklo_epi8(_w0, _mm_cmpgt_epi8(_mm_setzero_si128(), _w0));
+                    _w1 = _mm_unpacklo_epi8(_w1, _mm_cmpgt_epi8(_mm_setzero_si128(), _w1));
+                    _w2 = _mm_unpacklo_epi8(_w2, _mm_cmpgt_epi8(_mm_setzero_si128(), _w2));
+#endif
+                    _Rx = _mm_comp_dpwssd_epi32(_Rx, _w0, _xi);
+                    _Ux = _mm_comp_dpwssd_epi32(_Ux, _w1, _xi);
+                    _Nx = _mm_comp_dpwssd_epi32(_Nx, _w2, _xi);
+
+                    kptr += 24;
+                }
+
+                __m128i _Rh = _mm_setzero_si128();
+                __m128i _Uh = _mm_setzero_si128();
+                __m128i _Nh = _mm_setzero_si128();
+                for (int i = 0; i < num_output2; i += 2)
+                {
+                    __m128i _h_cont = _mm_set1_epi32(*(const int*)(hs + i));
+                    __m128i _w0 = _mm_loadl_epi64((const __m128i*)kptr);
+                    __m128i _w1 = _mm_loadl_epi64((const __m128i*)(kptr + 8));
+                    __m128i _w2 = _mm_loadl_epi64((const __m128i*)(kptr + 16));
+#if __SSE4_1__
+                    _w0 = _mm_cvtepi8_epi16(_w0);
+                    _w1 = _mm_cvtepi8_epi16(_w1);
+                    _w2 = _mm_cvtepi8_epi16(_w2);
+#else
+                    _w0 = _mm_unpacklo_epi8(_w0, _mm_cmpgt_epi8(_mm_setzero_si128(), _w0));
+                    _w1 = _mm_unpacklo_epi8(_w1, _mm_cmpgt_epi8(_mm_setzero_si128(), _w1));
+                    _w2 = _mm_unpacklo_epi8(_w2, _mm_cmpgt_epi8(_mm_setzero_si128(), _w2));
+#endif
+                    _Rh = _mm_comp_dpwssd_epi32(_Rh, _w0, _h_cont);
+                    _Uh = _mm_comp_dpwssd_epi32(_Uh, _w1, _h_cont);
+                    _Nh = _mm_comp_dpwssd_epi32(_Nh, _w2, _h_cont);
+
+                    kptr += 24;
+                }
+
+                __m128 _descale_x = _mm_set1_ps(descale_x);
+                __m128 _descale_h = _mm_set1_ps(descale_h);
+
+                __m128 _R = _mm_loadu_ps(bias_c_RUBN);
+                __m128 _U = _mm_loadu_ps(bias_c_RUBN + 4);
+                __m128 _WN = _mm_loadu_ps(bias_c_RUBN + 8);
+                __m128 _BN = _mm_loadu_ps(bias_c_RUBN + 12);
+                _R = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Rx), _mm_mul_ps(_descale_x, _mm_loadu_ps(descales_ptr)), _R);
+                _U = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Ux), _mm_mul_ps(_descale_x, _mm_loadu_ps(descales_ptr + 4)), _U);
+                _WN = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Nx), _mm_mul_ps(_descale_x, _mm_loadu_ps(descales_ptr + 8)), _WN);
+                _R = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Rh), _mm_mul_ps(_descale_h, _mm_loadu_ps(descales_ptr + 12)), _R);
+                _U = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Uh), _mm_mul_ps(_descale_h, _mm_loadu_ps(descales_ptr + 16)), _U);
+                _BN = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_Nh), _mm_mul_ps(_descale_h, _mm_loadu_ps(descales_ptr + 20)), _BN);
+
+                _R = sigmoid_sse(_R);
+                _U = sigmoid_sse(_U);
+                __m128 _N = tanh_sse(_mm_comp_fmadd_ps(_R, _BN, _WN));
+
+                _mm_storeu_ps(gates_U + q, _U);
+                _mm_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 2;
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+            const signed char* kptr = weight_data_tm.row<const signed char>(q);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+            const float* bias_c_RUBN = bias_c.row(q);
+
+            int Rx = 0;
+            int Ux = 0;
+            int Nx = 0;
+            for (int i = 0; i < size; i += 2)
+            {
+                short xi0 = x[i];
+                short xi1 = x[i + 1];
+
+                Rx += kptr[0] * xi0 + kptr[1] * xi1;
+                Ux += kptr[2] * xi0 + kptr[3] * xi1;
+                Nx += kptr[4] * xi0 + kptr[5] * xi1;
+
+                kptr += 6;
+            }
+
+            int Rh = 0;
+            int Uh = 0;
+            int Nh = 0;
+            for (int i = 0; i < num_output2; i += 2)
+            {
+                short h_cont0 = hs[i];
+                short h_cont1 = hs[i + 1];
+
+                Rh += kptr[0] * h_cont0 + kptr[1] * h_cont1;
+                Uh += kptr[2] * h_cont0 + kptr[3] * h_cont1;
+                Nh += kptr[4] * h_cont0 + kptr[5] * h_cont1;
+
+                kptr += 6;
+            }
+
+            float R = bias_c_RUBN[0] + Rx * (descale_x * descales_ptr[0]) + Rh * (descale_h * descales_ptr[3]);
+            float U = bias_c_RUBN[1] + Ux * (descale_x * descales_ptr[1]) + Uh * (descale_h * descales_ptr[4]);
+            float WN = bias_c_RUBN[2] + Nx * (descale_x * descales_ptr[2]);
+            float BN = bias_c_RUBN[3] + Nh * (descale_h * descales_ptr[5]);
+
+            // sigmoid(R)
+            // sigmoid(U)
+            R = 1.f / (1.f + expf(-R));
+            U = 1.f / (1.f + expf(-U));
+
+            // tanh(N)
+            float N = tanhf(WN + R * BN);
+
+            gates_U[q] = U;
+            gates_N[q] = N;
+        }
+
+        // h_t := (1 - update) .* new + update .* h_{t-1}
+        float* output_data = top_blob.row(ti);
+        float* hidden_ptr = hidden_state;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i + 15 < num_output; i += 16)
+        {
+            __m512 _U = _mm512_loadu_ps(gates_U + i);
+            __m512 _N = _mm512_loadu_ps(gates_N + i);
+            __m512 _H = _mm512_fmadd_ps(_U, _mm512_sub_ps(_mm512_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm512_storeu_ps(hidden_ptr + i, _H);
+            _mm512_storeu_ps(output_data + i, _H);
+        }
+#endif // __AVX512F__
+        for (; i + 7 < num_output; i += 8)
+        {
+            __m256 _U = _mm256_loadu_ps(gates_U + i);
+            __m256 _N = _mm256_loadu_ps(gates_N + i);
+            __m256 _H = _mm256_comp_fmadd_ps(_U, _mm256_sub_ps(_mm256_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm256_storeu_ps(hidden_ptr + i, _H);
+            _mm256_storeu_ps(output_data + i, _H);
+        }
+#endif // __AVX__
+        for (; i + 3 < num_output; i += 4)
+        {
+            __m128 _U = _mm_loadu_ps(gates_U + i);
+            __m128 _N = _mm_loadu_ps(gates_N + i);
+            __m128 _H = _mm_comp_fmadd_ps(_U, _mm_sub_ps(_mm_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm_storeu_ps(hidden_ptr + i, _H);
+            _mm_storeu_ps(output_data + i, _H);
+        }
+#endif // __SSE2__
+        for (; i < num_output; i++)
+        {
+            float U = gates_U[i];
+            float N = gates_N[i];
+
+            float H = (1 - U) * N + U * hidden_ptr[i];
+
+            hidden_ptr[i] = H;
+            output_data[i] = H;
+        }
+    }
+
+    return 0;
+}
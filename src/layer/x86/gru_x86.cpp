@@ -0,0 +1,861 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "gru_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_activation.h"
+#include "x86_usability.h"
+
+#include "cpu.h"
+
+namespace ncnn {
+
+#include "gru_int8.h"
+
+GRU_x86::GRU_x86()
+{
+    one_blob_only = false;
+    support_inplace = false;
+}
+
+// hidden units are packed in groups of 16, 8 and 4 as far as the isa allows
+static int gru_unit_elempack(int remain)
+{
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (remain >= 16)
+        return 16;
+#endif // __AVX512F__
+    if (remain >= 8)
+        return 8;
+#endif // __AVX__
+    if (remain >= 4)
+        return 4;
+#endif // __SSE2__
+    return 1;
+}
+
+int GRU_x86::create_pipeline(const Option& opt)
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return create_pipeline_int8(opt);
+    }
+#endif
+
+    // pack RUN
+    // the group of units starting at q takes row q, each input i holds R U N of all units in the group
+    const int num_directions = direction == 2 ? 2 : 1;
+    const int size = weight_data_size / num_directions / num_output / 3;
+
+    weight_xc_data_packed.create(size * 3, num_output, num_directions);
+    bias_c_data_packed.create(4, num_output, num_directions);
+    weight_hc_data_packed.create(num_output * 3, num_output, num_directions);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc = weight_xc_data.channel(dr);
+        const Mat bias_c = bias_c_data.channel(dr);
+        const Mat weight_hc = weight_hc_data.channel(dr);
+
+        Mat weight_xc_data_packed_dr = weight_xc_data_packed.channel(dr);
+        Mat bias_c_data_packed_dr = bias_c_data_packed.channel(dr);
+        Mat weight_hc_data_packed_dr = weight_hc_data_packed.channel(dr);
+
+        for (int q = 0; q < num_output;)
+        {
+            const int elempack = gru_unit_elempack(num_output - q);
+
+            float* bias_c_RUBN = bias_c_data_packed_dr.row(q);
+            for (int k = 0; k < 4; k++)
+            {
+                const float* bias_c_k = bias_c.row(k);
+                for (int j = 0; j < elempack; j++)
+                {
+                    *bias_c_RUBN++ = bias_c_k[q + j];
+                }
+            }
+
+            float* weight_xc_RUN = weight_xc_data_packed_dr.row(q);
+            for (int i = 0; i < size; i++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    for (int j = 0; j < elempack; j++)
+                    {
+                        *weight_xc_RUN++ = weight_xc.row(num_output * k + q + j)[i];
+                    }
+                }
+            }
+
+            float* weight_hc_RUN = weight_hc_data_packed_dr.row(q);
+            for (int i = 0; i < num_output; i++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    for (int j = 0; j < elempack; j++)
+                    {
+                        *weight_hc_RUN++ = weight_hc.row(num_output * k + q + j)[i];
+                    }
+                }
+            }
+
+            q += elempack;
+        }
+    }
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+    }
+
+    return 0;
+}
+
+static int gru(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc, const Mat& bias_c, const Mat& weight_hc, Mat& hidden_state, const Option& opt)
+{
+    const int size = bottom_blob.w;
+    const int T = bottom_blob.h;
+
+    const int num_output = top_blob.w;
+
+    // U and N of all units
+    Mat gates(num_output, 2, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        const int ti = reverse ? T - 1 - t : t;
+
+        const float* x = bottom_blob.row(ti);
+        const float* hs = hidden_state;
+
+        float* gates_U = gates.row(0);
+        float* gates_N = gates.row(1);
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 4;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 16;
+
+                const float* bias_c_RUBN = bias_c.row(q);
+                const float* weight_xc_RUN = weight_xc.row(q);
+                const float* weight_hc_RUN = weight_hc.row(q);
+
+                __m512 _R = _mm512_loadu_ps(bias_c_RUBN);
+                __m512 _U = _mm512_loadu_ps(bias_c_RUBN + 16);
+                __m512 _Nx = _mm512_loadu_ps(bias_c_RUBN + 32);
+                __m512 _Nh = _mm512_loadu_ps(bias_c_RUBN + 48);
+                __m512 _R1 = _mm512_setzero_ps();
+                __m512 _U1 = _mm512_setzero_ps();
+                __m512 _Nx1 = _mm512_setzero_ps();
+                __m512 _Nh1 = _mm512_setzero_ps();
+
+                int i = 0;
+                for (; i + 1 < size; i += 2)
+                {
+                    __m512 _xi0 = _mm512_set1_ps(x[i]);
+                    __m512 _xi1 = _mm512_set1_ps(x[i + 1]);
+                    _R = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN), _xi0, _R);
+                    _U = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 16), _xi0, _U);
+                    _Nx = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 32), _xi0, _Nx);
+                    _R1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 48), _xi1, _R1);
+                    _U1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 64), _xi1, _U1);
+                    _Nx1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 80), _xi1, _Nx1);
+
+                    weight_xc_RUN += 96;
+                }
+                for (; i < size; i++)
+                {
+                    __m512 _xi = _mm512_set1_ps(x[i]);
+                    _R = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN), _xi, _R);
+                    _U = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 16), _xi, _U);
+                    _Nx = _mm512_fmadd_ps(_mm512_loadu_ps(weight_xc_RUN + 32), _xi, _Nx);
+
+                    weight_xc_RUN += 48;
+                }
+
+                i = 0;
+                for (; i + 1 < num_output; i += 2)
+                {
+                    __m512 _h_cont0 = _mm512_set1_ps(hs[i]);
+                    __m512 _h_cont1 = _mm512_set1_ps(hs[i + 1]);
+                    _R = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN), _h_cont0, _R);
+                    _U = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 16), _h_cont0, _U);
+                    _Nh = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 32), _h_cont0, _Nh);
+                    _R1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 48), _h_cont1, _R1);
+                    _U1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 64), _h_cont1, _U1);
+                    _Nh1 = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 80), _h_cont1, _Nh1);
+
+                    weight_hc_RUN += 96;
+                }
+                for (; i < num_output; i++)
+                {
+                    __m512 _h_cont = _mm512_set1_ps(hs[i]);
+                    _R = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN), _h_cont, _R);
+                    _U = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 16), _h_cont, _U);
+                    _Nh = _mm512_fmadd_ps(_mm512_loadu_ps(weight_hc_RUN + 32), _h_cont, _Nh);
+
+                    weight_hc_RUN += 48;
+                }
+
+                _R = sigmoid_avx512(_mm512_add_ps(_R, _R1));
+                _U = sigmoid_avx512(_mm512_add_ps(_U, _U1));
+                _Nx = _mm512_add_ps(_Nx, _Nx1);
+                _Nh = _mm512_add_ps(_Nh, _Nh1);
+
+                // tanh(WN + R * BN)
+                __m512 _N = tanh_avx512(_mm512_fmadd_ps(_R, _Nh, _Nx));
+
+                _mm512_storeu_ps(gates_U + q, _U);
+                _mm512_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 4;
+        }
+#endif // __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 3;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 8;
+
+                const float* bias_c_RUBN = bias_c.row(q);
+                const float* weight_xc_RUN = weight_xc.row(q);
+                const float* weight_hc_RUN = weight_hc.row(q);
+
+                __m256 _R = _mm256_loadu_ps(bias_c_RUBN);
+                __m256 _U = _mm256_loadu_ps(bias_c_RUBN + 8);
+                __m256 _Nx = _mm256_loadu_ps(bias_c_RUBN + 16);
+                __m256 _Nh = _mm256_loadu_ps(bias_c_RUBN + 24);
+                __m256 _R1 = _mm256_setzero_ps();
+                __m256 _U1 = _mm256_setzero_ps();
+                __m256 _Nx1 = _mm256_setzero_ps();
+                __m256 _Nh1 = _mm256_setzero_ps();
+
+                int i = 0;
+                for (; i + 1 < size; i += 2)
+                {
+                    __m256 _xi0 = _mm256_set1_ps(x[i]);
+                    __m256 _xi1 = _mm256_set1_ps(x[i + 1]);
+                    _R = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN), _xi0, _R);
+                    _U = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 8), _xi0, _U);
+                    _Nx = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 16), _xi0, _Nx);
+                    _R1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 24), _xi1, _R1);
+                    _U1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 32), _xi1, _U1);
+                    _Nx1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 40), _xi1, _Nx1);
+
+                    weight_xc_RUN += 48;
+                }
+                for (; i < size; i++)
+                {
+                    __m256 _xi = _mm256_set1_ps(x[i]);
+                    _R = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN), _xi, _R);
+                    _U = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 8), _xi, _U);
+                    _Nx = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_xc_RUN + 16), _xi, _Nx);
+
+                    weight_xc_RUN += 24;
+                }
+
+                i = 0;
+                for (; i + 1 < num_output; i += 2)
+                {
+                    __m256 _h_cont0 = _mm256_set1_ps(hs[i]);
+                    __m256 _h_cont1 = _mm256_set1_ps(hs[i + 1]);
+                    _R = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN), _h_cont0, _R);
+                    _U = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 8), _h_cont0, _U);
+                    _Nh = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 16), _h_cont0, _Nh);
+                    _R1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 24), _h_cont1, _R1);
+                    _U1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 32), _h_cont1, _U1);
+                    _Nh1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 40), _h_cont1, _Nh1);
+
+                    weight_hc_RUN += 48;
+                }
+                for (; i < num_output; i++)
+                {
+                    __m256 _h_cont = _mm256_set1_ps(hs[i]);
+                    _R = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN), _h_cont, _R);
+                    _U = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 8), _h_cont, _U);
+                    _Nh = _mm256_comp_fmadd_ps(_mm256_loadu_ps(weight_hc_RUN + 16), _h_cont, _Nh);
+
+                    weight_hc_RUN += 24;
+                }
+
+                _R = sigmoid_avx(_mm256_add_ps(_R, _R1));
+                _U = sigmoid_avx(_mm256_add_ps(_U, _U1));
+                _Nx = _mm256_add_ps(_Nx, _Nx1);
+                _Nh = _mm256_add_ps(_Nh, _Nh1);
+
+                __m256 _N = tanh_avx(_mm256_comp_fmadd_ps(_R, _Nh, _Nx));
+
+                _mm256_storeu_ps(gates_U + q, _U);
+                _mm256_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 3;
+        }
+#endif // __AVX__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 2;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 4;
+
+                const float* bias_c_RUBN = bias_c.row(q);
+                const float* weight_xc_RUN = weight_xc.row(q);
+                const float* weight_hc_RUN = weight_hc.row(q);
+
+                __m128 _R = _mm_loadu_ps(bias_c_RUBN);
+                __m128 _U = _mm_loadu_ps(bias_c_RUBN + 4);
+                __m128 _Nx = _mm_loadu_ps(bias_c_RUBN + 8);
+                __m128 _Nh = _mm_loadu_ps(bias_c_RUBN + 12);
+                __m128 _R1 = _mm_setzero_ps();
+                __m128 _U1 = _mm_setzero_ps();
+                __m128 _Nx1 = _mm_setzero_ps();
+                __m128 _Nh1 = _mm_setzero_ps();
+
+                int i = 0;
+                for (; i + 1 < size; i += 2)
+                {
+                    __m128 _xi0 = _mm_set1_ps(x[i]);
+                    __m128 _xi1 = _mm_set1_ps(x[i + 1]);
+                    _R = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN), _xi0, _R);
+                    _U = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 4), _xi0, _U);
+                    _Nx = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 8), _xi0, _Nx);
+                    _R1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 12), _xi1, _R1);
+                    _U1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 16), _xi1, _U1);
+                    _Nx1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 20), _xi1, _Nx1);
+
+                    weight_xc_RUN += 24;
+                }
+                for (; i < size; i++)
+                {
+                    __m128 _xi = _mm_set1_ps(x[i]);
+                    _R = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN), _xi, _R);
+                    _U = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 4), _xi, _U);
+                    _Nx = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_xc_RUN + 8), _xi, _Nx);
+
+                    weight_xc_RUN += 12;
+                }
+
+                i = 0;
+                for (; i + 1 < num_output; i += 2)
+                {
+                    __m128 _h_cont0 = _mm_set1_ps(hs[i]);
+                    __m128 _h_cont1 = _mm_set1_ps(hs[i + 1]);
+                    _R = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN), _h_cont0, _R);
+                    _U = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 4), _h_cont0, _U);
+                    _Nh = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 8), _h_cont0, _Nh);
+                    _R1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 12), _h_cont1, _R1);
+                    _U1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 16), _h_cont1, _U1);
+                    _Nh1 = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 20), _h_cont1, _Nh1);
+
+                    weight_hc_RUN += 24;
+                }
+                for (; i < num_output; i++)
+                {
+                    __m128 _h_cont = _mm_set1_ps(hs[i]);
+                    _R = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN), _h_cont, _R);
+                    _U = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 4), _h_cont, _U);
+                    _Nh = _mm_comp_fmadd_ps(_mm_loadu_ps(weight_hc_RUN + 8), _h_cont, _Nh);
+
+                    weight_hc_RUN += 12;
+                }
+
+                _R = sigmoid_sse(_mm_add_ps(_R, _R1));
+                _U = sigmoid_sse(_mm_add_ps(_U, _U1));
+                _Nx = _mm_add_ps(_Nx, _Nx1);
+                _Nh = _mm_add_ps(_Nh, _Nh1);
+
+                __m128 _N = tanh_sse(_mm_comp_fmadd_ps(_R, _Nh, _Nx));
+
+                _mm_storeu_ps(gates_U + q, _U);
+                _mm_storeu_ps(gates_N + q, _N);
+            }
+            remain_num_output_start += nn_num_output << 2;
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+            const float* bias_c_RUBN = bias_c.row(q);
+            const float* weight_xc_RUN = weight_xc.row(q);
+            const float* weight_hc_RUN = weight_hc.row(q);
+
+            float R = bias_c_RUBN[0];
+            float U = bias_c_RUBN[1];
+            float Nx = bias_c_RUBN[2];
+            float Nh = bias_c_RUBN[3];
+
+            for (int i = 0; i < size; i++)
+            {
+                float xi = x[i];
+
+                R += weight_xc_RUN[0] * xi;
+                U += weight_xc_RUN[1] * xi;
+                Nx += weight_xc_RUN[2] * xi;
+
+                weight_xc_RUN += 3;
+            }
+
+            for (int i = 0; i < num_output; i++)
+            {
+                float h_cont = hs[i];
+
+                R += weight_hc_RUN[0] * h_cont;
+                U += weight_hc_RUN[1] * h_cont;
+                Nh += weight_hc_RUN[2] * h_cont;
+
+                weight_hc_RUN += 3;
+            }
+
+            // sigmoid(R)
+            // sigmoid(U)
+            R = 1.f / (1.f + expf(-R));
+            U = 1.f / (1.f + expf(-U));
+
+            // tanh(N)
+            float N = tanhf(Nx + R * Nh);
+
+            gates_U[q] = U;
+            gates_N[q] = N;
+        }
+
+        // h_t := (1 - update) .* new + update .* h_{t-1}
+        float* output_data = top_blob.row(ti);
+        float* hidden_ptr = hidden_state;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i + 15 < num_output; i += 16)
+        {
+            __m512 _U = _mm512_loadu_ps(gates_U + i);
+            __m512 _N = _mm512_loadu_ps(gates_N + i);
+            __m512 _H = _mm512_fmadd_ps(_U, _mm512_sub_ps(_mm512_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm512_storeu_ps(hidden_ptr + i, _H);
+            _mm512_storeu_ps(output_data + i, _H);
+        }
+#endif // __AVX512F__
+        for (; i + 7 < num_output; i += 8)
+        {
+            __m256 _U = _mm256_loadu_ps(gates_U + i);
+            __m256 _N = _mm256_loadu_ps(gates_N + i);
+            __m256 _H = _mm256_comp_fmadd_ps(_U, _mm256_sub_ps(_mm256_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm256_storeu_ps(hidden_ptr + i, _H);
+            _mm256_storeu_ps(output_data + i, _H);
+        }
+#endif // __AVX__
+        for (; i + 3 < num_output; i += 4)
+        {
+            __m128 _U = _mm_loadu_ps(gates_U + i);
+            __m128 _N = _mm_loadu_ps(gates_N + i);
+            __m128 _H = _mm_comp_fmadd_ps(_U, _mm_sub_ps(_mm_loadu_ps(hidden_ptr + i), _N), _N);
+            _mm_storeu_ps(hidden_ptr + i, _H);
+            _mm_storeu_ps(output_data + i, _H);
+        }
+#endif // __SSE2__
+        for (; i < num_output; i++)
+        {
+            float U = gates_U[i];
+            float N = gates_N[i];
+
+            float H = (1 - U) * N + U * hidden_ptr[i];
+
+            hidden_ptr[i] = H;
+            output_data[i] = H;
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blob, top_blob, opt);
+    }
+#endif
+
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            int ret = gru(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        hidden.fill(0.0f);
+
+        {
+            int ret = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+#if NCNN_INT8
+    if (int8_scale_term)
+    {
+        return forward_int8(bottom_blobs, top_blobs, opt);
+    }
+#endif
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru(bottom_blob, top_blob, direction, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            int ret = gru(bottom_blob, top_blob_forward, 0, weight_xc_data_packed.channel(0), bias_c_data_packed.channel(0), weight_hc_data_packed.channel(0), hidden0, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            int ret = gru(bottom_blob, top_blob_reverse, 1, weight_xc_data_packed.channel(1), bias_c_data_packed.channel(1), weight_hc_data_packed.channel(1), hidden1, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+
+#if NCNN_INT8
+int GRU_x86::create_pipeline_int8(const Option& opt)
+{
+    // pack RUN
+    const int num_directions = direction == 2 ? 2 : 1;
+    const int size = weight_data_size / num_directions / num_output / 3;
+
+    gru_transform_weight_int8(weight_xc_data, weight_xc_data_int8_scales, weight_hc_data, weight_hc_data_int8_scales, bias_c_data, weight_data_tm, weight_data_tm_int8_descales, bias_c_data_packed, size, num_output, num_directions, opt);
+
+    if (opt.lightmode)
+    {
+        weight_xc_data.release();
+        bias_c_data.release();
+        weight_hc_data.release();
+        weight_xc_data_int8_scales.release();
+        weight_hc_data_int8_scales.release();
+    }
+
+    return 0;
+}
+
+static void gru_dynamic_quantize(const Mat& bottom_blob, Mat& bottom_blob_int8, Mat& bottom_blob_int8_descales, const Option& opt)
+{
+    int size = bottom_blob.w;
+    int T = bottom_blob.h;
+
+    // dynamic quantize bottom_blob
+    bottom_blob_int8_descales.create(T, (size_t)4u, 1, opt.blob_allocator);
+
+    // int8 values widened to int16 and padded to even size, so that two of them make one madd operand
+    bottom_blob_int8.create(size + size % 2, T, (size_t)2u, opt.blob_allocator);
+
+    for (int t = 0; t < T; t++)
+    {
+        const float* ptr = bottom_blob.row(t);
+        short* outptr = bottom_blob_int8.row<short>(t);
+
+        const float absmax = gru_dynamic_quantize_get_absmax(ptr, size);
+
+        bottom_blob_int8_descales[t] = absmax / 127.f;
+
+        const float scale = absmax == 0.f ? 0.f : 127.f / absmax;
+        gru_dynamic_quantize_scale2int8(ptr, size, scale, outptr);
+    }
+}
+
+int GRU_x86::forward_int8(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int T = bottom_blob.h;
+
+    int num_directions = direction == 2 ? 2 : 1;
+
+    // initial hidden state
+    Mat hidden(num_output, 4u, opt.workspace_allocator);
+    if (hidden.empty())
+        return -100;
+    hidden.fill(0.f);
+
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        gru_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        {
+            int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        hidden.fill(0.f);
+
+        {
+            int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    return 0;
+}
+
+int GRU_x86::forward_int8(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+
+    int T = bottom_blob.h;
+    int num_directions = direction == 2 ? 2 : 1;
+
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 2)
+    {
+        hidden = bottom_blobs[1].clone(hidden_allocator);
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // dynamic quantize bottom_blob
+    Mat bottom_blob_int8;
+    Mat bottom_blob_int8_descales;
+    {
+        Option opt_quant = opt;
+        opt_quant.blob_allocator = opt.workspace_allocator;
+        opt_quant.use_packing_layout = false;
+        gru_dynamic_quantize(bottom_blob, bottom_blob_int8, bottom_blob_int8_descales, opt_quant);
+    }
+
+    // Uni directional
+    if (direction == 0 || direction == 1)
+    {
+        int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob, direction, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (direction == 2)
+    {
+        Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_forward.empty())
+            return -100;
+
+        Mat top_blob_reverse(num_output, T, 4u, opt.workspace_allocator);
+        if (top_blob_reverse.empty())
+            return -100;
+
+        Mat hidden0 = hidden.row_range(0, 1);
+        {
+            int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_forward, 0, weight_data_tm.channel(0), weight_data_tm_int8_descales.channel(0), bias_c_data_packed.channel(0), hidden0, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        Mat hidden1 = hidden.row_range(1, 1);
+        {
+            int ret = gru_int8(bottom_blob_int8, bottom_blob_int8_descales, top_blob_reverse, 1, weight_data_tm.channel(1), weight_data_tm_int8_descales.channel(1), bias_c_data_packed.channel(1), hidden1, opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        // concat w
+        for (int i = 0; i < T; i++)
+        {
+            const float* pf = top_blob_forward.row(i);
+            const float* pr = top_blob_reverse.row(i);
+            float* ptr = top_blob.row(i);
+
+            memcpy(ptr, pf, num_output * sizeof(float));
+            memcpy(ptr + num_output, pr, num_output * sizeof(float));
+        }
+    }
+
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+#endif // NCNN_INT8
+
+} // namespace ncnn
@@ -0,0 +1,441 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+// weight-only quantized linear shared by InnerProduct and Gemm
+// each weight row holds num_input int8 values, or int4 values packed two per byte
+// with the low nibble first and biased by 8, plus one scale per group_size inputs
+
+#if __SSE2__
+// sign extend the low 4 int8 to fp32
+static NCNN_FORCEINLINE __m128 weight_only_cvt_4xi8_ps(__m128i _v)
+{
+    _v = _mm_unpacklo_epi8(_v, _v);
+    _v = _mm_unpacklo_epi16(_v, _v);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_v, 24));
+}
+
+// expand the low 8 bytes of packed int4 into 16 int8 in input order
+static NCNN_FORCEINLINE __m128i weight_only_unpack_int4(__m128i _p)
+{
+    const __m128i _mask = _mm_set1_epi8(15);
+    __m128i _lo = _mm_and_si128(_p, _mask);
+    __m128i _hi = _mm_and_si128(_mm_srli_epi16(_p, 4), _mask);
+    return _mm_sub_epi8(_mm_unpacklo_epi8(_lo, _hi), _mm_set1_epi8(8));
+}
+#endif // __SSE2__
+
+static float innerproduct_weight_only_dot_int8(const float* ptr, const signed char* kptr, const float* scales, int num_input, int group_size)
+{
+    float sum = 0.f;
+#if __SSE2__
+    __m128 _sum = _mm_setzero_ps();
+#if __AVX2__
+    __m256 _sum256 = _mm256_setzero_ps();
+#endif
+#if __AVX512F__
+    __m512 _sum512 = _mm512_setzero_ps();
+#endif
+#endif // __SSE2__
+
+    for (int k = 0; k < num_input; k += group_size)
+    {
+        const int max_kk = std::min(num_input - k, group_size);
+        const float* p0 = ptr + k;
+        const signed char* k0 = kptr + k;
+        const float scale = scales[k / group_size];
+
+        int kk = 0;
+#if __SSE2__
+#if __AVX512F__
+        __m512 _acc512 = _mm512_setzero_ps();
+        for (; kk + 15 < max_kk; kk += 16)
+        {
+            __m512 _w = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128((const __m128i*)(k0 + kk))));
+            _acc512 = _mm512_fmadd_ps(_mm512_loadu_ps(p0 + kk), _w, _acc512);
+        }
+        _sum512 = _mm512_fmadd_ps(_acc512, _mm512_set1_ps(scale), _sum512);
+#endif // __AVX512F__
+#if __AVX2__
+        __m256 _acc256 = _mm256_setzero_ps();
+        for (; kk + 7 < max_kk; kk += 8)
+        {
+            __m256 _w = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)(k0 + kk))));
+            _acc256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(p0 + kk), _w, _acc256);
+        }
+        _sum256 = _mm256_comp_fmadd_ps(_acc256, _mm256_set1_ps(scale), _sum256);
+#endif // __AVX2__
+        __m128 _acc = _mm_setzero_ps();
+        for (; kk + 3 < max_kk; kk += 4)
+        {
+            int w4;
+            memcpy(&w4, k0 + kk, 4);
+            __m128 _w = weight_only_cvt_4xi8_ps(_mm_cvtsi32_si128(w4));
+            _acc = _mm_comp_fmadd_ps(_mm_loadu_ps(p0 + kk), _w, _acc);
+        }
+        _sum = _mm_comp_fmadd_ps(_acc, _mm_set1_ps(scale), _sum);
+#endif // __SSE2__
+        float acc = 0.f;
+        for (; kk < max_kk; kk++)
+        {
+            acc += p0[kk] * k0[kk];
+        }
+        sum += acc * scale;
+    }
+
+#if __SSE2__
+#if __AVX512F__
+    sum += _mm512_comp_reduce_add_ps(_sum512);
+#endif
+#if __AVX2__
+    sum += _mm256_reduce_add_ps(_sum256);
+#endif
+    sum += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+
+    return sum;
+}
+
+static float innerproduct_weight_only_dot_int4(const float* ptr, const unsigned char* kptr, const float* scales, int num_input, int group_size)
+{
+    float sum = 0.f;
+#if __SSE2__
+    __m128 _sum = _mm_setzero_ps();
+#if __AVX2__
+    __m256 _sum256 = _mm256_setzero_ps();
+#endif
+#if __AVX512F__
+    __m512 _sum512 = _mm512_setzero_ps();
+#endif
+#endif // __SSE2__
+
+    // group_size is even so every group starts at a whole byte
+    for (int k = 0; k < num_input; k += group_size)
+    {
+        const int max_kk = std::min(num_input - k, group_size);
+        const float* p0 = ptr + k;
+        const unsigned char* k0 = kptr + k / 2;
+        const float scale = scales[k / group_size];
+
+        int kk = 0;
+#if __SSE2__
+#if __AVX512F__
+        __m512 _acc512 = _mm512_setzero_ps();
+        for (; kk + 15 < max_kk; kk += 16)
+        {
+            __m128i _v = weight_only_unpack_int4(_mm_loadl_epi64((const __m128i*)(k0 + kk / 2)));
+            __m512 _w = _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_v));
+            _acc512 = _mm512_fmadd_ps(_mm512_loadu_ps(p0 + kk), _w, _acc512);
+        }
+        _sum512 = _mm512_fmadd_ps(_acc512, _mm512_set1_ps(scale), _sum512);
+#endif // __AVX512F__
+#if __AVX2__
+        __m256 _acc256 = _mm256_setzero_ps();
+        for (; kk + 7 < max_kk; kk += 8)
+        {
+            int w4;
+            memcpy(&w4, k0 + kk / 2, 4);
+            __m128i _v = weight_only_unpack_int4(_mm_cvtsi32_si128(w4));
+            __m256 _w = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_v));
+            _acc256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(p0 + kk), _w, _acc256);
+        }
+        _sum256 = _mm256_comp_fmadd_ps(_acc256, _mm256_set1_ps(scale), _sum256);
+#endif // __AVX2__
+        __m128 _acc = _mm_setzero_ps();
+        for (; kk + 3 < max_kk; kk += 4)
+        {
+            unsigned short w2;
+            memcpy(&w2, k0 + kk / 2, 2);
+            __m128 _w = weight_only_cvt_4xi8_ps(weight_only_unpack_int4(_mm_cvtsi32_si128(w2)));
+            _acc = _mm_comp_fmadd_ps(_mm_loadu_ps(p0 + kk), _w, _acc);
+        }
+        _sum = _mm_comp_fmadd_ps(_acc, _mm_set1_ps(scale), _sum);
+#endif // __SSE2__
+        float acc = 0.f;
+        for (; kk < max_kk; kk++)
+        {
+            const int q = (kk % 2 == 0 ? k0[kk / 2] & 15 : k0[kk / 2] >> 4) - 8;
+            acc += p0[kk] * q;
+        }
+        sum += acc * scale;
+    }
+
+#if __SSE2__
+#if __AVX512F__
+    sum += _mm512_comp_reduce_add_ps(_sum512);
+#endif
+#if __AVX2__
+    sum += _mm256_reduce_add_ps(_sum256);
+#endif
+    sum += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+
+    return sum;
+}
+
+static void innerproduct_weight_only_dequantize(const unsigned char* kptr, const float* scales, float* outptr, int num_input, int bits, int group_size)
+{
+    for (int k = 0; k < num_input; k += group_size)
+    {
+        const int max_kk = std::min(num_input - k, group_size);
+        const float scale = scales[k / group_size];
+        float* p0 = outptr + k;
+
+        int kk = 0;
+        if (bits == 4)
+        {
+            const unsigned char* k0 = kptr + k / 2;
+#if __SSE2__
+            __m128 _scale = _mm_set1_ps(scale);
+            for (; kk + 15 < max_kk; kk += 16)
+            {
+                __m128i _v = weight_only_unpack_int4(_mm_loadl_epi64((const __m128i*)(k0 + kk / 2)));
+                _mm_storeu_ps(p0 + kk, _mm_mul_ps(weight_only_cvt_4xi8_ps(_v), _scale));
+                _mm_storeu_ps(p0 + kk + 4, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 4)), _scale));
+                _mm_storeu_ps(p0 + kk + 8, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 8)), _scale));
+                _mm_storeu_ps(p0 + kk + 12, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 12)), _scale));
+            }
+#endif // __SSE2__
+            for (; kk < max_kk; kk++)
+            {
+                const int q = (kk % 2 == 0 ? k0[kk / 2] & 15 : k0[kk / 2] >> 4) - 8;
+                p0[kk] = q * scale;
+            }
+        }
+        else
+        {
+            const signed char* k0 = (const signed char*)kptr + k;
+#if __SSE2__
+            __m128 _scale = _mm_set1_ps(scale);
+            for (; kk + 15 < max_kk; kk += 16)
+            {
+                __m128i _v = _mm_loadu_si128((const __m128i*)(k0 + kk));
+                _mm_storeu_ps(p0 + kk, _mm_mul_ps(weight_only_cvt_4xi8_ps(_v), _scale));
+                _mm_storeu_ps(p0 + kk + 4, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 4)), _scale));
+                _mm_storeu_ps(p0 + kk + 8, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 8)), _scale));
+                _mm_storeu_ps(p0 + kk + 12, _mm_mul_ps(weight_only_cvt_4xi8_ps(_mm_srli_si128(_v, 12)), _scale));
+            }
+#endif // __SSE2__
+            for (; kk < max_kk; kk++)
+            {
+                p0[kk] = k0[kk] * scale;
+            }
+        }
+    }
+}
+
+// dot product of one input row against one dequantized weight row
+static float innerproduct_weight_only_dot_fp32(const float* ptr, const float* kptr, int num_input)
+{
+    float sum = 0.f;
+
+    int k = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _sum_512 = _mm512_setzero_ps();
+    for (; k + 15 < num_input; k += 16)
+    {
+        _sum_512 = _mm512_fmadd_ps(_mm512_loadu_ps(ptr + k), _mm512_loadu_ps(kptr + k), _sum_512);
+    }
+    sum += _mm512_comp_reduce_add_ps(_sum_512);
+#endif // __AVX512F__
+    __m256 _sum_256 = _mm256_setzero_ps();
+    for (; k + 7 < num_input; k += 8)
+    {
+        _sum_256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr + k), _mm256_loadu_ps(kptr + k), _sum_256);
+    }
+    sum += _mm256_reduce_add_ps(_sum_256);
+#endif // __AVX__
+    __m128 _sum = _mm_setzero_ps();
+    for (; k + 3 < num_input; k += 4)
+    {
+        _sum = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr + k), _mm_loadu_ps(kptr + k), _sum);
+    }
+    sum += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+    for (; k < num_input; k++)
+    {
+        sum += ptr[k] * kptr[k];
+    }
+
+    return sum;
+}
+
+// dot products of four input rows against one dequantized weight row
+static void innerproduct_weight_only_dot4_fp32(const float* ptr0, const float* ptr1, const float* ptr2, const float* ptr3, const float* kptr, int num_input, float* sums)
+{
+    float sum0 = 0.f;
+    float sum1 = 0.f;
+    float sum2 = 0.f;
+    float sum3 = 0.f;
+
+    int k = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _sum0_512 = _mm512_setzero_ps();
+    __m512 _sum1_512 = _mm512_setzero_ps();
+    __m512 _sum2_512 = _mm512_setzero_ps();
+    __m512 _sum3_512 = _mm512_setzero_ps();
+    for (; k + 15 < num_input; k += 16)
+    {
+        __m512 _w = _mm512_loadu_ps(kptr + k);
+        _sum0_512 = _mm512_fmadd_ps(_mm512_loadu_ps(ptr0 + k), _w, _sum0_512);
+        _sum1_512 = _mm512_fmadd_ps(_mm512_loadu_ps(ptr1 + k), _w, _sum1_512);
+        _sum2_512 = _mm512_fmadd_ps(_mm512_loadu_ps(ptr2 + k), _w, _sum2_512);
+        _sum3_512 = _mm512_fmadd_ps(_mm512_loadu_ps(ptr3 + k), _w, _sum3_512);
+    }
+    sum0 += _mm512_comp_reduce_add_ps(_sum0_512);
+    sum1 += _mm512_comp_reduce_add_ps(_sum1_512);
+    sum2 += _mm512_comp_reduce_add_ps(_sum2_512);
+    sum3 += _mm512_comp_reduce_add_ps(_sum3_512);
+#endif // __AVX512F__
+    __m256 _sum0_256 = _mm256_setzero_ps();
+    __m256 _sum1_256 = _mm256_setzero_ps();
+    __m256 _sum2_256 = _mm256_setzero_ps();
+    __m256 _sum3_256 = _mm256_setzero_ps();
+    for (; k + 7 < num_input; k += 8)
+    {
+        __m256 _w = _mm256_loadu_ps(kptr + k);
+        _sum0_256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr0 + k), _w, _sum0_256);
+        _sum1_256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr1 + k), _w, _sum1_256);
+        _sum2_256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr2 + k), _w, _sum2_256);
+        _sum3_256 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr3 + k), _w, _sum3_256);
+    }
+    sum0 += _mm256_reduce_add_ps(_sum0_256);
+    sum1 += _mm256_reduce_add_ps(_sum1_256);
+    sum2 += _mm256_reduce_add_ps(_sum2_256);
+    sum3 += _mm256_reduce_add_ps(_sum3_256);
+#endif // __AVX__
+    __m128 _sum0 = _mm_setzero_ps();
+    __m128 _sum1 = _mm_setzero_ps();
+    __m128 _sum2 = _mm_setzero_ps();
+    __m128 _sum3 = _mm_setzero_ps();
+    for (; k + 3 < num_input; k += 4)
+    {
+        __m128 _w = _mm_loadu_ps(kptr + k);
+        _sum0 = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr0 + k), _w, _sum0);
+        _sum1 = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr1 + k), _w, _sum1);
+        _sum2 = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr2 + k), _w, _sum2);
+        _sum3 = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr3 + k), _w, _sum3);
+    }
+    sum0 += _mm_reduce_add_ps(_sum0);
+    sum1 += _mm_reduce_add_ps(_sum1);
+    sum2 += _mm_reduce_add_ps(_sum2);
+    sum3 += _mm_reduce_add_ps(_sum3);
+#endif // __SSE2__
+    for (; k < num_input; k++)
+    {
+        sum0 += ptr0[k] * kptr[k];
+        sum1 += ptr1[k] * kptr[k];
+        sum2 += ptr2[k] * kptr[k];
+        sum3 += ptr3[k] * kptr[k];
+    }
+
+    sums[0] = sum0;
+    sums[1] = sum1;
+    sums[2] = sum2;
+    sums[3] = sum3;
+}
+
+// bottom_blob is num_input x h and top_blob is num_output x h, both without packing
+static int innerproduct_weight_only_sse(const Mat& bottom_blob, Mat& top_blob, const Mat& weight_data, const Mat& weight_scales, const Mat& bias_data, int bits, int group_size, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int num_input = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int num_output = top_blob.w;
+
+    const int num_group = (num_input + group_size - 1) / group_size;
+    const int weight_row_bytes = bits == 4 ? (num_input + 1) / 2 : num_input;
+
+    const float* bias_data_ptr = bias_data;
+
+    if (h < 4)
+    {
+        // few rows, stream each quantized weight row once and dequantize it in registers
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int p = 0; p < num_output; p++)
+        {
+            const unsigned char* kptr = (const unsigned char*)weight_data + weight_row_bytes * p;
+            const float* scales = (const float*)weight_scales + num_group * p;
+
+            for (int j = 0; j < h; j++)
+            {
+                const float* ptr = bottom_blob.row(j);
+
+                float sum;
+                if (bits == 4)
+                    sum = innerproduct_weight_only_dot_int4(ptr, kptr, scales, num_input, group_size);
+                else
+                    sum = innerproduct_weight_only_dot_int8(ptr, (const signed char*)kptr, scales, num_input, group_size);
+
+                if (bias_data_ptr)
+                    sum += bias_data_ptr[p];
+
+                top_blob.row(j)[p] = activation_ss(sum, activation_type, activation_params);
+            }
+        }
+
+        return 0;
+    }
+
+    // many rows, dequantize a tile of weight rows that stays in cache and reuse it for all rows
+    int TILE_N = std::max(1, std::min(num_output, 32768 / num_input));
+    TILE_N = std::min(TILE_N, (num_output + opt.num_threads - 1) / opt.num_threads);
+
+    const int nn_N = (num_output + TILE_N - 1) / TILE_N;
+
+    Mat weight_tile(num_input, TILE_N, opt.num_threads, 4u, opt.workspace_allocator);
+    if (weight_tile.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int ppj = 0; ppj < nn_N; ppj++)
+    {
+        const int j = ppj * TILE_N;
+        const int max_jj = std::min(num_output - j, TILE_N);
+
+        Mat tile = weight_tile.channel(get_omp_thread_num());
+
+        for (int jj = 0; jj < max_jj; jj++)
+        {
+            const unsigned char* kptr = (const unsigned char*)weight_data + weight_row_bytes * (j + jj);
+            const float* scales = (const float*)weight_scales + num_group * (j + jj);
+            innerproduct_weight_only_dequantize(kptr, scales, tile.row(jj), num_input, bits, group_size);
+        }
+
+        int i = 0;
+        for (; i + 3 < h; i += 4)
+        {
+            for (int jj = 0; jj < max_jj; jj++)
+            {
+                float sums[4];
+                innerproduct_weight_only_dot4_fp32(bottom_blob.row(i), bottom_blob.row(i + 1), bottom_blob.row(i + 2), bottom_blob.row(i + 3), tile.row(jj), num_input, sums);
+
+                for (int ii = 0; ii < 4; ii++)
+                {
+                    float sum = sums[ii];
+                    if (bias_data_ptr)
+                        sum += bias_data_ptr[j + jj];
+
+                    top_blob.row(i + ii)[j + jj] = activation_ss(sum, activation_type, activation_params);
+                }
+            }
+        }
+        for (; i < h; i++)
+        {
+            const float* ptr = bottom_blob.row(i);
+
+            for (int jj = 0; jj < max_jj; jj++)
+            {
+                float sum = innerproduct_weight_only_dot_fp32(ptr, tile.row(jj), num_input);
+                if (bias_data_ptr)
+                    sum += bias_data_ptr[j + jj];
+
+                top_blob.row(i)[j + jj] = activation_ss(sum, activation_type, activation_params);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -21,6 +21,7 @@ namespace ncnn {
 
 #include "innerproduct_fp.h"
 #include "innerproduct_gemm_fp.h"
+#include "innerproduct_weight_only.h"
 
 #if NCNN_F16C && __AVX__
 #define NCNN_IMPL_FP16S 1
@@ -40,6 +41,13 @@ InnerProduct_x86::InnerProduct_x86()
 
 int InnerProduct_x86::create_pipeline(const Option& opt)
 {
+    if (weight_quant_bits)
+    {
+        // weights stay quantized, fp32 inputs come without packing
+        support_packing = false;
+        return 0;
+    }
+
     //     if (opt.use_packing_layout)
     {
         flatten = ncnn::create_layer_cpu(ncnn::LayerType::Flatten);
@@ -87,8 +95,56 @@ int InnerProduct_x86::destroy_pipeline(const Option& opt)
     return 0;
 }
 
+int InnerProduct_x86::save_pipeline_weights(std::vector<Mat>& weights) const
+{
+    if (weight_quant_bits)
+    {
+        // nothing transformed
+        return -1;
+    }
+
+    weights.resize(2);
+    weights[0] = weight_data_tm;
+#if NCNN_INT8
+    weights[1] = scale_in_data;
+#endif
+
+    return 0;
+}
+
+int InnerProduct_x86::load_pipeline_weights(const std::vector<Mat>& weights, const Option& opt)
+{
+    if (weights.size() != 2)
+        return -1;
+
+    {
+        flatten = ncnn::create_layer_cpu(ncnn::LayerType::Flatten);
+
+        ncnn::ParamDict pd;
+
+        flatten->load_param(pd);
+
+        flatten->create_pipeline(opt);
+    }
+
+    weight_data_tm = weights[0];
+#if NCNN_INT8
+    scale_in_data = weights[1];
+#endif
+
+    if (opt.lightmode)
+        weight_data.release();
+
+    return 0;
+}
+
 int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
 {
+    if (weight_quant_bits)
+    {
+        return forward_weight_only_x86(bottom_blob, top_blob, opt);
+    }
+
 #if NCNN_INT8
     if (opt.use_int8_inference && int8_scale_term)
     {
@@ -160,6 +216,30 @@ int InnerProduct_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Optio
     return 0;
 }
 
+int InnerProduct_x86::forward_weight_only_x86(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int num_input = weight_data_size / num_output;
+
+    Mat bottom_blob_flattened = bottom_blob;
+    if (bottom_blob.dims == 2 && bottom_blob.w == num_input)
+    {
+        // gemm
+        top_blob.create(num_output, bottom_blob.h, 4u, opt.blob_allocator);
+    }
+    else
+    {
+        bottom_blob_flattened = bottom_blob.reshape(num_input, opt.workspace_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+
+        top_blob.create(num_output, 4u, opt.blob_allocator);
+    }
+    if (top_blob.empty())
+        return -100;
+
+    return innerproduct_weight_only_sse(bottom_blob_flattened, top_blob, weight_data, weight_data_quant_scales, bias_data, weight_quant_bits, weight_quant_group_size, activation_type, activation_params, opt);
+}
+
 #if NCNN_F16C && __AVX__
 int InnerProduct_x86::create_pipeline_fp16s(const Option& opt)
 {
@@ -0,0 +1,464 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "moe_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "x86_activation.h"
+#include "x86_usability.h"
+
+#include "layer_type.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace ncnn {
+
+MoE_x86::MoE_x86()
+{
+}
+
+static int create_expert_gemm(Layer*& gemm, int N, int K, const Mat& weight, const Mat& bias, const Option& opt)
+{
+    gemm = ncnn::create_layer_cpu(ncnn::LayerType::Gemm);
+
+    ncnn::ParamDict pd;
+    pd.set(2, 0);                       // transA
+    pd.set(3, 1);                       // transB
+    pd.set(4, 0);                       // constantA
+    pd.set(5, 1);                       // constantB
+    pd.set(6, 1);                       // constantC
+    pd.set(7, 0);                       // M
+    pd.set(8, N);                       // N
+    pd.set(9, K);                       // K
+    pd.set(10, bias.empty() ? -1 : 4);  // constant_broadcast_type_C
+    pd.set(11, 0);                      // output_N1M
+    pd.set(12, 1);                      // output_elempack
+
+    Mat weights[2];
+    weights[0] = weight;
+    weights[1] = bias;
+
+    int ret = gemm->load_param(pd);
+    if (ret == 0)
+        ret = gemm->load_model(ModelBinFromMatArray(weights));
+    if (ret == 0)
+        ret = gemm->create_pipeline(opt);
+
+    if (ret != 0)
+    {
+        delete gemm;
+        gemm = 0;
+    }
+
+    return ret;
+}
+
+int MoE_x86::create_pipeline(const Option& opt)
+{
+    const int up_dim = gated ? hidden_dim * 2 : hidden_dim;
+
+    up_gemm.resize(num_expert, 0);
+    down_gemm.resize(num_expert, 0);
+
+    for (int e = 0; e < num_expert; e++)
+    {
+        // gemm may keep the bias as it is, give it memory that outlives the released layer weights
+        Mat up_weight;
+        Mat up_bias;
+        if (gated)
+        {
+            up_weight.create(embed_dim * up_dim);
+            if (up_weight.empty())
+                return -100;
+
+            memcpy(up_weight, (const float*)gate_weight_data + (size_t)e * hidden_dim * embed_dim, (size_t)hidden_dim * embed_dim * sizeof(float));
+            memcpy((float*)up_weight + (size_t)hidden_dim * embed_dim, (const float*)up_weight_data + (size_t)e * hidden_dim * embed_dim, (size_t)hidden_dim * embed_dim * sizeof(float));
+
+            if (bias_term)
+            {
+                up_bias.create(up_dim);
+                if (up_bias.empty())
+                    return -100;
+
+                memcpy(up_bias, (const float*)gate_bias_data + e * hidden_dim, hidden_dim * sizeof(float));
+                memcpy((float*)up_bias + hidden_dim, (const float*)up_bias_data + e * hidden_dim, hidden_dim * sizeof(float));
+            }
+        }
+        else
+        {
+            up_weight = up_weight_data.range((size_t)e * hidden_dim * embed_dim, (size_t)hidden_dim * embed_dim);
+            if (bias_term)
+            {
+                up_bias = up_bias_data.range(e * hidden_dim, hidden_dim).clone();
+                if (up_bias.empty())
+                    return -100;
+            }
+        }
+
+        int ret = create_expert_gemm(up_gemm[e], up_dim, embed_dim, up_weight, up_bias, opt);
+        if (ret != 0)
+            return ret;
+
+        Mat down_weight = down_weight_data.range((size_t)e * embed_dim * hidden_dim, (size_t)embed_dim * hidden_dim);
+        Mat down_bias;
+        if (bias_term)
+        {
+            down_bias = down_bias_data.range(e * embed_dim, embed_dim).clone();
+            if (down_bias.empty())
+                return -100;
+        }
+
+        ret = create_expert_gemm(down_gemm[e], embed_dim, hidden_dim, down_weight, down_bias, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (opt.lightmode)
+    {
+        up_weight_data.release();
+        gate_weight_data.release();
+        down_weight_data.release();
+        up_bias_data.release();
+        gate_bias_data.release();
+        down_bias_data.release();
+    }
+
+    return 0;
+}
+
+int MoE_x86::destroy_pipeline(const Option& opt)
+{
+    // a failed create_pipeline leaves the remaining experts null
+    for (size_t i = 0; i < up_gemm.size(); i++)
+    {
+        if (!up_gemm[i])
+            continue;
+
+        up_gemm[i]->destroy_pipeline(opt);
+        delete up_gemm[i];
+    }
+    up_gemm.clear();
+
+    for (size_t i = 0; i < down_gemm.size(); i++)
+    {
+        if (!down_gemm[i])
+            continue;
+
+        down_gemm[i]->destroy_pipeline(opt);
+        delete down_gemm[i];
+    }
+    down_gemm.clear();
+
+    return 0;
+}
+
+// 7=silu and 8=gelu extend the fused activation numbering for moe only
+static NCNN_FORCEINLINE float moe_activation_ss(float v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 7)
+        return v / (1.f + expf(-v));
+
+    if (activation_type == 8)
+        return 0.5f * v * erfcf(-0.70710678f * v);
+
+    return activation_ss(v, activation_type, activation_params);
+}
+
+#if __SSE2__
+static NCNN_FORCEINLINE __m128 moe_activation_sse(__m128 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 7)
+        return swish_sse(_v);
+
+    if (activation_type == 8)
+    {
+        // exact gelu, erfc per lane
+        float tmp[4];
+        _mm_storeu_ps(tmp, _v);
+        for (int i = 0; i < 4; i++)
+        {
+            tmp[i] = moe_activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm_loadu_ps(tmp);
+    }
+
+    return activation_sse(_v, activation_type, activation_params);
+}
+
+#if __AVX__
+static NCNN_FORCEINLINE __m256 moe_activation_avx(__m256 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 7)
+        return swish_avx(_v);
+
+    if (activation_type == 8)
+    {
+        float tmp[8];
+        _mm256_storeu_ps(tmp, _v);
+        for (int i = 0; i < 8; i++)
+        {
+            tmp[i] = moe_activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm256_loadu_ps(tmp);
+    }
+
+    return activation_avx(_v, activation_type, activation_params);
+}
+
+#if __AVX512F__
+static NCNN_FORCEINLINE __m512 moe_activation_avx512(__m512 _v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 7)
+        return swish_avx512(_v);
+
+    if (activation_type == 8)
+    {
+        float tmp[16];
+        _mm512_storeu_ps(tmp, _v);
+        for (int i = 0; i < 16; i++)
+        {
+            tmp[i] = moe_activation_ss(tmp[i], activation_type, activation_params);
+        }
+        return _mm512_loadu_ps(tmp);
+    }
+
+    return activation_avx512(_v, activation_type, activation_params);
+}
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+static void moe_activation(float* ptr, const float* gate_ptr, int size, int activation_type, const Mat& activation_params)
+{
+    // y = act(gate) * ptr when gate_ptr is given, otherwise y = act(ptr)
+    const float* act_ptr = gate_ptr ? gate_ptr : ptr;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = moe_activation_avx512(_mm512_loadu_ps(act_ptr), activation_type, activation_params);
+        if (gate_ptr)
+            _p = _mm512_mul_ps(_p, _mm512_loadu_ps(ptr));
+        _mm512_storeu_ps(ptr, _p);
+        act_ptr += 16;
+        ptr += 16;
+    }
+#endif // __AVX512F__
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = moe_activation_avx(_mm256_loadu_ps(act_ptr), activation_type, activation_params);
+        if (gate_ptr)
+            _p = _mm256_mul_ps(_p, _mm256_loadu_ps(ptr));
+        _mm256_storeu_ps(ptr, _p);
+        act_ptr += 8;
+        ptr += 8;
+    }
+#endif // __AVX__
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = moe_activation_sse(_mm_loadu_ps(act_ptr), activation_type, activation_params);
+        if (gate_ptr)
+            _p = _mm_mul_ps(_p, _mm_loadu_ps(ptr));
+        _mm_storeu_ps(ptr, _p);
+        act_ptr += 4;
+        ptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        float v = moe_activation_ss(*act_ptr, activation_type, activation_params);
+        if (gate_ptr)
+            v *= *ptr;
+        *ptr = v;
+        act_ptr++;
+        ptr++;
+    }
+}
+
+static void moe_scatter_add(float* outptr, const float* ptr, float w, int size)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _w_avx512 = _mm512_set1_ps(w);
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(outptr, _mm512_fmadd_ps(_mm512_loadu_ps(ptr), _w_avx512, _mm512_loadu_ps(outptr)));
+        outptr += 16;
+        ptr += 16;
+    }
+#endif // __AVX512F__
+    __m256 _w_avx = _mm256_set1_ps(w);
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(outptr, _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr), _w_avx, _mm256_loadu_ps(outptr)));
+        outptr += 8;
+        ptr += 8;
+    }
+#endif // __AVX__
+    __m128 _w = _mm_set1_ps(w);
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(outptr, _mm_comp_fmadd_ps(_mm_loadu_ps(ptr), _w, _mm_loadu_ps(outptr)));
+        outptr += 4;
+        ptr += 4;
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        *outptr++ += *ptr++ * w;
+    }
+}
+
+int MoE_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    const Mat& bottom_blob = bottom_blobs[0];
+    const Mat& router_logits = bottom_blobs[1];
+
+    const int num_token = bottom_blob.dims == 1 ? 1 : bottom_blob.h;
+
+    if (bottom_blob.w != embed_dim || router_logits.w != num_expert || (router_logits.dims == 1 ? 1 : router_logits.h) != num_token)
+    {
+        NCNN_LOGE("MoE input shape mismatch, expect %d x %d and %d x %d", embed_dim, num_token, num_expert, num_token);
+        return -1;
+    }
+
+    Mat topk_index;
+    Mat topk_weight;
+    int ret = route(router_logits, topk_index, topk_weight, opt);
+    if (ret != 0)
+        return ret;
+
+    // group the routed tokens by expert with a counting sort
+    std::vector<int> expert_offset(num_expert + 1, 0);
+    for (int t = 0; t < num_token; t++)
+    {
+        const int* index = topk_index.row<const int>(t);
+        for (int k = 0; k < top_k; k++)
+        {
+            expert_offset[index[k] + 1]++;
+        }
+    }
+    for (int e = 0; e < num_expert; e++)
+    {
+        expert_offset[e + 1] += expert_offset[e];
+    }
+
+    const int num_routed = num_token * top_k;
+    std::vector<int> routed_token(num_routed);
+    std::vector<float> routed_weight(num_routed);
+    {
+        std::vector<int> cursor(num_expert);
+        for (int e = 0; e < num_expert; e++)
+        {
+            cursor[e] = expert_offset[e];
+        }
+
+        for (int t = 0; t < num_token; t++)
+        {
+            const int* index = topk_index.row<const int>(t);
+            const float* weight = topk_weight.row(t);
+            for (int k = 0; k < top_k; k++)
+            {
+                const int j = cursor[index[k]]++;
+                routed_token[j] = t;
+                routed_weight[j] = weight[k];
+            }
+        }
+    }
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create_like(bottom_blob, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    top_blob.fill(0.f);
+
+    Option opt_gemm = opt;
+    opt_gemm.blob_allocator = opt.workspace_allocator;
+
+    for (int e = 0; e < num_expert; e++)
+    {
+        const int offset = expert_offset[e];
+        const int rows = expert_offset[e + 1] - offset;
+        if (rows == 0)
+            continue;
+
+        Mat x(embed_dim, rows, (size_t)4u, opt.workspace_allocator);
+        if (x.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < rows; i++)
+        {
+            memcpy(x.row(i), bottom_blob.row(routed_token[offset + i]), embed_dim * sizeof(float));
+        }
+
+        std::vector<Mat> up_bottom_blobs(1, x);
+        std::vector<Mat> up_top_blobs(1);
+        ret = up_gemm[e]->forward(up_bottom_blobs, up_top_blobs, opt_gemm);
+        if (ret != 0)
+            return ret;
+
+        const Mat& up = up_top_blobs[0];
+
+        Mat hidden;
+        if (gated)
+        {
+            hidden.create(hidden_dim, rows, (size_t)4u, opt.workspace_allocator);
+            if (hidden.empty())
+                return -100;
+
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int i = 0; i < rows; i++)
+            {
+                float* ptr = hidden.row(i);
+                memcpy(ptr, up.row<const float>(i) + hidden_dim, hidden_dim * sizeof(float));
+                moe_activation(ptr, up.row<const float>(i), hidden_dim, activation_type, activation_params);
+            }
+        }
+        else
+        {
+            hidden = up;
+
+            if (activation_type != 0)
+            {
+                #pragma omp parallel for num_threads(opt.num_threads)
+                for (int i = 0; i < rows; i++)
+                {
+                    moe_activation(hidden.row(i), 0, hidden_dim, activation_type, activation_params);
+                }
+            }
+        }
+
+        std::vector<Mat> down_bottom_blobs(1, hidden);
+        std::vector<Mat> down_top_blobs(1);
+        ret = down_gemm[e]->forward(down_bottom_blobs, down_top_blobs, opt_gemm);
+        if (ret != 0)
+            return ret;
+
+        const Mat& y = down_top_blobs[0];
+
+        // a token is routed to an expert at most once, rows scatter to distinct outputs
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < rows; i++)
+        {
+            moe_scatter_add(top_blob.row(routed_token[offset + i]), y.row(i), routed_weight[offset + i], embed_dim);
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
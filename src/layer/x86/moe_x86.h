@@ -0,0 +1,29 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef LAYER_MOE_X86_H
+#define LAYER_MOE_X86_H
+
+#include "moe.h"
+
+namespace ncnn {
+
+class MoE_x86 : public MoE
+{
+public:
+    MoE_x86();
+
+    virtual int create_pipeline(const Option& opt);
+    virtual int destroy_pipeline(const Option& opt);
+
+    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+
+public:
+    // per expert, gate and up projections share one gemm with gate rows first
+    std::vector<Layer*> up_gemm;
+    std::vector<Layer*> down_gemm;
+};
+
+} // namespace ncnn
+
+#endif // LAYER_MOE_X86_H
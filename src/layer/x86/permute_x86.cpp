@@ -0,0 +1,302 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "permute_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+// input axis feeding each output axis, innermost first, w=0 h=1 d=2 c=3
+static const int permute_order_2d[2][2] = {
+    {0, 1}, {1, 0}
+};
+
+static const int permute_order_3d[6][3] = {
+    {0, 1, 2}, {1, 0, 2}, {0, 2, 1}, {2, 0, 1}, {1, 2, 0}, {2, 1, 0}
+};
+
+static const int permute_order_4d[24][4] = {
+    {0, 1, 2, 3}, {1, 0, 2, 3}, {0, 2, 1, 3}, {2, 0, 1, 3}, {1, 2, 0, 3}, {2, 1, 0, 3},
+    {0, 1, 3, 2}, {1, 0, 3, 2}, {0, 3, 1, 2}, {3, 0, 1, 2}, {1, 3, 0, 2}, {3, 1, 0, 2},
+    {0, 2, 3, 1}, {2, 0, 3, 1}, {0, 3, 2, 1}, {3, 0, 2, 1}, {2, 3, 0, 1}, {3, 2, 0, 1},
+    {1, 2, 3, 0}, {2, 1, 3, 0}, {1, 3, 2, 0}, {3, 1, 2, 0}, {2, 3, 1, 0}, {3, 2, 1, 0}
+};
+
+static void permute_transpose_pack(const float* ptr, float* outptr, const size_t* tq, int elempack)
+{
+    // elempack rows of elempack floats from consecutive outer indexes become elempack output elements
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _r0 = _mm512_loadu_ps(ptr + tq[0]);
+        __m512 _r1 = _mm512_loadu_ps(ptr + tq[1]);
+        __m512 _r2 = _mm512_loadu_ps(ptr + tq[2]);
+        __m512 _r3 = _mm512_loadu_ps(ptr + tq[3]);
+        __m512 _r4 = _mm512_loadu_ps(ptr + tq[4]);
+        __m512 _r5 = _mm512_loadu_ps(ptr + tq[5]);
+        __m512 _r6 = _mm512_loadu_ps(ptr + tq[6]);
+        __m512 _r7 = _mm512_loadu_ps(ptr + tq[7]);
+        __m512 _r8 = _mm512_loadu_ps(ptr + tq[8]);
+        __m512 _r9 = _mm512_loadu_ps(ptr + tq[9]);
+        __m512 _ra = _mm512_loadu_ps(ptr + tq[10]);
+        __m512 _rb = _mm512_loadu_ps(ptr + tq[11]);
+        __m512 _rc = _mm512_loadu_ps(ptr + tq[12]);
+        __m512 _rd = _mm512_loadu_ps(ptr + tq[13]);
+        __m512 _re = _mm512_loadu_ps(ptr + tq[14]);
+        __m512 _rf = _mm512_loadu_ps(ptr + tq[15]);
+        transpose16x16_ps(_r0, _r1, _r2, _r3, _r4, _r5, _r6, _r7, _r8, _r9, _ra, _rb, _rc, _rd, _re, _rf);
+        _mm512_storeu_ps(outptr, _r0);
+        _mm512_storeu_ps(outptr + 16, _r1);
+        _mm512_storeu_ps(outptr + 16 * 2, _r2);
+        _mm512_storeu_ps(outptr + 16 * 3, _r3);
+        _mm512_storeu_ps(outptr + 16 * 4, _r4);
+        _mm512_storeu_ps(outptr + 16 * 5, _r5);
+        _mm512_storeu_ps(outptr + 16 * 6, _r6);
+        _mm512_storeu_ps(outptr + 16 * 7, _r7);
+        _mm512_storeu_ps(outptr + 16 * 8, _r8);
+        _mm512_storeu_ps(outptr + 16 * 9, _r9);
+        _mm512_storeu_ps(outptr + 16 * 10, _ra);
+        _mm512_storeu_ps(outptr + 16 * 11, _rb);
+        _mm512_storeu_ps(outptr + 16 * 12, _rc);
+        _mm512_storeu_ps(outptr + 16 * 13, _rd);
+        _mm512_storeu_ps(outptr + 16 * 14, _re);
+        _mm512_storeu_ps(outptr + 16 * 15, _rf);
+        return;
+    }
+#endif // __AVX512F__
+#if __AVX__
+    if (elempack == 8)
+    {
+        __m256 _r0 = _mm256_loadu_ps(ptr + tq[0]);
+        __m256 _r1 = _mm256_loadu_ps(ptr + tq[1]);
+        __m256 _r2 = _mm256_loadu_ps(ptr + tq[2]);
+        __m256 _r3 = _mm256_loadu_ps(ptr + tq[3]);
+        __m256 _r4 = _mm256_loadu_ps(ptr + tq[4]);
+        __m256 _r5 = _mm256_loadu_ps(ptr + tq[5]);
+        __m256 _r6 = _mm256_loadu_ps(ptr + tq[6]);
+        __m256 _r7 = _mm256_loadu_ps(ptr + tq[7]);
+        transpose8x8_ps(_r0, _r1, _r2, _r3, _r4, _r5, _r6, _r7);
+        _mm256_storeu_ps(outptr, _r0);
+        _mm256_storeu_ps(outptr + 8, _r1);
+        _mm256_storeu_ps(outptr + 8 * 2, _r2);
+        _mm256_storeu_ps(outptr + 8 * 3, _r3);
+        _mm256_storeu_ps(outptr + 8 * 4, _r4);
+        _mm256_storeu_ps(outptr + 8 * 5, _r5);
+        _mm256_storeu_ps(outptr + 8 * 6, _r6);
+        _mm256_storeu_ps(outptr + 8 * 7, _r7);
+        return;
+    }
+#endif // __AVX__
+#if __SSE2__
+    if (elempack == 4)
+    {
+        __m128 _r0 = _mm_loadu_ps(ptr + tq[0]);
+        __m128 _r1 = _mm_loadu_ps(ptr + tq[1]);
+        __m128 _r2 = _mm_loadu_ps(ptr + tq[2]);
+        __m128 _r3 = _mm_loadu_ps(ptr + tq[3]);
+        _MM_TRANSPOSE4_PS(_r0, _r1, _r2, _r3);
+        _mm_storeu_ps(outptr, _r0);
+        _mm_storeu_ps(outptr + 4, _r1);
+        _mm_storeu_ps(outptr + 4 * 2, _r2);
+        _mm_storeu_ps(outptr + 4 * 3, _r3);
+        return;
+    }
+#endif // __SSE2__
+
+    for (int j = 0; j < elempack; j++)
+    {
+        for (int l = 0; l < elempack; l++)
+        {
+            *outptr++ = ptr[tq[l] + j];
+        }
+    }
+}
+
+static void permute_copy_pack(const float* ptr, float* outptr, int elempack)
+{
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        _mm512_storeu_ps(outptr, _mm512_loadu_ps(ptr));
+        return;
+    }
+#endif // __AVX512F__
+#if __AVX__
+    if (elempack == 8)
+    {
+        _mm256_storeu_ps(outptr, _mm256_loadu_ps(ptr));
+        return;
+    }
+#endif // __AVX__
+#if __SSE2__
+    if (elempack == 4)
+    {
+        _mm_storeu_ps(outptr, _mm_loadu_ps(ptr));
+        return;
+    }
+#endif // __SSE2__
+
+    for (int l = 0; l < elempack; l++)
+    {
+        outptr[l] = ptr[l];
+    }
+}
+
+Permute_x86::Permute_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+int Permute_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    const int dims = bottom_blob.dims;
+    const int elempack = bottom_blob.elempack;
+
+    if (dims == 1 || order_type == 0)
+    {
+        top_blob = bottom_blob;
+        return 0;
+    }
+
+    const int* order = dims == 2 ? permute_order_2d[order_type] : dims == 3 ? permute_order_3d[order_type] : permute_order_4d[order_type];
+
+    // logical axis sizes, innermost first, the outermost axis is the packed one
+    int sizes[4];
+    sizes[0] = bottom_blob.w;
+    sizes[1] = dims == 2 ? bottom_blob.h * elempack : bottom_blob.h;
+    sizes[2] = dims == 3 ? bottom_blob.c * elempack : bottom_blob.d;
+    sizes[3] = bottom_blob.c * elempack;
+
+    int outsizes[4] = {1, 1, 1, 1};
+    for (int k = 0; k < dims; k++)
+    {
+        outsizes[k] = sizes[order[k]];
+    }
+
+    const int outer = dims - 1;
+    const int outouter = outsizes[outer];
+
+    int out_elempack = 1;
+#if __SSE2__
+    if (opt.use_packing_layout)
+    {
+#if __AVX512F__
+        out_elempack = outouter % 16 == 0 ? 16 : outouter % 8 == 0 ? 8 : outouter % 4 == 0 ? 4 : 1;
+#elif __AVX__
+        out_elempack = outouter % 8 == 0 ? 8 : outouter % 4 == 0 ? 4 : 1;
+#else
+        out_elempack = outouter % 4 == 0 ? 4 : 1;
+#endif
+    }
+#endif // __SSE2__
+
+    if (elempack == 1 && out_elempack == 1)
+        return Permute::forward(bottom_blob, top_blob, opt);
+
+    const size_t out_elemsize = 4u * out_elempack;
+
+    if (dims == 2)
+        top_blob.create(outsizes[0], outouter / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (dims == 3)
+        top_blob.create(outsizes[0], outsizes[1], outouter / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (dims == 4)
+        top_blob.create(outsizes[0], outsizes[1], outsizes[2], outouter / out_elempack, out_elemsize, out_elempack, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    // float offset of every logical index along every input axis
+    size_t strides[4];
+    strides[0] = elempack;
+    strides[1] = (size_t)bottom_blob.w * elempack;
+    strides[2] = (size_t)bottom_blob.w * bottom_blob.h * elempack;
+    const size_t outer_stride = dims == 2 ? (size_t)bottom_blob.w * elempack : bottom_blob.cstep * elempack;
+
+    std::vector<size_t> offsets[4];
+    for (int a = 0; a < dims; a++)
+    {
+        offsets[a].resize(sizes[a]);
+        for (int i = 0; i < sizes[a]; i++)
+        {
+            offsets[a][i] = a == outer ? (i / elempack) * outer_stride + i % elempack : i * strides[a];
+        }
+    }
+
+    // absent output axes walk a single zero offset
+    const size_t zero = 0;
+    const size_t* tab_x = &offsets[order[0]][0];
+    const size_t* tab_y = dims >= 3 ? &offsets[order[1]][0] : &zero;
+    const size_t* tab_z = dims == 4 ? &offsets[order[2]][0] : &zero;
+    const size_t* tab_q = &offsets[order[outer]][0];
+
+    const int outw = outsizes[0];
+    const int outh = dims >= 3 ? outsizes[1] : 1;
+    const int outd = dims == 4 ? outsizes[2] : 1;
+
+    // packed axis stays outermost, every element moves as a whole
+    const bool copy_pack = elempack == out_elempack && order[outer] == outer;
+
+    // packed axis becomes the innermost one, transpose elempack x elempack tiles
+    const bool transpose_pack = elempack > 1 && elempack == out_elempack && order[0] == outer;
+
+    const float* ptr = bottom_blob;
+    const int outq = outouter / out_elempack;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < outq; q++)
+    {
+        float* outptr = dims == 2 ? top_blob.row(q) : top_blob.channel(q);
+
+        const size_t* tq = tab_q + q * out_elempack;
+
+        for (int z = 0; z < outd; z++)
+        {
+            for (int y = 0; y < outh; y++)
+            {
+                const float* ptr0 = ptr + tab_z[z] + tab_y[y];
+
+                if (copy_pack)
+                {
+                    ptr0 += tq[0];
+                    for (int x = 0; x < outw; x++)
+                    {
+                        permute_copy_pack(ptr0 + tab_x[x], outptr, out_elempack);
+                        outptr += out_elempack;
+                    }
+                }
+                else if (transpose_pack)
+                {
+                    for (int x = 0; x < outw; x += elempack)
+                    {
+                        permute_transpose_pack(ptr0 + tab_x[x], outptr, tq, elempack);
+                        outptr += elempack * elempack;
+                    }
+                }
+                else
+                {
+                    for (int x = 0; x < outw; x++)
+                    {
+                        const float* ptr1 = ptr0 + tab_x[x];
+                        for (int l = 0; l < out_elempack; l++)
+                        {
+                            *outptr++ = ptr1[tq[l]];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
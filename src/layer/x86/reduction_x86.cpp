@@ -0,0 +1,662 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "reduction_x86.h"
+
+#include <float.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+Reduction_x86::Reduction_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+namespace ReductionOp_x86 {
+
+struct reduction_op_add
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_mul
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x * y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_mul_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_mul_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_mul_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_asum
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + fabsf(y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, abs_ps(y));
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, abs256_ps(y));
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, abs512_ps(y));
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_sumsq
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + y * y;
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_comp_fmadd_ps(y, y, x);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_comp_fmadd_ps(y, y, x);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_fmadd_ps(y, y, x);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_sumexp
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return x + expf(y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_add_ps(x, exp_ps(y));
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_add_ps(x, exp256_ps(y));
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_add_ps(x, exp512_ps(y));
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_max
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return std::max(x, y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_max_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_max_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_max_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct reduction_op_min
+{
+    NCNN_FORCEINLINE float func(const float& x, const float& y) const
+    {
+        return std::min(x, y);
+    }
+#if __SSE2__
+    NCNN_FORCEINLINE __m128 func_pack4(const __m128& x, const __m128& y) const
+    {
+        return _mm_min_ps(x, y);
+    }
+#if __AVX__
+    NCNN_FORCEINLINE __m256 func_pack8(const __m256& x, const __m256& y) const
+    {
+        return _mm256_min_ps(x, y);
+    }
+#if __AVX512F__
+    NCNN_FORCEINLINE __m512 func_pack16(const __m512& x, const __m512& y) const
+    {
+        return _mm512_min_ps(x, y);
+    }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+} // namespace ReductionOp_x86
+
+using namespace ReductionOp_x86;
+
+// reduce elempack lanes independently over up to four strided axes, strides in floats
+template<typename Op>
+static void reduction_packed(const float* ptr, float* outptr, int elempack, float v0, int size0, size_t stride0, int size1, size_t stride1, int size2, size_t stride2, int size3, size_t stride3)
+{
+    Op op;
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    if (elempack == 16)
+    {
+        __m512 _sum = _mm512_set1_ps(v0);
+        for (int i3 = 0; i3 < size3; i3++)
+        {
+            for (int i2 = 0; i2 < size2; i2++)
+            {
+                for (int i1 = 0; i1 < size1; i1++)
+                {
+                    const float* p = ptr + i3 * stride3 + i2 * stride2 + i1 * stride1;
+                    for (int i0 = 0; i0 < size0; i0++)
+                    {
+                        _sum = op.func_pack16(_sum, _mm512_loadu_ps(p));
+                        p += stride0;
+                    }
+                }
+            }
+        }
+        _mm512_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __AVX512F__
+    if (elempack == 8)
+    {
+        __m256 _sum = _mm256_set1_ps(v0);
+        for (int i3 = 0; i3 < size3; i3++)
+        {
+            for (int i2 = 0; i2 < size2; i2++)
+            {
+                for (int i1 = 0; i1 < size1; i1++)
+                {
+                    const float* p = ptr + i3 * stride3 + i2 * stride2 + i1 * stride1;
+                    for (int i0 = 0; i0 < size0; i0++)
+                    {
+                        _sum = op.func_pack8(_sum, _mm256_loadu_ps(p));
+                        p += stride0;
+                    }
+                }
+            }
+        }
+        _mm256_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __AVX__
+    if (elempack == 4)
+    {
+        __m128 _sum = _mm_set1_ps(v0);
+        for (int i3 = 0; i3 < size3; i3++)
+        {
+            for (int i2 = 0; i2 < size2; i2++)
+            {
+                for (int i1 = 0; i1 < size1; i1++)
+                {
+                    const float* p = ptr + i3 * stride3 + i2 * stride2 + i1 * stride1;
+                    for (int i0 = 0; i0 < size0; i0++)
+                    {
+                        _sum = op.func_pack4(_sum, _mm_loadu_ps(p));
+                        p += stride0;
+                    }
+                }
+            }
+        }
+        _mm_storeu_ps(outptr, _sum);
+        return;
+    }
+#endif // __SSE2__
+
+    for (int k = 0; k < elempack; k++)
+    {
+        float sum = v0;
+        for (int i3 = 0; i3 < size3; i3++)
+        {
+            for (int i2 = 0; i2 < size2; i2++)
+            {
+                for (int i1 = 0; i1 < size1; i1++)
+                {
+                    const float* p = ptr + i3 * stride3 + i2 * stride2 + i1 * stride1 + k;
+                    for (int i0 = 0; i0 < size0; i0++)
+                    {
+                        sum = op.func(sum, *p);
+                        p += stride0;
+                    }
+                }
+            }
+        }
+        outptr[k] = sum;
+    }
+}
+
+static void reduction_packed(const float* ptr, float* outptr, int elempack, float v0, int size0, size_t stride0, int size1, size_t stride1, int size2, size_t stride2, int size3, size_t stride3, int op_type)
+{
+    if (op_type == Reduction::ReductionOp_SUM) return reduction_packed<reduction_op_add>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_ASUM) return reduction_packed<reduction_op_asum>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_SUMSQ) return reduction_packed<reduction_op_sumsq>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_PROD) return reduction_packed<reduction_op_mul>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_MAX) return reduction_packed<reduction_op_max>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_MIN) return reduction_packed<reduction_op_min>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+    if (op_type == Reduction::ReductionOp_LogSumExp) return reduction_packed<reduction_op_sumexp>(ptr, outptr, elempack, v0, size0, stride0, size1, stride1, size2, stride2, size3, stride3);
+}
+
+// combine partial results, lanes of a packed partial included
+static float reduction_fold(float v0, const float* ptr, int size, int op2_type)
+{
+    float sum = v0;
+    for (int i = 0; i < size; i++)
+    {
+        if (op2_type == Reduction::ReductionOp_MAX)
+            sum = std::max(sum, ptr[i]);
+        else if (op2_type == Reduction::ReductionOp_MIN)
+            sum = std::min(sum, ptr[i]);
+        else if (op2_type == Reduction::ReductionOp_PROD)
+            sum = sum * ptr[i];
+        else
+            sum = sum + ptr[i];
+    }
+
+    return sum;
+}
+
+int Reduction_x86::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+{
+    int dims = bottom_blob.dims;
+    int axes_flag[4] = {0};
+    bool reduce_w = false;
+    bool reduce_h = false;
+    bool reduce_d = false;
+    bool reduce_c = false;
+
+    if (reduce_all)
+    {
+        reduce_w = true;
+        reduce_h = true;
+        reduce_d = true;
+        reduce_c = true;
+    }
+    else
+    {
+        const int* axes_ptr = axes;
+        int reduced_axes_num = axes.w;
+
+        for (int i = 0; i < reduced_axes_num; i++)
+        {
+            int axis = axes_ptr[i];
+            // handle negative axis
+            if (axis < 0)
+                axis += dims;
+            axes_flag[axis] = 1;
+        }
+
+        if (dims == 1)
+        {
+            reduce_w = true;
+        }
+        else if (dims == 2)
+        {
+            if (axes_flag[0] == 1) reduce_h = true;
+            if (axes_flag[1] == 1) reduce_w = true;
+        }
+        else if (dims == 3)
+        {
+            if (axes_flag[0] == 1) reduce_c = true;
+            if (axes_flag[1] == 1) reduce_h = true;
+            if (axes_flag[2] == 1) reduce_w = true;
+        }
+        else if (dims == 4)
+        {
+            if (axes_flag[0] == 1) reduce_c = true;
+            if (axes_flag[1] == 1) reduce_d = true;
+            if (axes_flag[2] == 1) reduce_h = true;
+            if (axes_flag[3] == 1) reduce_w = true;
+        }
+    }
+
+    if (dims == 3)
+        reduce_d = false;
+    if (dims == 2)
+    {
+        reduce_d = false;
+        reduce_c = false;
+    }
+    if (dims == 1)
+    {
+        reduce_h = false;
+        reduce_d = false;
+        reduce_c = false;
+    }
+
+    const int elempack = bottom_blob.elempack;
+
+    if (elempack == 1 || (!reduce_w && !reduce_h && !reduce_d && !reduce_c))
+    {
+        if (elempack == 1)
+            return Reduction::forward(bottom_blob, top_blob, opt);
+
+        Option opt_pack = opt;
+        opt_pack.blob_allocator = opt.workspace_allocator;
+
+        Mat bottom_blob_unpacked;
+        convert_packing(bottom_blob, bottom_blob_unpacked, 1, opt_pack);
+        if (bottom_blob_unpacked.empty())
+            return -100;
+
+        return Reduction::forward(bottom_blob_unpacked, top_blob, opt);
+    }
+
+    int op_type = Reduction::ReductionOp_SUM;
+    int op2_type = Reduction::ReductionOp_SUM;
+    float v0 = 0.f;
+
+    switch (operation)
+    {
+    case Reduction::ReductionOp_ASUM:
+    case Reduction::ReductionOp_L1:
+        op_type = Reduction::ReductionOp_ASUM;
+        break;
+    case Reduction::ReductionOp_SUMSQ:
+    case Reduction::ReductionOp_L2:
+        op_type = Reduction::ReductionOp_SUMSQ;
+        break;
+    case Reduction::ReductionOp_MAX:
+        op_type = Reduction::ReductionOp_MAX;
+        op2_type = Reduction::ReductionOp_MAX;
+        v0 = -FLT_MAX;
+        break;
+    case Reduction::ReductionOp_MIN:
+        op_type = Reduction::ReductionOp_MIN;
+        op2_type = Reduction::ReductionOp_MIN;
+        v0 = FLT_MAX;
+        break;
+    case Reduction::ReductionOp_PROD:
+        op_type = Reduction::ReductionOp_PROD;
+        op2_type = Reduction::ReductionOp_PROD;
+        v0 = 1.f;
+        break;
+    case Reduction::ReductionOp_LogSumExp:
+        op_type = Reduction::ReductionOp_LogSumExp;
+        break;
+    default:
+        // SUM MEAN LogSum
+        break;
+    }
+
+    const int w = bottom_blob.w;
+    const int h = bottom_blob.h;
+    const int d = bottom_blob.d;
+    const int channels = bottom_blob.c;
+
+    // the outermost axis is the packed one, the others are walked in elempack floats
+    int outer_size = channels;
+    size_t outer_stride = bottom_blob.cstep * elempack;
+    bool reduce_outer = reduce_c;
+    if (dims == 1)
+    {
+        outer_size = w;
+        outer_stride = elempack;
+        reduce_outer = reduce_w;
+    }
+    if (dims == 2)
+    {
+        outer_size = h;
+        outer_stride = (size_t)w * elempack;
+        reduce_outer = reduce_h;
+    }
+
+    // inner axes innermost first, padded with unit axes
+    const int inner_num = dims == 4 ? 3 : dims - 1;
+    const int inner_sizes[3] = {w, h, d};
+    const size_t inner_strides[3] = {(size_t)elempack, (size_t)w * elempack, (size_t)w * h * elempack};
+    const bool inner_reduced[3] = {reduce_w, reduce_h, reduce_d};
+
+    int kept_num = 0;
+    int kept_sizes[3] = {1, 1, 1};
+    size_t kept_strides[3] = {0, 0, 0};
+    int reduced_sizes[3] = {1, 1, 1};
+    size_t reduced_strides[3] = {0, 0, 0};
+    int reduced_num = 0;
+    int scale = reduce_outer ? outer_size * elempack : 1;
+    for (int i = 0; i < inner_num; i++)
+    {
+        if (inner_reduced[i])
+        {
+            reduced_sizes[reduced_num] = inner_sizes[i];
+            reduced_strides[reduced_num] = inner_strides[i];
+            reduced_num++;
+            scale *= inner_sizes[i];
+        }
+        else
+        {
+            kept_sizes[kept_num] = inner_sizes[i];
+            kept_strides[kept_num] = inner_strides[i];
+            kept_num++;
+        }
+    }
+
+    // kept axes in w h d c order, reduced ones dropped unless keepdims
+    const int out_elempack = reduce_outer ? 1 : elempack;
+    const size_t out_elemsize = 4u * out_elempack;
+    {
+        int outshape[4];
+        int outdims = 0;
+        for (int i = 0; i < inner_num; i++)
+        {
+            if (keepdims || !inner_reduced[i])
+                outshape[outdims++] = inner_reduced[i] ? 1 : inner_sizes[i];
+        }
+        if (keepdims || !reduce_outer)
+            outshape[outdims++] = reduce_outer ? 1 : outer_size;
+
+        if (outdims == 0)
+            top_blob.create(1, out_elemsize, out_elempack, opt.blob_allocator);
+        if (outdims == 1)
+            top_blob.create(outshape[0], out_elemsize, out_elempack, opt.blob_allocator);
+        if (outdims == 2)
+            top_blob.create(outshape[0], outshape[1], out_elemsize, out_elempack, opt.blob_allocator);
+        if (outdims == 3)
+            top_blob.create(outshape[0], outshape[1], outshape[2], out_elemsize, out_elempack, opt.blob_allocator);
+        if (outdims == 4)
+            top_blob.create(outshape[0], outshape[1], outshape[2], outshape[3], out_elemsize, out_elempack, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+    }
+
+    const float* ptr = bottom_blob;
+    float* outptr = top_blob;
+
+    if (!reduce_outer)
+    {
+        // lanes stay apart, every output element is a packed vector
+        size_t out_outer_stride = top_blob.cstep * elempack;
+        if (top_blob.dims == 1)
+            out_outer_stride = elempack;
+        if (top_blob.dims == 2)
+            out_outer_stride = (size_t)top_blob.w * elempack;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < outer_size; q++)
+        {
+            const float* ptr0 = ptr + q * outer_stride;
+            float* outptr0 = outptr + q * out_outer_stride;
+
+            for (int k2 = 0; k2 < kept_sizes[2]; k2++)
+            {
+                for (int k1 = 0; k1 < kept_sizes[1]; k1++)
+                {
+                    for (int k0 = 0; k0 < kept_sizes[0]; k0++)
+                    {
+                        const float* ptr1 = ptr0 + k2 * kept_strides[2] + k1 * kept_strides[1] + k0 * kept_strides[0];
+
+                        reduction_packed(ptr1, outptr0, elempack, v0, reduced_sizes[0], reduced_strides[0], reduced_sizes[1], reduced_strides[1], reduced_sizes[2], reduced_strides[2], 1, 0, op_type);
+                        outptr0 += elempack;
+                    }
+                }
+            }
+        }
+    }
+    else if (kept_num == 0)
+    {
+        // everything reduced, partial per packed outer index
+        Mat sums(outer_size, (size_t)4u, opt.workspace_allocator);
+        if (sums.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < outer_size; q++)
+        {
+            float tmp[16];
+            reduction_packed(ptr + q * outer_stride, tmp, elempack, v0, reduced_sizes[0], reduced_strides[0], reduced_sizes[1], reduced_strides[1], reduced_sizes[2], reduced_strides[2], 1, 0, op_type);
+            sums[q] = reduction_fold(v0, tmp, elempack, op2_type);
+        }
+
+        outptr[0] = reduction_fold(v0, sums, outer_size, op2_type);
+    }
+    else
+    {
+        // packed axis reduced, lanes folded into unpacked output
+        size_t out_strides[3] = {1, (size_t)kept_sizes[0], (size_t)kept_sizes[0] * kept_sizes[1]};
+        if (!keepdims && kept_num == 3)
+            out_strides[2] = top_blob.cstep;
+
+        const int kept_total = kept_sizes[0] * kept_sizes[1] * kept_sizes[2];
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < kept_total; i++)
+        {
+            const int k0 = i % kept_sizes[0];
+            const int k1 = i / kept_sizes[0] % kept_sizes[1];
+            const int k2 = i / kept_sizes[0] / kept_sizes[1];
+
+            const float* ptr1 = ptr + k2 * kept_strides[2] + k1 * kept_strides[1] + k0 * kept_strides[0];
+
+            float tmp[16];
+            reduction_packed(ptr1, tmp, elempack, v0, reduced_sizes[0], reduced_strides[0], reduced_sizes[1], reduced_strides[1], reduced_sizes[2], reduced_strides[2], outer_size, outer_stride, op_type);
+
+            outptr[k2 * out_strides[2] + k1 * out_strides[1] + k0] = reduction_fold(v0, tmp, elempack, op2_type);
+        }
+    }
+
+    const int size = (int)(top_blob.total() * out_elempack);
+
+    if (operation == Reduction::ReductionOp_LogSum || operation == Reduction::ReductionOp_LogSumExp)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < size; i++)
+        {
+            outptr[i] = logf(outptr[i]);
+        }
+    }
+
+    if (operation == Reduction::ReductionOp_L2)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < size; i++)
+        {
+            // flush subnormal input to zero as the generic path does
+            outptr[i] = sqrtf(outptr[i] < FLT_MIN ? 0.f : outptr[i]);
+        }
+    }
+
+    float coeff = this->coeff;
+    if (operation == Reduction::ReductionOp_MEAN)
+        coeff = coeff / scale;
+
+    if (coeff != 1.f)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i = 0; i < size; i++)
+        {
+            outptr[i] = outptr[i] * coeff;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
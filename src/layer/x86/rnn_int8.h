@@ -0,0 +1,484 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+void rnn_transform_weight_int8_avx512vnni(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt);
+int rnn_int8_avx512vnni(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+void rnn_transform_weight_int8_avxvnni(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt);
+int rnn_int8_avxvnni(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+void rnn_transform_weight_int8_avx2(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt);
+int rnn_int8_avx2(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_XOP && __SSE2__ && !__XOP__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+int rnn_int8_xop(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt);
+#endif
+
+// hidden units are packed in groups of 16, 8 and 4 as far as the integer isa allows
+static int rnn_int8_unit_elempack(int remain)
+{
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+    if (remain >= 16)
+        return 16;
+#endif // __AVX512F__
+    if (remain >= 8)
+        return 8;
+#endif // __AVX2__
+    if (remain >= 4)
+        return 4;
+#endif // __SSE2__
+    return 1;
+}
+
+static void rnn_transform_weight_int8(const Mat& weight_xc, const Mat& weight_xc_int8_scales, const Mat& weight_hc, const Mat& weight_hc_int8_scales, Mat& weight_data_tm, Mat& weight_data_tm_int8_descales, int size, int num_output, int num_directions, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx512_vnni())
+    {
+        rnn_transform_weight_int8_avx512vnni(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, weight_data_tm, weight_data_tm_int8_descales, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        rnn_transform_weight_int8_avxvnni(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, weight_data_tm, weight_data_tm_int8_descales, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        rnn_transform_weight_int8_avx2(weight_xc, weight_xc_int8_scales, weight_hc, weight_hc_int8_scales, weight_data_tm, weight_data_tm_int8_descales, size, num_output, num_directions, opt);
+        return;
+    }
+#endif
+
+    // the group of units starting at q takes row q
+    // each input pair k holds the weights of all units in the group, two consecutive k per unit
+    // odd size and num_output are padded with zero weights
+    const int size2 = size + size % 2;
+    const int num_output2 = num_output + num_output % 2;
+
+    weight_data_tm.create(size2 + num_output2, num_output, num_directions, (size_t)1u);
+    weight_data_tm_int8_descales.create(2, num_output, num_directions);
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int dr = 0; dr < num_directions; dr++)
+    {
+        const Mat weight_xc_dr = weight_xc.channel(dr);
+        const Mat weight_hc_dr = weight_hc.channel(dr);
+        const float* weight_xc_int8_scales_ptr = weight_xc_int8_scales.row(dr);
+        const float* weight_hc_int8_scales_ptr = weight_hc_int8_scales.row(dr);
+
+        Mat weight_data_tm_dr = weight_data_tm.channel(dr);
+        Mat weight_data_tm_int8_descales_dr = weight_data_tm_int8_descales.channel(dr);
+
+        for (int q = 0; q < num_output;)
+        {
+            const int elempack = rnn_int8_unit_elempack(num_output - q);
+
+            float* descales_ptr = weight_data_tm_int8_descales_dr.row(q);
+            for (int j = 0; j < elempack; j++)
+            {
+                descales_ptr[j] = 1.f / weight_xc_int8_scales_ptr[q + j];
+                descales_ptr[elempack + j] = 1.f / weight_hc_int8_scales_ptr[q + j];
+            }
+
+            signed char* kptr = weight_data_tm_dr.row<signed char>(q);
+            for (int i = 0; i < size; i += 2)
+            {
+                for (int j = 0; j < elempack; j++)
+                {
+                    const signed char* weight_xc_ptr = weight_xc_dr.row<const signed char>(q + j);
+
+                    kptr[0] = weight_xc_ptr[i];
+                    kptr[1] = i + 1 < size ? weight_xc_ptr[i + 1] : 0;
+                    kptr += 2;
+                }
+            }
+            for (int i = 0; i < num_output; i += 2)
+            {
+                for (int j = 0; j < elempack; j++)
+                {
+                    const signed char* weight_hc_ptr = weight_hc_dr.row<const signed char>(q + j);
+
+                    kptr[0] = weight_hc_ptr[i];
+                    kptr[1] = i + 1 < num_output ? weight_hc_ptr[i + 1] : 0;
+                    kptr += 2;
+                }
+            }
+
+            q += elempack;
+        }
+    }
+}
+
+static float rnn_dynamic_quantize_get_absmax(const float* ptr, int size)
+{
+    float absmax = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _absmax_avx512 = _mm512_set1_ps(0.f);
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr + i);
+        _absmax_avx512 = _mm512_max_ps(_absmax_avx512, abs512_ps(_p));
+    }
+    absmax = std::max(absmax, _mm512_comp_reduce_max_ps(_absmax_avx512));
+#endif // __AVX512F__
+    __m256 _absmax_avx = _mm256_set1_ps(0.f);
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr + i);
+        _absmax_avx = _mm256_max_ps(_absmax_avx, abs256_ps(_p));
+    }
+    absmax = std::max(absmax, _mm256_reduce_max_ps(_absmax_avx));
+#endif // __AVX__
+    __m128 _absmax = _mm_set1_ps(0.f);
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr + i);
+        _absmax = _mm_max_ps(_absmax, abs_ps(_p));
+    }
+    absmax = std::max(absmax, _mm_reduce_max_ps(_absmax));
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        absmax = std::max(absmax, (float)fabs(ptr[i]));
+    }
+
+    return absmax;
+}
+
+// int8 values widened to int16, odd size gets one zero appended
+static void rnn_dynamic_quantize_scale2int8(const float* ptr, int size, float scale, short* outptr)
+{
+    for (int i = 0; i < size; i++)
+    {
+        outptr[i] = float2int8(ptr[i] * scale);
+    }
+
+    if (size % 2)
+        outptr[size] = 0;
+}
+
+static int rnn_int8(const Mat& bottom_blob_int8, const Mat& bottom_blob_int8_descales, Mat& top_blob, int reverse, const Mat& weight_data_tm, const Mat& weight_data_tm_int8_descales, const Mat& bias_c, Mat& hidden_state, const Option& opt)
+{
+#if NCNN_RUNTIME_CPU && NCNN_AVX512VNNI && __AVX512F__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx512_vnni())
+    {
+        return rnn_int8_avx512vnni(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVXVNNI && __AVX__ && !__AVX512F__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx_vnni())
+    {
+        return rnn_int8_avxvnni(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_AVX2 && __AVX__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_avx2())
+    {
+        return rnn_int8_avx2(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+#if NCNN_RUNTIME_CPU && NCNN_XOP && __SSE2__ && !__XOP__ && !__AVX2__ && !__AVXVNNI__ && !__AVX512VNNI__
+    if (ncnn::cpu_support_x86_xop())
+    {
+        return rnn_int8_xop(bottom_blob_int8, bottom_blob_int8_descales, top_blob, reverse, weight_data_tm, weight_data_tm_int8_descales, bias_c, hidden_state, opt);
+    }
+#endif
+
+    // size is padded to even already
+    const int size = bottom_blob_int8.w;
+    const int T = bottom_blob_int8.h;
+
+    const int num_output = top_blob.w;
+    const int num_output2 = num_output + num_output % 2;
+
+    // num_output
+    Mat gates(num_output, 4u, opt.workspace_allocator);
+    if (gates.empty())
+        return -100;
+
+    Mat hidden_state_int8(num_output2, (size_t)2u, 1, opt.workspace_allocator);
+    if (hidden_state_int8.empty())
+        return -100;
+
+    // unroll
+    for (int t = 0; t < T; t++)
+    {
+        const int ti = reverse ? T - 1 - t : t;
+
+        // dynamic quantize hidden_state
+        const float absmax = rnn_dynamic_quantize_get_absmax(hidden_state, num_output);
+        rnn_dynamic_quantize_scale2int8(hidden_state, num_output, absmax == 0.f ? 0.f : 127.f / absmax, hidden_state_int8);
+
+        const short* x = bottom_blob_int8.row<const short>(ti);
+        const short* hs = hidden_state_int8;
+        const float descale_x = bottom_blob_int8_descales[ti];
+        const float descale_h = absmax / 127.f;
+
+        float* gates_H = gates;
+
+        int remain_num_output_start = 0;
+#if __SSE2__
+#if __AVX2__
+#if __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 4;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 16;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+
+                __m512i _Hx0 = _mm512_setzero_si512();
+                __m512i _Hx1 = _mm512_setzero_si512();
+                int i = 0;
+                for (; i + 3 < size; i += 4)
+                {
+                    __m512i _w0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    __m512i _w1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 32)));
+                    _Hx0 = _mm512_comp_dpwssd_epi32(_Hx0, _w0, _mm512_set1_epi32(*(const int*)(x + i)));
+                    _Hx1 = _mm512_comp_dpwssd_epi32(_Hx1, _w1, _mm512_set1_epi32(*(const int*)(x + i + 2)));
+
+                    kptr += 64;
+                }
+                for (; i < size; i += 2)
+                {
+                    __m512i _w = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    _Hx0 = _mm512_comp_dpwssd_epi32(_Hx0, _w, _mm512_set1_epi32(*(const int*)(x + i)));
+
+                    kptr += 32;
+                }
+
+                __m512i _Hh0 = _mm512_setzero_si512();
+                __m512i _Hh1 = _mm512_setzero_si512();
+                i = 0;
+                for (; i + 3 < num_output2; i += 4)
+                {
+                    __m512i _w0 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    __m512i _w1 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)(kptr + 32)));
+                    _Hh0 = _mm512_comp_dpwssd_epi32(_Hh0, _w0, _mm512_set1_epi32(*(const int*)(hs + i)));
+                    _Hh1 = _mm512_comp_dpwssd_epi32(_Hh1, _w1, _mm512_set1_epi32(*(const int*)(hs + i + 2)));
+
+                    kptr += 64;
+                }
+                for (; i < num_output2; i += 2)
+                {
+                    __m512i _w = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i*)kptr));
+                    _Hh0 = _mm512_comp_dpwssd_epi32(_Hh0, _w, _mm512_set1_epi32(*(const int*)(hs + i)));
+
+                    kptr += 32;
+                }
+
+                __m512 _H = _mm512_loadu_ps((const float*)bias_c + q);
+                _H = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_add_epi32(_Hx0, _Hx1)), _mm512_mul_ps(_mm512_set1_ps(descale_x), _mm512_loadu_ps(descales_ptr)), _H);
+                _H = _mm512_fmadd_ps(_mm512_cvtepi32_ps(_mm512_add_epi32(_Hh0, _Hh1)), _mm512_mul_ps(_mm512_set1_ps(descale_h), _mm512_loadu_ps(descales_ptr + 16)), _H);
+
+                _H = tanh_avx512(_H);
+
+                _mm512_storeu_ps(gates_H + q, _H);
+            }
+            remain_num_output_start += nn_num_output << 4;
+        }
+#endif // __AVX512F__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 3;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 8;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+
+                __m256i _Hx0 = _mm256_setzero_si256();
+                __m256i _Hx1 = _mm256_setzero_si256();
+                int i = 0;
+                for (; i + 3 < size; i += 4)
+                {
+                    __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+                    _Hx0 = _mm256_comp_dpwssd_epi32(_Hx0, _w0, _mm256_set1_epi32(*(const int*)(x + i)));
+                    _Hx1 = _mm256_comp_dpwssd_epi32(_Hx1, _w1, _mm256_set1_epi32(*(const int*)(x + i + 2)));
+
+                    kptr += 32;
+                }
+                for (; i < size; i += 2)
+                {
+                    __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    _Hx0 = _mm256_comp_dpwssd_epi32(_Hx0, _w, _mm256_set1_epi32(*(const int*)(x + i)));
+
+                    kptr += 16;
+                }
+
+                __m256i _Hh0 = _mm256_setzero_si256();
+                __m256i _Hh1 = _mm256_setzero_si256();
+                i = 0;
+                for (; i + 3 < num_output2; i += 4)
+                {
+                    __m256i _w0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    __m256i _w1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(kptr + 16)));
+                    _Hh0 = _mm256_comp_dpwssd_epi32(_Hh0, _w0, _mm256_set1_epi32(*(const int*)(hs + i)));
+                    _Hh1 = _mm256_comp_dpwssd_epi32(_Hh1, _w1, _mm256_set1_epi32(*(const int*)(hs + i + 2)));
+
+                    kptr += 32;
+                }
+                for (; i < num_output2; i += 2)
+                {
+                    __m256i _w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)kptr));
+                    _Hh0 = _mm256_comp_dpwssd_epi32(_Hh0, _w, _mm256_set1_epi32(*(const int*)(hs + i)));
+
+                    kptr += 16;
+                }
+
+                __m256 _H = _mm256_loadu_ps((const float*)bias_c + q);
+                _H = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_Hx0, _Hx1)), _mm256_mul_ps(_mm256_set1_ps(descale_x), _mm256_loadu_ps(descales_ptr)), _H);
+                _H = _mm256_comp_fmadd_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_Hh0, _Hh1)), _mm256_mul_ps(_mm256_set1_ps(descale_h), _mm256_loadu_ps(descales_ptr + 8)), _H);
+
+                _H = tanh_avx(_H);
+
+                _mm256_storeu_ps(gates_H + q, _H);
+            }
+            remain_num_output_start += nn_num_output << 3;
+        }
+#endif // __AVX2__
+        {
+            const int nn_num_output = (num_output - remain_num_output_start) >> 2;
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int qq = 0; qq < nn_num_output; qq++)
+            {
+                const int q = remain_num_output_start + qq * 4;
+
+                const signed char* kptr = weight_data_tm.row<const signed char>(q);
+                const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+
+                __m128i _Hx0 = _mm_setzero_si128();
+                __m128i _Hx1 = _mm_setzero_si128();
+                int i = 0;
+                for (; i + 3 < size; i += 4)
+                {
+                    __m128i _w01 = _mm_loadu_si128((const __m128i*)kptr);
+#if __SSE4_1__
+                    __m128i _w0 = _mm_cvtepi8_epi16(_w01);
+                    __m128i _w1 = _mm_cvtepi8_epi16(_mm_unpackhi_epi64(_w01, _w01));
+#else
+                    __m128i _extw01 = _mm_cmpgt_epi8(_mm_setzero_si128(), _w01);
+                    __m128i _w0 = _mm_unpacklo_epi8(_w01, _extw01);
+                    __m128i _w1 = _mm_unpackhi_epi8(_w01, _extw01);
+#endif
+                    _Hx0 = _mm_comp_dpwssd_epi32(_Hx0, _w0, _mm_set1_epi32(*(const int*)(x + i)));
+                    _Hx1 = _mm_comp_dpwssd_epi32(_Hx1, _w1, _mm_set1_epi32(*(const int*)(x + i + 2)));
+
+                    kptr += 16;
+                }
+                for (; i < size; i += 2)
+                {
+                    __m128i _w = _mm_loadl_epi64((const __m128i*)kptr);
+#if __SSE4_1__
+                    _w = _mm_cvtepi8_epi16(_w);
+#else
+                    _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+#endif
+                    _Hx0 = _mm_comp_dpwssd_epi32(_Hx0, _w, _mm_set1_epi32(*(const int*)(x + i)));
+
+                    kptr += 8;
+                }
+
+                __m128i _Hh0 = _mm_setzero_si128();
+                __m128i _Hh1 = _mm_setzero_si128();
+                i = 0;
+                for (; i + 3 < num_output2; i += 4)
+                {
+                    __m128i _w01 = _mm_loadu_si128((const __m128i*)kptr);
+#if __SSE4_1__
+                    __m128i _w0 = _mm_cvtepi8_epi16(_w01);
+                    __m128i _w1 = _mm_cvtepi8_epi16(_mm_unpackhi_epi64(_w01, _w01));
+#else
+                    __m128i _extw01 = _mm_cmpgt_epi8(_mm_setzero_si128(), _w01);
+                    __m128i _w0 = _mm_unpacklo_epi8(_w01, _extw01);
+                    __m128i _w1 = _mm_unpackhi_epi8(_w01, _extw01);
+#endif
+                    _Hh0 = _mm_comp_dpwssd_epi32(_Hh0, _w0, _mm_set1_epi32(*(const int*)(hs + i)));
+                    _Hh1 = _mm_comp_dpwssd_epi32(_Hh1, _w1, _mm_set1_epi32(*(const int*)(hs + i + 2)));
+
+                    kptr += 16;
+                }
+                for (; i < num_output2; i += 2)
+                {
+                    __m128i _w = _mm_loadl_epi64((const __m128i*)kptr);
+#if __SSE4_1__
+                    _w = _mm_cvtepi8_epi16(_w);
+#else
+                    _w = _mm_unpacklo_epi8(_w, _mm_cmpgt_epi8(_mm_setzero_si128(), _w));
+#endif
+                    _Hh0 = _mm_comp_dpwssd_epi32(_Hh0, _w, _mm_set1_epi32(*(const int*)(hs + i)));
+
+                    kptr += 8;
+                }
+
+                __m128 _H = _mm_loadu_ps((const float*)bias_c + q);
+                _H = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_mm_add_epi32(_Hx0, _Hx1)), _mm_mul_ps(_mm_set1_ps(descale_x), _mm_loadu_ps(descales_ptr)), _H);
+                _H = _mm_comp_fmadd_ps(_mm_cvtepi32_ps(_mm_add_epi32(_Hh0, _Hh1)), _mm_mul_ps(_mm_set1_ps(descale_h), _mm_loadu_ps(descales_ptr + 4)), _H);
+
+                _H = tanh_sse(_H);
+
+                _mm_storeu_ps(gates_H + q, _H);
+            }
+            remain_num_output_start += nn_num_output << 2;
+        }
+#endif // __SSE2__
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = remain_num_output_start; q < num_output; q++)
+        {
+            const signed char* kptr = weight_data_tm.row<const signed char>(q);
+            const float* descales_ptr = weight_data_tm_int8_descales.row(q);
+
+            int Hx = 0;
+            for (int i = 0; i < size; i++)
+            {
+                Hx += kptr[i] * x[i];
+            }
+            kptr += size;
+
+            int Hh = 0;
+            for (int i = 0; i < num_output2; i++)
+            {
+                Hh += kptr[i] * hs[i];
+            }
+
+            float H = bias_c[q] + Hx * (descale_x * descales_ptr[0]) + Hh * (descale_h * descales_ptr[1]);
+
+            gates_H[q] = tanhf(H);
+        }
+
+        float* output_data = top_blob.row(ti);
+        float* hidden_ptr = hidden_state;
+
+        memcpy(hidden_ptr, gates_H, num_output * sizeof(float));
+        memcpy(output_data, gates_H, num_output * sizeof(float));
+    }
+
+    return 0;
+}
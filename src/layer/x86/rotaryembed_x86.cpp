@@ -0,0 +1,243 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "rotaryembed_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+namespace ncnn {
+
+RotaryEmbed_x86::RotaryEmbed_x86()
+{
+#if __SSE2__
+    support_packing = true;
+#endif // __SSE2__
+}
+
+static void rotaryembed_half(const float* ptr0, const float* ptr1, const float* cos_ptr, const float* sin_ptr, float* outptr0, float* outptr1, int size)
+{
+    int j = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; j + 15 < size; j += 16)
+    {
+        __m512 _x0 = _mm512_loadu_ps(ptr0 + j);
+        __m512 _x1 = _mm512_loadu_ps(ptr1 + j);
+        __m512 _cos = _mm512_loadu_ps(cos_ptr + j);
+        __m512 _sin = _mm512_loadu_ps(sin_ptr + j);
+        _mm512_storeu_ps(outptr0 + j, _mm512_fmsub_ps(_x0, _cos, _mm512_mul_ps(_x1, _sin)));
+        _mm512_storeu_ps(outptr1 + j, _mm512_fmadd_ps(_x0, _sin, _mm512_mul_ps(_x1, _cos)));
+    }
+#endif // __AVX512F__
+    for (; j + 7 < size; j += 8)
+    {
+        __m256 _x0 = _mm256_loadu_ps(ptr0 + j);
+        __m256 _x1 = _mm256_loadu_ps(ptr1 + j);
+        __m256 _cos = _mm256_loadu_ps(cos_ptr + j);
+        __m256 _sin = _mm256_loadu_ps(sin_ptr + j);
+        _mm256_storeu_ps(outptr0 + j, _mm256_comp_fmsub_ps(_x0, _cos, _mm256_mul_ps(_x1, _sin)));
+        _mm256_storeu_ps(outptr1 + j, _mm256_comp_fmadd_ps(_x0, _sin, _mm256_mul_ps(_x1, _cos)));
+    }
+#endif // __AVX__
+    for (; j + 3 < size; j += 4)
+    {
+        __m128 _x0 = _mm_loadu_ps(ptr0 + j);
+        __m128 _x1 = _mm_loadu_ps(ptr1 + j);
+        __m128 _cos = _mm_loadu_ps(cos_ptr + j);
+        __m128 _sin = _mm_loadu_ps(sin_ptr + j);
+        _mm_storeu_ps(outptr0 + j, _mm_comp_fmsub_ps(_x0, _cos, _mm_mul_ps(_x1, _sin)));
+        _mm_storeu_ps(outptr1 + j, _mm_comp_fmadd_ps(_x0, _sin, _mm_mul_ps(_x1, _cos)));
+    }
+#endif // __SSE2__
+    for (; j < size; j++)
+    {
+        const float x0 = ptr0[j];
+        const float x1 = ptr1[j];
+        outptr0[j] = x0 * cos_ptr[j] - x1 * sin_ptr[j];
+        outptr1[j] = x0 * sin_ptr[j] + x1 * cos_ptr[j];
+    }
+}
+
+static void rotaryembed_interleaved(const float* ptr, const float* cos_ptr, const float* sin_ptr, float* outptr, int size)
+{
+    // out = x * cos +- swap(x) * sin with subtraction on even lanes
+    int j = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    const __m512i _dup = _mm512_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7);
+    for (; j + 7 < size; j += 8)
+    {
+        __m512 _x = _mm512_loadu_ps(ptr + j * 2);
+        __m512 _cos = _mm512_permutexvar_ps(_dup, _mm512_castps256_ps512(_mm256_loadu_ps(cos_ptr + j)));
+        __m512 _sin = _mm512_permutexvar_ps(_dup, _mm512_castps256_ps512(_mm256_loadu_ps(sin_ptr + j)));
+        __m512 _xs = _mm512_permute_ps(_x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm512_storeu_ps(outptr + j * 2, _mm512_fmaddsub_ps(_x, _cos, _mm512_mul_ps(_xs, _sin)));
+    }
+#endif // __AVX512F__
+    for (; j + 3 < size; j += 4)
+    {
+        __m256 _x = _mm256_loadu_ps(ptr + j * 2);
+        __m128 _cos = _mm_loadu_ps(cos_ptr + j);
+        __m128 _sin = _mm_loadu_ps(sin_ptr + j);
+        __m256 _cos2 = combine4x2_ps(_mm_unpacklo_ps(_cos, _cos), _mm_unpackhi_ps(_cos, _cos));
+        __m256 _sin2 = combine4x2_ps(_mm_unpacklo_ps(_sin, _sin), _mm_unpackhi_ps(_sin, _sin));
+        __m256 _xs = _mm256_permute_ps(_x, _MM_SHUFFLE(2, 3, 0, 1));
+#if __FMA__
+        _mm256_storeu_ps(outptr + j * 2, _mm256_fmaddsub_ps(_x, _cos2, _mm256_mul_ps(_xs, _sin2)));
+#else
+        _mm256_storeu_ps(outptr + j * 2, _mm256_addsub_ps(_mm256_mul_ps(_x, _cos2), _mm256_mul_ps(_xs, _sin2)));
+#endif
+    }
+#endif // __AVX__
+    const __m128 _signmask = _mm_castsi128_ps(_mm_setr_epi32(0x80000000, 0, 0x80000000, 0));
+    for (; j + 1 < size; j += 2)
+    {
+        __m128 _x = _mm_loadu_ps(ptr + j * 2);
+        __m128 _cos = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(cos_ptr + j));
+        __m128 _sin = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(sin_ptr + j));
+        _cos = _mm_unpacklo_ps(_cos, _cos);
+        _sin = _mm_unpacklo_ps(_sin, _sin);
+        __m128 _xs = _mm_shuffle_ps(_x, _x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_ps(outptr + j * 2, _mm_comp_fmadd_ps(_x, _cos, _mm_xor_ps(_mm_mul_ps(_xs, _sin), _signmask)));
+    }
+#endif // __SSE2__
+    for (; j < size; j++)
+    {
+        const float x0 = ptr[j * 2];
+        const float x1 = ptr[j * 2 + 1];
+        outptr[j * 2] = x0 * cos_ptr[j] - x1 * sin_ptr[j];
+        outptr[j * 2 + 1] = x0 * sin_ptr[j] + x1 * cos_ptr[j];
+    }
+}
+
+// heads packed by elempack share the rotation of one position
+static void rotaryembed_pack(const float* ptr0, const float* ptr1, const float* cos_ptr, const float* sin_ptr, float* outptr0, float* outptr1, int size, int stride, int elempack)
+{
+    for (int j = 0; j < size; j++)
+    {
+        const float cos_val = cos_ptr[j];
+        const float sin_val = sin_ptr[j];
+
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        if (elempack == 16)
+        {
+            __m512 _x0 = _mm512_loadu_ps(ptr0);
+            __m512 _x1 = _mm512_loadu_ps(ptr1);
+            __m512 _cos = _mm512_set1_ps(cos_val);
+            __m512 _sin = _mm512_set1_ps(sin_val);
+            _mm512_storeu_ps(outptr0, _mm512_fmsub_ps(_x0, _cos, _mm512_mul_ps(_x1, _sin)));
+            _mm512_storeu_ps(outptr1, _mm512_fmadd_ps(_x0, _sin, _mm512_mul_ps(_x1, _cos)));
+        }
+#endif // __AVX512F__
+        if (elempack == 8)
+        {
+            __m256 _x0 = _mm256_loadu_ps(ptr0);
+            __m256 _x1 = _mm256_loadu_ps(ptr1);
+            __m256 _cos = _mm256_set1_ps(cos_val);
+            __m256 _sin = _mm256_set1_ps(sin_val);
+            _mm256_storeu_ps(outptr0, _mm256_comp_fmsub_ps(_x0, _cos, _mm256_mul_ps(_x1, _sin)));
+            _mm256_storeu_ps(outptr1, _mm256_comp_fmadd_ps(_x0, _sin, _mm256_mul_ps(_x1, _cos)));
+        }
+#endif // __AVX__
+        if (elempack == 4)
+        {
+            __m128 _x0 = _mm_loadu_ps(ptr0);
+            __m128 _x1 = _mm_loadu_ps(ptr1);
+            __m128 _cos = _mm_set1_ps(cos_val);
+            __m128 _sin = _mm_set1_ps(sin_val);
+            _mm_storeu_ps(outptr0, _mm_comp_fmsub_ps(_x0, _cos, _mm_mul_ps(_x1, _sin)));
+            _mm_storeu_ps(outptr1, _mm_comp_fmadd_ps(_x0, _sin, _mm_mul_ps(_x1, _cos)));
+        }
+#endif // __SSE2__
+
+        ptr0 += stride;
+        ptr1 += stride;
+        outptr0 += stride;
+        outptr1 += stride;
+    }
+}
+
+int RotaryEmbed_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+{
+    Option opt_pack = opt;
+    opt_pack.blob_allocator = opt.workspace_allocator;
+
+    // packing along heads is kept, cos and sin caches and packed sequence are not
+    Mat bottom_blob = bottom_blobs[0];
+    Mat cos_cache = bottom_blobs[1];
+    Mat sin_cache = bottom_blobs[2];
+    if (bottom_blob.elempack != 1 && bottom_blob.dims != 3)
+    {
+        convert_packing(bottom_blobs[0], bottom_blob, 1, opt_pack);
+        if (bottom_blob.empty())
+            return -100;
+    }
+    if (cos_cache.elempack != 1)
+    {
+        convert_packing(bottom_blobs[1], cos_cache, 1, opt_pack);
+        if (cos_cache.empty())
+            return -100;
+    }
+    if (sin_cache.elempack != 1)
+    {
+        convert_packing(bottom_blobs[2], sin_cache, 1, opt_pack);
+        if (sin_cache.empty())
+            return -100;
+    }
+
+    const int embed_dim = bottom_blob.w;
+    const int seqlen = bottom_blob.h;
+    const int num_heads = bottom_blob.c;
+    const int elempack = bottom_blob.elempack;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create_like(bottom_blob, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < num_heads; q++)
+    {
+        const Mat head = bottom_blob.channel(q);
+        Mat out_head = top_blob.channel(q);
+
+        for (int i = 0; i < seqlen; i++)
+        {
+            const float* ptr = head.row(i);
+            const float* cos_ptr = cos_cache.row(i);
+            const float* sin_ptr = sin_cache.row(i);
+            float* outptr = out_head.row(i);
+
+            if (elempack > 1)
+            {
+                if (interleaved)
+                    rotaryembed_pack(ptr, ptr + elempack, cos_ptr, sin_ptr, outptr, outptr + elempack, embed_dim / 2, elempack * 2, elempack);
+                else
+                    rotaryembed_pack(ptr, ptr + embed_dim / 2 * elempack, cos_ptr, sin_ptr, outptr, outptr + embed_dim / 2 * elempack, embed_dim / 2, elempack, elempack);
+            }
+            else if (interleaved)
+            {
+                rotaryembed_interleaved(ptr, cos_ptr, sin_ptr, outptr, embed_dim / 2);
+            }
+            else
+            {
+                rotaryembed_half(ptr, ptr + embed_dim / 2, cos_ptr, sin_ptr, outptr, outptr + embed_dim / 2, embed_dim / 2);
+            }
+        }
+    }
+
+    return 0;
+}
+
+} // namespace ncnn
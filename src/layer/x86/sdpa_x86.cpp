@@ -3,10 +3,572 @@
 
 #include "sdpa_x86.h"
 
+#include <float.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#if __AVX512F__
+#include "avx512_mathfun.h"
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+#include "cpu.h"
+#include "kvcache.h"
 #include "layer_type.h"
 
 namespace ncnn {
 
+// flash attention tiling
+// a tile of 8 query rows is scored against blocks of 64 keys at a time
+// the running row max and row sum rescale the output accumulator per key block,
+// so the full dst_seqlen x src_seqlen score matrix never materializes
+#define SDPA_FLASH_TILE_M 8
+#define SDPA_FLASH_TILE_N 64
+
+// one key block as embed_dim x 64, the tail block is zero padded
+// paged keys are picked from their pool blocks
+static void flash_pack_key_tile(const Mat& key_head, float* outptr, int embed_dim, int j0, int max_jj, const int* blocks, int block_size)
+{
+    if (max_jj < SDPA_FLASH_TILE_N)
+        memset(outptr, 0, embed_dim * SDPA_FLASH_TILE_N * sizeof(float));
+
+    for (int j = 0; j < max_jj; j++)
+    {
+        const float* kptr = key_head.row(blocks ? kvcache_paged_row(blocks, block_size, j0 + j) : j0 + j);
+        for (int k = 0; k < embed_dim; k++)
+        {
+            outptr[k * SDPA_FLASH_TILE_N + j] = kptr[k];
+        }
+    }
+}
+
+static void flash_pack_key_transposed(const Mat& key_head, Mat& key_t_head, int embed_dim, int dst_seqlen)
+{
+    // each row of key_t_head holds one key block
+    const int nn = (dst_seqlen + SDPA_FLASH_TILE_N - 1) / SDPA_FLASH_TILE_N;
+    for (int jj = 0; jj < nn; jj++)
+    {
+        const int j0 = jj * SDPA_FLASH_TILE_N;
+        const int max_jj = std::min(SDPA_FLASH_TILE_N, dst_seqlen - j0);
+        flash_pack_key_tile(key_head, key_t_head.row(jj), embed_dim, j0, max_jj, 0, 0);
+    }
+}
+
+// scores[8 x 64] = scale * q[8 x embed_dim] * key_t_block[embed_dim x 64]
+static void flash_qk_tile(const float** qptrs, const float* kptr, float* sptr, int embed_dim, float scale)
+{
+    int j = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; j + 15 < SDPA_FLASH_TILE_N; j += 16)
+    {
+        __m512 _sum0 = _mm512_setzero_ps();
+        __m512 _sum1 = _mm512_setzero_ps();
+        __m512 _sum2 = _mm512_setzero_ps();
+        __m512 _sum3 = _mm512_setzero_ps();
+        __m512 _sum4 = _mm512_setzero_ps();
+        __m512 _sum5 = _mm512_setzero_ps();
+        __m512 _sum6 = _mm512_setzero_ps();
+        __m512 _sum7 = _mm512_setzero_ps();
+
+        const float* k0 = kptr + j;
+        for (int k = 0; k < embed_dim; k++)
+        {
+            __m512 _k = _mm512_loadu_ps(k0);
+            _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[0][k]), _k, _sum0);
+            _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[1][k]), _k, _sum1);
+            _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[2][k]), _k, _sum2);
+            _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[3][k]), _k, _sum3);
+            _sum4 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[4][k]), _k, _sum4);
+            _sum5 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[5][k]), _k, _sum5);
+            _sum6 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[6][k]), _k, _sum6);
+            _sum7 = _mm512_fmadd_ps(_mm512_set1_ps(qptrs[7][k]), _k, _sum7);
+            k0 += SDPA_FLASH_TILE_N;
+        }
+
+        __m512 _scale = _mm512_set1_ps(scale);
+        _mm512_storeu_ps(sptr + j, _mm512_mul_ps(_sum0, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N + j, _mm512_mul_ps(_sum1, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 2 + j, _mm512_mul_ps(_sum2, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 3 + j, _mm512_mul_ps(_sum3, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 4 + j, _mm512_mul_ps(_sum4, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 5 + j, _mm512_mul_ps(_sum5, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 6 + j, _mm512_mul_ps(_sum6, _scale));
+        _mm512_storeu_ps(sptr + SDPA_FLASH_TILE_N * 7 + j, _mm512_mul_ps(_sum7, _scale));
+    }
+#endif // __AVX512F__
+    for (; j + 7 < SDPA_FLASH_TILE_N; j += 8)
+    {
+        __m256 _sum0 = _mm256_setzero_ps();
+        __m256 _sum1 = _mm256_setzero_ps();
+        __m256 _sum2 = _mm256_setzero_ps();
+        __m256 _sum3 = _mm256_setzero_ps();
+        __m256 _sum4 = _mm256_setzero_ps();
+        __m256 _sum5 = _mm256_setzero_ps();
+        __m256 _sum6 = _mm256_setzero_ps();
+        __m256 _sum7 = _mm256_setzero_ps();
+
+        const float* k0 = kptr + j;
+        for (int k = 0; k < embed_dim; k++)
+        {
+            __m256 _k = _mm256_loadu_ps(k0);
+            _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[0][k]), _k, _sum0);
+            _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[1][k]), _k, _sum1);
+            _sum2 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[2][k]), _k, _sum2);
+            _sum3 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[3][k]), _k, _sum3);
+            _sum4 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[4][k]), _k, _sum4);
+            _sum5 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[5][k]), _k, _sum5);
+            _sum6 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[6][k]), _k, _sum6);
+            _sum7 = _mm256_comp_fmadd_ps(_mm256_set1_ps(qptrs[7][k]), _k, _sum7);
+            k0 += SDPA_FLASH_TILE_N;
+        }
+
+        __m256 _scale = _mm256_set1_ps(scale);
+        _mm256_storeu_ps(sptr + j, _mm256_mul_ps(_sum0, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N + j, _mm256_mul_ps(_sum1, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 2 + j, _mm256_mul_ps(_sum2, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 3 + j, _mm256_mul_ps(_sum3, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 4 + j, _mm256_mul_ps(_sum4, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 5 + j, _mm256_mul_ps(_sum5, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 6 + j, _mm256_mul_ps(_sum6, _scale));
+        _mm256_storeu_ps(sptr + SDPA_FLASH_TILE_N * 7 + j, _mm256_mul_ps(_sum7, _scale));
+    }
+#endif // __AVX__
+    for (; j + 3 < SDPA_FLASH_TILE_N; j += 4)
+    {
+        __m128 _sum0 = _mm_setzero_ps();
+        __m128 _sum1 = _mm_setzero_ps();
+        __m128 _sum2 = _mm_setzero_ps();
+        __m128 _sum3 = _mm_setzero_ps();
+        __m128 _sum4 = _mm_setzero_ps();
+        __m128 _sum5 = _mm_setzero_ps();
+        __m128 _sum6 = _mm_setzero_ps();
+        __m128 _sum7 = _mm_setzero_ps();
+
+        const float* k0 = kptr + j;
+        for (int k = 0; k < embed_dim; k++)
+        {
+            __m128 _k = _mm_loadu_ps(k0);
+            _sum0 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[0][k]), _k, _sum0);
+            _sum1 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[1][k]), _k, _sum1);
+            _sum2 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[2][k]), _k, _sum2);
+            _sum3 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[3][k]), _k, _sum3);
+            _sum4 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[4][k]), _k, _sum4);
+            _sum5 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[5][k]), _k, _sum5);
+            _sum6 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[6][k]), _k, _sum6);
+            _sum7 = _mm_comp_fmadd_ps(_mm_set1_ps(qptrs[7][k]), _k, _sum7);
+            k0 += SDPA_FLASH_TILE_N;
+        }
+
+        __m128 _scale = _mm_set1_ps(scale);
+        _mm_storeu_ps(sptr + j, _mm_mul_ps(_sum0, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N + j, _mm_mul_ps(_sum1, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 2 + j, _mm_mul_ps(_sum2, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 3 + j, _mm_mul_ps(_sum3, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 4 + j, _mm_mul_ps(_sum4, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 5 + j, _mm_mul_ps(_sum5, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 6 + j, _mm_mul_ps(_sum6, _scale));
+        _mm_storeu_ps(sptr + SDPA_FLASH_TILE_N * 7 + j, _mm_mul_ps(_sum7, _scale));
+    }
+#endif // __SSE2__
+    for (; j < SDPA_FLASH_TILE_N; j++)
+    {
+        for (int r = 0; r < SDPA_FLASH_TILE_M; r++)
+        {
+            const float* qptr = qptrs[r];
+
+            float sum = 0.f;
+            for (int k = 0; k < embed_dim; k++)
+            {
+                sum += qptr[k] * kptr[k * SDPA_FLASH_TILE_N + j];
+            }
+
+            sptr[r * SDPA_FLASH_TILE_N + j] = sum * scale;
+        }
+    }
+}
+
+// turn one row of scores into exp(s - max) in place and return its sum
+// the caller provides max >= every score of the row
+static float flash_exp_sum(float* ptr, int size, float max)
+{
+    float sum = 0.f;
+
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _max_avx512 = _mm512_set1_ps(max);
+    __m512 _sum_avx512 = _mm512_setzero_ps();
+    for (; i + 15 < size; i += 16)
+    {
+        __m512 _p = _mm512_loadu_ps(ptr + i);
+        _p = exp512_ps(_mm512_sub_ps(_p, _max_avx512));
+        _mm512_storeu_ps(ptr + i, _p);
+        _sum_avx512 = _mm512_add_ps(_sum_avx512, _p);
+    }
+    sum += _mm512_comp_reduce_add_ps(_sum_avx512);
+#endif // __AVX512F__
+    __m256 _max_avx = _mm256_set1_ps(max);
+    __m256 _sum_avx = _mm256_setzero_ps();
+    for (; i + 7 < size; i += 8)
+    {
+        __m256 _p = _mm256_loadu_ps(ptr + i);
+        _p = exp256_ps(_mm256_sub_ps(_p, _max_avx));
+        _mm256_storeu_ps(ptr + i, _p);
+        _sum_avx = _mm256_add_ps(_sum_avx, _p);
+    }
+    sum += _mm256_reduce_add_ps(_sum_avx);
+#endif // __AVX__
+    __m128 _max = _mm_set1_ps(max);
+    __m128 _sum = _mm_setzero_ps();
+    for (; i + 3 < size; i += 4)
+    {
+        __m128 _p = _mm_loadu_ps(ptr + i);
+        _p = exp_ps(_mm_sub_ps(_p, _max));
+        _mm_storeu_ps(ptr + i, _p);
+        _sum = _mm_add_ps(_sum, _p);
+    }
+    sum += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        ptr[i] = expf(ptr[i] - max);
+        sum += ptr[i];
+    }
+
+    return sum;
+}
+
+static void flash_scale(float* ptr, int size, float scale)
+{
+    int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    __m512 _scale_avx512 = _mm512_set1_ps(scale);
+    for (; i + 15 < size; i += 16)
+    {
+        _mm512_storeu_ps(ptr + i, _mm512_mul_ps(_mm512_loadu_ps(ptr + i), _scale_avx512));
+    }
+#endif // __AVX512F__
+    __m256 _scale_avx = _mm256_set1_ps(scale);
+    for (; i + 7 < size; i += 8)
+    {
+        _mm256_storeu_ps(ptr + i, _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _scale_avx));
+    }
+#endif // __AVX__
+    __m128 _scale = _mm_set1_ps(scale);
+    for (; i + 3 < size; i += 4)
+    {
+        _mm_storeu_ps(ptr + i, _mm_mul_ps(_mm_loadu_ps(ptr + i), _scale));
+    }
+#endif // __SSE2__
+    for (; i < size; i++)
+    {
+        ptr[i] *= scale;
+    }
+}
+
+// out[8 x out_embed_dim] += p[8 x max_jj] * value_block[max_jj x out_embed_dim]
+static void flash_pv_tile(const float* pptr, const float** vptrs, int max_jj, float* outptr, int out_embed_dim)
+{
+    float* o0 = outptr;
+    float* o1 = outptr + out_embed_dim;
+    float* o2 = outptr + out_embed_dim * 2;
+    float* o3 = outptr + out_embed_dim * 3;
+    float* o4 = outptr + out_embed_dim * 4;
+    float* o5 = outptr + out_embed_dim * 5;
+    float* o6 = outptr + out_embed_dim * 6;
+    float* o7 = outptr + out_embed_dim * 7;
+
+    const float* p0 = pptr;
+    const float* p1 = pptr + SDPA_FLASH_TILE_N;
+    const float* p2 = pptr + SDPA_FLASH_TILE_N * 2;
+    const float* p3 = pptr + SDPA_FLASH_TILE_N * 3;
+    const float* p4 = pptr + SDPA_FLASH_TILE_N * 4;
+    const float* p5 = pptr + SDPA_FLASH_TILE_N * 5;
+    const float* p6 = pptr + SDPA_FLASH_TILE_N * 6;
+    const float* p7 = pptr + SDPA_FLASH_TILE_N * 7;
+
+    int d = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+    for (; d + 15 < out_embed_dim; d += 16)
+    {
+        __m512 _sum0 = _mm512_loadu_ps(o0 + d);
+        __m512 _sum1 = _mm512_loadu_ps(o1 + d);
+        __m512 _sum2 = _mm512_loadu_ps(o2 + d);
+        __m512 _sum3 = _mm512_loadu_ps(o3 + d);
+        __m512 _sum4 = _mm512_loadu_ps(o4 + d);
+        __m512 _sum5 = _mm512_loadu_ps(o5 + d);
+        __m512 _sum6 = _mm512_loadu_ps(o6 + d);
+        __m512 _sum7 = _mm512_loadu_ps(o7 + d);
+
+        for (int j = 0; j < max_jj; j++)
+        {
+            __m512 _v = _mm512_loadu_ps(vptrs[j] + d);
+            _sum0 = _mm512_fmadd_ps(_mm512_set1_ps(p0[j]), _v, _sum0);
+            _sum1 = _mm512_fmadd_ps(_mm512_set1_ps(p1[j]), _v, _sum1);
+            _sum2 = _mm512_fmadd_ps(_mm512_set1_ps(p2[j]), _v, _sum2);
+            _sum3 = _mm512_fmadd_ps(_mm512_set1_ps(p3[j]), _v, _sum3);
+            _sum4 = _mm512_fmadd_ps(_mm512_set1_ps(p4[j]), _v, _sum4);
+            _sum5 = _mm512_fmadd_ps(_mm512_set1_ps(p5[j]), _v, _sum5);
+            _sum6 = _mm512_fmadd_ps(_mm512_set1_ps(p6[j]), _v, _sum6);
+            _sum7 = _mm512_fmadd_ps(_mm512_set1_ps(p7[j]), _v, _sum7);
+        }
+
+        _mm512_storeu_ps(o0 + d, _sum0);
+        _mm512_storeu_ps(o1 + d, _sum1);
+        _mm512_storeu_ps(o2 + d, _sum2);
+        _mm512_storeu_ps(o3 + d, _sum3);
+        _mm512_storeu_ps(o4 + d, _sum4);
+        _mm512_storeu_ps(o5 + d, _sum5);
+        _mm512_storeu_ps(o6 + d, _sum6);
+        _mm512_storeu_ps(o7 + d, _sum7);
+    }
+#endif // __AVX512F__
+    for (; d + 7 < out_embed_dim; d += 8)
+    {
+        __m256 _sum0 = _mm256_loadu_ps(o0 + d);
+        __m256 _sum1 = _mm256_loadu_ps(o1 + d);
+        __m256 _sum2 = _mm256_loadu_ps(o2 + d);
+        __m256 _sum3 = _mm256_loadu_ps(o3 + d);
+        __m256 _sum4 = _mm256_loadu_ps(o4 + d);
+        __m256 _sum5 = _mm256_loadu_ps(o5 + d);
+        __m256 _sum6 = _mm256_loadu_ps(o6 + d);
+        __m256 _sum7 = _mm256_loadu_ps(o7 + d);
+
+        for (int j = 0; j < max_jj; j++)
+        {
+            __m256 _v = _mm256_loadu_ps(vptrs[j] + d);
+            _sum0 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p0[j]), _v, _sum0);
+            _sum1 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p1[j]), _v, _sum1);
+            _sum2 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p2[j]), _v, _sum2);
+            _sum3 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p3[j]), _v, _sum3);
+            _sum4 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p4[j]), _v, _sum4);
+            _sum5 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p5[j]), _v, _sum5);
+            _sum6 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p6[j]), _v, _sum6);
+            _sum7 = _mm256_comp_fmadd_ps(_mm256_set1_ps(p7[j]), _v, _sum7);
+        }
+
+        _mm256_storeu_ps(o0 + d, _sum0);
+        _mm256_storeu_ps(o1 + d, _sum1);
+        _mm256_storeu_ps(o2 + d, _sum2);
+        _mm256_storeu_ps(o3 + d, _sum3);
+        _mm256_storeu_ps(o4 + d, _sum4);
+        _mm256_storeu_ps(o5 + d, _sum5);
+        _mm256_storeu_ps(o6 + d, _sum6);
+        _mm256_storeu_ps(o7 + d, _sum7);
+    }
+#endif // __AVX__
+    for (; d + 3 < out_embed_dim; d += 4)
+    {
+        __m128 _sum0 = _mm_loadu_ps(o0 + d);
+        __m128 _sum1 = _mm_loadu_ps(o1 + d);
+        __m128 _sum2 = _mm_loadu_ps(o2 + d);
+        __m128 _sum3 = _mm_loadu_ps(o3 + d);
+        __m128 _sum4 = _mm_loadu_ps(o4 + d);
+        __m128 _sum5 = _mm_loadu_ps(o5 + d);
+        __m128 _sum6 = _mm_loadu_ps(o6 + d);
+        __m128 _sum7 = _mm_loadu_ps(o7 + d);
+
+        for (int j = 0; j < max_jj; j++)
+        {
+            __m128 _v = _mm_loadu_ps(vptrs[j] + d);
+            _sum0 = _mm_comp_fmadd_ps(_mm_set1_ps(p0[j]), _v, _sum0);
+            _sum1 = _mm_comp_fmadd_ps(_mm_set1_ps(p1[j]), _v, _sum1);
+            _sum2 = _mm_comp_fmadd_ps(_mm_set1_ps(p2[j]), _v, _sum2);
+            _sum3 = _mm_comp_fmadd_ps(_mm_set1_ps(p3[j]), _v, _sum3);
+            _sum4 = _mm_comp_fmadd_ps(_mm_set1_ps(p4[j]), _v, _sum4);
+            _sum5 = _mm_comp_fmadd_ps(_mm_set1_ps(p5[j]), _v, _sum5);
+            _sum6 = _mm_comp_fmadd_ps(_mm_set1_ps(p6[j]), _v, _sum6);
+            _sum7 = _mm_comp_fmadd_ps(_mm_set1_ps(p7[j]), _v, _sum7);
+        }
+
+        _mm_storeu_ps(o0 + d, _sum0);
+        _mm_storeu_ps(o1 + d, _sum1);
+        _mm_storeu_ps(o2 + d, _sum2);
+        _mm_storeu_ps(o3 + d, _sum3);
+        _mm_storeu_ps(o4 + d, _sum4);
+        _mm_storeu_ps(o5 + d, _sum5);
+        _mm_storeu_ps(o6 + d, _sum6);
+        _mm_storeu_ps(o7 + d, _sum7);
+    }
+#endif // __SSE2__
+    for (; d < out_embed_dim; d++)
+    {
+        for (int j = 0; j < max_jj; j++)
+        {
+            const float v = vptrs[j][d];
+            o0[d] += p0[j] * v;
+            o1[d] += p1[j] * v;
+            o2[d] += p2[j] * v;
+            o3[d] += p3[j] * v;
+            o4[d] += p4[j] * v;
+            o5[d] += p5[j] * v;
+            o6[d] += p6[j] * v;
+            o7[d] += p7[j] * v;
+        }
+    }
+}
+
+// blocks is the paged block table past its header, key and value are then the pools
+static int sdpa_flash_attention(const Mat& query, const Mat& key, const Mat& value, const Mat& attn_mask_blob, Mat& top_blob, int dst_seqlen, const int* blocks, int block_size, float scale, const Option& opt)
+{
+    const int embed_dim = query.w;
+    const int src_seqlen = query.h;
+    const int num_heads = query.c;
+    const int num_group = key.c;
+    const int out_embed_dim = value.w;
+
+    const int num_heads_per_group = num_heads / num_group;
+
+    // transposed key blocks, same footprint as key
+    // paged keys are packed tile by tile instead, nothing grows with the sequence
+    const int nn = (dst_seqlen + SDPA_FLASH_TILE_N - 1) / SDPA_FLASH_TILE_N;
+    Mat key_t;
+    if (!blocks)
+    {
+        key_t.create(embed_dim * SDPA_FLASH_TILE_N, nn, num_group, 4u, opt.workspace_allocator);
+        if (key_t.empty())
+            return -100;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q = 0; q < num_group; q++)
+        {
+            Mat key_t_head = key_t.channel(q);
+            flash_pack_key_transposed(key.channel(q), key_t_head, embed_dim, dst_seqlen);
+        }
+    }
+
+    // per thread scores, output accumulator, row max, row sum and the paged key tile
+    const int key_tile_size = blocks ? embed_dim * SDPA_FLASH_TILE_N : 0;
+    Mat workspace(SDPA_FLASH_TILE_M * (SDPA_FLASH_TILE_N + out_embed_dim + 2) + key_tile_size, 1, opt.num_threads, 4u, opt.workspace_allocator);
+    if (workspace.empty())
+        return -100;
+
+    const int mm = (src_seqlen + SDPA_FLASH_TILE_M - 1) / SDPA_FLASH_TILE_M;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int t = 0; t < num_heads * mm; t++)
+    {
+        const int q = t / mm;
+        const int i0 = (t % mm) * SDPA_FLASH_TILE_M;
+        const int max_ii = std::min(SDPA_FLASH_TILE_M, src_seqlen - i0);
+
+        const Mat query_head = query.channel(q);
+        const Mat key_head = key.channel(q / num_heads_per_group);
+        const Mat key_t_head = blocks ? Mat() : key_t.channel(q / num_heads_per_group);
+        const Mat value_head = value.channel(q / num_heads_per_group);
+        Mat top_blob_head = top_blob.channel(q);
+
+        float* sptr = workspace.channel(get_omp_thread_num());
+        float* outptr = sptr + SDPA_FLASH_TILE_M * SDPA_FLASH_TILE_N;
+        float* maxptr = outptr + SDPA_FLASH_TILE_M * out_embed_dim;
+        float* sumptr = maxptr + SDPA_FLASH_TILE_M;
+        float* ktptr = sumptr + SDPA_FLASH_TILE_M;
+
+        // the rows past src_seqlen repeat the last row and are dropped at the end
+        const float* qptrs[SDPA_FLASH_TILE_M];
+        const float* mptrs[SDPA_FLASH_TILE_M];
+        for (int r = 0; r < SDPA_FLASH_TILE_M; r++)
+        {
+            const int i = i0 + std::min(r, max_ii - 1);
+            qptrs[r] = query_head.row(i);
+            mptrs[r] = 0;
+            if (!attn_mask_blob.empty())
+            {
+                const Mat maskm = attn_mask_blob.c > 1 ? attn_mask_blob.channel(q) : attn_mask_blob;
+                mptrs[r] = maskm.row(i);
+            }
+
+            maxptr[r] = -FLT_MAX;
+            sumptr[r] = 0.f;
+        }
+
+        memset(outptr, 0, SDPA_FLASH_TILE_M * out_embed_dim * sizeof(float));
+
+        for (int jj = 0; jj < nn; jj++)
+        {
+            const int j0 = jj * SDPA_FLASH_TILE_N;
+            const int max_jj = std::min(SDPA_FLASH_TILE_N, dst_seqlen - j0);
+
+            const float* kptr = key_t_head.data ? key_t_head.row(jj) : ktptr;
+            if (blocks)
+                flash_pack_key_tile(key_head, ktptr, embed_dim, j0, max_jj, blocks, block_size);
+
+            flash_qk_tile(qptrs, kptr, sptr, embed_dim, scale);
+
+            // online softmax
+            for (int r = 0; r < SDPA_FLASH_TILE_M; r++)
+            {
+                float* ptr = sptr + r * SDPA_FLASH_TILE_N;
+
+                float max = maxptr[r];
+                if (mptrs[r])
+                {
+                    const float* mptr = mptrs[r] + j0;
+                    for (int j = 0; j < max_jj; j++)
+                    {
+                        ptr[j] += mptr[j];
+                        max = std::max(max, ptr[j]);
+                    }
+                }
+                else
+                {
+                    for (int j = 0; j < max_jj; j++)
+                    {
+                        max = std::max(max, ptr[j]);
+                    }
+                }
+
+                const float sum = flash_exp_sum(ptr, max_jj, max);
+
+                if (max != maxptr[r])
+                {
+                    const float alpha = expf(maxptr[r] - max);
+                    flash_scale(outptr + r * out_embed_dim, out_embed_dim, alpha);
+                    sumptr[r] *= alpha;
+                    maxptr[r] = max;
+                }
+
+                sumptr[r] += sum;
+            }
+
+            const float* vptrs[SDPA_FLASH_TILE_N];
+            for (int j = 0; j < max_jj; j++)
+            {
+                vptrs[j] = value_head.row(blocks ? kvcache_paged_row(blocks, block_size, j0 + j) : j0 + j);
+            }
+
+            flash_pv_tile(sptr, vptrs, max_jj, outptr, out_embed_dim);
+        }
+
+        for (int r = 0; r < max_ii; r++)
+        {
+            const float* ptr = outptr + r * out_embed_dim;
+            float* dstptr = top_blob_head.row(i0 + r);
+
+            const float sum_inv = 1.f / sumptr[r];
+            for (int d = 0; d < out_embed_dim; d++)
+            {
+                dstptr[d] = ptr[d] * sum_inv;
+            }
+        }
+    }
+
+    return 0;
+}
+
 SDPA_x86::SDPA_x86()
 {
     qk_gemm = 0;
@@ -126,6 +688,14 @@ int SDPA_x86::destroy_pipeline(const Option& _opt)
 
 int SDPA_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& _opt) const
 {
+#if NCNN_INT8
+    if (int8_scale_term && kv_cache == 2)
+    {
+        // the int8 gemm wants contiguous keys, the reference reads the pool blocks in place
+        return SDPA::forward(bottom_blobs, top_blobs, _opt);
+    }
+#endif
+
     Option opt = _opt;
     if (int8_scale_term)
     {
@@ -138,6 +708,7 @@ int SDPA_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     const Mat& attn_mask_blob = attn_mask ? bottom_blobs[3] : Mat();
     const Mat& past_key = kv_cache ? bottom_blobs[attn_mask ? 4 : 3] : Mat();
     const Mat& past_value = kv_cache ? bottom_blobs[attn_mask ? 5 : 4] : Mat();
+    const Mat& block_table = kv_cache == 2 ? bottom_blobs[attn_mask ? 6 : 5] : Mat();
 
     const int embed_dim = query.w;
     const int src_seqlen = query.h;
@@ -145,53 +716,35 @@ int SDPA_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
     const int cur_seqlen = cur_key.h;
     const int num_group = cur_key.c;
     const int out_embed_dim = cur_value.w;
-    const int past_seqlen = kv_cache ? past_key.h : 0;
-    const int dst_seqlen = past_seqlen + cur_seqlen;
+    if (kv_cache == 2 && (kvcache_check_paged(past_key, block_table, cur_key) != 0 || kvcache_check_paged(past_value, block_table, cur_value) != 0))
+        return -1;
 
-    Mat key;
-    if (past_seqlen > 0)
-    {
-        key.create(embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (key.empty())
-            return -100;
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_key_head = past_key.channel(q);
-            const Mat cur_key_head = cur_key.channel(q);
-            Mat key_head = key.channel(q);
+    const int past_seqlen = kv_cache == 2 ? ((const int*)block_table)[0] : kv_cache ? past_key.h : 0;
+    const int dst_seqlen = past_seqlen + cur_seqlen;
 
-            memcpy(key_head.row(0), past_key_head, embed_dim * past_seqlen * sizeof(float));
-            memcpy(key_head.row(past_seqlen), cur_key_head, embed_dim * cur_seqlen * sizeof(float));
-        }
-    }
-    else
-    {
-        key = cur_key;
-    }
+    // paged keys and values are read in place from their pool blocks
+    const int* blocks = kv_cache == 2 ? (const int*)block_table + 2 : 0;
+    const int block_size = kv_cache == 2 ? ((const int*)block_table)[1] : 0;
 
-    Mat value;
-    if (past_seqlen > 0)
+    Mat key = cur_key;
+    Mat value = cur_value;
+    if (kv_cache == 2)
     {
-        value.create(out_embed_dim, dst_seqlen, num_group, 4u, opt.blob_allocator);
-        if (value.empty())
-            return -100;
-
-        #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q = 0; q < num_group; q++)
-        {
-            const Mat past_value_head = past_value.channel(q);
-            const Mat cur_value_head = cur_value.channel(q);
-            Mat value_head = value.channel(q);
+        kvcache_write_paged(past_key, block_table, cur_key, opt);
+        kvcache_write_paged(past_value, block_table, cur_value, opt);
 
-            memcpy(value_head.row(0), past_value_head, out_embed_dim * past_seqlen * sizeof(float));
-            memcpy(value_head.row(past_seqlen), cur_value_head, out_embed_dim * cur_seqlen * sizeof(float));
-        }
+        key = past_key;
+        value = past_value;
     }
-    else
+    else if (kv_cache)
     {
-        value = cur_value;
+        int ret = kvcache_append(past_key, cur_key, key, opt);
+        if (ret != 0)
+            return ret;
+
+        ret = kvcache_append(past_value, cur_value, value, opt);
+        if (ret != 0)
+            return ret;
     }
 
     Mat& top_blob = top_blobs[0];
@@ -201,6 +754,25 @@ int SDPA_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
 
     const int num_heads_per_group = num_heads / num_group;
 
+    // flash attention keeps memory linear in sequence length
+    // decoding and short queries stay on the gemm path, packing keys does not pay off there
+    // paged keys and values are not contiguous, they always go through the block table here
+    if ((!int8_scale_term && src_seqlen >= SDPA_FLASH_TILE_M * 4) || kv_cache == 2)
+    {
+        const float _scale = scale == 0.f ? 1.f / sqrt(embed_dim) : scale;
+        int ret = sdpa_flash_attention(query, key, value, attn_mask_blob, top_blob, dst_seqlen, blocks, block_size, _scale, opt);
+        if (ret != 0)
+            return ret;
+
+        if (kv_cache == 1)
+        {
+            top_blobs[1] = key;
+            top_blobs[2] = value;
+        }
+
+        return 0;
+    }
+
     Mat qk_cross(dst_seqlen, src_seqlen, num_heads, 4u, opt.workspace_allocator);
     if (qk_cross.empty())
         return -100;
@@ -314,7 +886,7 @@ int SDPA_x86::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& to
             return retqkvs[i];
     }
 
-    if (kv_cache)
+    if (kv_cache == 1)
     {
         top_blobs[1] = key;
         top_blobs[2] = value;
@@ -218,6 +218,147 @@ Mat ModelBinFromDataReader::load(int w, int type) const
 
             return m;
         }
+        else if (flag_struct.tag == 0x00E4F808 || flag_struct.tag == 0x00E5F808)
+        {
+            // fp8 e4m3 or e5m2 data with a per-tensor scale
+            float scale;
+            nread = d->dr.read(&scale, sizeof(float));
+            if (nread != sizeof(float))
+            {
+                NCNN_LOGE("ModelBin read fp8 scale failed %zd", nread);
+                return Mat();
+            }
+
+#if __BIG_ENDIAN__
+            swap_endianness_32(&scale);
+#endif
+
+            size_t align_data_size = alignSize(w, 4);
+
+            const unsigned char* fp8_weights = 0;
+            std::vector<unsigned char> fp8_weights_buffer;
+
+            const void* refbuf = 0;
+            nread = d->dr.reference(align_data_size, &refbuf);
+            if (nread == align_data_size)
+            {
+                fp8_weights = (const unsigned char*)refbuf;
+            }
+            else
+            {
+                fp8_weights_buffer.resize(align_data_size);
+                nread = d->dr.read(&fp8_weights_buffer[0], align_data_size);
+                if (nread != align_data_size)
+                {
+                    NCNN_LOGE("ModelBin read fp8_weights failed %zd", nread);
+                    return Mat();
+                }
+
+                fp8_weights = &fp8_weights_buffer[0];
+            }
+
+            // decode through a lookup table of all 256 codes
+            float fp8_table[256];
+            for (int i = 0; i < 256; i++)
+            {
+                unsigned short fp16 = flag_struct.tag == 0x00E4F808 ? float8_to_float16((unsigned char)i) : bfloat8_to_float16((unsigned char)i);
+                fp8_table[i] = float16_to_float32(fp16) * scale;
+            }
+
+            m.create(w);
+            if (m.empty())
+                return m;
+
+            float* ptr = m;
+            for (int i = 0; i < w; i++)
+            {
+                ptr[i] = fp8_table[fp8_weights[i]];
+            }
+
+            return m;
+        }
+        else if (flag_struct.tag == 0x0004B34D)
+        {
+            // int4 data, symmetric quantized in groups with fp16 scales
+            int group_size;
+            nread = d->dr.read(&group_size, sizeof(int));
+            if (nread != sizeof(int))
+            {
+                NCNN_LOGE("ModelBin read int4 group_size failed %zd", nread);
+                return Mat();
+            }
+
+#if __BIG_ENDIAN__
+            swap_endianness_32(&group_size);
+#endif
+
+            if (group_size <= 0)
+            {
+                NCNN_LOGE("ModelBin invalid int4 group_size %d", group_size);
+                return Mat();
+            }
+
+            const int group_count = (w + group_size - 1) / group_size;
+
+            size_t align_scale_size = alignSize(group_count * sizeof(unsigned short), 4);
+            std::vector<unsigned short> float16_scales;
+            float16_scales.resize(align_scale_size / sizeof(unsigned short));
+            nread = d->dr.read(&float16_scales[0], align_scale_size);
+            if (nread != align_scale_size)
+            {
+                NCNN_LOGE("ModelBin read int4 scales failed %zd", nread);
+                return Mat();
+            }
+
+            size_t align_data_size = alignSize((w + 1) / 2, 4);
+
+            const unsigned char* int4_weights = 0;
+            std::vector<unsigned char> int4_weights_buffer;
+
+            const void* refbuf = 0;
+            nread = d->dr.reference(align_data_size, &refbuf);
+            if (nread == align_data_size)
+            {
+                int4_weights = (const unsigned char*)refbuf;
+            }
+            else
+            {
+                int4_weights_buffer.resize(align_data_size);
+                nread = d->dr.read(&int4_weights_buffer[0], align_data_size);
+                if (nread != align_data_size)
+                {
+                    NCNN_LOGE("ModelBin read int4_weights failed %zd", nread);
+                    return Mat();
+                }
+
+                int4_weights = &int4_weights_buffer[0];
+            }
+
+            m.create(w);
+            if (m.empty())
+                return m;
+
+            // low nibble first, each nibble holds the quantized value plus 8
+            float* ptr = m;
+            for (int g = 0; g < group_count; g++)
+            {
+#if __BIG_ENDIAN__
+                swap_endianness_16(&float16_scales[g]);
+#endif
+                const float scale = float16_to_float32(float16_scales[g]);
+
+                const int i0 = g * group_size;
+                const int i1 = std::min(i0 + group_size, w);
+                for (int i = i0; i < i1; i++)
+                {
+                    const unsigned char v = int4_weights[i / 2];
+                    const int q = (i % 2 == 0 ? (v & 0x0f) : (v >> 4)) - 8;
+                    ptr[i] = q * scale;
+                }
+            }
+
+            return m;
+        }
 
         if (flag != 0)
         {
@@ -5,6 +5,7 @@
 
 #include "cpu.h"
 #include "datareader.h"
+#include "layer/elementwisechain.h"
 #include "layer_type.h"
 #include "modelbin.h"
 #include "paramdict.h"
@@ -13,9 +14,16 @@
 #include <stdint.h>
 #include <string.h>
 
-#if NCNN_BENCHMARK
+#if NCNN_STDIO
+#if _WIN32
+#include <process.h>
+#include <windows.h>
+#elif defined __unix__ || defined __APPLE__
+#include <unistd.h>
+#endif
+#endif // NCNN_STDIO
+
 #include "benchmark.h"
-#endif // NCNN_BENCHMARK
 
 #if NCNN_VULKAN
 #include "command.h"
@@ -24,6 +32,43 @@
 
 namespace ncnn {
 
+#if NCNN_STDIO
+#define WEIGHT_CACHE_MAGIC 0x4357434e // NCWC
+#define WEIGHT_CACHE_VERSION 1
+
+// layer weights transformed by create_pipeline
+struct weight_cache_entry
+{
+    uint64_t key;
+    int cached;
+    std::vector<Mat> weights;
+};
+#endif // NCNN_STDIO
+
+#if NCNN_THREADS
+class BranchParallelContext;
+
+// branch parallel workers kept alive across extracts
+class BranchParallelPool
+{
+public:
+    BranchParallelPool();
+    ~BranchParallelPool();
+
+    // run the context on the calling thread and worker_count - 1 pool workers
+    void run(BranchParallelContext* ctx);
+
+    static void* worker(void* args);
+
+    Mutex lock;
+    ConditionVariable task_cond;
+    ConditionVariable finish_cond;
+    std::vector<BranchParallelContext*> tasks;
+    std::vector<Thread*> workers;
+    bool stopping;
+};
+#endif // NCNN_THREADS
+
 class NetPrivate
 {
 public:
@@ -38,7 +83,16 @@ public:
 #endif // NCNN_VULKAN
 
     friend class Extractor;
-    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const;
+    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt, Profiler* profiler, int lane) const;
+
+    // flat topologically sorted layer order that produces one blob
+    // graph outputs read the plan compiled at load time, other blobs build theirs into scratch
+    const std::vector<int>& get_forward_plan(int blob_index, std::vector<int>& scratch) const;
+    void build_forward_plan(int blob_index, std::vector<int>& plan) const;
+    int forward_plan(const std::vector<int>& plan, int blob_index, std::vector<Mat>& blob_mats, const Option& opt, Profiler* profiler) const;
+#if NCNN_THREADS
+    int forward_plan_branch_parallel(const std::vector<int>& plan, const std::vector<unsigned char>& layer_wanted, std::vector<Mat>& blob_mats, const Option& opt, Profiler* profiler) const;
+#endif // NCNN_THREADS
 
 #if NCNN_VULKAN
     int forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const;
@@ -58,6 +112,15 @@ public:
 #if NCNN_STRING
     void update_input_output_names();
 #endif // NCNN_STRING
+    void update_forward_plans();
+    void clear_forward_plans();
+
+    void fuse_elementwise_chains();
+
+#if NCNN_STDIO
+    int read_weight_cache(uint64_t key, std::vector<weight_cache_entry>& entries);
+    int write_weight_cache(uint64_t key, const std::vector<weight_cache_entry>& entries) const;
+#endif // NCNN_STDIO
 
     std::vector<Blob> blobs;
     std::vector<Layer*> layers;
@@ -75,6 +138,24 @@ public:
     PoolAllocator* local_blob_allocator;
     PoolAllocator* local_workspace_allocator;
 
+    // hash of the network structure, part of the weight cache key
+    uint64_t param_hash;
+
+#if NCNN_STDIO
+    // file mappings referenced by layer weights
+    std::vector<DataReader*> mapped_readers;
+
+    std::string weight_cache_path;
+#endif // NCNN_STDIO
+
+    // execution plan per graph output blob index, built at load time and read only by extractors
+    std::vector<std::vector<int> > forward_plans;
+    std::vector<unsigned char> forward_plans_ready;
+
+#if NCNN_THREADS
+    mutable BranchParallelPool branch_parallel_pool;
+#endif // NCNN_THREADS
+
 #if NCNN_VULKAN
     const VulkanDevice* vkdev;
 
@@ -91,143 +172,1070 @@ NetPrivate::NetPrivate(Option& _opt)
     local_blob_allocator = 0;
     local_workspace_allocator = 0;
 
-#if NCNN_VULKAN
-    vkdev = 0;
-    weight_vkallocator = 0;
-    weight_staging_vkallocator = 0;
-    pipeline_cache = 0;
-#endif // NCNN_VULKAN
+    param_hash = 0;
+
+#if NCNN_VULKAN
+    vkdev = 0;
+    weight_vkallocator = 0;
+    weight_staging_vkallocator = 0;
+    pipeline_cache = 0;
+#endif // NCNN_VULKAN
+}
+
+static Option get_masked_option(const Option& opt, int featmask)
+{
+    // mask option usage as layer specific featmask
+    Option opt1 = opt;
+    opt1.use_fp16_arithmetic = opt1.use_fp16_arithmetic && !(featmask & (1 << 0));
+    opt1.use_fp16_packed = opt1.use_fp16_packed && !(featmask & (1 << 1));
+    opt1.use_fp16_storage = opt1.use_fp16_storage && !(featmask & (1 << 1));
+    opt1.use_bf16_packed = opt1.use_bf16_packed && !(featmask & (1 << 2));
+    opt1.use_bf16_storage = opt1.use_bf16_storage && !(featmask & (1 << 2));
+    opt1.use_int8_packed = opt1.use_int8_packed && !(featmask & (1 << 3));
+    opt1.use_int8_storage = opt1.use_int8_storage && !(featmask & (1 << 3));
+    opt1.use_int8_arithmetic = opt1.use_int8_arithmetic && !(featmask & (1 << 3));
+    opt1.use_vulkan_compute = opt1.use_vulkan_compute && !(featmask & (1 << 4));
+    opt1.use_tensor_storage = opt1.use_tensor_storage && !(featmask & (1 << 4));
+    opt1.use_sgemm_convolution = opt1.use_sgemm_convolution && !(featmask & (1 << 5));
+    opt1.use_winograd_convolution = opt1.use_winograd_convolution && !(featmask & (1 << 6));
+
+    if (featmask & (1 << 7))
+        opt1.num_threads = 1;
+
+    return opt1;
+}
+
+// purely elementwise, one input, evaluated inplace without weights
+static bool is_fusable_elementwise_layer(const Layer* layer)
+{
+    if (!layer->one_blob_only || !layer->support_inplace)
+        return false;
+
+    // binaryop is one blob only with scalar operand
+    switch (layer->typeindex)
+    {
+    case LayerType::AbsVal:
+    case LayerType::BinaryOp:
+    case LayerType::BNLL:
+    case LayerType::CELU:
+    case LayerType::Clip:
+    case LayerType::ELU:
+    case LayerType::Erf:
+    case LayerType::Exp:
+    case LayerType::GELU:
+    case LayerType::HardSigmoid:
+    case LayerType::HardSwish:
+    case LayerType::Log:
+    case LayerType::Mish:
+    case LayerType::Power:
+    case LayerType::ReLU:
+    case LayerType::SELU:
+    case LayerType::Shrink:
+    case LayerType::Sigmoid:
+    case LayerType::Swish:
+    case LayerType::TanH:
+    case LayerType::Threshold:
+    case LayerType::UnaryOp:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// the chain member to resume from when light mode released the chain input
+// after an intermediate blob of the chain was extracted on its own, -1 when the chain runs whole
+static int find_elementwise_chain_resume(const Layer* layer, const std::vector<Mat>& blob_mats)
+{
+    if (layer->typeindex != LayerType::ElementwiseChain || blob_mats[layer->bottoms[0]].dims != 0)
+        return -1;
+
+    const std::vector<Layer*>& chain = ((const ElementwiseChain*)layer)->chain;
+    for (int j = (int)chain.size() - 2; j >= 0; j--)
+    {
+        if (blob_mats[chain[j]->tops[0]].dims != 0)
+            return j + 1;
+    }
+
+    return -1;
+}
+
+// word-wise fnv-1a variant, used for cache keys only
+static uint64_t hash_bytes(uint64_t h, const void* data, size_t size)
+{
+    const unsigned char* p = (const unsigned char*)data;
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+    {
+        unsigned int v;
+        memcpy(&v, p + i, 4);
+        h = (h ^ v) * 1099511628211ULL;
+        h ^= h >> 29;
+    }
+    for (; i < size; i++)
+    {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+
+    return h;
+}
+
+// pass reads through and hash the bytes seen
+class DataReaderHashing : public DataReader
+{
+public:
+    DataReaderHashing(const DataReader& _dr)
+        : dr(_dr), hash(seed)
+    {
+    }
+
+#if NCNN_STRING
+    virtual int scan(const char* format, void* p) const
+    {
+        int nscan = dr.scan(format, p);
+        if (nscan == 1)
+        {
+            hash = hash_bytes(hash, format, strlen(format));
+
+            // string conversions write a null-terminated string, the others write a 32bit value
+            if (strchr(format, 's') || strchr(format, '['))
+                hash = hash_bytes(hash, p, strlen((const char*)p));
+            else
+                hash = hash_bytes(hash, p, 4);
+        }
+        return nscan;
+    }
+#endif // NCNN_STRING
+
+    virtual size_t read(void* buf, size_t size) const
+    {
+        size_t nread = dr.read(buf, size);
+        hash = hash_bytes(hash, buf, nread);
+        return nread;
+    }
+
+    virtual size_t reference(size_t size, const void** buf) const
+    {
+        size_t nread = dr.reference(size, buf);
+        if (nread > 0)
+            hash = hash_bytes(hash, *buf, nread);
+        return nread;
+    }
+
+public:
+    static const uint64_t seed = 14695981039346656037ULL;
+
+    const DataReader& dr;
+    mutable uint64_t hash;
+};
+
+#if NCNN_STDIO
+static uint64_t get_weight_cache_key(uint64_t param_hash)
+{
+    // everything that steers weight transformation besides the layer options
+    const int features[] = {
+        cpu_support_arm_neon(),
+        cpu_support_arm_vfpv4(),
+        cpu_support_arm_asimdhp(),
+        cpu_support_arm_asimddp(),
+        cpu_support_arm_asimdfhm(),
+        cpu_support_arm_bf16(),
+        cpu_support_arm_i8mm(),
+        cpu_support_arm_sve(),
+        cpu_support_arm_sve2(),
+        cpu_support_x86_avx(),
+        cpu_support_x86_fma(),
+        cpu_support_x86_xop(),
+        cpu_support_x86_f16c(),
+        cpu_support_x86_avx2(),
+        cpu_support_x86_avx_vnni(),
+        cpu_support_x86_avx_vnni_int8(),
+        cpu_support_x86_avx_vnni_int16(),
+        cpu_support_x86_avx_ne_convert(),
+        cpu_support_x86_avx512(),
+        cpu_support_x86_avx512_vnni(),
+        cpu_support_x86_avx512_bf16(),
+        cpu_support_x86_avx512_fp16(),
+        cpu_support_loongarch_lsx(),
+        cpu_support_loongarch_lasx(),
+        cpu_support_mips_msa(),
+        cpu_support_loongson_mmi(),
+        cpu_support_riscv_v(),
+        cpu_support_riscv_zfh(),
+        cpu_support_riscv_zvfh(),
+        cpu_support_riscv_xtheadvector(),
+        cpu_riscv_vlenb(),
+        get_cpu_level2_cache_size(),
+        get_cpu_level3_cache_size(),
+    };
+
+    uint64_t h = hash_bytes(param_hash, features, sizeof(features));
+#ifdef NCNN_VERSION_STRING
+    h = hash_bytes(h, NCNN_VERSION_STRING, strlen(NCNN_VERSION_STRING));
+#endif
+    return h;
+}
+
+static uint64_t get_weight_cache_layer_key(uint64_t weight_hash, const Option& opt)
+{
+    const int options[] = {
+        opt.lightmode,
+        opt.num_threads,
+        opt.use_winograd_convolution,
+        opt.use_sgemm_convolution,
+        opt.use_int8_inference,
+        opt.use_bf16_storage,
+        opt.use_fp16_packed,
+        opt.use_fp16_storage,
+        opt.use_fp16_arithmetic,
+        opt.use_int8_packed,
+        opt.use_int8_storage,
+        opt.use_int8_arithmetic,
+        opt.use_packing_layout,
+        opt.use_bf16_packed,
+        opt.use_winograd23_convolution,
+        opt.use_winograd43_convolution,
+        opt.use_winograd63_convolution,
+        opt.use_a53_a55_optimized_kernel,
+        opt.use_fp16_uniform,
+        opt.use_int8_uniform,
+    };
+
+    return hash_bytes(weight_hash, options, sizeof(options));
+}
+
+int NetPrivate::read_weight_cache(uint64_t key, std::vector<weight_cache_entry>& entries)
+{
+    // a missing cache is not an error, it will be written after load_model
+    FILE* fp = fopen(weight_cache_path.c_str(), "rb");
+    if (!fp)
+        return -1;
+    fclose(fp);
+
+    DataReaderFromMmap* dr = new DataReaderFromMmap(weight_cache_path.c_str());
+    if (!dr->mapped())
+    {
+        delete dr;
+        return -1;
+    }
+
+    size_t offset = 0;
+
+#define READ_CACHE_VALUE(buf)                          \
+    if (dr->read(&buf, sizeof(buf)) != sizeof(buf))    \
+    {                                                  \
+        NCNN_LOGE("weight cache read " #buf " failed"); \
+        entries.clear();                               \
+        delete dr;                                     \
+        return -1;                                     \
+    }                                                  \
+    offset += sizeof(buf);
+
+    unsigned int magic = 0;
+    unsigned int version = 0;
+    uint64_t file_key = 0;
+    int layer_count = 0;
+    READ_CACHE_VALUE(magic)
+    READ_CACHE_VALUE(version)
+    READ_CACHE_VALUE(file_key)
+    READ_CACHE_VALUE(layer_count)
+
+    if (magic != WEIGHT_CACHE_MAGIC || version != WEIGHT_CACHE_VERSION || file_key != key || layer_count != (int)layers.size())
+    {
+        // stale cache, rebuild silently
+        delete dr;
+        return -1;
+    }
+
+    entries.resize(layer_count);
+    for (int i = 0; i < layer_count; i++)
+    {
+        weight_cache_entry& entry = entries[i];
+
+        int weight_count = 0;
+        READ_CACHE_VALUE(entry.key)
+        READ_CACHE_VALUE(weight_count)
+
+        entry.cached = weight_count >= 0;
+        if (!entry.cached)
+            continue;
+
+        entry.weights.resize(weight_count);
+        for (int j = 0; j < weight_count; j++)
+        {
+            int shape[7];
+            uint64_t cstep = 0;
+            READ_CACHE_VALUE(shape)
+            READ_CACHE_VALUE(cstep)
+
+            const int dims = shape[0];
+            const int w = shape[1];
+            const int h = shape[2];
+            const int d = shape[3];
+            const int c = shape[4];
+            const int elempack = shape[5];
+            const size_t elemsize = (size_t)shape[6];
+
+            if (dims == 0)
+                continue;
+
+            // weight data starts at malloc alignment
+            const size_t padding = alignSize(offset, NCNN_MALLOC_ALIGN) - offset;
+            const void* data = 0;
+            if (padding > 0 && dr->reference(padding, &data) != padding)
+            {
+                NCNN_LOGE("weight cache read padding failed");
+                entries.clear();
+                delete dr;
+                return -1;
+            }
+            offset += padding;
+
+            const size_t size = (size_t)cstep * c * elemsize;
+            if (dr->reference(size, &data) != size)
+            {
+                NCNN_LOGE("weight cache read weight data failed");
+                entries.clear();
+                delete dr;
+                return -1;
+            }
+            offset += size;
+
+            Mat m;
+            if (dims == 1)
+                m = Mat(w, (void*)data, elemsize, elempack);
+            if (dims == 2)
+                m = Mat(w, h, (void*)data, elemsize, elempack);
+            if (dims == 3)
+                m = Mat(w, h, c, (void*)data, elemsize, elempack);
+            if (dims == 4)
+                m = Mat(w, h, d, c, (void*)data, elemsize, elempack);
+
+            if (m.cstep != (size_t)cstep)
+            {
+                // channel alignment differs, let the layer transform again
+                entry.cached = 0;
+                continue;
+            }
+
+            entry.weights[j] = m;
+        }
+    }
+
+#undef READ_CACHE_VALUE
+
+    // cached weights reference the mapping
+    mapped_readers.push_back(dr);
+
+    return 0;
+}
+
+int NetPrivate::write_weight_cache(uint64_t key, const std::vector<weight_cache_entry>& entries) const
+{
+    // write aside and rename, processes may still map the old cache
+#if _WIN32
+    const int pid = _getpid();
+#elif defined __unix__ || defined __APPLE__
+    const int pid = getpid();
+#else
+    const int pid = 0;
+#endif
+    char tmppath[256];
+    snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", weight_cache_path.c_str(), pid);
+
+    FILE* fp = fopen(tmppath, "wb");
+    if (!fp)
+    {
+        NCNN_LOGE("fopen %s failed", tmppath);
+        return -1;
+    }
+
+    size_t offset = 0;
+    bool ok = true;
+
+#define WRITE_CACHE_DATA(buf, size)                \
+    ok = ok && fwrite(buf, 1, size, fp) == size; \
+    offset += size;
+
+    const unsigned int magic = WEIGHT_CACHE_MAGIC;
+    const unsigned int version = WEIGHT_CACHE_VERSION;
+    const int layer_count = (int)entries.size();
+    WRITE_CACHE_DATA(&magic, sizeof(magic))
+    WRITE_CACHE_DATA(&version, sizeof(version))
+    WRITE_CACHE_DATA(&key, sizeof(key))
+    WRITE_CACHE_DATA(&layer_count, sizeof(layer_count))
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        const weight_cache_entry& entry = entries[i];
+
+        const int weight_count = entry.cached ? (int)entry.weights.size() : -1;
+        WRITE_CACHE_DATA(&entry.key, sizeof(entry.key))
+        WRITE_CACHE_DATA(&weight_count, sizeof(weight_count))
+
+        for (int j = 0; j < weight_count; j++)
+        {
+            const Mat& m = entry.weights[j];
+
+            const int shape[7] = {m.dims, m.w, m.h, m.d, m.c, m.elempack, (int)m.elemsize};
+            const uint64_t cstep = m.cstep;
+            WRITE_CACHE_DATA(shape, sizeof(shape))
+            WRITE_CACHE_DATA(&cstep, sizeof(cstep))
+
+            if (m.dims == 0)
+                continue;
+
+            const unsigned char zeros[NCNN_MALLOC_ALIGN] = {0};
+            const size_t padding = alignSize(offset, NCNN_MALLOC_ALIGN) - offset;
+            WRITE_CACHE_DATA(zeros, padding)
+
+            const size_t size = m.total() * m.elemsize;
+            WRITE_CACHE_DATA(m.data, size)
+        }
+    }
+
+#undef WRITE_CACHE_DATA
+
+    fclose(fp);
+
+    if (!ok)
+    {
+        NCNN_LOGE("write weight cache %s failed", tmppath);
+        remove(tmppath);
+        return -1;
+    }
+
+    // replace the target in one step, readers see either the old cache or the new one
+#if _WIN32
+    if (!MoveFileExA(tmppath, weight_cache_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+    if (rename(tmppath, weight_cache_path.c_str()) != 0)
+#endif
+    {
+        NCNN_LOGE("rename %s failed", tmppath);
+        remove(tmppath);
+        return -1;
+    }
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
+#if NCNN_VULKAN
+int NetPrivate::upload_model()
+{
+    ncnn::VkTransfer cmd(vkdev);
+
+    // create gpu device allocator if null
+    if (!weight_vkallocator)
+    {
+        weight_vkallocator = new VkWeightAllocator(vkdev);
+    }
+    if (!weight_staging_vkallocator)
+    {
+        weight_staging_vkallocator = new VkWeightStagingAllocator(vkdev);
+    }
+
+    Option opt_upload = opt;
+    opt_upload.blob_allocator = 0;
+    opt_upload.workspace_allocator = 0;
+    opt_upload.blob_vkallocator = weight_vkallocator;
+    opt_upload.workspace_vkallocator = weight_vkallocator;
+    opt_upload.staging_vkallocator = weight_staging_vkallocator;
+
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->support_vulkan)
+        {
+            int uret = layers[i]->upload_model(cmd, get_masked_option(opt_upload, layers[i]->featmask));
+            if (uret != 0)
+            {
+                NCNN_LOGE("layer upload_model %d failed", (int)i);
+                return -1;
+            }
+        }
+    }
+
+    return cmd.submit_and_wait();
+}
+#endif // NCNN_VULKAN
+
+// blob shape in storage layout without data
+static Mat get_profile_shape(const Mat& m)
+{
+    Mat shape;
+    shape.dims = m.dims;
+    shape.w = m.w;
+    shape.h = m.h;
+    shape.d = m.d;
+    shape.c = m.c;
+    shape.elempack = m.elempack;
+    shape.elemsize = m.elemsize;
+    shape.cstep = m.cstep;
+    return shape;
+}
+
+int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt, Profiler* profiler, int lane) const
+{
+    const Layer* layer = layers[layer_index];
+
+    if (layer->typeindex == LayerType::Input)
+        return 0;
+
+    //     NCNN_LOGE("forward_layer %d %s", layer_index, layer->name.c_str());
+
+    // bottom blobs are ready, the caller walks the execution plan in topological order
+
+#if NCNN_BENCHMARK
+    double start = get_current_time();
+    Mat bottom_blob;
+    if (layer->one_blob_only)
+    {
+        int bottom_blob_index = layer->bottoms[0];
+        bottom_blob.dims = blob_mats[bottom_blob_index].dims;
+        bottom_blob.w = blob_mats[bottom_blob_index].w;
+        bottom_blob.h = blob_mats[bottom_blob_index].h;
+        bottom_blob.d = blob_mats[bottom_blob_index].d;
+        bottom_blob.c = blob_mats[bottom_blob_index].c;
+        bottom_blob.elempack = blob_mats[bottom_blob_index].elempack;
+        bottom_blob.elemsize = blob_mats[bottom_blob_index].elemsize;
+    }
+#endif
+    // the option the layer actually runs with, after the branch split or partition cap and its featmask
+    const Option opt1 = layer->featmask ? get_masked_option(opt, layer->featmask) : opt;
+
+    // bottom blobs may be released by the layer in light mode, take their shapes first
+    LayerProfile profile;
+    std::vector<const void*> bottom_datas;
+    if (profiler)
+    {
+        profile.layer_index = layer_index;
+        profile.typeindex = layer->typeindex;
+#if NCNN_STRING
+        profile.type = layer->type;
+        profile.name = layer->name;
+#endif // NCNN_STRING
+        profile.lane = lane;
+        profile.num_threads = opt1.num_threads;
+
+        for (size_t i = 0; i < layer->bottoms.size(); i++)
+        {
+            const Mat& bottom_blob = blob_mats[layer->bottoms[i]];
+            profile.bottom_shapes.push_back(get_profile_shape(bottom_blob));
+            bottom_datas.push_back(bottom_blob.data);
+        }
+
+        profile.start = get_current_time();
+    }
+
+    int ret = 0;
+    const int resume = find_elementwise_chain_resume(layer, blob_mats);
+    if (resume != -1)
+    {
+        // run the rest of the chain layer by layer from the intermediate blob
+        const std::vector<Layer*>& chain = ((const ElementwiseChain*)layer)->chain;
+        for (size_t j = resume; j < chain.size() && ret == 0; j++)
+        {
+            ret = do_forward_layer(chain[j], blob_mats, opt1);
+        }
+    }
+    else
+    {
+        ret = do_forward_layer(layer, blob_mats, opt1);
+    }
+#if NCNN_BENCHMARK
+    double end = get_current_time();
+    if (layer->one_blob_only)
+    {
+        int top_blob_index = layer->tops[0];
+        benchmark(layer, bottom_blob, blob_mats[top_blob_index], start, end);
+    }
+    else
+    {
+        benchmark(layer, start, end);
+    }
+#endif
+    if (ret != 0)
+        return ret;
+
+    if (profiler)
+    {
+        profile.end = get_current_time();
+
+        for (size_t i = 0; i < layer->tops.size(); i++)
+        {
+            const Mat& top_blob = blob_mats[layer->tops[i]];
+            profile.top_shapes.push_back(get_profile_shape(top_blob));
+
+            // inplace forward writes into the bottom blob
+            bool inplace = false;
+            for (size_t j = 0; j < bottom_datas.size(); j++)
+            {
+                if (bottom_datas[j] == top_blob.data)
+                    inplace = true;
+            }
+
+            if (!inplace)
+                profile.bytes_allocated += top_blob.cstep * top_blob.c * top_blob.elemsize;
+        }
+
+        profiler->record(profile);
+    }
+
+    //     NCNN_LOGE("forward_layer %d %s done", layer_index, layer->name.c_str());
+    //     const Mat& blob = blob_mats[layer->tops[0]];
+    //     NCNN_LOGE("[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d", layer_index, layer->type.c_str(), layer->name.c_str(), layer->tops[0], blob.c, blob.h, blob.w);
+
+    return 0;
+}
+
+const std::vector<int>& NetPrivate::get_forward_plan(int blob_index, std::vector<int>& scratch) const
+{
+    // the size differs when the graph was constructed without load_param
+    if (forward_plans_ready.size() == blobs.size() && forward_plans_ready[blob_index])
+        return forward_plans[blob_index];
+
+    build_forward_plan(blob_index, scratch);
+    return scratch;
+}
+
+void NetPrivate::build_forward_plan(int blob_index, std::vector<int>& plan) const
+{
+    plan.clear();
+
+    int producer = blobs[blob_index].producer;
+    if (producer == -1)
+        return;
+
+    // iterative depth-first post-order walk, keeping the same layer order as recursive forward
+    // every layer is pushed at most once, so the stack never grows beyond the layer count
+    std::vector<unsigned char> visited(layers.size(), 0);
+    std::vector<int> stack_layers(layers.size());
+    std::vector<int> stack_bottoms(layers.size());
+    int stack_top = 0;
+
+    visited[producer] = 1;
+    stack_layers[0] = producer;
+    stack_bottoms[0] = 0;
+
+    while (stack_top >= 0)
+    {
+        const int layer_index = stack_layers[stack_top];
+        const int bottom_i = stack_bottoms[stack_top];
+        const Layer* layer = layers[layer_index];
+
+        if (layer->typeindex != LayerType::Input && bottom_i < (int)layer->bottoms.size())
+        {
+            stack_bottoms[stack_top] = bottom_i + 1;
+
+            int bottom_producer = blobs[layer->bottoms[bottom_i]].producer;
+            if (bottom_producer != -1 && !visited[bottom_producer])
+            {
+                visited[bottom_producer] = 1;
+                stack_top++;
+                stack_layers[stack_top] = bottom_producer;
+                stack_bottoms[stack_top] = 0;
+            }
+            continue;
+        }
+
+        stack_top--;
+
+        // input layer is a no-op
+        if (layer->typeindex != LayerType::Input)
+            plan.push_back(layer_index);
+    }
+}
+
+// dedicated cores for the duration of one extract
+class CpuPartitionGuard
+{
+public:
+    CpuPartitionGuard(Option& opt)
+        : enabled(opt.use_cpu_partition)
+    {
+        if (enabled)
+            opt.num_threads = acquire_cpu_partition(opt.num_threads, partition, previous_affinity_mask);
+    }
+
+    ~CpuPartitionGuard()
+    {
+        if (enabled)
+            release_cpu_partition(partition, previous_affinity_mask);
+    }
+
+private:
+    bool enabled;
+    CpuSet partition;
+    CpuSet previous_affinity_mask;
+};
+
+int NetPrivate::forward_plan(const std::vector<int>& plan, int blob_index, std::vector<Mat>& blob_mats, const Option& _opt, Profiler* profiler) const
+{
+    const int plan_size = (int)plan.size();
+
+    // walk backwards once and skip the layers whose wanted top blobs are already there
+    // eg. user provided intermediate blobs or blobs left by previous extract
+    std::vector<unsigned char> blob_wanted(blobs.size(), 0);
+    std::vector<unsigned char> layer_wanted(plan_size, 0);
+
+    blob_wanted[blob_index] = 1;
+    for (int i = plan_size - 1; i >= 0; i--)
+    {
+        const Layer* layer = layers[plan[i]];
+
+        bool run = false;
+        for (size_t j = 0; j < layer->tops.size(); j++)
+        {
+            int top_blob_index = layer->tops[j];
+            if (blob_wanted[top_blob_index] && blob_mats[top_blob_index].dims == 0)
+            {
+                run = true;
+                break;
+            }
+        }
+
+        if (!run)
+            continue;
+
+        layer_wanted[i] = 1;
+
+        const int resume = find_elementwise_chain_resume(layer, blob_mats);
+        if (resume != -1)
+        {
+            // the intermediate blob is there, the released chain input is not recomputed
+            continue;
+        }
+
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            blob_wanted[layer->bottoms[j]] = 1;
+        }
+    }
+
+    Option opt = _opt;
+    CpuPartitionGuard partition_guard(opt);
+
+#if NCNN_THREADS
+    if (opt.use_branch_parallel && opt.num_threads > 1)
+    {
+        return forward_plan_branch_parallel(plan, layer_wanted, blob_mats, opt, profiler);
+    }
+#endif // NCNN_THREADS
+
+    for (int i = 0; i < plan_size; i++)
+    {
+        if (!layer_wanted[i])
+            continue;
+
+        int ret = forward_layer(plan[i], blob_mats, opt, profiler, 0);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+#if NCNN_THREADS
+class BranchParallelContext
+{
+public:
+    const NetPrivate* net;
+    const std::vector<int>* plan;
+    std::vector<Mat>* blob_mats;
+    const Option* opt;
+    Profiler* profiler;
+    int worker_count;
+    int next_lane;
+
+    // plan step dependency graph in csr form
+    std::vector<int> successor_offsets;
+    std::vector<int> successors;
+
+    Mutex lock;
+    ConditionVariable cond;
+    std::vector<int> pending;
+    std::vector<int> ready;
+    int running;
+    int remaining;
+    int ret;
+
+    // pool workers inside branch_parallel_worker, guarded by the pool lock
+    int attached;
+};
+
+static void* branch_parallel_worker(void* args)
+{
+    BranchParallelContext* ctx = (BranchParallelContext*)args;
+
+    ctx->lock.lock();
+    const int lane = ctx->next_lane++;
+    ctx->lock.unlock();
+
+    // denormal flushing is per-thread state
+    int old_flush_denormals = get_flush_denormals();
+    set_flush_denormals(ctx->opt->flush_denormals);
+
+    ctx->lock.lock();
+    for (;;)
+    {
+        while (ctx->ready.empty() && ctx->remaining > 0 && ctx->ret == 0)
+        {
+            ctx->cond.wait(ctx->lock);
+        }
+
+        if (ctx->remaining == 0 || ctx->ret != 0)
+            break;
+
+        const int step = ctx->ready.back();
+        ctx->ready.resize(ctx->ready.size() - 1);
+        ctx->running++;
+
+        // split the threads among the layers that may run concurrently right now
+        const int concurrency = std::min(ctx->worker_count, ctx->running + (int)ctx->ready.size());
+
+        ctx->lock.unlock();
+
+        Option opt = *ctx->opt;
+        opt.num_threads = std::max(1, ctx->opt->num_threads / concurrency);
+
+        int ret = ctx->net->forward_layer((*ctx->plan)[step], *ctx->blob_mats, opt, ctx->profiler, lane);
+
+        ctx->lock.lock();
+
+        ctx->running--;
+        ctx->remaining--;
+
+        if (ret != 0)
+        {
+            ctx->ret = ret;
+        }
+        else
+        {
+            for (int i = ctx->successor_offsets[step]; i < ctx->successor_offsets[step + 1]; i++)
+            {
+                const int successor = ctx->successors[i];
+                if (--ctx->pending[successor] == 0)
+                    ctx->ready.push_back(successor);
+            }
+        }
+
+        ctx->cond.broadcast();
+    }
+    ctx->lock.unlock();
+
+    set_flush_denormals(old_flush_denormals);
+
+    return 0;
 }
 
-static Option get_masked_option(const Option& opt, int featmask)
+BranchParallelPool::BranchParallelPool()
 {
-    // mask option usage as layer specific featmask
-    Option opt1 = opt;
-    opt1.use_fp16_arithmetic = opt1.use_fp16_arithmetic && !(featmask & (1 << 0));
-    opt1.use_fp16_packed = opt1.use_fp16_packed && !(featmask & (1 << 1));
-    opt1.use_fp16_storage = opt1.use_fp16_storage && !(featmask & (1 << 1));
-    opt1.use_bf16_packed = opt1.use_bf16_packed && !(featmask & (1 << 2));
-    opt1.use_bf16_storage = opt1.use_bf16_storage && !(featmask & (1 << 2));
-    opt1.use_int8_packed = opt1.use_int8_packed && !(featmask & (1 << 3));
-    opt1.use_int8_storage = opt1.use_int8_storage && !(featmask & (1 << 3));
-    opt1.use_int8_arithmetic = opt1.use_int8_arithmetic && !(featmask & (1 << 3));
-    opt1.use_vulkan_compute = opt1.use_vulkan_compute && !(featmask & (1 << 4));
-    opt1.use_tensor_storage = opt1.use_tensor_storage && !(featmask & (1 << 4));
-    opt1.use_sgemm_convolution = opt1.use_sgemm_convolution && !(featmask & (1 << 5));
-    opt1.use_winograd_convolution = opt1.use_winograd_convolution && !(featmask & (1 << 6));
+    stopping = false;
+}
 
-    if (featmask & (1 << 7))
-        opt1.num_threads = 1;
+BranchParallelPool::~BranchParallelPool()
+{
+    lock.lock();
+    stopping = true;
+    task_cond.broadcast();
+    lock.unlock();
 
-    return opt1;
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->join();
+        delete workers[i];
+    }
 }
 
-#if NCNN_VULKAN
-int NetPrivate::upload_model()
+void BranchParallelPool::run(BranchParallelContext* ctx)
 {
-    ncnn::VkTransfer cmd(vkdev);
+    lock.lock();
 
-    // create gpu device allocator if null
-    if (!weight_vkallocator)
+    // grow on demand, the workers stay parked here between extracts
+    while ((int)workers.size() < ctx->worker_count - 1)
     {
-        weight_vkallocator = new VkWeightAllocator(vkdev);
+        workers.push_back(new Thread(worker, (void*)this));
     }
-    if (!weight_staging_vkallocator)
+
+    ctx->attached = 0;
+    for (int i = 0; i < ctx->worker_count - 1; i++)
     {
-        weight_staging_vkallocator = new VkWeightStagingAllocator(vkdev);
+        tasks.push_back(ctx);
     }
+    task_cond.broadcast();
 
-    Option opt_upload = opt;
-    opt_upload.blob_allocator = 0;
-    opt_upload.workspace_allocator = 0;
-    opt_upload.blob_vkallocator = weight_vkallocator;
-    opt_upload.workspace_vkallocator = weight_vkallocator;
-    opt_upload.staging_vkallocator = weight_staging_vkallocator;
+    lock.unlock();
 
-    for (size_t i = 0; i < layers.size(); i++)
+    branch_parallel_worker((void*)ctx);
+
+    lock.lock();
+
+    // the context is done, drop the tasks no worker has picked up yet
+    size_t j = 0;
+    for (size_t i = 0; i < tasks.size(); i++)
     {
-        if (layers[i]->support_vulkan)
+        if (tasks[i] != ctx)
+            tasks[j++] = tasks[i];
+    }
+    tasks.resize(j);
+
+    while (ctx->attached > 0)
+    {
+        finish_cond.wait(lock);
+    }
+
+    lock.unlock();
+}
+
+void* BranchParallelPool::worker(void* args)
+{
+    BranchParallelPool* pool = (BranchParallelPool*)args;
+
+    pool->lock.lock();
+    for (;;)
+    {
+        while (pool->tasks.empty() && !pool->stopping)
         {
-            int uret = layers[i]->upload_model(cmd, get_masked_option(opt_upload, layers[i]->featmask));
-            if (uret != 0)
-            {
-                NCNN_LOGE("layer upload_model %d failed", (int)i);
-                return -1;
-            }
+            pool->task_cond.wait(pool->lock);
         }
+
+        if (pool->stopping)
+            break;
+
+        BranchParallelContext* ctx = pool->tasks.front();
+        pool->tasks.erase(pool->tasks.begin());
+        ctx->attached++;
+
+        pool->lock.unlock();
+
+        branch_parallel_worker((void*)ctx);
+
+        pool->lock.lock();
+
+        ctx->attached--;
+        pool->finish_cond.broadcast();
     }
+    pool->lock.unlock();
 
-    return cmd.submit_and_wait();
+    return 0;
 }
-#endif // NCNN_VULKAN
 
-int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, const Option& opt) const
+int NetPrivate::forward_plan_branch_parallel(const std::vector<int>& plan, const std::vector<unsigned char>& layer_wanted, std::vector<Mat>& blob_mats, const Option& opt, Profiler* profiler) const
 {
-    const Layer* layer = layers[layer_index];
+    const int plan_size = (int)plan.size();
 
-    if (layer->typeindex == LayerType::Input)
-        return 0;
+    std::vector<int> layer_step(layers.size(), -1);
+    for (int i = 0; i < plan_size; i++)
+    {
+        if (layer_wanted[i])
+            layer_step[plan[i]] = i;
+    }
 
-    //     NCNN_LOGE("forward_layer %d %s", layer_index, layer->name.c_str());
+    BranchParallelContext ctx;
+    ctx.net = this;
+    ctx.plan = &plan;
+    ctx.blob_mats = &blob_mats;
+    ctx.opt = &opt;
+    ctx.profiler = profiler;
+    ctx.next_lane = 0;
+    ctx.pending.resize(plan_size, 0);
+    ctx.running = 0;
+    ctx.remaining = 0;
+    ctx.ret = 0;
 
-    // load bottom blobs
-    for (size_t i = 0; i < layer->bottoms.size(); i++)
+    // count successors of each step, producers of the same step counted once per bottom
+    std::vector<int> successor_count(plan_size, 0);
+    for (int i = 0; i < plan_size; i++)
     {
-        int bottom_blob_index = layer->bottoms[i];
+        if (!layer_wanted[i])
+            continue;
 
-        if (blob_mats[bottom_blob_index].dims == 0)
+        ctx.remaining++;
+
+        const Layer* layer = layers[plan[i]];
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
         {
-            int ret = forward_layer(blobs[bottom_blob_index].producer, blob_mats, opt);
-            if (ret != 0)
-                return ret;
+            int producer = blobs[layer->bottoms[j]].producer;
+            if (producer == -1 || layer_step[producer] == -1)
+                continue;
+
+            successor_count[layer_step[producer]]++;
+            ctx.pending[i]++;
         }
     }
 
-#if NCNN_BENCHMARK
-    double start = get_current_time();
-    Mat bottom_blob;
-    if (layer->one_blob_only)
+    ctx.successor_offsets.resize(plan_size + 1, 0);
+    for (int i = 0; i < plan_size; i++)
     {
-        int bottom_blob_index = layer->bottoms[0];
-        bottom_blob.dims = blob_mats[bottom_blob_index].dims;
-        bottom_blob.w = blob_mats[bottom_blob_index].w;
-        bottom_blob.h = blob_mats[bottom_blob_index].h;
-        bottom_blob.d = blob_mats[bottom_blob_index].d;
-        bottom_blob.c = blob_mats[bottom_blob_index].c;
-        bottom_blob.elempack = blob_mats[bottom_blob_index].elempack;
-        bottom_blob.elemsize = blob_mats[bottom_blob_index].elemsize;
+        ctx.successor_offsets[i + 1] = ctx.successor_offsets[i] + successor_count[i];
     }
-#endif
-    int ret = 0;
-    if (layer->featmask)
+
+    ctx.successors.resize(ctx.successor_offsets[plan_size]);
+    std::vector<int> successor_fill(plan_size);
+    for (int i = 0; i < plan_size; i++)
     {
-        ret = do_forward_layer(layer, blob_mats, get_masked_option(opt, layer->featmask));
+        successor_fill[i] = ctx.successor_offsets[i];
     }
-    else
+    for (int i = 0; i < plan_size; i++)
     {
-        ret = do_forward_layer(layer, blob_mats, opt);
+        if (!layer_wanted[i])
+            continue;
+
+        const Layer* layer = layers[plan[i]];
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            int producer = blobs[layer->bottoms[j]].producer;
+            if (producer == -1 || layer_step[producer] == -1)
+                continue;
+
+            ctx.successors[successor_fill[layer_step[producer]]++] = i;
+        }
     }
-#if NCNN_BENCHMARK
-    double end = get_current_time();
-    if (layer->one_blob_only)
+
+    // upper bound of the graph width, a plain chain gains nothing from extra workers
+    int width = 0;
+    for (int i = 0; i < plan_size; i++)
     {
-        int top_blob_index = layer->tops[0];
-        benchmark(layer, bottom_blob, blob_mats[top_blob_index], start, end);
+        if (!layer_wanted[i])
+            continue;
+
+        if (ctx.pending[i] == 0)
+            width++;
+
+        width += std::max(0, successor_count[i] - 1);
     }
-    else
+
+    // push in reverse so that the first step in plan order is picked first
+    for (int i = plan_size - 1; i >= 0; i--)
     {
-        benchmark(layer, start, end);
+        if (layer_wanted[i] && ctx.pending[i] == 0)
+            ctx.ready.push_back(i);
     }
-#endif
-    if (ret != 0)
-        return ret;
 
-    //     NCNN_LOGE("forward_layer %d %s done", layer_index, layer->name.c_str());
-    //     const Mat& blob = blob_mats[layer->tops[0]];
-    //     NCNN_LOGE("[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d", layer_index, layer->type.c_str(), layer->name.c_str(), layer->tops[0], blob.c, blob.h, blob.w);
+    ctx.worker_count = std::min(opt.num_threads, width);
 
-    return 0;
+    if (ctx.worker_count <= 1)
+    {
+        for (int i = 0; i < plan_size; i++)
+        {
+            if (!layer_wanted[i])
+                continue;
+
+            int ret = forward_layer(plan[i], blob_mats, opt, profiler, 0);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    // the calling thread works as well
+    branch_parallel_pool.run(&ctx);
+
+    return ctx.ret;
 }
+#endif // NCNN_THREADS
 
 #if NCNN_VULKAN
 int NetPrivate::forward_layer(int layer_index, std::vector<Mat>& blob_mats, std::vector<VkMat>& blob_mats_gpu, VkCompute& cmd, const Option& opt) const
@@ -900,6 +1908,108 @@ void NetPrivate::update_input_output_indexes()
     }
 }
 
+void NetPrivate::fuse_elementwise_chains()
+{
+    const int layer_count = (int)layers.size();
+
+    std::vector<int> consumer_count(blobs.size(), 0);
+    for (int i = 0; i < layer_count; i++)
+    {
+        for (size_t j = 0; j < layers[i]->bottoms.size(); j++)
+        {
+            consumer_count[layers[i]->bottoms[j]]++;
+        }
+    }
+
+    // layers from user registries are released by their own destroyer
+    std::vector<unsigned char> fusable(layer_count, 0);
+    for (int i = 0; i < layer_count; i++)
+    {
+        const Layer* layer = layers[i];
+        if (!is_fusable_elementwise_layer(layer))
+            continue;
+
+        bool overwritten = false;
+        for (size_t j = 0; j < overwrite_builtin_layer_registry.size(); j++)
+        {
+            if (overwrite_builtin_layer_registry[j].typeindex == layer->typeindex)
+                overwritten = true;
+        }
+
+        fusable[i] = overwritten ? 0 : 1;
+    }
+
+    for (int i = 0; i < layer_count; i++)
+    {
+        if (!fusable[i])
+            continue;
+
+        // follow single consumer links
+        std::vector<Layer*> chain;
+        chain.push_back(layers[i]);
+        fusable[i] = 0;
+
+        int last = i;
+        for (;;)
+        {
+            const int top_blob_index = layers[last]->tops[0];
+            if (consumer_count[top_blob_index] != 1)
+                break;
+
+            const int next = blobs[top_blob_index].consumer;
+            if (next == -1 || !fusable[next] || layers[next]->featmask != layers[i]->featmask)
+                break;
+
+            chain.push_back(layers[next]);
+            fusable[next] = 0;
+            last = next;
+        }
+
+        if (chain.size() < 2)
+            continue;
+
+        ElementwiseChain* layer = (ElementwiseChain*)create_layer_cpu(LayerType::ElementwiseChain);
+        if (!layer)
+            return;
+
+#if NCNN_STRING
+        // stand in for the last layer, which produces the same top blob
+        layer->type = "ElementwiseChain";
+        layer->name = chain[chain.size() - 1]->name;
+#endif // NCNN_STRING
+        layer->bottoms = layers[i]->bottoms;
+        layer->tops = layers[last]->tops;
+        layer->chain = chain;
+
+        // member pipelines are created already, the chain only takes over their capabilities
+        layer->create_pipeline(opt);
+
+        layers[last] = layer;
+    }
+}
+
+void NetPrivate::update_forward_plans()
+{
+    forward_plans.clear();
+    forward_plans.resize(blobs.size());
+    forward_plans_ready.clear();
+    forward_plans_ready.resize(blobs.size(), 0);
+
+    // compile the plans for graph outputs ahead of time
+    for (size_t i = 0; i < output_blob_indexes.size(); i++)
+    {
+        int blob_index = output_blob_indexes[i];
+        build_forward_plan(blob_index, forward_plans[blob_index]);
+        forward_plans_ready[blob_index] = 1;
+    }
+}
+
+void NetPrivate::clear_forward_plans()
+{
+    forward_plans.clear();
+    forward_plans_ready.clear();
+}
+
 #if NCNN_STRING
 void NetPrivate::update_input_output_names()
 {
@@ -1034,8 +2144,10 @@ int Net::register_custom_layer(int index, layer_creator_func creator, layer_dest
 }
 
 #if NCNN_STRING
-int Net::load_param(const DataReader& dr)
+int Net::load_param(const DataReader& _dr)
 {
+    DataReaderHashing dr(_dr);
+
 #define SCAN_VALUE(fmt, v)                \
     if (dr.scan(fmt, &v) != 1)            \
     {                                     \
@@ -1319,14 +2431,19 @@ int Net::load_param(const DataReader& dr)
 
     d->update_input_output_indexes();
     d->update_input_output_names();
+    d->update_forward_plans();
+
+    d->param_hash = dr.hash;
 
 #undef SCAN_VALUE
     return 0;
 }
 #endif // NCNN_STRING
 
-int Net::load_param_bin(const DataReader& dr)
+int Net::load_param_bin(const DataReader& _dr)
 {
+    DataReaderHashing dr(_dr);
+
 #if __BIG_ENDIAN__
 #define READ_VALUE(buf)                            \
     if (dr.read(&buf, sizeof(buf)) != sizeof(buf)) \
@@ -1603,6 +2720,9 @@ int Net::load_param_bin(const DataReader& dr)
     }
 
     d->update_input_output_indexes();
+    d->update_forward_plans();
+
+    d->param_hash = dr.hash;
 
 #undef READ_VALUE
     return 0;
@@ -1633,7 +2753,34 @@ int Net::load_model(const DataReader& dr)
     }
 #endif // NCNN_VULKAN
 
-    ModelBinFromDataReader mb(dr);
+    bool use_weight_cache = false;
+
+#if NCNN_STDIO
+    // weight cache does not apply to gpu pipelines
+    use_weight_cache = !d->weight_cache_path.empty() && !opt.use_vulkan_compute;
+
+    uint64_t weight_cache_key = 0;
+    std::vector<weight_cache_entry> weight_cache_entries;
+    bool weight_cache_dirty = false;
+    if (use_weight_cache)
+    {
+        weight_cache_key = get_weight_cache_key(d->param_hash);
+        if (d->read_weight_cache(weight_cache_key, weight_cache_entries) != 0)
+        {
+            weight_cache_entries.clear();
+            weight_cache_entries.resize(layer_count);
+            for (int i = 0; i < layer_count; i++)
+            {
+                weight_cache_entries[i].key = 0;
+                weight_cache_entries[i].cached = 0;
+            }
+        }
+    }
+#endif // NCNN_STDIO
+
+    // hash weight bytes only when keying the weight cache
+    DataReaderHashing hdr(dr);
+    ModelBinFromDataReader mb(use_weight_cache ? (const DataReader&)hdr : dr);
     for (int i = 0; i < layer_count; i++)
     {
         Layer* layer = d->layers[i];
@@ -1646,6 +2793,8 @@ int Net::load_model(const DataReader& dr)
             break;
         }
 
+        hdr.hash = DataReaderHashing::seed;
+
         int lret = layer->load_model(mb);
         if (lret != 0)
         {
@@ -1660,6 +2809,39 @@ int Net::load_model(const DataReader& dr)
 
         Option opt1 = get_masked_option(opt, layer->featmask);
 
+#if NCNN_STDIO
+        if (use_weight_cache)
+        {
+            // the layer key covers the weight bytes this layer just consumed
+            weight_cache_entry& entry = weight_cache_entries[i];
+            const uint64_t layer_key = get_weight_cache_layer_key(hdr.hash, opt1);
+
+            if (entry.cached && entry.key == layer_key && layer->load_pipeline_weights(entry.weights, opt1) == 0)
+            {
+                entry.weights.clear();
+                continue;
+            }
+
+            int cret = layer->create_pipeline(opt1);
+            if (cret != 0)
+            {
+#if NCNN_STRING
+                NCNN_LOGE("layer create_pipeline %d %s failed", i, layer->name.c_str());
+#else
+                NCNN_LOGE("layer create_pipeline %d failed", i);
+#endif
+                ret = -1;
+                break;
+            }
+
+            entry.key = layer_key;
+            entry.weights.clear();
+            entry.cached = layer->save_pipeline_weights(entry.weights) == 0;
+            weight_cache_dirty = true;
+            continue;
+        }
+#endif // NCNN_STDIO
+
         int cret = layer->create_pipeline(opt1);
         if (cret != 0)
         {
@@ -1673,6 +2855,20 @@ int Net::load_model(const DataReader& dr)
         }
     }
 
+    if (ret == 0 && opt.use_elementwise_fusion && !opt.use_vulkan_compute)
+    {
+        d->fuse_elementwise_chains();
+        d->update_forward_plans();
+    }
+
+#if NCNN_STDIO
+    if (use_weight_cache && ret == 0 && weight_cache_dirty)
+    {
+        // failing to write the cache does not fail loading
+        d->write_weight_cache(weight_cache_key, weight_cache_entries);
+    }
+#endif // NCNN_STDIO
+
     if (opt.use_local_pool_allocator)
     {
         if (opt.blob_allocator == 0)
@@ -1820,6 +3016,27 @@ int Net::load_model(const wchar_t* modelpath)
     return ret;
 }
 #endif
+
+int Net::set_weight_cache(const char* cachepath)
+{
+    d->weight_cache_path = cachepath ? cachepath : "";
+    return 0;
+}
+
+int Net::load_model_mmap(const char* modelpath)
+{
+    DataReaderFromMmap* dr = new DataReaderFromMmap(modelpath);
+    if (!dr->mapped())
+    {
+        delete dr;
+        return -1;
+    }
+
+    // keep the mapping alive as long as layers may reference it
+    d->mapped_readers.push_back(dr);
+
+    return load_model(*dr);
+}
 #endif // NCNN_STDIO
 
 int Net::load_param(const unsigned char* _mem)
@@ -1907,6 +3124,7 @@ int Net::load_model(AAssetManager* mgr, const char* assetpath)
 void Net::clear()
 {
     d->blobs.clear();
+    d->clear_forward_plans();
     for (size_t i = 0; i < d->layers.size(); i++)
     {
         Layer* layer = d->layers[i];
@@ -1961,6 +3179,14 @@ void Net::clear()
     }
     d->layers.clear();
 
+#if NCNN_STDIO
+    for (size_t i = 0; i < d->mapped_readers.size(); i++)
+    {
+        delete d->mapped_readers[i];
+    }
+    d->mapped_readers.clear();
+#endif // NCNN_STDIO
+
     if (d->local_blob_allocator)
     {
         delete d->local_blob_allocator;
@@ -2031,14 +3257,23 @@ const std::vector<Layer*>& Net::layers() const
 
 std::vector<Blob>& Net::mutable_blobs()
 {
+    // graph may change, drop the compiled execution plans
+    d->clear_forward_plans();
     return d->blobs;
 }
 
 std::vector<Layer*>& Net::mutable_layers()
 {
+    // graph may change, drop the compiled execution plans
+    d->clear_forward_plans();
     return d->layers;
 }
 
+void Net::update_forward_plans()
+{
+    d->update_forward_plans();
+}
+
 #if NCNN_VULKAN
 void Net::set_vulkan_device(int device_index)
 {
@@ -2164,12 +3399,13 @@ class ExtractorPrivate
 {
 public:
     ExtractorPrivate(const Net* _net)
-        : net(_net)
+        : net(_net), profiler(0)
     {
     }
     const Net* net;
     std::vector<Mat> blob_mats;
     Option opt;
+    Profiler* profiler;
 
 #if NCNN_VULKAN
     VkAllocator* local_blob_vkallocator;
@@ -2209,6 +3445,7 @@ Extractor::Extractor(const Extractor& rhs)
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
     d->opt = rhs.d->opt;
+    d->profiler = rhs.d->profiler;
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2226,6 +3463,7 @@ Extractor& Extractor::operator=(const Extractor& rhs)
     d->net = rhs.d->net;
     d->blob_mats = rhs.d->blob_mats;
     d->opt = rhs.d->opt;
+    d->profiler = rhs.d->profiler;
 
 #if NCNN_VULKAN
     d->local_blob_vkallocator = 0;
@@ -2275,6 +3513,11 @@ void Extractor::set_workspace_allocator(Allocator* allocator)
     d->opt.workspace_allocator = allocator;
 }
 
+void Extractor::set_profiler(Profiler* profiler)
+{
+    d->profiler = profiler;
+}
+
 #if NCNN_VULKAN
 void Extractor::set_blob_vkallocator(VkAllocator* allocator)
 {
@@ -2355,8 +3598,6 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
 
     if (d->blob_mats[blob_index].dims == 0)
     {
-        int layer_index = d->net->blobs()[blob_index].producer;
-
         // use local allocator
         if (d->opt.use_local_pool_allocator)
         {
@@ -2421,10 +3662,14 @@ int Extractor::extract(int blob_index, Mat& feat, int type)
         }
         else
         {
-            ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
+            std::vector<int> scratch;
+            const std::vector<int>& plan = d->net->d->get_forward_plan(blob_index, scratch);
+            ret = d->net->d->forward_plan(plan, blob_index, d->blob_mats, d->opt, d->profiler);
         }
 #else
-        ret = d->net->d->forward_layer(layer_index, d->blob_mats, d->opt);
+        std::vector<int> scratch;
+        const std::vector<int>& plan = d->net->d->get_forward_plan(blob_index, scratch);
+        ret = d->net->d->forward_plan(plan, blob_index, d->blob_mats, d->opt, d->profiler);
 #endif // NCNN_VULKAN
     }
 
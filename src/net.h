@@ -23,6 +23,7 @@ class VkCompute;
 #endif // NCNN_VULKAN
 class DataReader;
 class Extractor;
+class Profiler;
 class NetPrivate;
 class NCNN_EXPORT Net
 {
@@ -93,6 +94,18 @@ public:
 #if _WIN32
     int load_model(const wchar_t* modelpath);
 #endif
+
+    // map network weight data from model file
+    // weight data is referenced in place where layers keep it unpacked
+    // the mapping is retained until clear() or the net is destroyed
+    // return 0 if success
+    int load_model_mmap(const char* modelpath);
+
+    // keep the layer weights transformed by create_pipeline in cache file
+    // following load_model restores matching layers from the cache instead of transforming weights again
+    // the cache is rewritten when the model, cpu features or options do not match
+    // return 0 if success
+    int set_weight_cache(const char* cachepath);
 #endif // NCNN_STDIO
 
     // load network structure from external memory
@@ -144,6 +157,11 @@ public:
     std::vector<Blob>& mutable_blobs();
     std::vector<Layer*>& mutable_layers();
 
+    // recompile the execution plans after editing the graph through mutable_blobs() and mutable_layers()
+    // tools keeping these references across edits must call it before creating an extractor
+    // extractors read the plans without locking, do not call it while any of them is running
+    void update_forward_plans();
+
 protected:
     friend class Extractor;
 #if NCNN_STRING
@@ -189,6 +207,10 @@ public:
     // set workspace memory allocator
     void set_workspace_allocator(Allocator* allocator);
 
+    // record per-layer timing and blob shapes of the following extract calls
+    // cpu layers only, pass null to stop recording
+    void set_profiler(Profiler* profiler);
+
 #if NCNN_VULKAN
     void set_blob_vkallocator(VkAllocator* allocator);
 
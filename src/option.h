@@ -141,9 +141,24 @@ public:
     bool use_fp16_uniform;
     bool use_int8_uniform;
 
-    bool use_reserved_9;
-    bool use_reserved_10;
-    bool use_reserved_11;
+    // run independent branches of the graph concurrently
+    // the thread budget of each layer is num_threads divided among the running branches
+    // except for arm and riscv gemm and convolution tiled at load time, which keep the load-time value
+    // the branch workers are kept alive by the net and reused across extracts
+    // blob allocator must be thread-safe when enabled, eg. PoolAllocator
+    // disabled by default
+    bool use_branch_parallel;
+
+    // reserve dedicated cores for each extract among extractors running concurrently
+    // num_threads is capped to the free cores and the workers are pinned to them
+    // extract waits while every core is reserved, see acquire_cpu_partition
+    // disabled by default
+    bool use_cpu_partition;
+
+    // evaluate chains of elementwise layers tile by tile in one memory pass
+    // applied once in load_model, cpu only
+    // disabled by default
+    bool use_elementwise_fusion;
 };
 
 } // namespace ncnn
@@ -0,0 +1,361 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdio.h>
+
+#include "allocator.h"
+#include "mat.h"
+#include "platform.h"
+
+// emulate a small chain of layers in light mode
+// a -> b -> c, a -> d, c + d -> e
+static int run_chain(ncnn::Allocator* allocator, float value, float& result)
+{
+    ncnn::Mat a(64, 32, 4, (size_t)4u, allocator);
+    if (a.empty())
+        return -100;
+    a.fill(value);
+
+    ncnn::Mat b(64, 32, 4, (size_t)4u, allocator);
+    ncnn::Mat d(16, 16, 4, (size_t)4u, allocator);
+    if (b.empty() || d.empty())
+        return -100;
+    for (int i = 0; i < (int)b.total(); i++)
+        b[i] = a[i] * 2.f;
+    d.fill(a[0] + 1.f);
+    a.release();
+
+    ncnn::Mat c(128, 16, 4, (size_t)4u, allocator);
+    if (c.empty())
+        return -100;
+    for (int i = 0; i < (int)c.total(); i++)
+        c[i] = b[i] + 1.f;
+    b.release();
+
+    ncnn::Mat e(8, (size_t)4u, allocator);
+    if (e.empty())
+        return -100;
+    e.fill(c[0] + d[0]);
+    c.release();
+    d.release();
+
+    result = e[0];
+
+    return 0;
+}
+
+static int test_arena_allocator_0()
+{
+    ncnn::ArenaAllocator arena;
+
+    float result = 0.f;
+
+    arena.begin_plan();
+    int ret = run_chain(&arena, 1.f, result);
+    if (ret != 0 || arena.end_plan() != 0)
+    {
+        fprintf(stderr, "arena allocator plan failed\n");
+        return -1;
+    }
+
+    // a and b are alive at the same time, c may reuse a
+    const size_t planned = arena.planned_size();
+    const size_t one_blob = ncnn::alignSize(64 * 32 * 4 * 4 + sizeof(int), NCNN_MALLOC_ALIGN);
+    if (planned < one_blob * 2 || planned >= one_blob * 3 + 4096)
+    {
+        fprintf(stderr, "arena allocator planned size %lu unexpected\n", (unsigned long)planned);
+        return -1;
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+        float v = 2.f + i;
+        ret = run_chain(&arena, v, result);
+        if (ret != 0 || result != (v * 2.f + 1.f) + (v + 1.f))
+        {
+            fprintf(stderr, "arena allocator replay %d failed %f\n", i, result);
+            return -1;
+        }
+    }
+
+    if (arena.heap_fallback_count() != 0 || arena.arena_hit_count() != 5 * 3)
+    {
+        fprintf(stderr, "arena allocator hit %lu fallback %lu\n", (unsigned long)arena.arena_hit_count(), (unsigned long)arena.heap_fallback_count());
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_arena_allocator_1()
+{
+    ncnn::ArenaAllocator arena;
+
+    float result = 0.f;
+
+    arena.begin_plan();
+    run_chain(&arena, 1.f, result);
+    arena.end_plan();
+
+    // keep a buffer of the replay alive, the overlapping slots must not be handed out
+    ncnn::Mat held(64, 32, 4, (size_t)4u, &arena);
+    held.fill(7.f);
+
+    int ret = run_chain(&arena, 3.f, result);
+    if (ret != 0 || result != (3.f * 2.f + 1.f) + (3.f + 1.f))
+    {
+        fprintf(stderr, "arena allocator conflict replay failed %f\n", result);
+        return -1;
+    }
+
+    for (int i = 0; i < (int)held.total(); i++)
+    {
+        if (held[i] != 7.f)
+        {
+            fprintf(stderr, "arena allocator overwrote a live buffer\n");
+            return -1;
+        }
+    }
+
+    if (arena.heap_fallback_count() == 0)
+    {
+        fprintf(stderr, "arena allocator should fallback to heap\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_arena_allocator_2()
+{
+    ncnn::ArenaAllocator arena;
+
+    float result = 0.f;
+
+    arena.begin_plan();
+    run_chain(&arena, 1.f, result);
+    arena.end_plan();
+
+    // an inference that stops after two blobs leaves the cursor in the middle of the plan
+    {
+        ncnn::Mat a(64, 32, 4, (size_t)4u, &arena);
+        ncnn::Mat b(64, 32, 4, (size_t)4u, &arena);
+    }
+
+    // the next inference starts over from the first slot
+    for (int i = 0; i < 2; i++)
+    {
+        float v = 2.f + i;
+        int ret = run_chain(&arena, v, result);
+        if (ret != 0 || result != (v * 2.f + 1.f) + (v + 1.f))
+        {
+            fprintf(stderr, "arena allocator resync replay %d failed %f\n", i, result);
+            return -1;
+        }
+    }
+
+    if (arena.heap_fallback_count() != 0 || arena.arena_hit_count() != 2 + 5 * 2)
+    {
+        fprintf(stderr, "arena allocator resync hit %lu fallback %lu\n", (unsigned long)arena.arena_hit_count(), (unsigned long)arena.heap_fallback_count());
+        return -1;
+    }
+
+    return 0;
+}
+
+struct thread_caching_args
+{
+    ncnn::ThreadCachingAllocator* allocator;
+    int seed;
+    int ret;
+};
+
+static void* thread_caching_worker(void* args)
+{
+    thread_caching_args* a = (thread_caching_args*)args;
+
+    // allocations of mixed sizes, some of them freed in a different order
+    for (int i = 0; i < 200; i++)
+    {
+        const int w = 16 + (a->seed * 7 + i * 13) % 300;
+
+        ncnn::Mat m0(w, 8, (size_t)4u, a->allocator);
+        ncnn::Mat m1(w * 2, (size_t)4u, a->allocator);
+        ncnn::Mat m2(5000 + w, 4, (size_t)4u, a->allocator);
+        if (m0.empty() || m1.empty() || m2.empty())
+        {
+            a->ret = -100;
+            return 0;
+        }
+
+        m0.fill((float)a->seed);
+        m1.fill((float)i);
+        m2.fill((float)(a->seed + i));
+        m1.release();
+
+        for (int j = 0; j < (int)m0.total(); j++)
+        {
+            if (m0[j] != (float)a->seed)
+            {
+                a->ret = -1;
+                return 0;
+            }
+        }
+        for (int j = 0; j < (int)m2.total(); j++)
+        {
+            if (m2[j] != (float)(a->seed + i))
+            {
+                a->ret = -1;
+                return 0;
+            }
+        }
+    }
+
+    a->ret = 0;
+    return 0;
+}
+
+static int test_thread_caching_allocator_0()
+{
+    ncnn::ThreadCachingAllocator allocator;
+
+    // small limit forces depot traffic
+    allocator.set_thread_cache_limit(64 * 1024);
+
+    const int thread_count = 4;
+    thread_caching_args args[thread_count];
+    std::vector<ncnn::Thread*> threads(thread_count);
+    for (int i = 0; i < thread_count; i++)
+    {
+        args[i].allocator = &allocator;
+        args[i].seed = i + 1;
+        args[i].ret = -1;
+        threads[i] = new ncnn::Thread(thread_caching_worker, (void*)&args[i]);
+    }
+
+    int ret = 0;
+    for (int i = 0; i < thread_count; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+
+        if (args[i].ret != 0)
+        {
+            fprintf(stderr, "thread caching allocator worker %d failed %d\n", i, args[i].ret);
+            ret = -1;
+        }
+    }
+
+    if (ret != 0)
+        return ret;
+
+    const size_t hit = allocator.thread_cache_hit_count();
+    const size_t heap = allocator.heap_alloc_count();
+    if (hit == 0 || hit + allocator.depot_hit_count() < heap)
+    {
+        fprintf(stderr, "thread caching allocator hit %lu depot %lu heap %lu\n", (unsigned long)hit, (unsigned long)allocator.depot_hit_count(), (unsigned long)heap);
+        return -1;
+    }
+
+    if (allocator.cached_bytes() == 0)
+    {
+        fprintf(stderr, "thread caching allocator should keep freed buffers\n");
+        return -1;
+    }
+
+    allocator.clear();
+
+    if (allocator.cached_bytes() != 0)
+    {
+        fprintf(stderr, "thread caching allocator clear failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void* thread_churn_worker(void* args)
+{
+    thread_caching_args* a = (thread_caching_args*)args;
+
+    for (int i = 0; i < 20; i++)
+    {
+        ncnn::Mat m0(64, 16, (size_t)4u, a->allocator);
+        ncnn::Mat m1(300, 8, (size_t)4u, a->allocator);
+        ncnn::Mat m2(1000, 4, (size_t)4u, a->allocator);
+        if (m0.empty() || m1.empty() || m2.empty())
+        {
+            a->ret = -100;
+            return 0;
+        }
+
+        m0.fill((float)i);
+        m1.fill((float)i);
+        m2.fill((float)i);
+    }
+
+    a->ret = 0;
+    return 0;
+}
+
+static int test_thread_caching_allocator_1()
+{
+    ncnn::ThreadCachingAllocator allocator;
+
+    // one short lived thread after another, like a worker per request
+    size_t heap_first = 0;
+    for (int i = 0; i < 8; i++)
+    {
+        thread_caching_args args;
+        args.allocator = &allocator;
+        args.seed = i;
+        args.ret = -1;
+
+        ncnn::Thread thread(thread_churn_worker, (void*)&args);
+        thread.join();
+
+        if (args.ret != 0)
+        {
+            fprintf(stderr, "thread caching allocator churn worker %d failed %d\n", i, args.ret);
+            return -1;
+        }
+
+        if (i == 0)
+            heap_first = allocator.heap_alloc_count();
+    }
+
+    // the buffers of exited threads are reused instead of hoarded
+    const size_t heap = allocator.heap_alloc_count();
+    if (heap_first == 0 || heap != heap_first || allocator.depot_hit_count() < 7)
+    {
+        fprintf(stderr, "thread caching allocator churn heap %lu first %lu depot %lu\n", (unsigned long)heap, (unsigned long)heap_first, (unsigned long)allocator.depot_hit_count());
+        return -1;
+    }
+
+    // statistics of exited threads are kept
+    if (allocator.thread_cache_hit_count() < 8 * 19 * 3)
+    {
+        fprintf(stderr, "thread caching allocator churn hit %lu\n", (unsigned long)allocator.thread_cache_hit_count());
+        return -1;
+    }
+
+    allocator.clear();
+
+    if (allocator.cached_bytes() != 0)
+    {
+        fprintf(stderr, "thread caching allocator churn clear failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    return 0
+           || test_arena_allocator_0()
+           || test_arena_allocator_1()
+           || test_arena_allocator_2()
+           || test_thread_caching_allocator_0()
+           || test_thread_caching_allocator_1();
+}
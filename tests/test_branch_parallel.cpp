@@ -0,0 +1,196 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "platform.h"
+
+// three convolution branches joined by concat
+// gemm with constant A and gemm with constant B joined by add
+static const char* g_param = "7767517\n"
+                             "11 15\n"
+                             "Input data 0 1 data 0=16 1=16 2=16\n"
+                             "Split sp 1 5 data d0 d1 d2 d3 d4\n"
+                             "Convolution c0 1 1 d0 c0 0=16 1=3 4=1 5=1 6=2304\n"
+                             "Convolution c1 1 1 d1 c1 0=32 1=1 5=1 6=512\n"
+                             "Convolution c2 1 1 d2 c2 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                             "Concat cat 3 1 c0 c1 c2 out0 0=0\n"
+                             "Reshape r0 1 1 d3 r0 0=256 1=16\n"
+                             "Gemm ga 1 1 r0 ga 4=1 7=96 9=16 14=1\n"
+                             "Reshape r1 1 1 d4 r1 0=16 1=256\n"
+                             "Gemm gb 1 1 r1 gb 5=1 8=96 9=16\n"
+                             "BinaryOp add 2 1 ga gb out1 0=0\n";
+
+static int compare_output(const ncnn::Mat& a, const ncnn::Mat& b)
+{
+    if (a.dims != b.dims || a.w != b.w || a.h != b.h || a.c != b.c)
+        return -1;
+
+    for (int q = 0; q < a.c; q++)
+    {
+        const float* pa = a.channel(q);
+        const float* pb = b.channel(q);
+        for (int i = 0; i < a.w * a.h; i++)
+        {
+            if (fabs(pa[i] - pb[i]) > 1e-3f * (1.f + fabs(pa[i])))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+static ncnn::Mat make_input()
+{
+    ncnn::Mat in(16, 16, 16);
+    for (int i = 0; i < (int)in.total(); i++)
+    {
+        in[i] = ((i * 7) % 29) / 29.f - 0.5f;
+    }
+
+    return in;
+}
+
+static int extract(const ncnn::Net& net, ncnn::Mat& out0, ncnn::Mat& out1)
+{
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", make_input());
+
+    if (ex.extract("out0", out0) != 0 || ex.extract("out1", out1) != 0)
+        return -1;
+
+    out0 = out0.clone();
+    out1 = out1.clone();
+
+    return 0;
+}
+
+struct ConcurrentExtract
+{
+    const ncnn::Net* net;
+    const ncnn::Mat* out0_ref;
+    const ncnn::Mat* out1_ref;
+    int ret;
+};
+
+static void* concurrent_extract(void* args)
+{
+    ConcurrentExtract* ce = (ConcurrentExtract*)args;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Mat out0;
+        ncnn::Mat out1;
+        if (extract(*ce->net, out0, out1) != 0 || compare_output(*ce->out0_ref, out0) != 0 || compare_output(*ce->out1_ref, out1) != 0)
+        {
+            ce->ret = -1;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static int test_branch_parallel(const ncnn::Option& opt)
+{
+    ncnn::Mat out0_ref;
+    ncnn::Mat out1_ref;
+    {
+        ncnn::Option opt_ref = opt;
+        opt_ref.num_threads = 1;
+        opt_ref.use_branch_parallel = false;
+
+        ncnn::Net net;
+        net.opt = opt_ref;
+        if (load_net_random(net, g_param) != 0 || extract(net, out0_ref, out1_ref) != 0)
+        {
+            fprintf(stderr, "test_branch_parallel reference run failed\n");
+            return -1;
+        }
+    }
+
+    ncnn::Net net;
+    net.opt = opt;
+    if (load_net_random(net, g_param) != 0)
+    {
+        fprintf(stderr, "test_branch_parallel load failed\n");
+        return -1;
+    }
+
+    // the workers are reused across extracts
+    // fewer threads than at load time must still match the pre-packed gemm and convolution weights
+    const int num_threads[5] = {opt.num_threads, opt.num_threads, 2, 3, 1};
+    for (int i = 0; i < 5; i++)
+    {
+        net.opt.num_threads = num_threads[i];
+
+        ncnn::Mat out0;
+        ncnn::Mat out1;
+        if (extract(net, out0, out1) != 0 || compare_output(out0_ref, out0) != 0 || compare_output(out1_ref, out1) != 0)
+        {
+            fprintf(stderr, "test_branch_parallel failed num_threads=%d extract num_threads=%d use_packing_layout=%d\n", opt.num_threads, num_threads[i], opt.use_packing_layout);
+            return -1;
+        }
+    }
+
+    net.opt.num_threads = opt.num_threads;
+
+    // extractors running concurrently share the workers of the net
+    ConcurrentExtract ce[2];
+    ncnn::Thread* threads[2];
+    for (int i = 0; i < 2; i++)
+    {
+        ce[i].net = &net;
+        ce[i].out0_ref = &out0_ref;
+        ce[i].out1_ref = &out1_ref;
+        ce[i].ret = 0;
+        threads[i] = new ncnn::Thread(concurrent_extract, (void*)&ce[i]);
+    }
+
+    int ret = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+
+        if (ce[i].ret != 0)
+            ret = -1;
+    }
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_branch_parallel concurrent extract failed num_threads=%d use_packing_layout=%d\n", opt.num_threads, opt.use_packing_layout);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    ncnn::Option opts[3];
+
+    opts[0].num_threads = 4;
+    opts[0].use_branch_parallel = true;
+
+    opts[1].num_threads = 4;
+    opts[1].use_branch_parallel = true;
+    opts[1].use_packing_layout = false;
+
+    opts[2].num_threads = 3;
+    opts[2].use_branch_parallel = true;
+    opts[2].lightmode = false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_branch_parallel(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -5,6 +5,10 @@
 
 #include "cpu.h"
 
+#if defined __linux__ && !defined __ANDROID__
+#include <sched.h>
+#endif
+
 #if defined __ANDROID__ || defined __linux__ || defined __APPLE__
 
 static int test_cpu_set()
@@ -104,6 +108,89 @@ static int test_cpu_powersave()
     }
 }
 
+static int test_cpu_partition()
+{
+    const int cpucount = ncnn::get_cpu_count();
+
+    ncnn::CpuSet partition0;
+    ncnn::CpuSet previous0;
+    int num_reserved0 = ncnn::acquire_cpu_partition(cpucount, partition0, previous0);
+    if (num_reserved0 < 1 || num_reserved0 > cpucount || partition0.num_enabled() != num_reserved0)
+    {
+        fprintf(stderr, "acquire_cpu_partition reserved %d cores out of %d\n", num_reserved0, cpucount);
+        return 1;
+    }
+
+    ncnn::release_cpu_partition(partition0, previous0);
+
+    if (cpucount < 2)
+        return 0;
+
+    // the second partition gets what the first one left
+    ncnn::CpuSet previous1;
+    int num_reserved1 = ncnn::acquire_cpu_partition(1, partition0, previous0);
+
+    ncnn::CpuSet partition1;
+    int num_reserved2 = ncnn::acquire_cpu_partition(cpucount, partition1, previous1);
+
+    int overlap = 0;
+    for (int i = 0; i < cpucount; i++)
+    {
+        if (partition0.is_enabled(i) && partition1.is_enabled(i))
+            overlap++;
+    }
+
+    ncnn::release_cpu_partition(partition1, previous1);
+    ncnn::release_cpu_partition(partition0, previous0);
+
+    if (num_reserved1 != 1 || num_reserved2 != num_reserved0 - 1 || overlap != 0)
+    {
+        fprintf(stderr, "acquire_cpu_partition reserved %d and %d cores, %d overlapped\n", num_reserved1, num_reserved2, overlap);
+        return 1;
+    }
+
+#if defined __linux__ && !defined __ANDROID__
+    // release restores the affinity the caller had, not the default mask
+    cpu_set_t origin_mask;
+    CPU_ZERO(&origin_mask);
+    if (sched_getaffinity(0, sizeof(origin_mask), &origin_mask) != 0 || CPU_COUNT(&origin_mask) < 2)
+        return 0;
+
+    cpu_set_t custom_mask;
+    CPU_ZERO(&custom_mask);
+    for (int i = 0; i < CPU_SETSIZE; i++)
+    {
+        if (CPU_ISSET(i, &origin_mask))
+        {
+            CPU_SET(i, &custom_mask);
+            break;
+        }
+    }
+
+    if (sched_setaffinity(0, sizeof(custom_mask), &custom_mask) != 0)
+        return 0;
+
+    ncnn::CpuSet partition2;
+    ncnn::CpuSet previous2;
+    ncnn::acquire_cpu_partition(cpucount, partition2, previous2);
+    ncnn::release_cpu_partition(partition2, previous2);
+
+    cpu_set_t restored_mask;
+    CPU_ZERO(&restored_mask);
+    sched_getaffinity(0, sizeof(restored_mask), &restored_mask);
+
+    sched_setaffinity(0, sizeof(origin_mask), &origin_mask);
+
+    if (!CPU_EQUAL(&restored_mask, &custom_mask))
+    {
+        fprintf(stderr, "release_cpu_partition did not restore the calling thread affinity\n");
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
 #else
 
 #if defined _WIN32
@@ -149,6 +236,11 @@ static int test_cpu_powersave()
     return 0;
 }
 
+static int test_cpu_partition()
+{
+    return 0;
+}
+
 #endif
 
 int main()
@@ -157,5 +249,6 @@ int main()
            || test_cpu_set()
            || test_cpu_info()
            || test_cpu_omp()
-           || test_cpu_powersave();
+           || test_cpu_powersave()
+           || test_cpu_partition();
 }
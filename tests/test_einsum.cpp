@@ -149,6 +149,24 @@ static int test_einsum_11()
     return test_einsum(a, "imnj,kmln->ijkl");
 }
 
+static int test_einsum_12()
+{
+    std::vector<ncnn::Mat> a(2);
+    a[0] = RandomMat(16, 24, 8);
+    a[1] = RandomMat(16, 20, 8);
+
+    return test_einsum(a, "ijl,ikl->ijk");
+}
+
+static int test_einsum_13()
+{
+    std::vector<ncnn::Mat> a(2);
+    a[0] = RandomMat(32, 12);
+    a[1] = RandomMat(16, 32, 4);
+
+    return test_einsum(a, "il,jlk->ijk");
+}
+
 int main()
 {
     SRAND(7767517);
@@ -165,5 +183,7 @@ int main()
            || test_einsum_8()
            || test_einsum_9()
            || test_einsum_10()
-           || test_einsum_11();
+           || test_einsum_11()
+           || test_einsum_12()
+           || test_einsum_13();
 }
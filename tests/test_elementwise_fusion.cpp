@@ -0,0 +1,149 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "layer_type.h"
+#include "net.h"
+
+// conv -> mul -> tanh -> clip -> swish -> hardswish -> split
+//   split -> sigmoid -> relu -> add
+//   split -> conv
+static const char* g_param = "7767517\n"
+                             "13 14\n"
+                             "Input data 0 1 data 0=23 1=19 2=16\n"
+                             "Convolution conv0 1 1 data conv0 0=16 1=1 5=1 6=256\n"
+                             "BinaryOp mul 1 1 conv0 mul 0=2 1=1 2=0.5\n"
+                             "UnaryOp tanh 1 1 mul tanh 0=16\n"
+                             "Clip clip 1 1 tanh clip 0=-0.8 1=0.8\n"
+                             "Swish swish 1 1 clip swish\n"
+                             "HardSwish hardswish 1 1 swish hardswish 0=0.2 1=0.5\n"
+                             "Split split 1 2 hardswish hardswish_0 hardswish_1\n"
+                             "Sigmoid sigmoid 1 1 hardswish_0 sigmoid\n"
+                             "ReLU relu 1 1 sigmoid relu 0=0.1\n"
+                             "BinaryOp add 1 1 relu out0 0=0 1=1 2=-0.25\n"
+                             "Convolution conv1 1 1 hardswish_1 conv1 0=8 1=3 4=1 5=1 6=1152\n"
+                             "ReLU relu1 1 1 conv1 out1\n";
+
+static int compare_output(const ncnn::Mat& a, const ncnn::Mat& b)
+{
+    if (a.dims != b.dims || a.w != b.w || a.h != b.h || a.c != b.c)
+        return -1;
+
+    for (int q = 0; q < a.c; q++)
+    {
+        const float* pa = a.channel(q);
+        const float* pb = b.channel(q);
+        for (int i = 0; i < a.w * a.h; i++)
+        {
+            if (fabs(pa[i] - pb[i]) > 1e-3f * (1.f + fabs(pa[i])))
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int run_net(const ncnn::Option& opt, bool fusion, ncnn::Mat& out0, ncnn::Mat& out1, ncnn::Mat& clip)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.opt.use_elementwise_fusion = fusion;
+    if (load_net_random(net, g_param, 2.f) != 0)
+        return -1;
+
+    // the two chains stand in for their last layers
+    const std::vector<ncnn::Layer*>& layers = net.layers();
+    if (fusion && (layers[6]->typeindex != ncnn::LayerType::ElementwiseChain || layers[10]->typeindex != ncnn::LayerType::ElementwiseChain || layers[2]->type != "BinaryOp" || layers[12]->type != "ReLU"))
+    {
+        fprintf(stderr, "elementwise chains not fused as expected\n");
+        return -1;
+    }
+
+    ncnn::Mat in(23, 19, 16);
+    for (int i = 0; i < (int)in.total(); i++)
+    {
+        in[i] = ((i * 7) % 29) / 29.f - 0.5f;
+    }
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    if (ex.extract("out0", out0) != 0 || ex.extract("out1", out1) != 0)
+        return -1;
+
+    // blob inside a fused chain is still reachable
+    ncnn::Extractor ex2 = net.create_extractor();
+    ex2.input("data", in);
+    if (ex2.extract("clip", clip) != 0)
+        return -1;
+
+    out0 = out0.clone();
+    out1 = out1.clone();
+    clip = clip.clone();
+
+    // blob inside a fused chain first, then the chain output on the same extractor
+    // light mode has released the chain input by then
+    ncnn::Extractor ex3 = net.create_extractor();
+    ex3.input("data", in);
+
+    ncnn::Mat clip3;
+    ncnn::Mat out03;
+    if (ex3.extract("clip", clip3) != 0 || ex3.extract("out0", out03) != 0)
+        return -1;
+
+    if (compare_output(clip, clip3) != 0 || compare_output(out0, out03) != 0)
+    {
+        fprintf(stderr, "chain output after intermediate extract mismatch\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_elementwise_fusion(const ncnn::Option& opt)
+{
+    ncnn::Mat out0_ref;
+    ncnn::Mat out1_ref;
+    ncnn::Mat clip_ref;
+    ncnn::Mat out0;
+    ncnn::Mat out1;
+    ncnn::Mat clip;
+    if (run_net(opt, false, out0_ref, out1_ref, clip_ref) != 0 || run_net(opt, true, out0, out1, clip) != 0)
+    {
+        fprintf(stderr, "test_elementwise_fusion run failed\n");
+        return -1;
+    }
+
+    if (compare_output(out0_ref, out0) != 0 || compare_output(out1_ref, out1) != 0 || compare_output(clip_ref, clip) != 0)
+    {
+        fprintf(stderr, "test_elementwise_fusion failed num_threads=%d use_packing_layout=%d lightmode=%d\n", opt.num_threads, opt.use_packing_layout, opt.lightmode);
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    ncnn::Option opts[3];
+
+    opts[0].num_threads = 1;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = false;
+
+    opts[2].num_threads = 2;
+    opts[2].lightmode = false;
+
+    for (int i = 0; i < 3; i++)
+    {
+        int ret = test_elementwise_fusion(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+static int test_gemm_weight_only(int M, int N, int K, float alpha, float beta, int broadcast_type_C, int output_N1M, int bits, int group_size)
+{
+    const int num_group = (K + group_size - 1) / group_size;
+    const int B_row_bytes = bits == 4 ? (K + 1) / 2 : K;
+
+    ncnn::ParamDict pd;
+    pd.set(0, alpha);
+    pd.set(1, beta);
+    pd.set(2, 0); // transA
+    pd.set(3, 1); // transB
+    pd.set(4, 0); // constantA
+    pd.set(5, 1); // constantB
+    pd.set(6, broadcast_type_C == -1 ? 0 : 1); // constantC
+    pd.set(7, M);
+    pd.set(8, N);
+    pd.set(9, K);
+    pd.set(10, broadcast_type_C);
+    pd.set(11, output_N1M);
+    pd.set(23, bits);
+    pd.set(24, group_size);
+
+    std::vector<ncnn::Mat> weights;
+    weights.push_back(RandomS8Mat(B_row_bytes, N));
+    if (broadcast_type_C == 0)
+        weights.push_back(RandomMat(1));
+    if (broadcast_type_C == 1 || broadcast_type_C == 2)
+        weights.push_back(RandomMat(M));
+    if (broadcast_type_C == 3)
+        weights.push_back(RandomMat(N, M));
+    if (broadcast_type_C == 4)
+        weights.push_back(RandomMat(N));
+    weights.push_back(RandomMat(num_group * N, 0.001f, 0.01f));
+
+    std::vector<ncnn::Mat> a(1);
+    a[0] = RandomMat(K, M);
+
+    int ret = test_layer("Gemm", pd, weights, a, 1, 0.001f, TEST_LAYER_DISABLE_GPU_TESTING);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_gemm_weight_only failed M=%d N=%d K=%d alpha=%f beta=%f broadcast_type_C=%d output_N1M=%d bits=%d group_size=%d\n", M, N, K, alpha, beta, broadcast_type_C, output_N1M, bits, group_size);
+    }
+
+    return ret;
+}
+
+static int test_gemm_0(int M, int N, int K, int group_size)
+{
+    return 0
+           || test_gemm_weight_only(M, N, K, 1.f, 1.f, 4, 0, 8, group_size)
+           || test_gemm_weight_only(M, N, K, 1.f, 1.f, 4, 0, 4, group_size)
+           || test_gemm_weight_only(M, N, K, 1.f, 1.f, -1, 0, 8, group_size)
+           || test_gemm_weight_only(M, N, K, 2.1f, 1.f, -1, 1, 4, group_size)
+           || test_gemm_weight_only(M, N, K, 0.5f, 0.3f, 0, 0, 4, group_size)
+           || test_gemm_weight_only(M, N, K, 1.f, 2.f, 1, 1, 8, group_size)
+           || test_gemm_weight_only(M, N, K, 1.f, 0.7f, 3, 0, 4, group_size)
+           || test_gemm_weight_only(M, N, K, 3.1f, 1.f, 4, 1, 8, group_size);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return 0
+           || test_gemm_0(1, 1, 2, 2)
+           || test_gemm_0(1, 16, 64, 32)
+           || test_gemm_0(1, 23, 45, 16)
+           || test_gemm_0(3, 17, 96, 64)
+           || test_gemm_0(4, 8, 33, 32)
+           || test_gemm_0(8, 32, 128, 32)
+           || test_gemm_0(13, 19, 71, 8)
+           || test_gemm_0(24, 40, 256, 128);
+}
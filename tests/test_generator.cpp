@@ -0,0 +1,274 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+#include "generator.h"
+#include "net.h"
+
+#include <float.h>
+
+// one attention block over token and position embeddings
+static const char* g_param = "7767517\n"
+                             "19 24\n"
+                             "Input ids 0 1 ids\n"
+                             "Input pos 0 1 pos\n"
+                             "Input mask 0 1 mask\n"
+                             "Input past_key 0 1 past_key\n"
+                             "Input past_value 0 1 past_value\n"
+                             "Embed tok 1 1 ids te 0=32 1=64 3=2048\n"
+                             "Embed pe 1 1 pos pp 0=32 1=128 3=4096\n"
+                             "BinaryOp add 2 1 te pp x 0=0\n"
+                             "Split split 1 4 x x0 x1 x2 x3\n"
+                             "InnerProduct q 1 1 x0 q0 0=32 2=1024\n"
+                             "InnerProduct k 1 1 x1 k0 0=32 2=1024\n"
+                             "InnerProduct v 1 1 x2 v0 0=32 2=1024\n"
+                             "Reshape rq 1 1 q0 q 0=32 1=-1 2=1\n"
+                             "Reshape rk 1 1 k0 k 0=32 1=-1 2=1\n"
+                             "Reshape rv 1 1 v0 v 0=32 1=-1 2=1\n"
+                             "SDPA sdpa 6 3 q k v mask past_key past_value a key value 5=1 7=1\n"
+                             "Reshape ra 1 1 a a2 0=32 1=-1\n"
+                             "BinaryOp res 2 1 a2 x3 h 0=0\n"
+                             "InnerProduct lm 1 1 h logits 0=64 2=2048\n";
+
+// greedy decoding that runs the whole sequence at every step without cache
+static std::vector<int> generate_reference(const ncnn::Net& net, std::vector<int> tokens, int max_new_tokens)
+{
+    std::vector<int> output;
+    for (int step = 0; step < max_new_tokens; step++)
+    {
+        const int seqlen = (int)tokens.size();
+
+        ncnn::Mat ids(seqlen, (size_t)4u);
+        ncnn::Mat pos(seqlen, (size_t)4u);
+        ncnn::Mat mask(seqlen, seqlen);
+        for (int i = 0; i < seqlen; i++)
+        {
+            ((int*)ids)[i] = tokens[i];
+            ((int*)pos)[i] = i;
+            for (int j = 0; j < seqlen; j++)
+            {
+                mask.row(i)[j] = j > i ? -FLT_MAX : 0.f;
+            }
+        }
+
+        ncnn::Mat logits;
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("ids", ids);
+        ex.input("pos", pos);
+        ex.input("mask", mask);
+        ex.input("past_key", ncnn::Mat());
+        ex.input("past_value", ncnn::Mat());
+        ex.extract("logits", logits);
+
+        const float* p = logits.row(seqlen - 1);
+        int token = 0;
+        for (int i = 1; i < logits.w; i++)
+        {
+            if (p[i] > p[token])
+                token = i;
+        }
+
+        tokens.push_back(token);
+        output.push_back(token);
+    }
+
+    return output;
+}
+
+static bool same_tokens(const std::vector<int>& a, const std::vector<int>& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i] != b[i])
+            return false;
+    }
+
+    return true;
+}
+
+static int test_generator(const ncnn::Option& opt)
+{
+    ncnn::Net net;
+    ncnn::Net draft_net;
+    net.opt = opt;
+    draft_net.opt = opt;
+    if (load_net_random(net, g_param) != 0 || load_net_random(draft_net, g_param, 1.f, 1234) != 0)
+        return -1;
+
+    std::vector<int> prompt;
+    prompt.push_back(3);
+    prompt.push_back(17);
+    prompt.push_back(42);
+    prompt.push_back(9);
+    prompt.push_back(60);
+
+    const std::vector<int> expect = generate_reference(net, prompt, 16);
+
+    ncnn::GenerateOption gopt;
+    gopt.max_new_tokens = 12;
+
+    // greedy with kv cache, then continue the conversation
+    {
+        ncnn::Generator generator;
+        generator.load(&net, "ids", "logits", "pos", "mask");
+
+        std::vector<int> output;
+        if (generator.generate(prompt, output, gopt) != 0)
+            return -1;
+
+        std::vector<int> expect12(expect.begin(), expect.begin() + 12);
+        if (!same_tokens(output, expect12) || generator.forward_count() != 12)
+        {
+            fprintf(stderr, "generator greedy mismatch\n");
+            return -1;
+        }
+
+        std::vector<int> turn;
+        turn.push_back(5);
+        turn.push_back(11);
+
+        std::vector<int> continued = generator.tokens();
+        continued.insert(continued.end(), turn.begin(), turn.end());
+        const std::vector<int> expect_turn = generate_reference(net, continued, 4);
+
+        std::vector<int> output_turn;
+        gopt.max_new_tokens = 4;
+        if (generator.generate(turn, output_turn, gopt) != 0 || !same_tokens(output_turn, expect_turn))
+        {
+            fprintf(stderr, "generator continued greedy mismatch\n");
+            return -1;
+        }
+        gopt.max_new_tokens = 12;
+    }
+
+    // speculative decoding yields the greedy tokens of the net alone
+    for (int i = 0; i < 2; i++)
+    {
+        ncnn::Generator generator;
+        generator.load(&net, "ids", "logits", "pos", "mask");
+        generator.load_draft(i == 0 ? &net : &draft_net, "ids", "logits", "pos", "mask");
+
+        for (int num_draft_tokens = 1; num_draft_tokens <= 5; num_draft_tokens += 2)
+        {
+            generator.clear();
+
+            gopt.num_draft_tokens = num_draft_tokens;
+            gopt.max_new_tokens = 16;
+
+            std::vector<int> output;
+            if (generator.generate(prompt, output, gopt) != 0)
+                return -1;
+
+            if (!same_tokens(output, expect))
+            {
+                fprintf(stderr, "generator speculative mismatch draft=%d num_draft_tokens=%d\n", i, num_draft_tokens);
+                return -1;
+            }
+
+            // the net drafting for itself gets every proposal accepted
+            if (i == 0 && generator.accept_count() != generator.draft_count())
+            {
+                fprintf(stderr, "generator self speculative accepted %d of %d\n", generator.accept_count(), generator.draft_count());
+                return -1;
+            }
+        }
+    }
+
+    // eos stops generation right after it
+    {
+        ncnn::Generator generator;
+        generator.load(&net, "ids", "logits", "pos", "mask");
+        generator.load_draft(&draft_net, "ids", "logits", "pos", "mask");
+
+        gopt.eos_token = expect[6];
+        gopt.num_draft_tokens = 4;
+
+        std::vector<int> output;
+        if (generator.generate(prompt, output, gopt) != 0 || output.empty() || output[output.size() - 1] != gopt.eos_token || output.size() > 7)
+        {
+            fprintf(stderr, "generator eos not honored\n");
+            return -1;
+        }
+
+        gopt.eos_token = -1;
+    }
+
+    // sampling is reproducible for a seed and stays in vocabulary
+    {
+        gopt.temperature = 0.8f;
+        gopt.top_k = 10;
+        gopt.top_p = 0.9f;
+        gopt.max_new_tokens = 20;
+
+        ncnn::Generator generator;
+        generator.load(&net, "ids", "logits", "pos", "mask");
+
+        std::vector<int> output0;
+        std::vector<int> output1;
+        generator.generate(prompt, output0, gopt);
+        generator.clear();
+        generator.generate(prompt, output1, gopt);
+
+        if (!same_tokens(output0, output1) || output0.size() != 20)
+        {
+            fprintf(stderr, "generator sampling not reproducible\n");
+            return -1;
+        }
+
+        generator.clear();
+        generator.load_draft(&draft_net, "ids", "logits", "pos", "mask");
+
+        std::vector<int> output2;
+        if (generator.generate(prompt, output2, gopt) != 0 || output2.size() != 20)
+        {
+            fprintf(stderr, "generator speculative sampling failed\n");
+            return -1;
+        }
+
+        for (size_t i = 0; i < output2.size(); i++)
+        {
+            if (output2[i] < 0 || output2[i] >= 64)
+            {
+                fprintf(stderr, "generator sampled token %d out of vocabulary\n", output2[i]);
+                return -1;
+            }
+        }
+
+        // top_k=1 is greedy
+        gopt.top_k = 1;
+        gopt.max_new_tokens = 16;
+        generator.clear();
+
+        std::vector<int> output3;
+        if (generator.generate(prompt, output3, gopt) != 0 || !same_tokens(output3, expect))
+        {
+            fprintf(stderr, "generator top_k=1 sampling differs from greedy\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    ncnn::Option opts[2];
+
+    opts[0].num_threads = 1;
+
+    opts[1].num_threads = 2;
+    opts[1].lightmode = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        int ret = test_generator(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
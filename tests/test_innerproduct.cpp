@@ -246,6 +246,57 @@ static int test_innerproduct_5()
 }
 #endif // NCNN_INT8
 
+static int test_innerproduct_weight_only(const ncnn::Mat& a, int outch, int bias, int bits, int group_size)
+{
+    const int num_input = a.dims == 2 ? a.w : a.w * a.h * a.c;
+    const int num_group = (num_input + group_size - 1) / group_size;
+
+    ncnn::ParamDict pd;
+    pd.set(0, outch);
+    pd.set(1, bias);
+    pd.set(2, outch * num_input);
+    pd.set(11, bits);
+    pd.set(12, group_size);
+
+    int activation_type = RAND() % 7;
+    ncnn::Mat activation_params(2);
+    activation_params[0] = (activation_type == 6) ? RandomFloat(0, 1) : RandomFloat(-1, 0); // alpha
+    activation_params[1] = RandomFloat(0, 1);
+    pd.set(9, activation_type);
+    pd.set(10, activation_params);
+
+    std::vector<ncnn::Mat> weights(bias ? 3 : 2);
+    weights[0] = RandomS8Mat(bits == 4 ? (num_input + 1) / 2 * outch : num_input * outch);
+    if (bias)
+        weights[1] = RandomMat(outch);
+    weights[bias ? 2 : 1] = RandomMat(num_group * outch, 0.001f, 0.01f);
+
+    int ret = test_layer("InnerProduct", pd, weights, a, 0.001f, TEST_LAYER_DISABLE_GPU_TESTING);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_innerproduct_weight_only failed a.dims=%d a=(%d %d %d) outch=%d bias=%d bits=%d group_size=%d act=%d actparams=[%f,%f]\n", a.dims, a.w, a.h, a.c, outch, bias, bits, group_size, activation_type, activation_params[0], activation_params[1]);
+    }
+
+    return ret;
+}
+
+static int test_innerproduct_6()
+{
+    return 0
+           || test_innerproduct_weight_only(RandomMat(64), 16, 1, 8, 32)
+           || test_innerproduct_weight_only(RandomMat(64), 16, 0, 4, 32)
+           || test_innerproduct_weight_only(RandomMat(35), 7, 1, 4, 16)
+           || test_innerproduct_weight_only(RandomMat(37), 9, 1, 8, 2)
+           || test_innerproduct_weight_only(RandomMat(5, 3, 6), 13, 1, 4, 16)
+           || test_innerproduct_weight_only(RandomMat(4, 4, 8), 24, 0, 8, 32)
+           || test_innerproduct_weight_only(RandomMat(131, 1), 20, 1, 4, 32)
+           || test_innerproduct_weight_only(RandomMat(96, 3), 17, 0, 8, 64)
+           || test_innerproduct_weight_only(RandomMat(51, 4), 12, 1, 4, 16)
+           || test_innerproduct_weight_only(RandomMat(128, 9), 33, 1, 8, 32)
+           || test_innerproduct_weight_only(RandomMat(67, 13), 8, 0, 4, 2)
+           || test_innerproduct_weight_only(RandomMat(256, 6), 40, 1, 4, 128);
+}
+
 int main()
 {
     SRAND(7767517);
@@ -257,12 +308,14 @@ int main()
            || test_innerproduct_2()
            || test_innerproduct_3()
            || test_innerproduct_4()
-           || test_innerproduct_5();
+           || test_innerproduct_5()
+           || test_innerproduct_6();
 #else
     return 0
            || test_innerproduct_0()
            || test_innerproduct_1()
            || test_innerproduct_2()
-           || test_innerproduct_4();
+           || test_innerproduct_4()
+           || test_innerproduct_6();
 #endif
 }
@@ -0,0 +1,380 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+#include "datareader.h"
+#include "kvcache.h"
+#include "net.h"
+
+static const char* g_param = "7767517\n"
+                             "6 8\n"
+                             "Input q 0 1 q\n"
+                             "Input k 0 1 k\n"
+                             "Input v 0 1 v\n"
+                             "Input past_key 0 1 past_key\n"
+                             "Input past_value 0 1 past_value\n"
+                             "SDPA sdpa 5 3 q k v past_key past_value out key value 7=1\n";
+
+static const char* g_param_paged = "7767517\n"
+                                   "7 7\n"
+                                   "Input q 0 1 q\n"
+                                   "Input k 0 1 k\n"
+                                   "Input v 0 1 v\n"
+                                   "Input key_pool 0 1 key_pool\n"
+                                   "Input value_pool 0 1 value_pool\n"
+                                   "Input block_table 0 1 block_table\n"
+                                   "SDPA sdpa 6 1 q k v key_pool value_pool block_table out 7=2\n";
+
+class DataReaderFromEmpty : public ncnn::DataReader
+{
+public:
+    virtual int scan(const char* format, void* p) const
+    {
+        return 0;
+    }
+    virtual size_t read(void* buf, size_t size) const
+    {
+        memset(buf, 0, size);
+        return size;
+    }
+};
+
+static int run_step(const ncnn::Net& net, const ncnn::Mat& past_key, const ncnn::Mat& past_value, int seqlen, ncnn::Mat& out, ncnn::Mat& key, ncnn::Mat& value)
+{
+    ncnn::Mat q = RandomMat(32, seqlen, 4);
+    ncnn::Mat k = RandomMat(32, seqlen, 2);
+    ncnn::Mat v = RandomMat(24, seqlen, 2);
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("q", q);
+    ex.input("k", k);
+    ex.input("v", v);
+    ex.input("past_key", past_key);
+    ex.input("past_value", past_value);
+    ex.extract("out", out);
+    ex.extract("key", key);
+    ex.extract("value", value);
+
+    // same step against plain blobs that have to be concatenated
+    ncnn::Mat out_ref;
+    ncnn::Mat key_ref;
+    ncnn::Mat value_ref;
+    {
+        ncnn::Extractor ex2 = net.create_extractor();
+        ex2.input("q", q);
+        ex2.input("k", k);
+        ex2.input("v", v);
+        ex2.input("past_key", past_key.clone());
+        ex2.input("past_value", past_value.clone());
+        ex2.extract("out", out_ref);
+        ex2.extract("key", key_ref);
+        ex2.extract("value", value_ref);
+    }
+
+    if (CompareMat(out, out_ref, 0.001) != 0 || CompareMat(key.clone(), key_ref, 0.001) != 0 || CompareMat(value.clone(), value_ref, 0.001) != 0)
+    {
+        fprintf(stderr, "kvcache step mismatch past_seqlen=%d seqlen=%d\n", past_key.h, seqlen);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_kvcache(const ncnn::Option& opt)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(g_param);
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+
+    ncnn::KVCache cache;
+    if (cache.reserve(32, 24, 2, 44) != 0)
+        return -1;
+
+    // prefill, then decode one token per step until the reserved capacity runs out
+    for (int i = 0; i < 8; i++)
+    {
+        const int seqlen = i == 0 ? 40 : 1;
+        const int capacity = cache.capacity;
+
+        ncnn::Mat out;
+        ncnn::Mat key;
+        ncnn::Mat value;
+        if (run_step(net, cache.key(), cache.value(), seqlen, out, key, value) != 0)
+            return -1;
+
+        const bool inplace = key.data == cache.key_storage.data && value.data == cache.value_storage.data;
+        if (inplace != (cache.seqlen + seqlen <= capacity))
+        {
+            fprintf(stderr, "kvcache expect inplace=%d at seqlen %d\n", (int)!inplace, cache.seqlen);
+            return -1;
+        }
+
+        if (cache.update(key, value) != 0 || cache.seqlen != key.h)
+            return -1;
+
+        if (cache.capacity < cache.seqlen || (!inplace && cache.capacity != capacity * 2))
+        {
+            fprintf(stderr, "kvcache capacity %d not grown for seqlen %d\n", cache.capacity, cache.seqlen);
+            return -1;
+        }
+    }
+
+    // roll back two tokens and continue in place
+    cache.truncate(cache.seqlen - 2);
+    {
+        ncnn::Mat out;
+        ncnn::Mat key;
+        ncnn::Mat value;
+        if (run_step(net, cache.key(), cache.value(), 3, out, key, value) != 0)
+            return -1;
+
+        if (key.data != cache.key_storage.data || key.h != 48)
+        {
+            fprintf(stderr, "kvcache truncated append not in place\n");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// one step of seq through the block pool, checked against plain concatenated blobs
+static int run_paged_step(const ncnn::Net& net, const ncnn::Net& net_paged, ncnn::PagedKVCache& cache, int seq, int seqlen, ncnn::Mat& past_key, ncnn::Mat& past_value)
+{
+    ncnn::Mat q = RandomMat(32, seqlen, 4);
+    ncnn::Mat k = RandomMat(32, seqlen, 2);
+    ncnn::Mat v = RandomMat(24, seqlen, 2);
+
+    ncnn::Mat block_table;
+    if (cache.prepare(seq, seqlen, block_table) != 0)
+    {
+        fprintf(stderr, "paged kvcache prepare failed\n");
+        return -1;
+    }
+
+    ncnn::Mat out;
+    {
+        ncnn::Extractor ex = net_paged.create_extractor();
+        ex.input("q", q);
+        ex.input("k", k);
+        ex.input("v", v);
+        ex.input("key_pool", cache.key_pool());
+        ex.input("value_pool", cache.value_pool());
+        ex.input("block_table", block_table);
+        ex.extract("out", out);
+    }
+
+    cache.advance(seq, seqlen);
+
+    ncnn::Mat out_ref;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("q", q);
+        ex.input("k", k);
+        ex.input("v", v);
+        ex.input("past_key", past_key);
+        ex.input("past_value", past_value);
+        ex.extract("out", out_ref);
+        ex.extract("key", past_key);
+        ex.extract("value", past_value);
+    }
+
+    if (CompareMat(out, out_ref, 0.001) != 0)
+    {
+        fprintf(stderr, "paged kvcache step mismatch seq=%d past_seqlen=%d seqlen=%d\n", seq, past_key.h - seqlen, seqlen);
+        return -1;
+    }
+
+    return 0;
+}
+
+// block tables that do not cover the tokens or point outside the pool are rejected
+static int test_paged_kvcache_invalid_table(const ncnn::Net& net_paged, const ncnn::PagedKVCache& cache)
+{
+    const int pool_block_count = cache.key_pool().h / cache.block_size();
+
+    // 20 new tokens need two blocks
+    const int tables[3][4] = {
+        {0, cache.block_size(), 0, -1},
+        {0, cache.block_size(), 0, pool_block_count},
+        {0, 0, 0, 1},
+    };
+    const int table_sizes[3] = {3, 4, 4};
+
+    for (int i = 0; i < 4; i++)
+    {
+        ncnn::Mat block_table;
+        if (i < 3)
+        {
+            block_table.create(table_sizes[i], (size_t)4u);
+            memcpy(block_table, tables[i], table_sizes[i] * sizeof(int));
+        }
+        else
+        {
+            // header only
+            block_table.create(1, (size_t)4u);
+            ((int*)block_table)[0] = 0;
+        }
+
+        ncnn::Extractor ex = net_paged.create_extractor();
+        ex.input("q", RandomMat(32, 20, 4));
+        ex.input("k", RandomMat(32, 20, 2));
+        ex.input("v", RandomMat(24, 20, 2));
+        ex.input("key_pool", cache.key_pool());
+        ex.input("value_pool", cache.value_pool());
+        ex.input("block_table", block_table);
+
+        ncnn::Mat out;
+        if (ex.extract("out", out) == 0)
+        {
+            fprintf(stderr, "paged kvcache invalid block table %d accepted\n", i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_paged_kvcache(const ncnn::Option& opt)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(g_param);
+
+    ncnn::Net net_paged;
+    net_paged.opt = opt;
+    net_paged.load_param_mem(g_param_paged);
+
+    DataReaderFromEmpty dr;
+    net.load_model(dr);
+    net_paged.load_model(dr);
+
+    ncnn::PagedKVCache cache;
+    if (cache.create(32, 24, 2, 16, 12) != 0)
+        return -1;
+
+    // shared prompt of 20 tokens fills one and a quarter blocks
+    const int prompt = cache.add_sequence();
+    ncnn::Mat prompt_key(32, 0, 2);
+    ncnn::Mat prompt_value(24, 0, 2);
+    if (run_paged_step(net, net_paged, cache, prompt, 20, prompt_key, prompt_value) != 0)
+        return -1;
+
+    ncnn::Mat past_keys[2];
+    ncnn::Mat past_values[2];
+    int seqs[2];
+    for (int i = 0; i < 2; i++)
+    {
+        seqs[i] = cache.fork_sequence(prompt);
+        past_keys[i] = prompt_key.clone();
+        past_values[i] = prompt_value.clone();
+    }
+
+    if (cache.free_block_count() != 10 || cache.seqlen(seqs[1]) != 20)
+    {
+        fprintf(stderr, "paged kvcache fork should share the prompt blocks\n");
+        return -1;
+    }
+
+    // the first append of each fork copies the shared tail block
+    for (int step = 0; step < 3; step++)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            if (run_paged_step(net, net_paged, cache, seqs[i], step == 0 ? 1 : 7, past_keys[i], past_values[i]) != 0)
+                return -1;
+        }
+    }
+
+    if (cache.free_block_count() != 6)
+    {
+        fprintf(stderr, "paged kvcache expect 6 free blocks but got %d\n", cache.free_block_count());
+        return -1;
+    }
+
+    // the prompt itself is untouched by its forks
+    if (run_paged_step(net, net_paged, cache, prompt, 2, prompt_key, prompt_value) != 0)
+        return -1;
+
+    // roll back and continue
+    cache.truncate(seqs[0], 16);
+    {
+        ncnn::Mat key(32, 16, 2);
+        ncnn::Mat value(24, 16, 2);
+        for (int q = 0; q < 2; q++)
+        {
+            memcpy(key.channel(q), past_keys[0].channel(q), 32 * 16 * sizeof(float));
+            memcpy(value.channel(q), past_values[0].channel(q), 24 * 16 * sizeof(float));
+        }
+        past_keys[0] = key;
+        past_values[0] = value;
+    }
+    if (run_paged_step(net, net_paged, cache, seqs[0], 5, past_keys[0], past_values[0]) != 0)
+        return -1;
+
+    // long prompt spans several query tiles and key blocks
+    {
+        const int seq = cache.add_sequence();
+        ncnn::Mat key(32, 0, 2);
+        ncnn::Mat value(24, 0, 2);
+        if (run_paged_step(net, net_paged, cache, seq, 40, key, value) != 0 || run_paged_step(net, net_paged, cache, seq, 3, key, value) != 0)
+            return -1;
+
+        cache.remove_sequence(seq);
+    }
+
+    // running out of blocks leaves the cache untouched, the shared tail included
+    {
+        const int seq = cache.fork_sequence(prompt);
+        const int free_block_count = cache.free_block_count();
+
+        ncnn::Mat block_table;
+        if (cache.prepare(seq, (free_block_count + 1) * cache.block_size(), block_table) == 0 || cache.free_block_count() != free_block_count || cache.seqlen(seq) != cache.seqlen(prompt))
+        {
+            fprintf(stderr, "paged kvcache prepare beyond capacity should fail without taking blocks\n");
+            return -1;
+        }
+
+        cache.remove_sequence(seq);
+    }
+
+    if (test_paged_kvcache_invalid_table(net_paged, cache) != 0)
+        return -1;
+
+    cache.remove_sequence(seqs[0]);
+    cache.remove_sequence(seqs[1]);
+    cache.remove_sequence(prompt);
+
+    if (cache.free_block_count() != 12)
+    {
+        fprintf(stderr, "paged kvcache blocks leaked\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    ncnn::Option opts[2];
+
+    opts[0].num_threads = 1;
+
+    opts[1].num_threads = 2;
+    opts[1].lightmode = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        int ret = test_kvcache(opts[i]) || test_paged_kvcache(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,178 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "datareader.h"
+#include "modelbin.h"
+
+static void append_u32(std::vector<unsigned char>& buf, unsigned int v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    buf.insert(buf.end(), p, p + 4);
+}
+
+static void append_f32(std::vector<unsigned char>& buf, float v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    buf.insert(buf.end(), p, p + 4);
+}
+
+static void append_u16(std::vector<unsigned char>& buf, unsigned short v)
+{
+    const unsigned char* p = (const unsigned char*)&v;
+    buf.insert(buf.end(), p, p + 2);
+}
+
+static void append_padding(std::vector<unsigned char>& buf)
+{
+    while (buf.size() % 4 != 0)
+        buf.push_back(0);
+}
+
+static int compare_weight(const ncnn::Mat& m, const float* expect, int w, const char* tag)
+{
+    if (m.empty() || m.w != w || m.elemsize != 4)
+    {
+        fprintf(stderr, "test_modelbin %s load failed\n", tag);
+        return -1;
+    }
+
+    for (int i = 0; i < w; i++)
+    {
+        if (m[i] != expect[i])
+        {
+            fprintf(stderr, "test_modelbin %s value mismatch at %d, expect %f but got %f\n", tag, i, expect[i], m[i]);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// load through memory with zero-copy reference and through stdio with plain read
+static int test_modelbin_load(const std::vector<unsigned char>& buf, int w, const float* expect, const char* tag)
+{
+    {
+        const unsigned char* mem = buf.data();
+        ncnn::DataReaderFromMemory dr(mem);
+        ncnn::ModelBinFromDataReader mb(dr);
+
+        ncnn::Mat m = mb.load(w, 0);
+        if (compare_weight(m, expect, w, tag) != 0)
+            return -1;
+
+        if (mem != buf.data() + buf.size())
+        {
+            fprintf(stderr, "test_modelbin %s consumed %d bytes, expect %d\n", tag, (int)(mem - buf.data()), (int)buf.size());
+            return -1;
+        }
+    }
+
+#if NCNN_STDIO
+    {
+        FILE* fp = tmpfile();
+        if (!fp)
+            return 0;
+
+        fwrite(buf.data(), 1, buf.size(), fp);
+        rewind(fp);
+
+        ncnn::DataReaderFromStdio dr(fp);
+        ncnn::ModelBinFromDataReader mb(dr);
+
+        ncnn::Mat m = mb.load(w, 0);
+        int ret = compare_weight(m, expect, w, tag);
+
+        if (ret == 0 && ftell(fp) != (long)buf.size())
+        {
+            fprintf(stderr, "test_modelbin %s stdio consumed %d bytes, expect %d\n", tag, (int)ftell(fp), (int)buf.size());
+            ret = -1;
+        }
+
+        fclose(fp);
+
+        if (ret != 0)
+            return -1;
+    }
+#endif // NCNN_STDIO
+
+    return 0;
+}
+
+static int test_modelbin_0()
+{
+    // fp16
+    std::vector<unsigned char> buf;
+    append_u32(buf, 0x01306B47);
+    append_u16(buf, 0x3C00);
+    append_u16(buf, 0xC000);
+    append_u16(buf, 0x3E00);
+    append_padding(buf);
+
+    const float expect[3] = {1.f, -2.f, 1.5f};
+    return test_modelbin_load(buf, 3, expect, "fp16");
+}
+
+static int test_modelbin_1()
+{
+    // fp8 e4m3 with scale 0.5
+    std::vector<unsigned char> buf;
+    append_u32(buf, 0x00E4F808);
+    append_f32(buf, 0.5f);
+    buf.push_back(0x38);
+    buf.push_back(0xC0);
+    buf.push_back(0x00);
+    buf.push_back(0x3C);
+    buf.push_back(0x77);
+    append_padding(buf);
+
+    const float expect[5] = {0.5f, -1.f, 0.f, 0.75f, 120.f};
+    return test_modelbin_load(buf, 5, expect, "fp8e4m3");
+}
+
+static int test_modelbin_2()
+{
+    // fp8 e5m2 with scale 2
+    std::vector<unsigned char> buf;
+    append_u32(buf, 0x00E5F808);
+    append_f32(buf, 2.f);
+    buf.push_back(0x3C);
+    buf.push_back(0xC0);
+    buf.push_back(0x3E);
+    append_padding(buf);
+
+    const float expect[3] = {2.f, -4.f, 3.f};
+    return test_modelbin_load(buf, 3, expect, "fp8e5m2");
+}
+
+static int test_modelbin_3()
+{
+    // int4 in groups of 2 with fp16 scales 1 0.5 2
+    std::vector<unsigned char> buf;
+    append_u32(buf, 0x0004B34D);
+    append_u32(buf, 2);
+    append_u16(buf, 0x3C00);
+    append_u16(buf, 0x3800);
+    append_u16(buf, 0x4000);
+    append_padding(buf);
+    buf.push_back(0x79); // 1 -1
+    buf.push_back(0x0F); // 7 -8
+    buf.push_back(0x0B); // 3
+    append_padding(buf);
+
+    const float expect[5] = {1.f, -1.f, 3.5f, -4.f, 6.f};
+    return test_modelbin_load(buf, 5, expect, "int4");
+}
+
+int main()
+{
+    return 0
+           || test_modelbin_0()
+           || test_modelbin_1()
+           || test_modelbin_2()
+           || test_modelbin_3();
+}
@@ -0,0 +1,160 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+static int test_moe(const ncnn::Mat& a, int num_expert, int top_k, int hidden_dim, int gated, int activation_type, int norm_topk_prob, int bias_term)
+{
+    const int embed_dim = a.w;
+    const int num_token = a.dims == 1 ? 1 : a.h;
+
+    ncnn::ParamDict pd;
+    pd.set(0, num_expert);
+    pd.set(1, top_k);
+    pd.set(2, embed_dim);
+    pd.set(3, hidden_dim);
+    pd.set(4, gated);
+    pd.set(5, activation_type);
+    pd.set(6, norm_topk_prob);
+    pd.set(7, bias_term);
+
+    ncnn::Mat activation_params(2);
+    activation_params[0] = (activation_type == 6) ? RandomFloat(0, 1) : RandomFloat(-1, 0); // alpha
+    activation_params[1] = RandomFloat(0, 1);                                               // beta
+    pd.set(8, activation_params);
+
+    std::vector<ncnn::Mat> weights;
+    weights.push_back(RandomMat(embed_dim * hidden_dim * num_expert));
+    if (gated)
+        weights.push_back(RandomMat(embed_dim * hidden_dim * num_expert));
+    weights.push_back(RandomMat(hidden_dim * embed_dim * num_expert));
+    if (bias_term)
+    {
+        weights.push_back(RandomMat(hidden_dim * num_expert));
+        if (gated)
+            weights.push_back(RandomMat(hidden_dim * num_expert));
+        weights.push_back(RandomMat(embed_dim * num_expert));
+    }
+
+    std::vector<ncnn::Mat> as(2);
+    as[0] = a;
+    as[1] = a.dims == 1 ? RandomMat(num_expert, -4.f, 4.f) : RandomMat(num_expert, num_token, -4.f, 4.f);
+
+    int ret = test_layer("MoE", pd, weights, as, 1);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_moe failed a.dims=%d a=(%d %d) num_expert=%d top_k=%d hidden_dim=%d gated=%d activation_type=%d actparams=[%f,%f] norm_topk_prob=%d bias_term=%d\n", a.dims, a.w, a.h, num_expert, top_k, hidden_dim, gated, activation_type, activation_params[0], activation_params[1], norm_topk_prob, bias_term);
+    }
+
+    return ret;
+}
+
+static int test_moe_0()
+{
+    return 0
+           || test_moe(RandomMat(16, 13), 4, 2, 24, 1, 7, 1, 0)
+           || test_moe(RandomMat(32, 7), 8, 2, 40, 1, 7, 0, 0)
+           || test_moe(RandomMat(12, 20), 6, 1, 16, 0, 1, 1, 1)
+           || test_moe(RandomMat(23, 9), 5, 3, 17, 1, 8, 1, 1)
+           || test_moe(RandomMat(20, 11), 4, 2, 12, 0, 2, 1, 0)
+           || test_moe(RandomMat(17, 6), 4, 1, 20, 1, 6, 0, 1)
+           || test_moe(RandomMat(48, 33), 16, 4, 32, 1, 7, 1, 0);
+}
+
+static int test_moe_1()
+{
+    return 0
+           || test_moe(RandomMat(16), 4, 2, 24, 1, 7, 1, 0)
+           || test_moe(RandomMat(35), 8, 2, 19, 0, 0, 0, 1)
+           || test_moe(RandomMat(64, 1), 8, 2, 48, 1, 7, 1, 0);
+}
+
+// lightmode releases the layer weights after create_pipeline, the experts must not keep views of them
+static int test_moe_lightmode(int gated, int bias_term)
+{
+    const int num_expert = 4;
+    const int top_k = 2;
+    const int embed_dim = 16;
+    const int hidden_dim = 24;
+    const int num_token = 9;
+
+    ncnn::ParamDict pd;
+    pd.set(0, num_expert);
+    pd.set(1, top_k);
+    pd.set(2, embed_dim);
+    pd.set(3, hidden_dim);
+    pd.set(4, gated);
+    pd.set(5, 1);
+    pd.set(7, bias_term);
+
+    std::vector<ncnn::Mat> weights;
+    weights.push_back(RandomMat(embed_dim * hidden_dim * num_expert));
+    if (gated)
+        weights.push_back(RandomMat(embed_dim * hidden_dim * num_expert));
+    weights.push_back(RandomMat(hidden_dim * embed_dim * num_expert));
+    if (bias_term)
+    {
+        weights.push_back(RandomMat(hidden_dim * num_expert));
+        if (gated)
+            weights.push_back(RandomMat(hidden_dim * num_expert));
+        weights.push_back(RandomMat(embed_dim * num_expert));
+    }
+
+    std::vector<ncnn::Mat> as(2);
+    as[0] = RandomMat(embed_dim, num_token);
+    as[1] = RandomMat(num_expert, num_token, -4.f, 4.f);
+
+    std::vector<ncnn::Mat> b;
+    if (test_layer_naive(ncnn::layer_to_index("MoE"), pd, weights, as, 1, b, 0) != 0)
+        return -1;
+
+    ncnn::Option opt;
+    opt.num_threads = 1;
+    opt.lightmode = true;
+
+    ncnn::Layer* op = ncnn::create_layer_cpu("MoE");
+    op->load_param(pd);
+    op->load_model(ncnn::ModelBinFromMatArray(weights.data()));
+
+    int ret = op->create_pipeline(opt);
+
+    // drop the test copies of the weights too and reuse the freed memory
+    weights.clear();
+    std::vector<ncnn::Mat> scrub;
+    for (int i = 0; i < 16; i++)
+    {
+        ncnn::Mat m(hidden_dim * num_expert);
+        m.fill(1e30f);
+        scrub.push_back(m);
+    }
+
+    std::vector<ncnn::Mat> c(1);
+    if (ret == 0)
+        ret = op->forward(as, c, opt);
+
+    op->destroy_pipeline(opt);
+    delete op;
+
+    if (ret != 0 || CompareMat(b, c, 0.001) != 0)
+    {
+        fprintf(stderr, "test_moe_lightmode failed gated=%d bias_term=%d\n", gated, bias_term);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_moe_2()
+{
+    return 0
+           || test_moe_lightmode(0, 1)
+           || test_moe_lightmode(1, 1)
+           || test_moe_lightmode(0, 0);
+}
+
+int main()
+{
+    SRAND(7767517);
+
+    return test_moe_0() || test_moe_1() || test_moe_2();
+}
@@ -0,0 +1,335 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "net.h"
+
+// run ncnnoptimize over small graphs and compare the outputs before and after folding
+struct OptimizeCase
+{
+    const char* name;
+    const char* param;
+
+    // weight sizes in load order, positive for tagged fp32 data, negative for raw fp32 data, 0 terminates
+    int weights[16];
+
+    int input_w;
+    int input_h;
+    int input_c;
+
+    // layer count left in the optimized param
+    int layer_count;
+
+    // optional param that must appear on the line of the named layer
+    const char* check_layer;
+    const char* check_param;
+};
+
+static const OptimizeCase g_cases[] = {
+    {"layernorm_innerproduct",
+     "7767517\n"
+     "6 8\n"
+     "Input in0 0 1 in0 0=16 1=4\n"
+     "LayerNorm ln 1 1 in0 ln 0=16 1=1e-5 2=1\n"
+     "Split sp 1 3 ln ln_0 ln_1 ln_2\n"
+     "InnerProduct ip0 1 1 ln_0 out0 0=8 1=1 2=128\n"
+     "InnerProduct ip1 1 1 ln_1 out1 0=4 1=0 2=64\n"
+     "Gemm gemm 1 1 ln_2 out2 0=0.5 1=2 3=1 5=1 6=1 8=8 9=16 10=4\n",
+     {-16, -16, 128, -8, 64, 128, 8, 0},
+     16, 4, 0,
+     6,
+     "ln", " 2=0"},
+
+    {"binaryop_scale_matmul",
+     "7767517\n"
+     "13 16\n"
+     "Input in0 0 1 in0 0=16 1=4\n"
+     "Split sp 1 4 in0 in0_0 in0_1 in0_2 in0_3\n"
+     "Gemm q 1 1 in0_0 q 0=0.5 1=2 3=1 5=1 6=1 8=8 9=16 10=4\n"
+     "BinaryOp qscale 1 1 q qs 0=2 1=1 2=0.25\n"
+     "InnerProduct k 1 1 in0_1 k 0=8 1=1 2=128\n"
+     "MatMul qk 2 1 qs k out0 0=1\n"
+     "InnerProduct v 1 1 in0_2 v 0=8 1=1 2=128 9=1\n"
+     "BinaryOp vscale 1 1 v vs 0=3 1=1 2=4\n"
+     "MemoryData m 0 1 m 0=5 1=8\n"
+     "MatMul vm 2 1 vs m out1\n"
+     "BinaryOp xscale 1 1 in0_3 xs 0=2 1=1 2=-0.5\n"
+     "MemoryData m2 0 1 m2 0=16 1=3\n"
+     "MatMul xm 2 1 xs m2 out2 0=1\n",
+     {128, 8, 128, -8, 128, -8, -40, -48, 0},
+     16, 4, 0,
+     10,
+     0, 0},
+
+    {"innerproduct_innerproduct",
+     "7767517\n"
+     "3 3\n"
+     "Input in0 0 1 in0 0=16\n"
+     "InnerProduct ip0 1 1 in0 a 0=8 1=1 2=128\n"
+     "InnerProduct ip1 1 1 a out0 0=4 1=1 2=32 9=1\n",
+     {128, -8, 32, -4, 0},
+     16, 0, 0,
+     2,
+     0, 0},
+
+    {"gemm_gemm",
+     "7767517\n"
+     "3 3\n"
+     "Input in0 0 1 in0 0=16 1=4\n"
+     "Gemm g0 1 1 in0 a 0=0.5 1=2 5=1 6=1 8=8 9=16 10=4\n"
+     "Gemm g1 1 1 a out0 0=1.5 1=0.5 3=1 5=1 6=1 8=4 9=8 10=0\n",
+     {128, 8, 32, 1, 0},
+     16, 4, 0,
+     2,
+     0, 0},
+
+    {"convolution_convolution1x1",
+     "7767517\n"
+     "3 3\n"
+     "Input in0 0 1 in0 0=7 1=6 2=3\n"
+     "Convolution c0 1 1 in0 a 0=8 1=3 4=1 5=1 6=216\n"
+     "Convolution c1 1 1 a out0 0=4 1=1 5=1 6=32\n",
+     {216, -8, 32, -4, 0},
+     7, 6, 3,
+     2,
+     0, 0},
+
+    {"constant_subgraph",
+     "7767517\n"
+     "6 6\n"
+     "Input in0 0 1 in0 0=16\n"
+     "MemoryData md 0 1 md 0=16\n"
+     "BinaryOp mul 1 1 md mds 0=2 1=1 2=3\n"
+     "InnerProduct ip 1 1 mds c 0=8 1=1 2=128\n"
+     "InnerProduct ip1 1 1 in0 a 0=8 1=1 2=128\n"
+     "BinaryOp add 2 1 a c out0 0=0\n",
+     {-16, 128, -8, 128, -8, 0},
+     16, 0, 0,
+     2,
+     0, 0},
+};
+
+static float random_value(unsigned int& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return ((int)((seed >> 8) % 2001) - 1000) / 1000.f;
+}
+
+static int write_case(const OptimizeCase& c, const std::string& parampath, const std::string& binpath)
+{
+    FILE* pp = fopen(parampath.c_str(), "wb");
+    if (!pp)
+        return -1;
+
+    fputs(c.param, pp);
+    fclose(pp);
+
+    FILE* bp = fopen(binpath.c_str(), "wb");
+    if (!bp)
+        return -1;
+
+    unsigned int seed = 7767517;
+    for (int i = 0; c.weights[i] != 0; i++)
+    {
+        if (c.weights[i] > 0)
+        {
+            // raw fp32 tag
+            const unsigned int tag = 0;
+            fwrite(&tag, sizeof(tag), 1, bp);
+        }
+
+        const int size = c.weights[i] > 0 ? c.weights[i] : -c.weights[i];
+        for (int j = 0; j < size; j++)
+        {
+            float v = random_value(seed);
+            fwrite(&v, sizeof(v), 1, bp);
+        }
+    }
+
+    fclose(bp);
+
+    return 0;
+}
+
+static int run_case(const OptimizeCase& c, const std::string& parampath, const std::string& binpath, std::vector<std::string>& output_names, std::vector<ncnn::Mat>& outputs)
+{
+    ncnn::Net net;
+    net.opt.use_packing_layout = false;
+    net.opt.use_fp16_packed = false;
+    net.opt.use_fp16_storage = false;
+    net.opt.use_fp16_arithmetic = false;
+    net.opt.use_bf16_storage = false;
+
+    if (net.load_param(parampath.c_str()) != 0 || net.load_model(binpath.c_str()) != 0)
+        return -1;
+
+    ncnn::Mat in;
+    if (c.input_c)
+        in.create(c.input_w, c.input_h, c.input_c);
+    else if (c.input_h)
+        in.create(c.input_w, c.input_h);
+    else
+        in.create(c.input_w);
+
+    unsigned int seed = 1;
+    for (int i = 0; i < c.input_c || i == 0; i++)
+    {
+        ncnn::Mat m = in.dims == 3 ? in.channel(i) : in;
+        for (int j = 0; j < m.w * m.h; j++)
+        {
+            m[j] = random_value(seed);
+        }
+    }
+
+    // the optimized net is queried with the original output names
+    if (output_names.empty())
+        output_names.assign(net.output_names().begin(), net.output_names().end());
+
+    outputs.clear();
+    for (size_t i = 0; i < output_names.size(); i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("in0", in);
+
+        ncnn::Mat out;
+        if (ex.extract(output_names[i].c_str(), out) != 0)
+            return -1;
+
+        outputs.push_back(out.clone());
+    }
+
+    return 0;
+}
+
+static int compare_output(const ncnn::Mat& a, const ncnn::Mat& b)
+{
+    if (a.dims != b.dims || a.w != b.w || a.h != b.h || a.c != b.c)
+        return -1;
+
+    for (int q = 0; q < a.c; q++)
+    {
+        const float* pa = a.channel(q);
+        const float* pb = b.channel(q);
+        for (int i = 0; i < a.w * a.h; i++)
+        {
+            if (fabs(pa[i] - pb[i]) > 1e-3f * (1.f + fabs(pa[i])))
+            {
+                fprintf(stderr, "value not match at c:%d i:%d expect %f but got %f\n", q, i, pa[i], pb[i]);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int check_optimized_param(const OptimizeCase& c, const std::string& parampath)
+{
+    FILE* fp = fopen(parampath.c_str(), "rb");
+    if (!fp)
+        return -1;
+
+    int magic = 0;
+    int layer_count = 0;
+    int blob_count = 0;
+    int nscan = fscanf(fp, "%d %d %d", &magic, &layer_count, &blob_count);
+    if (nscan != 3 || layer_count != c.layer_count)
+    {
+        fprintf(stderr, "test_ncnnoptimize %s expect %d layers but got %d\n", c.name, c.layer_count, layer_count);
+        fclose(fp);
+        return -1;
+    }
+
+    bool checked = c.check_layer == 0;
+
+    char line[1024];
+    while (!checked && fgets(line, sizeof(line), fp))
+    {
+        char layer_type[256];
+        char layer_name[256];
+        if (sscanf(line, "%255s %255s", layer_type, layer_name) != 2 || strcmp(layer_name, c.check_layer) != 0)
+            continue;
+
+        checked = strstr(line, c.check_param) != 0;
+        break;
+    }
+
+    fclose(fp);
+
+    if (!checked)
+    {
+        fprintf(stderr, "test_ncnnoptimize %s expect %s on layer %s\n", c.name, c.check_param, c.check_layer);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_ncnnoptimize(const OptimizeCase& c)
+{
+    const std::string prefix = std::string("test_ncnnoptimize_") + c.name;
+    const std::string parampath = prefix + ".param";
+    const std::string binpath = prefix + ".bin";
+    const std::string optparampath = prefix + "_opt.param";
+    const std::string optbinpath = prefix + "_opt.bin";
+
+    if (write_case(c, parampath, binpath) != 0)
+    {
+        fprintf(stderr, "test_ncnnoptimize %s write model failed\n", c.name);
+        return -1;
+    }
+
+    const std::string cmd = std::string("\"") + NCNNOPTIMIZE_EXECUTABLE + "\" " + parampath + " " + binpath + " " + optparampath + " " + optbinpath + " 0";
+    if (system(cmd.c_str()) != 0)
+    {
+        fprintf(stderr, "test_ncnnoptimize %s ncnnoptimize failed\n", c.name);
+        return -1;
+    }
+
+    if (check_optimized_param(c, optparampath) != 0)
+        return -1;
+
+    std::vector<std::string> output_names;
+    std::vector<ncnn::Mat> outputs_ref;
+    std::vector<ncnn::Mat> outputs;
+    if (run_case(c, parampath, binpath, output_names, outputs_ref) != 0 || run_case(c, optparampath, optbinpath, output_names, outputs) != 0)
+    {
+        fprintf(stderr, "test_ncnnoptimize %s run failed\n", c.name);
+        return -1;
+    }
+
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        if (compare_output(outputs_ref[i], outputs[i]) != 0)
+        {
+            fprintf(stderr, "test_ncnnoptimize %s output %d mismatch\n", c.name, (int)i);
+            return -1;
+        }
+    }
+
+    remove(parampath.c_str());
+    remove(binpath.c_str());
+    remove(optparampath.c_str());
+    remove(optbinpath.c_str());
+
+    return 0;
+}
+
+int main()
+{
+    for (size_t i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++)
+    {
+        int ret = test_ncnnoptimize(g_cases[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,232 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <stdio.h>
+#include <string.h>
+
+#include "benchmark.h"
+#include "datareader.h"
+#include "net.h"
+
+static const char* g_param = "7767517\n"
+                             "4 4\n"
+                             "Input data 0 1 data 0=8 1=8 2=4\n"
+                             "Convolution conv 1 1 data conv 0=8 1=3 4=1 5=1 6=288\n"
+                             "ReLU relu 1 1 conv relu\n"
+                             "InnerProduct fc 1 1 relu out 0=10 1=1 2=5120\n";
+
+// two convolution branches, the second one pinned to a single thread by featmask
+static const char* g_param_branch = "7767517\n"
+                                    "5 6\n"
+                                    "Input data 0 1 data 0=8 1=8 2=4\n"
+                                    "Split sp 1 2 data d0 d1\n"
+                                    "Convolution c0 1 1 d0 c0 0=8 1=3 4=1 5=1 6=288\n"
+                                    "Convolution c1 1 1 d1 c1 0=8 1=3 4=1 5=1 6=288 31=128\n"
+                                    "Concat cat 2 1 c0 c1 out 0=0\n";
+
+class DataReaderFromZero : public ncnn::DataReader
+{
+public:
+    virtual size_t read(void* buf, size_t size) const
+    {
+        memset(buf, 0, size);
+        return size;
+    }
+};
+
+static int count_lines(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+        return -1;
+
+    int lines = 0;
+    int ch;
+    while ((ch = fgetc(fp)) != EOF)
+    {
+        if (ch == '\n')
+            lines++;
+    }
+
+    fclose(fp);
+    return lines;
+}
+
+static int test_profiler(const ncnn::Option& opt)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(g_param);
+
+    DataReaderFromZero dr;
+    net.load_model(dr);
+
+    ncnn::Mat in(8, 8, 4);
+    in.fill(1.f);
+
+    ncnn::Profiler profiler;
+
+    {
+        ncnn::Mat out;
+        ncnn::Extractor ex = net.create_extractor();
+        ex.set_profiler(&profiler);
+        ex.input("data", in);
+        ex.extract("out", out);
+    }
+
+    const std::vector<ncnn::LayerProfile>& records = profiler.records();
+    if (records.size() != 3)
+    {
+        fprintf(stderr, "test_profiler expect 3 records but got %d\n", (int)records.size());
+        return -1;
+    }
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const ncnn::LayerProfile& p = records[i];
+        if (p.end < p.start || p.bottom_shapes.size() != 1 || p.top_shapes.size() != 1 || p.num_threads != opt.num_threads)
+        {
+            fprintf(stderr, "test_profiler record %d invalid\n", (int)i);
+            return -1;
+        }
+    }
+
+    const ncnn::LayerProfile& conv = records[0];
+    const ncnn::LayerProfile& relu = records[1];
+    const ncnn::LayerProfile& fc = records[2];
+    if (conv.name != "conv" || relu.type != "ReLU" || fc.layer_index != 3)
+    {
+        fprintf(stderr, "test_profiler layer order mismatch\n");
+        return -1;
+    }
+
+    const ncnn::Mat& conv_top = conv.top_shapes[0];
+    if (conv_top.dims != 3 || conv_top.w != 8 || conv_top.h != 8 || conv_top.c * conv_top.elempack != 8 || conv.bytes_allocated < 8 * 8 * 8 * conv_top.elemsize / conv_top.elempack)
+    {
+        fprintf(stderr, "test_profiler conv top shape mismatch\n");
+        return -1;
+    }
+
+    if (relu.bytes_allocated != 0)
+    {
+        fprintf(stderr, "test_profiler inplace relu should not allocate\n");
+        return -1;
+    }
+
+    if (profiler.save_csv("test_profiler.csv") != 0 || count_lines("test_profiler.csv") != 4)
+    {
+        fprintf(stderr, "test_profiler save_csv failed\n");
+        return -1;
+    }
+
+    // header, one event per line and the footer
+    if (profiler.save_chrome_trace("test_profiler.json") != 0 || count_lines("test_profiler.json") != 5)
+    {
+        fprintf(stderr, "test_profiler save_chrome_trace failed\n");
+        return -1;
+    }
+
+    remove("test_profiler.csv");
+    remove("test_profiler.json");
+
+    // recording stops without profiler
+    profiler.clear();
+    {
+        ncnn::Mat out;
+        ncnn::Extractor ex = net.create_extractor();
+        ex.input("data", in);
+        ex.extract("out", out);
+    }
+
+    if (!profiler.records().empty())
+    {
+        fprintf(stderr, "test_profiler recorded without profiler\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int test_profiler_branch_parallel(const ncnn::Option& opt)
+{
+    ncnn::Net net;
+    net.opt = opt;
+    net.load_param_mem(g_param_branch);
+
+    DataReaderFromZero dr;
+    net.load_model(dr);
+
+    ncnn::Mat in(8, 8, 4);
+    in.fill(1.f);
+
+    ncnn::Profiler profiler;
+
+    {
+        ncnn::Mat out;
+        ncnn::Extractor ex = net.create_extractor();
+        ex.set_profiler(&profiler);
+        ex.input("data", in);
+        ex.extract("out", out);
+    }
+
+    const std::vector<ncnn::LayerProfile>& records = profiler.records();
+    if (records.size() != 4)
+    {
+        fprintf(stderr, "test_profiler_branch_parallel expect 4 records but got %d\n", (int)records.size());
+        return -1;
+    }
+
+    // the thread count is the share the layer ran with, not the net option
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        const ncnn::LayerProfile& p = records[i];
+
+        int expect_max_threads = opt.num_threads;
+        if (p.name == "c1")
+            expect_max_threads = 1;
+
+        if (p.num_threads < 1 || p.num_threads > expect_max_threads)
+        {
+            fprintf(stderr, "test_profiler_branch_parallel %s num_threads %d\n", p.name.c_str(), p.num_threads);
+            return -1;
+        }
+
+        // split runs alone and keeps all threads
+        if (p.name == "sp" && p.num_threads != opt.num_threads)
+        {
+            fprintf(stderr, "test_profiler_branch_parallel sp num_threads %d\n", p.num_threads);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int main()
+{
+    ncnn::Option opts[2];
+
+    opts[0].num_threads = 1;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        int ret = test_profiler(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    {
+        ncnn::Option opt;
+        opt.num_threads = 4;
+        opt.use_branch_parallel = true;
+
+        int ret = test_profiler_branch_parallel(opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
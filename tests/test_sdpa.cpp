@@ -48,6 +48,15 @@ static int test_sdpa_0()
            || test_sdpa(RandomMat(28, 17, 15), RandomMat(28, 32, 5), RandomMat(11, 32, 5), 1, -0.4f);
 }
 
+static int test_sdpa_2()
+{
+    // long sequences across several key blocks
+    return 0
+           || test_sdpa(RandomMat(64, 200, 4), RandomMat(64, 333, 2), RandomMat(40, 333, 2), 1)
+           || test_sdpa(RandomMat(80, 257, 2), RandomMat(80, 600, 2), RandomMat(80, 600, 2), 0)
+           || test_sdpa(RandomMat(16, 33, 3), RandomMat(16, 1030, 1), RandomMat(7, 1030, 1), 1, 0.5f);
+}
+
 #if NCNN_INT8
 static int test_sdpa_int8(const ncnn::Mat& q, const ncnn::Mat& k, const ncnn::Mat& v, int attn_mask, float scale = 0.f)
 {
@@ -101,8 +110,8 @@ int main()
     SRAND(7767517);
 
 #if NCNN_INT8
-    return test_sdpa_0() || test_sdpa_1();
+    return test_sdpa_0() || test_sdpa_2() || test_sdpa_1();
 #else
-    return test_sdpa_0();
+    return test_sdpa_0() || test_sdpa_2();
 #endif
 }
@@ -200,6 +200,12 @@ static int test_squeezenet(const ncnn::Option& opt, int load_model_type, float e
         squeezenet.load_param((const unsigned char*)param_data);
         squeezenet.load_model((const unsigned char*)model_data);
     }
+    if (load_model_type == 4)
+    {
+        // load from mapped model file
+        squeezenet.load_param(MODEL_DIR "/squeezenet_v1.1.param");
+        squeezenet.load_model_mmap(MODEL_DIR "/squeezenet_v1.1.bin");
+    }
 
     ncnn::Mat in = generate_ncnn_logo(ncnn::Mat::PIXEL_BGR, 227, 227);
 
@@ -209,7 +215,7 @@ static int test_squeezenet(const ncnn::Option& opt, int load_model_type, float e
     ncnn::Extractor ex = squeezenet.create_extractor();
 
     ncnn::Mat out;
-    if (load_model_type == 0 || load_model_type == 1)
+    if (load_model_type == 0 || load_model_type == 1 || load_model_type == 4)
     {
         ex.input("data", in);
         ex.extract("prob", out);
@@ -505,5 +511,16 @@ int main()
 #endif // NCNN_VULKAN
     }
 
+    {
+        ncnn::Option opt_cpu = opts[0];
+        opt_cpu.use_vulkan_compute = false;
+        int ret = test_squeezenet(opt_cpu, 4, 0.01);
+        if (ret != 0)
+        {
+            fprintf(stderr, "test_squeezenet cpu load_model_mmap failed\n");
+            return ret;
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,227 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "testutil.h"
+
+#include <stdio.h>
+
+#include "layer.h"
+#include "net.h"
+
+static const char* g_param = "7767517\n"
+                             "8 8\n"
+                             "Input data 0 1 data 0=12 1=12 2=16\n"
+                             "Convolution conv0 1 1 data conv0 0=16 1=3 4=1 5=1 6=2304 9=1\n"
+                             "Convolution conv1 1 1 conv0 conv1 0=24 1=1 5=1 6=384\n"
+                             "Convolution conv2 1 1 conv1 conv2 0=8 1=3 3=2 5=1 6=1728\n"
+                             "InnerProduct fc 1 1 conv2 fc 0=10 1=1 2=2000\n"
+                             "Reshape reshape 1 1 fc fcr 0=10 1=1\n"
+                             "CacheProbe probe 1 1 fcr fcp\n"
+                             "Gemm gemm 1 1 fcp out 5=1 6=1 8=8 9=10 10=-1\n";
+
+static const char* g_cache_path = "test_weight_cache.ncnncache";
+
+// identity layer counting whether its pipeline was created or restored from the cache
+static int g_probe_create_count = 0;
+static int g_probe_restore_count = 0;
+
+class CacheProbe : public ncnn::Layer
+{
+public:
+    CacheProbe()
+    {
+        one_blob_only = true;
+        support_inplace = true;
+        pipeline_value = 0.f;
+    }
+
+    virtual int create_pipeline(const ncnn::Option& /*opt*/)
+    {
+        g_probe_create_count++;
+        pipeline_value = 42.f;
+        return 0;
+    }
+
+    virtual int save_pipeline_weights(std::vector<ncnn::Mat>& weights) const
+    {
+        ncnn::Mat m(1);
+        m[0] = pipeline_value;
+        weights.push_back(m);
+        return 0;
+    }
+
+    virtual int load_pipeline_weights(const std::vector<ncnn::Mat>& weights, const ncnn::Option& /*opt*/)
+    {
+        if (weights.size() != 1 || weights[0].w != 1 || weights[0][0] != 42.f)
+            return -1;
+
+        g_probe_restore_count++;
+        pipeline_value = weights[0][0];
+        return 0;
+    }
+
+    virtual int forward_inplace(ncnn::Mat& /*bottom_top_blob*/, const ncnn::Option& /*opt*/) const
+    {
+        return pipeline_value == 42.f ? 0 : -1;
+    }
+
+public:
+    float pipeline_value;
+};
+
+DEFINE_LAYER_CREATOR(CacheProbe)
+
+static int run_net(const ncnn::Option& opt, bool use_weight_cache, ncnn::Mat& out)
+{
+    ncnn::Net net;
+    net.opt = opt;
+
+    net.register_custom_layer("CacheProbe", CacheProbe_layer_creator);
+
+    if (use_weight_cache)
+        net.set_weight_cache(g_cache_path);
+
+    int ret = load_net_random(net, g_param, 0.25f);
+    if (ret != 0)
+        return ret;
+
+    ncnn::Mat in(12, 12, 16);
+    for (int i = 0; i < (int)in.total(); i++)
+    {
+        in[i] = (i % 17) / 17.f - 0.5f;
+    }
+
+    ncnn::Extractor ex = net.create_extractor();
+    ex.input("data", in);
+    ret = ex.extract("out", out);
+    if (ret != 0)
+        return ret;
+
+    out = out.clone();
+
+    return 0;
+}
+
+static int compare_output(const ncnn::Mat& a, const ncnn::Mat& b)
+{
+    if (a.w != b.w || a.h != b.h || a.c != b.c || a.total() != b.total())
+        return -1;
+
+    for (int i = 0; i < (int)a.total(); i++)
+    {
+        if (a[i] != b[i])
+            return -1;
+    }
+
+    return 0;
+}
+
+static int test_weight_cache(const ncnn::Option& opt)
+{
+    remove(g_cache_path);
+
+    ncnn::Mat out_ref;
+    int ret = run_net(opt, false, out_ref);
+    if (ret != 0)
+    {
+        fprintf(stderr, "test_weight_cache reference failed\n");
+        return -1;
+    }
+
+    // the first run writes the cache, the second one restores from it
+    for (int i = 0; i < 2; i++)
+    {
+        g_probe_create_count = 0;
+        g_probe_restore_count = 0;
+
+        ncnn::Mat out;
+        ret = run_net(opt, true, out);
+        if (ret != 0 || compare_output(out_ref, out) != 0)
+        {
+            fprintf(stderr, "test_weight_cache run %d failed num_threads=%d use_packing_layout=%d use_winograd_convolution=%d use_sgemm_convolution=%d\n", i, opt.num_threads, opt.use_packing_layout, opt.use_winograd_convolution, opt.use_sgemm_convolution);
+            return -1;
+        }
+
+        FILE* fp = fopen(g_cache_path, "rb");
+        if (!fp)
+        {
+            fprintf(stderr, "test_weight_cache cache file missing\n");
+            return -1;
+        }
+        fclose(fp);
+
+        const int expect_create_count = i == 0 ? 1 : 0;
+        const int expect_restore_count = i == 0 ? 0 : 1;
+        if (g_probe_create_count != expect_create_count || g_probe_restore_count != expect_restore_count)
+        {
+            fprintf(stderr, "test_weight_cache run %d created %d restored %d\n", i, g_probe_create_count, g_probe_restore_count);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int test_weight_cache_mismatch()
+{
+    ncnn::Option opt;
+    opt.num_threads = 1;
+
+    remove(g_cache_path);
+
+    ncnn::Mat out_ref;
+    if (run_net(opt, true, out_ref) != 0)
+        return -1;
+
+    // a cache written with different options must not be used
+    ncnn::Option opt2;
+    opt2.num_threads = 1;
+    opt2.use_winograd_convolution = false;
+    opt2.use_sgemm_convolution = false;
+
+    ncnn::Mat out_ref2;
+    if (run_net(opt2, false, out_ref2) != 0)
+        return -1;
+
+    g_probe_create_count = 0;
+    g_probe_restore_count = 0;
+
+    ncnn::Mat out2;
+    if (run_net(opt2, true, out2) != 0 || compare_output(out_ref2, out2) != 0 || g_probe_create_count != 1 || g_probe_restore_count != 0)
+    {
+        fprintf(stderr, "test_weight_cache_mismatch failed\n");
+        return -1;
+    }
+
+    remove(g_cache_path);
+
+    return 0;
+}
+
+int main()
+{
+    ncnn::Option opts[4];
+
+    opts[0].num_threads = 1;
+
+    opts[1].num_threads = 2;
+    opts[1].use_packing_layout = false;
+
+    opts[2].num_threads = 1;
+    opts[2].use_winograd_convolution = false;
+
+    opts[3].num_threads = 2;
+    opts[3].lightmode = false;
+    opts[3].use_sgemm_convolution = false;
+
+    for (int i = 0; i < 4; i++)
+    {
+        int ret = test_weight_cache(opts[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    remove(g_cache_path);
+
+    return test_weight_cache_mismatch();
+}
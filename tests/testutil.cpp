@@ -12,6 +12,7 @@
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if NCNN_VULKAN
 #include "command.h"
@@ -2239,3 +2240,34 @@ int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std:
 
     return 0;
 }
+
+DataReaderFromRandom::DataReaderFromRandom(float _scale, unsigned int _seed)
+    : scale(_scale), seed(_seed)
+{
+}
+
+size_t DataReaderFromRandom::read(void* buf, size_t size) const
+{
+    // the weight tags are random too, a nonzero tag reads the weight as
+    // a 256 entry lookup table plus indices, which still gives random values
+    float* p = (float*)buf;
+    for (size_t i = 0; i < size / 4; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        p[i] = ((int)((seed >> 8) % 2001) - 1000) / 1000.f * scale;
+    }
+
+    memset((unsigned char*)buf + size / 4 * 4, 0, size % 4);
+
+    return size;
+}
+
+int load_net_random(ncnn::Net& net, const char* param, float scale, unsigned int seed)
+{
+    int ret = net.load_param_mem(param);
+    if (ret != 0)
+        return ret;
+
+    DataReaderFromRandom dr(scale, seed);
+    return net.load_model(dr);
+}
@@ -5,8 +5,10 @@
 #define TESTUTIL_H
 
 #include "cpu.h"
+#include "datareader.h"
 #include "layer.h"
 #include "mat.h"
+#include "net.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -106,4 +108,22 @@ int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std:
 
 int test_layer_oom(const char* layer_type, const ncnn::ParamDict& pd, const std::vector<ncnn::Mat>& weights, const ncnn::Mat& a, int flag = 0);
 
+// net test
+
+// deterministic random weights in [-scale, scale] for Net::load_model
+class DataReaderFromRandom : public ncnn::DataReader
+{
+public:
+    DataReaderFromRandom(float scale = 1.f, unsigned int seed = 7767517);
+
+    virtual size_t read(void* buf, size_t size) const;
+
+public:
+    float scale;
+    mutable unsigned int seed;
+};
+
+// net.opt and custom layers are set up by the caller
+int load_net_random(ncnn::Net& net, const char* param, float scale = 1.f, unsigned int seed = 7767517);
+
 #endif // TESTUTIL_H
@@ -218,7 +218,7 @@ public:
     bool has_custom_layer;
 
 public:
-    // 0=fp32 1=fp16
+    // 0=fp32 1=fp16 2=fp8e4m3 3=fp8e5m2 4=int4
     int storage_type;
 
     int gen_random_weight;
@@ -239,6 +239,7 @@ public:
 
     int fwrite_weight_tag_data(const ncnn::Mat& data, FILE* bp, float a = -1.2f, float b = 1.2f);
     int fwrite_weight_data(const ncnn::Mat& data, FILE* bp, float a = -1.2f, float b = 1.2f);
+    int fwrite_weight_quant_scales(const ncnn::Mat& data, FILE* bp);
 
     int save(const char* parampath, const char* binpath);
 };
@@ -331,6 +332,9 @@ int ModelWriter::shape_inference()
         }
     }
 
+    // the passes changed the graph, recompile the execution plans
+    update_forward_plans();
+
     ncnn::Extractor ex = create_extractor();
     ex.set_light_mode(true);
 
@@ -455,6 +459,9 @@ int ModelWriter::estimate_memory_footprint()
 
     MemoryFootprintAllocator allocator;
 
+    // the passes changed the graph, recompile the execution plans
+    update_forward_plans();
+
     ncnn::Extractor ex = create_extractor();
     ex.set_light_mode(true);
 
@@ -606,6 +613,91 @@ static void Randomize(ncnn::Mat& m, float a = -1.2f, float b = 1.2f)
     }
 }
 
+static unsigned char float32_to_fp8(float v, int e5m2)
+{
+    const unsigned short fp16 = ncnn::float32_to_float16(v);
+    const unsigned char c = e5m2 ? ncnn::float16_to_bfloat8(fp16) : ncnn::float16_to_float8(fp16);
+
+    // conversion truncates the mantissa, round to the nearer of the two neighbour codes
+    const unsigned char c1 = c + 1;
+    if ((c1 & 0x7f) == 0)
+        return c;
+
+    const float v0 = ncnn::float16_to_float32(e5m2 ? ncnn::bfloat8_to_float16(c) : ncnn::float8_to_float16(c));
+    const float v1 = ncnn::float16_to_float32(e5m2 ? ncnn::bfloat8_to_float16(c1) : ncnn::float8_to_float16(c1));
+    if (v1 != v1 || fabsf(v1) > 65504.f)
+        return c;
+
+    return fabsf(v1 - v) < fabsf(v - v0) ? c1 : c;
+}
+
+static void fwrite_fp8_data(const ncnn::Mat& data, FILE* bp, int e5m2)
+{
+    const int tag = e5m2 ? 0x00E5F808 : 0x00E4F808; // fp8 magic
+    fwrite(&tag, sizeof(int), 1, bp);
+
+    const float* ptr = data;
+
+    float absmax = 0.f;
+    for (int i = 0; i < data.w; i++)
+    {
+        absmax = std::max(absmax, fabsf(ptr[i]));
+    }
+
+    // map absmax to the largest finite value, 240 for e4m3 without infinity and 57344 for e5m2
+    const float scale = absmax == 0.f ? 1.f : absmax / (e5m2 ? 57344.f : 240.f);
+    fwrite(&scale, sizeof(float), 1, bp);
+
+    std::vector<unsigned char> fp8_data(data.w);
+    for (int i = 0; i < data.w; i++)
+    {
+        fp8_data[i] = float32_to_fp8(ptr[i] / scale, e5m2);
+    }
+    fwrite(fp8_data.data(), sizeof(unsigned char), data.w, bp);
+}
+
+static void fwrite_int4_data(const ncnn::Mat& data, FILE* bp)
+{
+    const int tag = 0x0004B34D; // int4 magic
+    fwrite(&tag, sizeof(int), 1, bp);
+
+    const int group_size = 32;
+    fwrite(&group_size, sizeof(int), 1, bp);
+
+    const int group_count = (data.w + group_size - 1) / group_size;
+
+    const float* ptr = data;
+
+    std::vector<unsigned short> scales(alignSize(group_count, 2), 0);
+    std::vector<unsigned char> int4_data((data.w + 1) / 2, 0);
+    for (int g = 0; g < group_count; g++)
+    {
+        const int i0 = g * group_size;
+        const int i1 = std::min(i0 + group_size, data.w);
+
+        float absmax = 0.f;
+        for (int i = i0; i < i1; i++)
+        {
+            absmax = std::max(absmax, fabsf(ptr[i]));
+        }
+
+        // quantize against the stored fp16 scale so that decoding reproduces the same values
+        scales[g] = ncnn::float32_to_float16(absmax / 7.f);
+        const float scale = ncnn::float16_to_float32(scales[g]);
+
+        for (int i = i0; i < i1; i++)
+        {
+            int q = scale == 0.f ? 0 : (int)roundf(ptr[i] / scale);
+            q = std::min(std::max(q, -8), 7);
+
+            int4_data[i / 2] |= (unsigned char)((q + 8) << (i % 2 * 4));
+        }
+    }
+
+    fwrite(scales.data(), sizeof(unsigned short), scales.size(), bp);
+    fwrite(int4_data.data(), sizeof(unsigned char), int4_data.size(), bp);
+}
+
 int ModelWriter::fwrite_weight_tag_data(const ncnn::Mat& data, FILE* bp, float a, float b)
 {
     int p0 = ftell(bp);
@@ -624,6 +716,14 @@ int ModelWriter::fwrite_weight_tag_data(const ncnn::Mat& data, FILE* bp, float a
             ncnn::cast_float32_to_float16(data_flattened, data_flattened_fp16);
             fwrite(data_flattened_fp16.data, data_flattened_fp16.elemsize, data_flattened_fp16.w, bp);
         }
+        else if (storage_type == 2 || storage_type == 3)
+        {
+            fwrite_fp8_data(data_flattened, bp, storage_type == 3);
+        }
+        else if (storage_type == 4)
+        {
+            fwrite_int4_data(data_flattened, bp);
+        }
         else
         {
             const int tag = 0; // fp32 magic
@@ -682,6 +782,33 @@ int ModelWriter::fwrite_weight_data(const ncnn::Mat& data, FILE* bp, float a, fl
     return 0;
 }
 
+int ModelWriter::fwrite_weight_quant_scales(const ncnn::Mat& data, FILE* bp)
+{
+    // scales below the fp16 normal range would lose precision, keep them fp32
+    // fp8 and int4 are for weights only, scales are written as fp16
+    const int storage_type_saved = storage_type;
+    if (storage_type > 1)
+        storage_type = 1;
+    if (data.elemsize == 4)
+    {
+        const float* p = data;
+        for (size_t i = 0; i < data.total(); i++)
+        {
+            if (p[i] != 0.f && fabsf(p[i]) < 6.1036e-05f)
+            {
+                storage_type = 0;
+                break;
+            }
+        }
+    }
+
+    int ret = fwrite_weight_tag_data(data, bp, 0.001f, 0.01f);
+
+    storage_type = storage_type_saved;
+
+    return ret;
+}
+
 int ModelWriter::save(const char* parampath, const char* binpath)
 {
     uint64_t mac = 0;
@@ -1786,6 +1913,8 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 20=%d", constant_TILE_M)
             fprintf_param_value(" 21=%d", constant_TILE_N)
             fprintf_param_value(" 22=%d", constant_TILE_K)
+            fprintf_param_value(" 23=%d", weight_quant_bits)
+            fprintf_param_value(" 24=%d", weight_quant_group_size)
 
             if (op->constantA == 1)
             {
@@ -1799,6 +1928,10 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             {
                 fwrite_weight_tag_data(op->C_data, bp);
             }
+            if (op->weight_quant_bits)
+            {
+                fwrite_weight_quant_scales(op->B_data_quant_scales, bp);
+            }
 
 #if NCNN_INT8
             // write int8_scale data
@@ -1899,10 +2032,17 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             {
                 if (!op->activation_params.empty()) fprintf_param_float_array(10, op->activation_params, pp);
             }
+            fprintf_param_value(" 11=%d", weight_quant_bits)
+            fprintf_param_value(" 12=%d", weight_quant_group_size)
 
             fwrite_weight_tag_data(op->weight_data, bp);
             fwrite_weight_data(op->bias_data, bp);
 
+            if (op->weight_quant_bits)
+            {
+                fwrite_weight_quant_scales(op->weight_data_quant_scales, bp);
+            }
+
 #if NCNN_INT8
             // write int8_scale data
             if (op->int8_scale_term)
@@ -1940,8 +2080,11 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 1=%e", eps)
             fprintf_param_value(" 2=%d", affine)
 
-            fwrite_weight_data(op->gamma_data, bp);
-            fwrite_weight_data(op->beta_data, bp);
+            if (op->affine)
+            {
+                fwrite_weight_data(op->gamma_data, bp);
+                fwrite_weight_data(op->beta_data, bp);
+            }
         }
         else if (layer->type == "Interp")
         {
@@ -1968,8 +2111,11 @@ int ModelWriter::save(const char* parampath, const char* binpath)
             fprintf_param_value(" 1=%e", eps)
             fprintf_param_value(" 2=%d", affine)
 
-            fwrite_weight_data(op->gamma_data, bp);
-            fwrite_weight_data(op->beta_data, bp);
+            if (op->affine)
+            {
+                fwrite_weight_data(op->gamma_data, bp);
+                fwrite_weight_data(op->beta_data, bp);
+            }
         }
         else if (layer->type == "Log")
         {
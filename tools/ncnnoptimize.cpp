@@ -60,6 +60,11 @@ public:
     int fuse_innerproduct_activation();
     int fuse_memorydata_binaryop();
     int fuse_binaryop_eltwise();
+    int fuse_layernorm_innerproduct();
+    int fuse_binaryop_scale_matmul();
+    int fuse_innerproduct_innerproduct();
+    int fuse_gemm_gemm();
+    int fuse_convolution_convolution1x1();
 
     int eliminate_dropout();
     int eliminate_pooling1x1();
@@ -75,6 +80,11 @@ public:
     int replace_prelu_with_leaky_relu();
     int replace_convolution_with_innerproduct_after_global_pooling();
     int replace_convolution_with_innerproduct_after_innerproduct();
+
+    int fold_constant_subgraph();
+
+protected:
+    int count_blob_consumers(int blob_index) const;
 };
 
 NetOptimize::NetOptimize()
@@ -82,6 +92,24 @@ NetOptimize::NetOptimize()
 {
 }
 
+int NetOptimize::count_blob_consumers(int blob_index) const
+{
+    int count = 0;
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->type == "ncnnfused")
+            continue;
+
+        for (size_t j = 0; j < layers[i]->bottoms.size(); j++)
+        {
+            if (layers[i]->bottoms[j] == blob_index)
+                count++;
+        }
+    }
+
+    return count;
+}
+
 int NetOptimize::fuse_batchnorm_scale()
 {
     const size_t layer_count = layers.size();
@@ -2036,266 +2064,1252 @@ int NetOptimize::fuse_binaryop_eltwise()
     return 0;
 }
 
-int NetOptimize::eliminate_dropout()
+// Gemm with constant B over a single dynamic A, and at most a per-N constant C
+static bool is_linear_gemm(const ncnn::Gemm* gemm)
 {
-    const size_t layer_count = layers.size();
-    for (size_t i = 0; i < layer_count; i++)
-    {
-        if (layers[i]->type != "Dropout")
-            continue;
+    if (gemm->bottoms.size() != 1 || gemm->constantA != 0 || gemm->constantB != 1 || gemm->transA != 0)
+        return false;
 
-        ncnn::Dropout* dropout = (ncnn::Dropout*)layers[i];
-        if (dropout->scale != 1.f)
-            continue;
+    if (gemm->int8_scale_term || gemm->weight_quant_bits || gemm->B_data.elemsize != 4)
+        return false;
 
-        // Any - Dropout
-        int bottom_blob_index = layers[i]->bottoms[0];
+    if (gemm->constantC == 1 && gemm->constant_broadcast_type_C != -1 && gemm->constant_broadcast_type_C != 0 && gemm->constant_broadcast_type_C != 4)
+        return false;
 
-        int j = i - 1;
-        for (; j >= 0; j--)
-        {
-            if (layers[j]->type == "ncnnfused")
-                continue;
+    return true;
+}
 
-            if (layers[j]->tops.size() != 1)
-                continue;
+// alpha * beta * C broadcast to N, gemm computes alpha * (A * B + beta * C)
+static std::vector<float> get_gemm_bias(const ncnn::Gemm* gemm)
+{
+    const int N = gemm->constantN;
 
-            if (layers[j]->tops[0] == bottom_blob_index)
-                break;
+    std::vector<float> bias(N, 0.f);
+    if (gemm->constantC == 1 && gemm->constant_broadcast_type_C == 0)
+    {
+        for (int n = 0; n < N; n++)
+        {
+            bias[n] = gemm->alpha * gemm->beta * gemm->C_data[0];
+        }
+    }
+    if (gemm->constantC == 1 && gemm->constant_broadcast_type_C == 4)
+    {
+        for (int n = 0; n < N; n++)
+        {
+            bias[n] = gemm->alpha * gemm->beta * gemm->C_data[n];
         }
-
-        if (j == -1)
-            continue;
-
-        ncnn::Layer* any = layers[j];
-
-        fprintf(stderr, "eliminate_dropout %s %s\n", any->name.c_str(), dropout->name.c_str());
-
-        int top_blob_index_final = dropout->tops[0];
-        any->tops[0] = top_blob_index_final;
-        blobs[top_blob_index_final].producer = j;
-        dropout->type = "ncnnfused";
     }
 
-    return 0;
+    return bias;
 }
 
-int NetOptimize::eliminate_pooling1x1()
+// B element at row k column n
+static float get_gemm_B(const ncnn::Gemm* gemm, int k, int n)
+{
+    const float* B = gemm->B_data;
+    return gemm->transB ? B[gemm->constantK * n + k] : B[gemm->constantN * k + n];
+}
+
+int NetOptimize::fuse_layernorm_innerproduct()
 {
     const size_t layer_count = layers.size();
     for (size_t i = 0; i < layer_count; i++)
     {
-        if (layers[i]->type != "Pooling")
-            continue;
-
-        ncnn::Pooling* pooling = (ncnn::Pooling*)layers[i];
-        if (pooling->pad_left != 0 || pooling->pad_right != 0 || pooling->pad_top != 0 || pooling->pad_bottom != 0)
+        if (layers[i]->type != "LayerNorm")
             continue;
 
-        if (pooling->kernel_w != 1 || pooling->kernel_h != 1 || pooling->stride_w != 1 || pooling->stride_h != 1)
+        ncnn::LayerNorm* layernorm = (ncnn::LayerNorm*)layers[i];
+        if (layernorm->affine == 0)
             continue;
 
-        if (pooling->global_pooling != 0)
-            continue;
+        // LayerNorm - InnerProduct
+        // LayerNorm - Split - InnerProduct InnerProduct ...
+        // LayerNorm - Gemm, pnnx emits Gemm for Linear over sequence inputs
+        std::vector<int> blob_indexes(1, layernorm->tops[0]);
 
-        // Any - Pooling
-        int bottom_blob_index = layers[i]->bottoms[0];
+        size_t split_index = i;
+        for (size_t j = i + 1; j < layer_count; j++)
+        {
+            if (layers[j]->type == "Split" && layers[j]->bottoms[0] == layernorm->tops[0])
+            {
+                blob_indexes.insert(blob_indexes.end(), layers[j]->tops.begin(), layers[j]->tops.end());
+                split_index = j;
+                break;
+            }
+        }
 
-        int top_i = -1;
-        int j = i - 1;
-        for (; j >= 0; j--)
+        std::vector<ncnn::Layer*> consumers;
+        bool all_linear = true;
+        for (size_t j = i + 1; j < layer_count; j++)
         {
-            if (layers[j]->type == "ncnnfused")
+            if (layers[j]->type == "ncnnfused" || j == split_index)
                 continue;
 
-            for (size_t k = 0; k < layers[j]->tops.size(); k++)
+            for (size_t k = 0; k < layers[j]->bottoms.size(); k++)
             {
-                if (layers[j]->tops[k] == bottom_blob_index)
+                if (std::find(blob_indexes.begin(), blob_indexes.end(), layers[j]->bottoms[k]) == blob_indexes.end())
+                    continue;
+
+                if (layers[j]->type == "InnerProduct")
                 {
-                    top_i = k;
+                    ncnn::InnerProduct* innerproduct = (ncnn::InnerProduct*)layers[j];
+                    if (innerproduct->int8_scale_term || innerproduct->weight_quant_bits || innerproduct->weight_data_size != innerproduct->num_output * layernorm->affine_size)
+                    {
+                        all_linear = false;
+                        break;
+                    }
+                }
+                else if (layers[j]->type == "Gemm")
+                {
+                    ncnn::Gemm* gemm = (ncnn::Gemm*)layers[j];
+                    if (!is_linear_gemm(gemm) || gemm->constantK != layernorm->affine_size)
+                    {
+                        all_linear = false;
+                        break;
+                    }
+                }
+                else
+                {
+                    all_linear = false;
                     break;
                 }
+
+                consumers.push_back(layers[j]);
             }
 
-            if (top_i != -1)
+            if (!all_linear)
                 break;
         }
 
-        if (j == -1)
+        if (!all_linear || consumers.empty())
             continue;
 
-        ncnn::Layer* any = layers[j];
-
-        fprintf(stderr, "eliminate_pooling1x1 %s %s\n", any->name.c_str(), pooling->name.c_str());
+        // fuse LayerNorm affine into InnerProduct and Gemm
+        const int num_input = layernorm->affine_size;
+        const float* gamma = layernorm->gamma_data;
+        const float* beta = layernorm->beta_data;
 
-        int top_blob_index_final = pooling->tops[0];
-        any->tops[top_i] = top_blob_index_final;
-        blobs[top_blob_index_final].producer = j;
-        pooling->type = "ncnnfused";
-    }
+        for (size_t j = 0; j < consumers.size(); j++)
+        {
+            fprintf(stderr, "fuse_layernorm_innerproduct %s %s\n", layernorm->name.c_str(), consumers[j]->name.c_str());
 
-    return 0;
-}
+            if (consumers[j]->type == "Gemm")
+            {
+                ncnn::Gemm* gemm = (ncnn::Gemm*)consumers[j];
 
-int NetOptimize::eliminate_noop()
-{
-    const size_t layer_count = layers.size();
-    for (size_t i = 0; i < layer_count; i++)
-    {
-        if (layers[i]->type != "Noop")
-            continue;
+                const int N = gemm->constantN;
 
-        ncnn::Layer* noop = layers[i];
+                // alpha * ((gamma * x + beta) * B + b * C) = alpha * (x * (gamma * B) + (beta * B + b * C))
+                ncnn::Mat C_data(N, 1);
+                for (int n = 0; n < N; n++)
+                {
+                    float sum = 0.f;
+                    if (gemm->constantC == 1 && gemm->constant_broadcast_type_C == 0)
+                        sum = gemm->beta * gemm->C_data[0];
+                    if (gemm->constantC == 1 && gemm->constant_broadcast_type_C == 4)
+                        sum = gemm->beta * gemm->C_data[n];
+
+                    for (int k = 0; k < num_input; k++)
+                    {
+                        sum += beta[k] * get_gemm_B(gemm, k, n);
+                    }
+
+                    C_data[n] = sum;
+                }
 
-        if (noop->bottoms.empty())
-        {
-            // Noop
-            fprintf(stderr, "eliminate_noop %s\n", noop->name.c_str());
+                float* B = gemm->B_data;
+                for (int n = 0; n < N; n++)
+                {
+                    for (int k = 0; k < num_input; k++)
+                    {
+                        B[gemm->transB ? num_input * n + k : N * k + n] *= gamma[k];
+                    }
+                }
 
-            size_t top_blob_count = noop->tops.size();
-            for (size_t j = 0; j < top_blob_count; j++)
-            {
-                int top_blob_index_final = noop->tops[j];
-                blobs[top_blob_index_final].producer = -1;
+                gemm->beta = 1.f;
+                gemm->constantC = 1;
+                gemm->constant_broadcast_type_C = 4;
+                gemm->C_data = C_data;
+                continue;
             }
-            noop->type = "ncnnfused";
 
-            continue;
-        }
+            ncnn::InnerProduct* innerproduct = (ncnn::InnerProduct*)consumers[j];
 
-        // Any - Noop
-        int bottom_blob_index = noop->bottoms[0];
+            const int num_output = innerproduct->num_output;
 
-        int j = i - 1;
-        int any_k = -1;
-        for (; j >= 0; j--)
-        {
-            if (layers[j]->type == "ncnnfused")
-                continue;
+            // W * (gamma * x + beta) + b = (W * gamma) * x + (W * beta + b)
+            ncnn::Mat bias_data(num_output);
+            for (int p = 0; p < num_output; p++)
+            {
+                const float* weight = (const float*)innerproduct->weight_data + num_input * p;
 
-            bool link_noop = false;
-            size_t top_blob_count = layers[j]->tops.size();
-            for (size_t k = 0; k < top_blob_count; k++)
+                float sum = innerproduct->bias_term ? innerproduct->bias_data[p] : 0.f;
+                for (int q = 0; q < num_input; q++)
+                {
+                    sum += weight[q] * beta[q];
+                }
+
+                bias_data[p] = sum;
+            }
+
+            for (int p = 0; p < num_output; p++)
             {
-                if (layers[j]->tops[k] == bottom_blob_index)
+                float* weight = (float*)innerproduct->weight_data + num_input * p;
+                for (int q = 0; q < num_input; q++)
                 {
-                    link_noop = true;
-                    any_k = k;
-                    break;
+                    weight[q] *= gamma[q];
                 }
             }
 
-            if (link_noop)
-                break;
+            innerproduct->bias_term = 1;
+            innerproduct->bias_data = bias_data;
         }
 
-        if (j == -1 || any_k == -1)
-            continue;
-
-        ncnn::Layer* any = layers[j];
-
-        fprintf(stderr, "eliminate_noop %s %s\n", any->name.c_str(), noop->name.c_str());
-
-        int top_blob_index_final = noop->tops[0];
-        any->tops[any_k] = top_blob_index_final;
-        blobs[top_blob_index_final].producer = j;
-
-        noop->type = "ncnnfused";
+        layernorm->affine = 0;
+        layernorm->gamma_data.release();
+        layernorm->beta_data.release();
     }
 
     return 0;
 }
 
-int NetOptimize::eliminate_split()
+int NetOptimize::fuse_binaryop_scale_matmul()
 {
     const size_t layer_count = layers.size();
     for (size_t i = 0; i < layer_count; i++)
     {
-        if (layers[i]->type != "Split")
+        if (layers[i]->type != "BinaryOp")
             continue;
 
-        ncnn::Layer* split = layers[i];
+        ncnn::BinaryOp* binaryop = (ncnn::BinaryOp*)layers[i];
+        if (binaryop->with_scalar == 0 || binaryop->bottoms.size() != 1)
+            continue;
 
-        int real_split_output_count = 0;
-        int real_split_top_blob_index = -1;
-        size_t top_blob_count = split->tops.size();
-        for (size_t j = 0; j < top_blob_count; j++)
+        if (binaryop->op_type != ncnn::BinaryOp::Operation_MUL && binaryop->op_type != ncnn::BinaryOp::Operation_DIV)
+            continue;
+
+        if (binaryop->op_type == ncnn::BinaryOp::Operation_DIV && binaryop->b == 0.f)
+            continue;
+
+        // BinaryOp - MatMul
+        int top_blob_index = binaryop->tops[0];
+
+        size_t j = i + 1;
+        for (; j < layer_count; j++)
         {
-            int top_blob_index_final = split->tops[j];
-            if (blobs[top_blob_index_final].consumer != -1)
-            {
-                real_split_output_count += 1;
-                real_split_top_blob_index = j;
-            }
+            if (layers[j]->type != "MatMul")
+                continue;
+
+            if (layers[j]->bottoms.size() != 2)
+                continue;
+
+            if (layers[j]->bottoms[0] == top_blob_index || layers[j]->bottoms[1] == top_blob_index)
+                break;
         }
 
-        if (real_split_output_count > 1)
+        if (j == layer_count)
             continue;
 
-        // Any - Pooling
-        int bottom_blob_index = split->bottoms[0];
+        if (count_blob_consumers(top_blob_index) != 1)
+            continue;
 
-        int top_i = -1;
-        int j = i - 1;
-        for (; j >= 0; j--)
+        ncnn::Layer* matmul = layers[j];
+
+        const int scaled_index = matmul->bottoms[0] == top_blob_index ? 0 : 1;
+        const int bottom_blob_index = binaryop->bottoms[0];
+        const int other_blob_index = matmul->bottoms[1 - scaled_index];
+
+        const float scale = binaryop->op_type == ncnn::BinaryOp::Operation_MUL ? binaryop->b : 1.f / binaryop->b;
+
+        // move the scale into the weights producing either MatMul operand
+        bool fused = false;
+        for (int k = 0; k < 2 && !fused; k++)
         {
-            if (layers[j]->type == "ncnnfused")
+            const int blob_index = k == 0 ? bottom_blob_index : other_blob_index;
+            const int producer = blobs[blob_index].producer;
+            if (producer < 0 || count_blob_consumers(blob_index) != 1)
                 continue;
 
-            for (size_t k = 0; k < layers[j]->tops.size(); k++)
+            ncnn::Layer* layer = layers[producer];
+
+            if (layer->type == "InnerProduct")
             {
-                if (layers[j]->tops[k] == bottom_blob_index)
+                ncnn::InnerProduct* innerproduct = (ncnn::InnerProduct*)layer;
+                if (innerproduct->int8_scale_term || innerproduct->weight_quant_bits)
+                    continue;
+
+                // relu and leakyrelu commute with a positive scale
+                const int activation_type = innerproduct->activation_type;
+                if (!(activation_type == 0 || ((activation_type == 1 || activation_type == 2) && scale > 0.f)))
+                    continue;
+
+                fprintf(stderr, "fuse_binaryop_scale_matmul %s %s %s\n", innerproduct->name.c_str(), binaryop->name.c_str(), matmul->name.c_str());
+
+                float* weight = innerproduct->weight_data;
+                for (int q = 0; q < innerproduct->weight_data_size; q++)
                 {
-                    top_i = k;
-                    break;
+                    weight[q] *= scale;
+                }
+
+                if (innerproduct->bias_term)
+                {
+                    float* bias = innerproduct->bias_data;
+                    for (int q = 0; q < innerproduct->num_output; q++)
+                    {
+                        bias[q] *= scale;
+                    }
                 }
+
+                fused = true;
             }
+            else if (layer->type == "Gemm")
+            {
+                ncnn::Gemm* gemm = (ncnn::Gemm*)layer;
+                if (gemm->int8_scale_term)
+                    continue;
 
-            if (top_i != -1)
-                break;
-        }
+                fprintf(stderr, "fuse_binaryop_scale_matmul %s %s %s\n", gemm->name.c_str(), binaryop->name.c_str(), matmul->name.c_str());
 
-        if (j == -1)
-            continue;
+                // alpha scales both A * B and beta * C
+                gemm->alpha *= scale;
 
-        ncnn::Layer* any = layers[j];
+                fused = true;
+            }
+            else if (layer->type == "MemoryData")
+            {
+                ncnn::MemoryData* memorydata = (ncnn::MemoryData*)layer;
 
-        fprintf(stderr, "eliminate_split %s %s\n", any->name.c_str(), split->name.c_str());
+                fprintf(stderr, "fuse_binaryop_scale_matmul %s %s %s\n", memorydata->name.c_str(), binaryop->name.c_str(), matmul->name.c_str());
 
-        int top_blob_index_final = split->tops[real_split_top_blob_index];
-        any->tops[top_i] = top_blob_index_final;
-        blobs[top_blob_index_final].producer = j;
-        split->type = "ncnnfused";
+                float* data = memorydata->data;
+                for (size_t q = 0; q < memorydata->data.total(); q++)
+                {
+                    data[q] *= scale;
+                }
+
+                fused = true;
+            }
+        }
+
+        if (!fused)
+            continue;
+
+        matmul->bottoms[scaled_index] = bottom_blob_index;
+        blobs[bottom_blob_index].consumer = j;
+        binaryop->type = "ncnnfused";
     }
 
     return 0;
 }
 
-int NetOptimize::eliminate_orphaned_memorydata()
+int NetOptimize::fuse_innerproduct_innerproduct()
 {
     const size_t layer_count = layers.size();
     for (size_t i = 0; i < layer_count; i++)
     {
-        if (layers[i]->type != "MemoryData")
+        if (layers[i]->type != "InnerProduct")
             continue;
 
-        // MemoryData - X
+        // InnerProduct - InnerProduct
         int top_blob_index = layers[i]->tops[0];
 
         size_t j = i + 1;
         for (; j < layer_count; j++)
         {
-            if (layers[j]->type == "ncnnfused")
+            if (layers[j]->type != "InnerProduct")
                 continue;
 
-            bool orphaned = true;
-            for (size_t k = 0; k < layers[j]->bottoms.size(); k++)
-            {
-                if (layers[j]->bottoms[k] == top_blob_index)
-                {
-                    orphaned = false;
-                    break;
-                }
+            if (layers[j]->bottoms.size() != 1)
+                continue;
+
+            if (layers[j]->bottoms[0] == top_blob_index)
+                break;
+        }
+
+        if (j == layer_count)
+            continue;
+
+        ncnn::InnerProduct* innerproduct = (ncnn::InnerProduct*)layers[i];
+        ncnn::InnerProduct* innerproduct2 = (ncnn::InnerProduct*)layers[j];
+
+        if (innerproduct->activation_type != 0 || innerproduct->int8_scale_term || innerproduct->weight_quant_bits)
+            continue;
+
+        if (innerproduct2->int8_scale_term || innerproduct2->weight_quant_bits)
+            continue;
+
+        if (count_blob_consumers(top_blob_index) != 1)
+            continue;
+
+        const int num_input = innerproduct->weight_data_size / innerproduct->num_output;
+        const int num_hidden = innerproduct->num_output;
+        const int num_output = innerproduct2->num_output;
+
+        if (innerproduct2->weight_data_size != num_output * num_hidden)
+            continue;
+
+        // a low-rank pair is cheaper than the folded product
+        if ((int64_t)num_output * num_input > (int64_t)num_hidden * num_input + (int64_t)num_output * num_hidden)
+            continue;
+
+        fprintf(stderr, "fuse_innerproduct_innerproduct %s %s\n", innerproduct->name.c_str(), innerproduct2->name.c_str());
+
+        // W2 * (W1 * x + b1) + b2 = (W2 * W1) * x + (W2 * b1 + b2)
+        ncnn::Mat weight_data(num_output * num_input);
+        weight_data.fill(0.f);
+
+        const float* weight1 = innerproduct->weight_data;
+        const float* weight2 = innerproduct2->weight_data;
+        for (int p = 0; p < num_output; p++)
+        {
+            float* weight = (float*)weight_data + num_input * p;
+            for (int h = 0; h < num_hidden; h++)
+            {
+                const float w2 = weight2[num_hidden * p + h];
+                const float* weight1_h = weight1 + num_input * h;
+                for (int q = 0; q < num_input; q++)
+                {
+                    weight[q] += w2 * weight1_h[q];
+                }
+            }
+        }
+
+        if (innerproduct->bias_term || innerproduct2->bias_term)
+        {
+            ncnn::Mat bias_data(num_output);
+            for (int p = 0; p < num_output; p++)
+            {
+                float sum = innerproduct2->bias_term ? innerproduct2->bias_data[p] : 0.f;
+                if (innerproduct->bias_term)
+                {
+                    for (int h = 0; h < num_hidden; h++)
+                    {
+                        sum += weight2[num_hidden * p + h] * innerproduct->bias_data[h];
+                    }
+                }
+
+                bias_data[p] = sum;
+            }
+
+            innerproduct->bias_term = 1;
+            innerproduct->bias_data = bias_data;
+        }
+
+        innerproduct->num_output = num_output;
+        innerproduct->weight_data_size = num_output * num_input;
+        innerproduct->weight_data = weight_data;
+        innerproduct->activation_type = innerproduct2->activation_type;
+        innerproduct->activation_params = innerproduct2->activation_params;
+
+        int top_blob_index_final = innerproduct2->tops[0];
+        innerproduct->tops[0] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = i;
+        innerproduct2->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::fuse_gemm_gemm()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Gemm")
+            continue;
+
+        // Gemm - Gemm
+        int top_blob_index = layers[i]->tops[0];
+
+        size_t j = i + 1;
+        for (; j < layer_count; j++)
+        {
+            if (layers[j]->type != "Gemm")
+                continue;
+
+            if (layers[j]->bottoms.size() != 1)
+                continue;
+
+            if (layers[j]->bottoms[0] == top_blob_index)
+                break;
+        }
+
+        if (j == layer_count)
+            continue;
+
+        ncnn::Gemm* gemm = (ncnn::Gemm*)layers[i];
+        ncnn::Gemm* gemm2 = (ncnn::Gemm*)layers[j];
+
+        if (!is_linear_gemm(gemm) || !is_linear_gemm(gemm2))
+            continue;
+
+        if (gemm->output_transpose || gemm->output_N1M)
+            continue;
+
+        if (count_blob_consumers(top_blob_index) != 1)
+            continue;
+
+        const int K = gemm->constantK;
+        const int N1 = gemm->constantN;
+        const int N = gemm2->constantN;
+
+        if (gemm2->constantK != N1)
+            continue;
+
+        // a low-rank pair is cheaper than the folded product
+        if ((int64_t)N * K > (int64_t)N1 * K + (int64_t)N * N1)
+            continue;
+
+        fprintf(stderr, "fuse_gemm_gemm %s %s\n", gemm->name.c_str(), gemm2->name.c_str());
+
+        // a2 * (a1 * (A * B1 + b1 * C1) * B2 + b2 * C2) = A * (a1 * a2 * B1 * B2) + (a2 * bias1 * B2 + bias2)
+        // with bias1 = a1 * b1 * C1 and bias2 = a2 * b2 * C2
+        const float alpha = gemm->alpha * gemm2->alpha;
+
+        // stored transposed as N x K
+        ncnn::Mat B_data(K, N);
+        for (int n = 0; n < N; n++)
+        {
+            float* ptr = B_data.row(n);
+            for (int k = 0; k < K; k++)
+            {
+                float sum = 0.f;
+                for (int h = 0; h < N1; h++)
+                {
+                    sum += get_gemm_B(gemm, k, h) * get_gemm_B(gemm2, h, n);
+                }
+
+                ptr[k] = sum * alpha;
+            }
+        }
+
+        const std::vector<float> bias1 = get_gemm_bias(gemm);
+        const std::vector<float> bias2 = get_gemm_bias(gemm2);
+
+        bool has_bias = false;
+        ncnn::Mat C_data(N, 1);
+        for (int n = 0; n < N; n++)
+        {
+            float sum = 0.f;
+            for (int h = 0; h < N1; h++)
+            {
+                sum += bias1[h] * get_gemm_B(gemm2, h, n);
+            }
+
+            C_data[n] = sum * gemm2->alpha + bias2[n];
+            if (C_data[n] != 0.f)
+                has_bias = true;
+        }
+
+        gemm->alpha = 1.f;
+        gemm->beta = 1.f;
+        gemm->transB = 1;
+        gemm->constantN = N;
+        gemm->B_data = B_data;
+        gemm->constantC = 1;
+        gemm->constant_broadcast_type_C = has_bias ? 4 : -1;
+        gemm->C_data = has_bias ? C_data : ncnn::Mat();
+        gemm->output_N1M = gemm2->output_N1M;
+        gemm->output_elempack = gemm2->output_elempack;
+        gemm->output_elemtype = gemm2->output_elemtype;
+        gemm->output_transpose = gemm2->output_transpose;
+
+        int top_blob_index_final = gemm2->tops[0];
+        gemm->tops[0] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = i;
+        gemm2->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::fuse_convolution_convolution1x1()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Convolution")
+            continue;
+
+        // Convolution - Convolution1x1
+        int top_blob_index = layers[i]->tops[0];
+
+        size_t j = i + 1;
+        for (; j < layer_count; j++)
+        {
+            if (layers[j]->type != "Convolution")
+                continue;
+
+            if (layers[j]->bottoms.size() != 1)
+                continue;
+
+            if (layers[j]->bottoms[0] == top_blob_index)
+                break;
+        }
+
+        if (j == layer_count)
+            continue;
+
+        ncnn::Convolution* convolution = (ncnn::Convolution*)layers[i];
+        ncnn::Convolution* convolution2 = (ncnn::Convolution*)layers[j];
+
+        if (convolution->activation_type != 0 || convolution->int8_scale_term || convolution->dynamic_weight)
+            continue;
+
+        if (convolution2->int8_scale_term || convolution2->dynamic_weight)
+            continue;
+
+        // the second one must be pointwise, same padding of 1x1 stride 1 pads nothing
+        if (convolution2->kernel_w != 1 || convolution2->kernel_h != 1 || convolution2->stride_w != 1 || convolution2->stride_h != 1)
+            continue;
+
+        const bool same_padding = convolution2->pad_left == -233 || convolution2->pad_left == -234;
+        if (!same_padding && (convolution2->pad_left != 0 || convolution2->pad_right != 0 || convolution2->pad_top != 0 || convolution2->pad_bottom != 0))
+            continue;
+
+        if (count_blob_consumers(top_blob_index) != 1)
+            continue;
+
+        const int maxk = convolution->kernel_w * convolution->kernel_h;
+        const int num_hidden = convolution->num_output;
+        const int num_output = convolution2->num_output;
+        const int num_input = convolution->weight_data_size / maxk / num_hidden;
+
+        if (convolution2->weight_data_size != num_output * num_hidden)
+            continue;
+
+        // a bottleneck pair is cheaper than the folded product
+        if ((int64_t)num_output * num_input * maxk > (int64_t)num_hidden * num_input * maxk + (int64_t)num_output * num_hidden)
+            continue;
+
+        fprintf(stderr, "fuse_convolution_convolution1x1 %s %s\n", convolution->name.c_str(), convolution2->name.c_str());
+
+        // W2 * (W1 * x + b1) + b2 = (W2 * W1) * x + (W2 * b1 + b2)
+        const int weight_per_outch = num_input * maxk;
+
+        ncnn::Mat weight_data(num_output * weight_per_outch);
+        weight_data.fill(0.f);
+
+        const float* weight1 = convolution->weight_data;
+        const float* weight2 = convolution2->weight_data;
+        for (int p = 0; p < num_output; p++)
+        {
+            float* weight = (float*)weight_data + weight_per_outch * p;
+            for (int h = 0; h < num_hidden; h++)
+            {
+                const float w2 = weight2[num_hidden * p + h];
+                const float* weight1_h = weight1 + weight_per_outch * h;
+                for (int q = 0; q < weight_per_outch; q++)
+                {
+                    weight[q] += w2 * weight1_h[q];
+                }
+            }
+        }
+
+        if (convolution->bias_term || convolution2->bias_term)
+        {
+            ncnn::Mat bias_data(num_output);
+            for (int p = 0; p < num_output; p++)
+            {
+                float sum = convolution2->bias_term ? convolution2->bias_data[p] : 0.f;
+                if (convolution->bias_term)
+                {
+                    for (int h = 0; h < num_hidden; h++)
+                    {
+                        sum += weight2[num_hidden * p + h] * convolution->bias_data[h];
+                    }
+                }
+
+                bias_data[p] = sum;
+            }
+
+            convolution->bias_term = 1;
+            convolution->bias_data = bias_data;
+        }
+
+        convolution->num_output = num_output;
+        convolution->weight_data_size = num_output * weight_per_outch;
+        convolution->weight_data = weight_data;
+        convolution->activation_type = convolution2->activation_type;
+        convolution->activation_params = convolution2->activation_params;
+
+        int top_blob_index_final = convolution2->tops[0];
+        convolution->tops[0] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = i;
+        convolution2->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::fold_constant_subgraph()
+{
+    if (has_custom_layer)
+    {
+        fprintf(stderr, "model has custom layer, fold_constant_subgraph skipped\n");
+        return -1;
+    }
+
+    const size_t layer_count = layers.size();
+    const size_t blob_count = blobs.size();
+
+    // blobs consumed before folding, the ones left without consumer afterwards are dead
+    std::vector<int> blob_consumed(blob_count, 0);
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type == "ncnnfused")
+            continue;
+
+        for (size_t j = 0; j < layers[i]->bottoms.size(); j++)
+        {
+            blob_consumed[layers[i]->bottoms[j]] = 1;
+        }
+    }
+
+    // evaluate in fp32 without packing, so that the folded values are exact
+    const ncnn::Option opt_saved = opt;
+    opt.use_packing_layout = false;
+    opt.use_fp16_packed = false;
+    opt.use_fp16_storage = false;
+    opt.use_fp16_arithmetic = false;
+    opt.use_bf16_packed = false;
+    opt.use_bf16_storage = false;
+
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        layer->destroy_pipeline(opt_saved);
+
+        int cret = layer->create_pipeline(opt);
+        if (cret != 0)
+        {
+            NCNN_LOGE("layer create_pipeline %d %s failed", (int)i, layer->name.c_str());
+            opt = opt_saved;
+            return -1;
+        }
+    }
+
+    // layers whose output grows much larger than the input stay, folding them would bloat the model
+    // layers producing network outputs stay too, a MemoryData without consumer would be eliminated
+    std::vector<int> layer_rejected(layer_count, 0);
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        for (size_t j = 0; j < layers[i]->tops.size(); j++)
+        {
+            if (!blob_consumed[layers[i]->tops[j]])
+                layer_rejected[i] = 1;
+        }
+    }
+
+    std::vector<int> layer_constant;
+    std::vector<int> blob_constant;
+    std::map<int, ncnn::Mat> folded_blobs;
+    for (;;)
+    {
+        // MemoryData - X - Y ...
+        layer_constant.assign(layer_count, 0);
+        blob_constant.assign(blob_count, 0);
+        for (size_t i = 0; i < layer_count; i++)
+        {
+            const ncnn::Layer* layer = layers[i];
+            if (layer->type == "ncnnfused")
+                continue;
+
+            bool is_constant = false;
+            if (layer->type == "MemoryData")
+            {
+                is_constant = true;
+            }
+            else if (!layer->bottoms.empty() && !layer_rejected[i])
+            {
+                is_constant = true;
+                for (size_t j = 0; j < layer->bottoms.size(); j++)
+                {
+                    if (!blob_constant[layer->bottoms[j]])
+                        is_constant = false;
+                }
+            }
+
+            if (!is_constant)
+                continue;
+
+            layer_constant[i] = layer->type == "MemoryData" ? 0 : 1;
+            for (size_t j = 0; j < layer->tops.size(); j++)
+            {
+                blob_constant[layer->tops[j]] = 1;
+            }
+        }
+
+        // evaluate the constant blobs that leave the subgraph
+        ncnn::Extractor ex = create_extractor();
+        ex.set_light_mode(false);
+
+        folded_blobs.clear();
+        bool rejected = false;
+        for (size_t i = 0; i < layer_count; i++)
+        {
+            if (!layer_constant[i])
+                continue;
+
+            const ncnn::Layer* layer = layers[i];
+
+            size_t bottom_total = 0;
+            for (size_t j = 0; j < layer->bottoms.size(); j++)
+            {
+                ncnn::Mat m;
+                ex.extract(layer->bottoms[j], m);
+                bottom_total += m.total();
+            }
+
+            for (size_t j = 0; j < layer->tops.size(); j++)
+            {
+                int top_blob_index = layer->tops[j];
+
+                bool is_boundary = false;
+                for (size_t k = i + 1; k < layer_count; k++)
+                {
+                    if (layers[k]->type == "ncnnfused" || layer_constant[k])
+                        continue;
+
+                    if (std::find(layers[k]->bottoms.begin(), layers[k]->bottoms.end(), top_blob_index) != layers[k]->bottoms.end())
+                        is_boundary = true;
+                }
+
+                if (!is_boundary)
+                    continue;
+
+                ncnn::Mat m;
+                int ret = ex.extract(top_blob_index, m);
+                if (ret != 0 || m.empty() || m.elemsize != 4 || m.elempack != 1)
+                {
+                    layer_rejected[i] = 1;
+                    rejected = true;
+                    break;
+                }
+
+                if (m.total() > std::max(bottom_total, (size_t)1024))
+                {
+                    layer_rejected[i] = 1;
+                    rejected = true;
+                    break;
+                }
+
+                folded_blobs[top_blob_index] = m.clone();
+            }
+        }
+
+        if (!rejected)
+            break;
+    }
+
+    opt = opt_saved;
+
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        layer->destroy_pipeline(opt);
+
+        int cret = layer->create_pipeline(opt);
+        if (cret != 0)
+        {
+            NCNN_LOGE("layer create_pipeline %d %s failed", (int)i, layer->name.c_str());
+            return -1;
+        }
+    }
+
+    // replace each constant layer with MemoryData for its outputs in use
+    std::vector<ncnn::Layer*> new_layers;
+    std::vector<int> new_layer_first(layer_count);
+    std::vector<int> new_layer_last(layer_count);
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        ncnn::Layer* layer = layers[i];
+
+        new_layer_first[i] = (int)new_layers.size();
+
+        if (!layer_constant[i])
+        {
+            new_layer_last[i] = (int)new_layers.size();
+            new_layers.push_back(layer);
+            continue;
+        }
+
+        for (size_t j = 0; j < layer->tops.size(); j++)
+        {
+            int top_blob_index = layer->tops[j];
+            if (folded_blobs.find(top_blob_index) == folded_blobs.end())
+                continue;
+
+            const ncnn::Mat& m = folded_blobs[top_blob_index];
+
+            fprintf(stderr, "fold_constant_subgraph %s %s\n", layer->name.c_str(), blobs[top_blob_index].name.c_str());
+
+            ncnn::MemoryData* memorydata = (ncnn::MemoryData*)ncnn::create_layer_cpu("MemoryData");
+
+            memorydata->type = "MemoryData";
+            memorydata->name = layer->tops.size() == 1 ? layer->name : layer->name + "_" + std::to_string(j);
+            memorydata->tops.push_back(top_blob_index);
+
+            ncnn::ParamDict pd;
+            memorydata->load_param(pd);
+
+            memorydata->w = m.w;
+            memorydata->h = m.dims >= 2 ? m.h : 0;
+            memorydata->d = m.dims == 4 ? m.d : 0;
+            memorydata->c = m.dims >= 3 ? m.c : 0;
+            memorydata->data = m;
+
+            new_layers.push_back(memorydata);
+
+            int cret = memorydata->create_pipeline(opt);
+            if (cret != 0)
+            {
+                NCNN_LOGE("layer create_pipeline %s failed", memorydata->name.c_str());
+
+                // leave the graph untouched
+                for (size_t k = 0; k < new_layers.size(); k++)
+                {
+                    if (std::find(layers.begin(), layers.end(), new_layers[k]) == layers.end())
+                        delete new_layers[k];
+                }
+                return -1;
+            }
+        }
+
+        new_layer_last[i] = (int)new_layers.size();
+        new_layers.push_back(layer);
+    }
+
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layer_constant[i])
+            layers[i]->type = "ncnnfused";
+    }
+
+    layers = new_layers;
+
+    if (cutstart != -1)
+        cutstart = new_layer_first[cutstart];
+    if (cutend != -1)
+        cutend = new_layer_last[cutend];
+
+    // remove the layers left without any consumer
+    for (;;)
+    {
+        bool eliminated = false;
+
+        for (size_t i = 0; i < layers.size(); i++)
+        {
+            ncnn::Layer* layer = layers[i];
+            if (layer->type == "ncnnfused")
+                continue;
+
+            bool unreachable = !layer->tops.empty();
+            for (size_t j = 0; j < layer->tops.size(); j++)
+            {
+                int top_blob_index = layer->tops[j];
+                if (!blob_consumed[top_blob_index] || count_blob_consumers(top_blob_index) != 0)
+                    unreachable = false;
+            }
+
+            if (!unreachable)
+                continue;
+
+            fprintf(stderr, "eliminate_unreachable_layer %s\n", layer->name.c_str());
+
+            layer->type = "ncnnfused";
+            eliminated = true;
+        }
+
+        if (!eliminated)
+            break;
+    }
+
+    // layer indexes changed
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        const ncnn::Layer* layer = layers[i];
+        if (layer->type == "ncnnfused")
+            continue;
+
+        for (size_t j = 0; j < layer->tops.size(); j++)
+        {
+            blobs[layer->tops[j]].producer = i;
+        }
+        for (size_t j = 0; j < layer->bottoms.size(); j++)
+        {
+            blobs[layer->bottoms[j]].consumer = i;
+        }
+    }
+
+    // the folding changed the graph, recompile the execution plans
+    update_forward_plans();
+
+    return 0;
+}
+
+int NetOptimize::eliminate_dropout()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Dropout")
+            continue;
+
+        ncnn::Dropout* dropout = (ncnn::Dropout*)layers[i];
+        if (dropout->scale != 1.f)
+            continue;
+
+        // Any - Dropout
+        int bottom_blob_index = layers[i]->bottoms[0];
+
+        int j = i - 1;
+        for (; j >= 0; j--)
+        {
+            if (layers[j]->type == "ncnnfused")
+                continue;
+
+            if (layers[j]->tops.size() != 1)
+                continue;
+
+            if (layers[j]->tops[0] == bottom_blob_index)
+                break;
+        }
+
+        if (j == -1)
+            continue;
+
+        ncnn::Layer* any = layers[j];
+
+        fprintf(stderr, "eliminate_dropout %s %s\n", any->name.c_str(), dropout->name.c_str());
+
+        int top_blob_index_final = dropout->tops[0];
+        any->tops[0] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = j;
+        dropout->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::eliminate_pooling1x1()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Pooling")
+            continue;
+
+        ncnn::Pooling* pooling = (ncnn::Pooling*)layers[i];
+        if (pooling->pad_left != 0 || pooling->pad_right != 0 || pooling->pad_top != 0 || pooling->pad_bottom != 0)
+            continue;
+
+        if (pooling->kernel_w != 1 || pooling->kernel_h != 1 || pooling->stride_w != 1 || pooling->stride_h != 1)
+            continue;
+
+        if (pooling->global_pooling != 0)
+            continue;
+
+        // Any - Pooling
+        int bottom_blob_index = layers[i]->bottoms[0];
+
+        int top_i = -1;
+        int j = i - 1;
+        for (; j >= 0; j--)
+        {
+            if (layers[j]->type == "ncnnfused")
+                continue;
+
+            for (size_t k = 0; k < layers[j]->tops.size(); k++)
+            {
+                if (layers[j]->tops[k] == bottom_blob_index)
+                {
+                    top_i = k;
+                    break;
+                }
+            }
+
+            if (top_i != -1)
+                break;
+        }
+
+        if (j == -1)
+            continue;
+
+        ncnn::Layer* any = layers[j];
+
+        fprintf(stderr, "eliminate_pooling1x1 %s %s\n", any->name.c_str(), pooling->name.c_str());
+
+        int top_blob_index_final = pooling->tops[0];
+        any->tops[top_i] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = j;
+        pooling->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::eliminate_noop()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Noop")
+            continue;
+
+        ncnn::Layer* noop = layers[i];
+
+        if (noop->bottoms.empty())
+        {
+            // Noop
+            fprintf(stderr, "eliminate_noop %s\n", noop->name.c_str());
+
+            size_t top_blob_count = noop->tops.size();
+            for (size_t j = 0; j < top_blob_count; j++)
+            {
+                int top_blob_index_final = noop->tops[j];
+                blobs[top_blob_index_final].producer = -1;
+            }
+            noop->type = "ncnnfused";
+
+            continue;
+        }
+
+        // Any - Noop
+        int bottom_blob_index = noop->bottoms[0];
+
+        int j = i - 1;
+        int any_k = -1;
+        for (; j >= 0; j--)
+        {
+            if (layers[j]->type == "ncnnfused")
+                continue;
+
+            bool link_noop = false;
+            size_t top_blob_count = layers[j]->tops.size();
+            for (size_t k = 0; k < top_blob_count; k++)
+            {
+                if (layers[j]->tops[k] == bottom_blob_index)
+                {
+                    link_noop = true;
+                    any_k = k;
+                    break;
+                }
+            }
+
+            if (link_noop)
+                break;
+        }
+
+        if (j == -1 || any_k == -1)
+            continue;
+
+        ncnn::Layer* any = layers[j];
+
+        fprintf(stderr, "eliminate_noop %s %s\n", any->name.c_str(), noop->name.c_str());
+
+        int top_blob_index_final = noop->tops[0];
+        any->tops[any_k] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = j;
+
+        noop->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::eliminate_split()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "Split")
+            continue;
+
+        ncnn::Layer* split = layers[i];
+
+        int real_split_output_count = 0;
+        int real_split_top_blob_index = -1;
+        size_t top_blob_count = split->tops.size();
+        for (size_t j = 0; j < top_blob_count; j++)
+        {
+            int top_blob_index_final = split->tops[j];
+            if (blobs[top_blob_index_final].consumer != -1)
+            {
+                real_split_output_count += 1;
+                real_split_top_blob_index = j;
+            }
+        }
+
+        if (real_split_output_count > 1)
+            continue;
+
+        // Any - Pooling
+        int bottom_blob_index = split->bottoms[0];
+
+        int top_i = -1;
+        int j = i - 1;
+        for (; j >= 0; j--)
+        {
+            if (layers[j]->type == "ncnnfused")
+                continue;
+
+            for (size_t k = 0; k < layers[j]->tops.size(); k++)
+            {
+                if (layers[j]->tops[k] == bottom_blob_index)
+                {
+                    top_i = k;
+                    break;
+                }
+            }
+
+            if (top_i != -1)
+                break;
+        }
+
+        if (j == -1)
+            continue;
+
+        ncnn::Layer* any = layers[j];
+
+        fprintf(stderr, "eliminate_split %s %s\n", any->name.c_str(), split->name.c_str());
+
+        int top_blob_index_final = split->tops[real_split_top_blob_index];
+        any->tops[top_i] = top_blob_index_final;
+        blobs[top_blob_index_final].producer = j;
+        split->type = "ncnnfused";
+    }
+
+    return 0;
+}
+
+int NetOptimize::eliminate_orphaned_memorydata()
+{
+    const size_t layer_count = layers.size();
+    for (size_t i = 0; i < layer_count; i++)
+    {
+        if (layers[i]->type != "MemoryData")
+            continue;
+
+        // MemoryData - X
+        int top_blob_index = layers[i]->tops[0];
+
+        size_t j = i + 1;
+        for (; j < layer_count; j++)
+        {
+            if (layers[j]->type == "ncnnfused")
+                continue;
+
+            bool orphaned = true;
+            for (size_t k = 0; k < layers[j]->bottoms.size(); k++)
+            {
+                if (layers[j]->bottoms[k] == top_blob_index)
+                {
+                    orphaned = false;
+                    break;
+                }
             }
 
             if (!orphaned)
@@ -2753,6 +3767,7 @@ int main(int argc, char** argv)
     if (argc < 6)
     {
         fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [flag] [cutstart] [cutend]\n", argv[0]);
+        fprintf(stderr, "       flag 0=fp32 1=fp16 2=fp8e4m3 3=fp8e5m2 4=int4\n");
         return -1;
     }
 
@@ -2780,6 +3795,11 @@ int main(int argc, char** argv)
     {
         optimizer.storage_type = 1;
     }
+    else if (flag == 2 || flag == 3 || flag == 4)
+    {
+        // 2=fp8e4m3 3=fp8e5m2 4=int4
+        optimizer.storage_type = flag;
+    }
     else
     {
         optimizer.storage_type = 0;
@@ -2801,6 +3821,8 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    optimizer.fold_constant_subgraph();
+
     optimizer.fuse_batchnorm_scale();
     optimizer.fuse_convolution_batchnorm();
     optimizer.fuse_convolution_mul();
@@ -2839,6 +3861,13 @@ int main(int argc, char** argv)
     optimizer.replace_convolution_with_innerproduct_after_innerproduct();
 
     optimizer.eliminate_flatten_after_innerproduct();
+
+    optimizer.fuse_layernorm_innerproduct();
+    optimizer.fuse_binaryop_scale_matmul();
+    optimizer.fuse_innerproduct_innerproduct();
+    optimizer.fuse_gemm_gemm();
+    optimizer.fuse_convolution_convolution1x1();
+
     optimizer.eliminate_orphaned_memorydata();
 
     optimizer.shape_inference();
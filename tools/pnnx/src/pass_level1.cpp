@@ -315,6 +315,24 @@ void pass_level1(const torch::jit::Module& mod, const std::shared_ptr<torch::jit
                                 constant_attr_nodes[unique_id] = mn;
                             }
                         }
+                        else if (mn->kind() == c10::aten::topk)
+                        {
+                            // routing of sparse blocks, python attributes like top_k are traced in as constants
+                            torch::jit::Node* kn = mn->input(1)->node();
+                            if (kn->kind() == c10::prim::Constant)
+                            {
+                                op->params["top_k"] = Parameter(kn);
+
+                                // the picked probabilities are renormalized when they feed a sum or another softmax
+                                bool norm_topk_prob = false;
+                                for (const auto& u : mn->output(0)->uses())
+                                {
+                                    if (u.user->kind() == c10::aten::sum || u.user->kind() == c10::aten::softmax)
+                                        norm_topk_prob = true;
+                                }
+                                op->params["norm_topk_prob"] = norm_topk_prob;
+                            }
+                        }
                     }
 
                     int pnnx_moduleop_unknown_index = 0;
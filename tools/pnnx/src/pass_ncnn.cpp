@@ -6,6 +6,7 @@
 #include "pass_ncnn/convert_attribute.h"
 #include "pass_ncnn/convert_custom_op.h"
 #include "pass_ncnn/convert_module_op.h"
+#include "pass_ncnn/convert_moe.h"
 #include "pass_ncnn/convert_half_to_float.h"
 #include "pass_ncnn/convert_input.h"
 #include "pass_ncnn/convert_reshape_interp_expression.h"
@@ -82,6 +83,8 @@ void pass_ncnn(Graph& g, const std::vector<std::string>& module_operators)
 
     ncnn::fuse_convert_rotaryembed(g);
 
+    ncnn::convert_moe(g, module_operators);
+
     ncnn::expand_expression(g);
 
     ncnn::chain_multi_output(g);
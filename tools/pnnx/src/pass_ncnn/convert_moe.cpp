@@ -0,0 +1,187 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "convert_moe.h"
+
+#include <algorithm>
+
+namespace pnnx {
+
+namespace ncnn {
+
+// expert projection names of the sparse moe blocks in the wild
+// the gate projection goes through silu and multiplies the up projection
+static const char* moe_expert_names[][3] = {
+    {"w1", "w3", "w2"},                      // mixtral
+    {"gate_proj", "up_proj", "down_proj"}    // qwen moe, olmoe, deepseek moe
+};
+
+static std::string moe_expert_attr(int e, const char* proj, const char* name)
+{
+    return std::string("experts.") + std::to_string(e) + "." + proj + "." + name;
+}
+
+static Attribute moe_concat_expert_attr(const Operator* op, int num_expert, const char* proj, const char* name)
+{
+    Attribute a = op->attrs.at(moe_expert_attr(0, proj, name));
+    for (int e = 1; e < num_expert; e++)
+    {
+        a = a + op->attrs.at(moe_expert_attr(e, proj, name));
+    }
+    return a;
+}
+
+void convert_moe(Graph& graph, const std::vector<std::string>& module_operators)
+{
+    for (size_t i = 0; i < graph.ops.size(); i++)
+    {
+        Operator* op = graph.ops[i];
+
+        if (std::find(module_operators.begin(), module_operators.end(), op->type) == module_operators.end())
+            continue;
+
+        if (!op->has_attr("gate.weight") || op->inputs.size() != 1)
+            continue;
+
+        int scheme = -1;
+        for (int s = 0; s < (int)(sizeof(moe_expert_names) / sizeof(moe_expert_names[0])); s++)
+        {
+            if (op->has_attr(moe_expert_attr(0, moe_expert_names[s][0], "weight")))
+            {
+                scheme = s;
+                break;
+            }
+        }
+        if (scheme == -1)
+            continue;
+
+        const char* gate_proj = moe_expert_names[scheme][0];
+        const char* up_proj = moe_expert_names[scheme][1];
+        const char* down_proj = moe_expert_names[scheme][2];
+
+        const Attribute& router_weight = op->attrs.at("gate.weight");
+        const int num_expert = router_weight.shape[0];
+        const int embed_dim = router_weight.shape[1];
+        const bool router_bias = op->has_attr("gate.bias");
+        const bool bias_term = op->has_attr(moe_expert_attr(0, up_proj, "bias"));
+
+        // anything beyond router and routed experts, like a shared expert, stays a module op
+        size_t expect_attr_count = 1 + (router_bias ? 1 : 0) + num_expert * 3 * (bias_term ? 2 : 1);
+        bool supported = op->attrs.size() == expect_attr_count;
+        for (int e = 0; e < num_expert && supported; e++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                if (!op->has_attr(moe_expert_attr(e, moe_expert_names[scheme][j], "weight")))
+                    supported = false;
+                if (bias_term && !op->has_attr(moe_expert_attr(e, moe_expert_names[scheme][j], "bias")))
+                    supported = false;
+            }
+        }
+
+        // the router logits output is only consumed by the auxiliary loss in training
+        for (size_t j = 1; j < op->outputs.size(); j++)
+        {
+            if (!op->outputs[j]->consumers.empty())
+                supported = false;
+        }
+
+        if (!supported)
+        {
+            fprintf(stderr, "convert_moe skip %s %s with unsupported experts\n", op->type.c_str(), op->name.c_str());
+            continue;
+        }
+
+        // top_k and norm_topk_prob are read from the topk routing in the traced block
+        if (!op->has_param("top_k") || op->params.at("top_k").type != 2)
+        {
+            fprintf(stderr, "convert_moe skip %s %s without constant topk routing\n", op->type.c_str(), op->name.c_str());
+            continue;
+        }
+
+        const int top_k = op->params.at("top_k").i;
+        const bool norm_topk_prob = op->has_param("norm_topk_prob") && op->params.at("norm_topk_prob").b;
+
+        if (top_k < 1 || top_k > num_expert)
+        {
+            fprintf(stderr, "convert_moe skip %s %s with top_k %d out of %d experts\n", op->type.c_str(), op->name.c_str(), top_k, num_expert);
+            continue;
+        }
+
+        const int hidden_dim = op->attrs.at(moe_expert_attr(0, up_proj, "weight")).shape[0];
+
+        fprintf(stderr, "convert_moe %s %s num_expert=%d top_k=%d norm_topk_prob=%d\n", op->type.c_str(), op->name.c_str(), num_expert, top_k, norm_topk_prob ? 1 : 0);
+
+        for (size_t j = 1; j < op->outputs.size(); j++)
+        {
+            Operand* out = op->outputs[j];
+            out->producer = 0;
+            graph.operands.erase(std::find(graph.operands.begin(), graph.operands.end(), out));
+            delete out;
+        }
+        op->outputs.resize(1);
+
+        Operand* in = op->inputs[0];
+
+        // router projection in front, lowered with the other nn.Linear
+        Operator* router = graph.new_operator_before("nn.Linear", op->name + "_router", op);
+
+        Operand* router_logits = graph.new_operand(op->name + "_router_logits");
+        router_logits->producer = router;
+        router_logits->type = in->type;
+        router_logits->shape = in->shape;
+        if (!router_logits->shape.empty())
+            router_logits->shape.back() = num_expert;
+        router_logits->params = in->params;
+
+        router->inputs.push_back(in);
+        router->outputs.push_back(router_logits);
+        in->consumers.push_back(router);
+
+        router->params["in_features"] = embed_dim;
+        router->params["out_features"] = num_expert;
+        router->params["bias"] = router_bias;
+        router->attrs["weight"] = router_weight;
+        if (router_bias)
+            router->attrs["bias"] = op->attrs.at("gate.bias");
+
+        op->inputs.push_back(router_logits);
+        router_logits->consumers.push_back(op);
+
+        std::map<std::string, Attribute> expert_attrs;
+        expert_attrs["0"] = Attribute();
+        expert_attrs["0"].data = {0, 0, 0, 0};
+        expert_attrs["1"] = moe_concat_expert_attr(op, num_expert, up_proj, "weight");
+        expert_attrs["2"] = Attribute();
+        expert_attrs["2"].data = {0, 0, 0, 0};
+        expert_attrs["3"] = moe_concat_expert_attr(op, num_expert, gate_proj, "weight");
+        expert_attrs["4"] = Attribute();
+        expert_attrs["4"].data = {0, 0, 0, 0};
+        expert_attrs["5"] = moe_concat_expert_attr(op, num_expert, down_proj, "weight");
+        if (bias_term)
+        {
+            expert_attrs["6"] = moe_concat_expert_attr(op, num_expert, up_proj, "bias");
+            expert_attrs["7"] = moe_concat_expert_attr(op, num_expert, gate_proj, "bias");
+            expert_attrs["8"] = moe_concat_expert_attr(op, num_expert, down_proj, "bias");
+        }
+
+        // the gate projection goes through silu
+        op->type = "MoE";
+        op->params.clear();
+        op->params["0"] = num_expert;
+        op->params["1"] = top_k;
+        op->params["2"] = embed_dim;
+        op->params["3"] = hidden_dim;
+        op->params["4"] = 1;
+        op->params["5"] = 7;
+        op->params["6"] = norm_topk_prob ? 1 : 0;
+        op->params["7"] = bias_term ? 1 : 0;
+        op->attrs = expert_attrs;
+
+        i++;
+    }
+}
+
+} // namespace ncnn
+
+} // namespace pnnx
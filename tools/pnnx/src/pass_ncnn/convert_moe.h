@@ -0,0 +1,14 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "ir.h"
+
+namespace pnnx {
+
+namespace ncnn {
+
+void convert_moe(Graph& graph, const std::vector<std::string>& module_operators);
+
+} // namespace ncnn
+
+} // namespace pnnx
@@ -0,0 +1,92 @@
+# Copyright 2025 Tencent
+# SPDX-License-Identifier: BSD-3-Clause
+
+import torch
+import torch.nn as nn
+import torch.nn.functional as F
+
+class Expert(nn.Module):
+    def __init__(self, embed_dim, hidden_dim):
+        super(Expert, self).__init__()
+
+        self.w1 = nn.Linear(embed_dim, hidden_dim, bias=False)
+        self.w2 = nn.Linear(hidden_dim, embed_dim, bias=False)
+        self.w3 = nn.Linear(embed_dim, hidden_dim, bias=False)
+
+    def forward(self, x):
+        return self.w2(F.silu(self.w1(x)) * self.w3(x))
+
+class SparseMoeBlock(nn.Module):
+    def __init__(self, embed_dim, hidden_dim, num_expert, top_k, norm_topk_prob):
+        super(SparseMoeBlock, self).__init__()
+
+        self.num_expert = num_expert
+        self.top_k = top_k
+        self.norm_topk_prob = norm_topk_prob
+
+        self.gate = nn.Linear(embed_dim, num_expert, bias=False)
+        self.experts = nn.ModuleList([Expert(embed_dim, hidden_dim) for _ in range(num_expert)])
+
+    def forward(self, x):
+        router_logits = self.gate(x)
+        routing_weights = F.softmax(router_logits, dim=-1, dtype=torch.float)
+        routing_weights, selected_experts = torch.topk(routing_weights, self.top_k, dim=-1)
+        if self.norm_topk_prob:
+            routing_weights = routing_weights / routing_weights.sum(dim=-1, keepdim=True)
+
+        out = torch.zeros_like(x)
+        for e in range(self.num_expert):
+            w = (routing_weights * (selected_experts == e)).sum(dim=-1, keepdim=True)
+            out = out + w * self.experts[e](x)
+        return out
+
+class Model(nn.Module):
+    def __init__(self):
+        super(Model, self).__init__()
+
+        self.moe0 = SparseMoeBlock(64, 48, 4, 1, False)
+        self.moe1 = SparseMoeBlock(64, 32, 6, 3, True)
+
+    def forward(self, x):
+        x = self.moe0(x)
+        x = self.moe1(x)
+        return x
+
+def test():
+    net = Model()
+    net.eval()
+
+    torch.manual_seed(0)
+    x = torch.rand(16, 64)
+
+    a = net(x)
+
+    # export torchscript
+    mod = torch.jit.trace(net, x)
+    mod.save("test_ncnn_convert_moe.pt")
+
+    # torchscript to pnnx
+    import os
+    os.system("../../src/pnnx test_ncnn_convert_moe.pt inputshape=[16,64] moduleop=SparseMoeBlock")
+
+    # the routing width and renormalization come from the traced blocks
+    with open("test_ncnn_convert_moe.ncnn.param") as f:
+        moe_lines = [line for line in f if line.startswith("MoE ")]
+    if len(moe_lines) != 2:
+        return False
+    if " 1=1 " not in moe_lines[0] or " 6=0 " not in moe_lines[0]:
+        return False
+    if " 1=3 " not in moe_lines[1] or " 6=1 " not in moe_lines[1]:
+        return False
+
+    # ncnn inference
+    import test_ncnn_convert_moe_ncnn
+    b = test_ncnn_convert_moe_ncnn.test_inference()
+
+    return torch.allclose(a, b, 1e-4, 1e-4)
+
+if __name__ == "__main__":
+    if test():
+        exit(0)
+    else:
+        exit(1)
@@ -5,12 +5,18 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #endif
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <map>
 #include <set>
+#include <string>
 #include <vector>
 
+// npy format header
+#include "npy.hpp"
+
 // ncnn public header
 #include "datareader.h"
 #include "layer.h"
@@ -105,6 +111,21 @@ static bool read_int8scale_table(const char* filepath, std::map<std::string, ncn
     return true;
 }
 
+// int8 error of one layer alone, fed with the fp32 activations
+struct MixedPrecisionCandidate
+{
+    int layer_index;
+    double noise;
+    double energy;
+    double macs;
+
+    // cheapest error per multiply-accumulate first
+    bool operator<(const MixedPrecisionCandidate& b) const
+    {
+        return noise / std::max(energy, 1e-30) / std::max(macs, 1.0) < b.noise / std::max(b.energy, 1e-30) / std::max(b.macs, 1.0);
+    }
+};
+
 class NetQuantize : public ModelWriter
 {
 public:
@@ -113,11 +134,18 @@ public:
     std::map<std::string, ncnn::Mat> blob_int8scale_table;
     std::map<std::string, ncnn::Mat> weight_int8scale_table;
 
+    // 0=off 4=int4 8=int8
+    int weight_quant_bits;
+    int weight_quant_group_size;
+
 public:
     int quantize_convolution();
     int quantize_convolutiondepthwise();
     int quantize_innerproduct();
 
+    int quantize_innerproduct_weight_only();
+    int quantize_gemm_weight_only();
+
     int quantize_rnn();
     int quantize_lstm();
     int quantize_gru();
@@ -128,11 +156,70 @@ public:
     int quantize_sdpa();
 
     int fuse_requantize();
+
+    // int8 error of every calibrated layer on the samples, independent of the budget
+    int measure_sensitivity(const std::vector<std::vector<ncnn::Mat> >& samples, std::vector<MixedPrecisionCandidate>& candidates) const;
+
+    // drop the most sensitive layers from the scale table so that they keep the float storage type
+    int select_mixed_precision(const std::vector<MixedPrecisionCandidate>& candidates, float budget);
 };
 
 NetQuantize::NetQuantize()
     : ModelWriter()
 {
+    weight_quant_bits = 0;
+    weight_quant_group_size = 32;
+}
+
+// symmetric per-group quantization of row-major weights, needs no calibration data
+// int4 packs two inputs per byte, low nibble first, biased by 8
+static int quantize_weight_only(const float* weight, int num_input, int num_output, int bits, int group_size, ncnn::Mat& weight_data_quantized, ncnn::Mat& scales)
+{
+    const int num_group = (num_input + group_size - 1) / group_size;
+    const int row_bytes = bits == 4 ? (num_input + 1) / 2 : num_input;
+    const int qmax = bits == 4 ? 7 : 127;
+
+    weight_data_quantized.create(row_bytes * num_output, (size_t)1u);
+    scales.create(num_group * num_output);
+    if (weight_data_quantized.empty() || scales.empty())
+        return -100;
+
+    memset(weight_data_quantized.data, 0, row_bytes * num_output);
+
+    for (int p = 0; p < num_output; p++)
+    {
+        const float* ptr = weight + num_input * p;
+        unsigned char* outptr = (unsigned char*)weight_data_quantized.data + row_bytes * p;
+
+        for (int g = 0; g < num_group; g++)
+        {
+            const int k0 = g * group_size;
+            const int k1 = std::min(k0 + group_size, num_input);
+
+            float absmax = 0.f;
+            for (int k = k0; k < k1; k++)
+            {
+                absmax = std::max(absmax, (float)fabs(ptr[k]));
+            }
+
+            const float scale = absmax / qmax;
+            const float scale_inv = absmax == 0.f ? 0.f : qmax / absmax;
+            scales[num_group * p + g] = scale;
+
+            for (int k = k0; k < k1; k++)
+            {
+                int q = static_cast<int>(round(ptr[k] * scale_inv));
+                q = std::min(std::max(q, -qmax), qmax);
+
+                if (bits == 4)
+                    outptr[k / 2] |= (unsigned char)((q + 8) << (k % 2 * 4));
+                else
+                    ((signed char*)outptr)[k] = (signed char)q;
+            }
+        }
+    }
+
+    return 0;
 }
 
 int NetQuantize::quantize_convolution()
@@ -310,6 +397,84 @@ int NetQuantize::quantize_innerproduct()
     return 0;
 }
 
+int NetQuantize::quantize_innerproduct_weight_only()
+{
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->type != "InnerProduct")
+            continue;
+
+        // InnerProduct - quantize weight from fp32 to int8/int4 per group
+        ncnn::InnerProduct* fc = (ncnn::InnerProduct*)layers[i];
+
+        if (fc->int8_scale_term || fc->weight_data.elemsize != 4)
+            continue;
+
+        fprintf(stderr, "quantize_innerproduct_weight_only %s\n", fc->name.c_str());
+
+        const int num_input = fc->weight_data_size / fc->num_output;
+
+        ncnn::Mat weight_data_quantized;
+        ncnn::Mat weight_data_quant_scales;
+        int ret = quantize_weight_only(fc->weight_data, num_input, fc->num_output, weight_quant_bits, weight_quant_group_size, weight_data_quantized, weight_data_quant_scales);
+        if (ret != 0)
+            return ret;
+
+        fc->weight_quant_bits = weight_quant_bits;
+        fc->weight_quant_group_size = weight_quant_group_size;
+        fc->weight_data = weight_data_quantized;
+        fc->weight_data_quant_scales = weight_data_quant_scales;
+    }
+
+    return 0;
+}
+
+int NetQuantize::quantize_gemm_weight_only()
+{
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        if (layers[i]->type != "Gemm")
+            continue;
+
+        // Gemm - quantize constant B from fp32 to int8/int4 per group
+        ncnn::Gemm* gemm = (ncnn::Gemm*)layers[i];
+
+        if (gemm->int8_scale_term || gemm->constantA || !gemm->constantB || gemm->transA || gemm->output_transpose || gemm->B_data.elemsize != 4)
+            continue;
+
+        fprintf(stderr, "quantize_gemm_weight_only %s\n", gemm->name.c_str());
+
+        if (gemm->transB == 0)
+        {
+            // transpose to one row per N
+            ncnn::Mat B_data_transposed(gemm->constantK * gemm->constantN);
+            for (int i = 0; i < gemm->constantN; i++)
+            {
+                float* ptr = (float*)B_data_transposed + i * gemm->constantK;
+                for (int j = 0; j < gemm->constantK; j++)
+                {
+                    ptr[j] = gemm->B_data[j * gemm->constantN + i];
+                }
+            }
+            gemm->B_data = B_data_transposed;
+            gemm->transB = 1;
+        }
+
+        ncnn::Mat B_data_quantized;
+        ncnn::Mat B_data_quant_scales;
+        int ret = quantize_weight_only(gemm->B_data, gemm->constantK, gemm->constantN, weight_quant_bits, weight_quant_group_size, B_data_quantized, B_data_quant_scales);
+        if (ret != 0)
+            return ret;
+
+        gemm->weight_quant_bits = weight_quant_bits;
+        gemm->weight_quant_group_size = weight_quant_group_size;
+        gemm->B_data = B_data_quantized;
+        gemm->B_data_quant_scales = B_data_quant_scales;
+    }
+
+    return 0;
+}
+
 int NetQuantize::quantize_rnn()
 {
     for (size_t i = 0; i < layers.size(); i++)
@@ -615,6 +780,9 @@ int NetQuantize::quantize_gemm()
         // Gemm - quantize weight from fp32 to int8
         ncnn::Gemm* gemm = (ncnn::Gemm*)layers[i];
 
+        if (gemm->weight_quant_bits)
+            continue;
+
         fprintf(stderr, "quantize_gemm %s\n", gemm->name.c_str());
 
         // TODO move to ncnn2table
@@ -1065,11 +1233,394 @@ int NetQuantize::fuse_requantize()
     return 0;
 }
 
+static int create_int8_layer(const ncnn::Layer* layer, const ncnn::Mat& weight_data_int8_scales, const ncnn::Mat& bottom_blob_int8_scales, const ncnn::Option& opt, ncnn::Layer*& op)
+{
+    ncnn::ParamDict pd;
+    std::vector<ncnn::Mat> weights;
+
+    if (layer->type == "Convolution")
+    {
+        const ncnn::Convolution* convolution = (const ncnn::Convolution*)layer;
+
+        pd.set(0, convolution->num_output);
+        pd.set(1, convolution->kernel_w);
+        pd.set(11, convolution->kernel_h);
+        pd.set(2, convolution->dilation_w);
+        pd.set(12, convolution->dilation_h);
+        pd.set(3, convolution->stride_w);
+        pd.set(13, convolution->stride_h);
+        pd.set(4, convolution->pad_left);
+        pd.set(15, convolution->pad_right);
+        pd.set(14, convolution->pad_top);
+        pd.set(16, convolution->pad_bottom);
+        pd.set(18, convolution->pad_value);
+        pd.set(5, convolution->bias_term);
+        pd.set(6, convolution->weight_data_size);
+        pd.set(8, 2);
+        pd.set(9, convolution->activation_type);
+        pd.set(10, convolution->activation_params);
+
+        weights.push_back(convolution->weight_data);
+        if (convolution->bias_term)
+            weights.push_back(convolution->bias_data);
+    }
+    else if (layer->type == "ConvolutionDepthWise")
+    {
+        const ncnn::ConvolutionDepthWise* convdw = (const ncnn::ConvolutionDepthWise*)layer;
+
+        pd.set(0, convdw->num_output);
+        pd.set(1, convdw->kernel_w);
+        pd.set(11, convdw->kernel_h);
+        pd.set(2, convdw->dilation_w);
+        pd.set(12, convdw->dilation_h);
+        pd.set(3, convdw->stride_w);
+        pd.set(13, convdw->stride_h);
+        pd.set(4, convdw->pad_left);
+        pd.set(15, convdw->pad_right);
+        pd.set(14, convdw->pad_top);
+        pd.set(16, convdw->pad_bottom);
+        pd.set(18, convdw->pad_value);
+        pd.set(5, convdw->bias_term);
+        pd.set(6, convdw->weight_data_size);
+        pd.set(7, convdw->group);
+        pd.set(8, 1);
+        pd.set(9, convdw->activation_type);
+        pd.set(10, convdw->activation_params);
+
+        weights.push_back(convdw->weight_data);
+        if (convdw->bias_term)
+            weights.push_back(convdw->bias_data);
+    }
+    else // if (layer->type == "InnerProduct")
+    {
+        const ncnn::InnerProduct* fc = (const ncnn::InnerProduct*)layer;
+
+        pd.set(0, fc->num_output);
+        pd.set(1, fc->bias_term);
+        pd.set(2, fc->weight_data_size);
+        pd.set(8, 2);
+        pd.set(9, fc->activation_type);
+        pd.set(10, fc->activation_params);
+
+        weights.push_back(fc->weight_data);
+        if (fc->bias_term)
+            weights.push_back(fc->bias_data);
+    }
+
+    // fp32 weights are quantized by the layer itself with these scales
+    weights.push_back(weight_data_int8_scales);
+    weights.push_back(bottom_blob_int8_scales);
+
+    op = ncnn::create_layer_cpu(layer->typeindex);
+
+    int ret = op->load_param(pd);
+    if (ret == 0)
+        ret = op->load_model(ncnn::ModelBinFromMatArray(weights.data()));
+    if (ret == 0)
+        ret = op->create_pipeline(opt);
+
+    if (ret != 0)
+    {
+        fprintf(stderr, "create int8 layer %s failed\n", layer->name.c_str());
+        delete op;
+        op = 0;
+    }
+
+    return ret;
+}
+
+// accumulate squared error and squared reference over all elements
+static void accumulate_error(const ncnn::Mat& a, const ncnn::Mat& ref, double& noise, double& energy)
+{
+    if (a.w != ref.w || a.h != ref.h || a.d != ref.d || a.c != ref.c)
+    {
+        fprintf(stderr, "output shape mismatch\n");
+        noise += 1e30;
+        return;
+    }
+
+    const int size = ref.w * ref.h * ref.d;
+    for (int q = 0; q < ref.c; q++)
+    {
+        const float* pa = a.channel(q);
+        const float* pref = ref.channel(q);
+        for (int i = 0; i < size; i++)
+        {
+            noise += (double)(pa[i] - pref[i]) * (pa[i] - pref[i]);
+            energy += (double)pref[i] * pref[i];
+        }
+    }
+}
+
+// relative squared error of all network outputs against the fp32 references
+static int compute_output_error(const ncnn::Net& net, const std::vector<std::vector<ncnn::Mat> >& samples, const std::vector<std::vector<ncnn::Mat> >& references, float& error)
+{
+    const std::vector<const char*>& input_names = net.input_names();
+    const std::vector<const char*>& output_names = net.output_names();
+
+    double noise = 0.0;
+    double energy = 0.0;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        ncnn::Extractor ex = net.create_extractor();
+        for (size_t j = 0; j < input_names.size(); j++)
+        {
+            ex.input(input_names[j], samples[i][j]);
+        }
+
+        for (size_t j = 0; j < output_names.size(); j++)
+        {
+            ncnn::Mat out;
+            int ret = ex.extract(output_names[j], out);
+            if (ret != 0)
+            {
+                fprintf(stderr, "extract %s failed\n", output_names[j]);
+                return ret;
+            }
+
+            accumulate_error(out, references[i][j], noise, energy);
+        }
+    }
+
+    error = energy == 0.0 ? 0.f : (float)(noise / energy);
+
+    return 0;
+}
+
+static const char* storage_type_name(int storage_type)
+{
+    switch (storage_type)
+    {
+    case 1:
+        return "fp16";
+    case 2:
+        return "fp8e4m3";
+    case 3:
+        return "fp8e5m2";
+    case 4:
+        return "int4";
+    default:
+        return "fp32";
+    }
+}
+
+static double get_layer_macs(const ncnn::Layer* layer, const ncnn::Mat& top_blob)
+{
+    int num_output = 0;
+    int weight_data_size = 0;
+    if (layer->type == "Convolution")
+    {
+        num_output = ((const ncnn::Convolution*)layer)->num_output;
+        weight_data_size = ((const ncnn::Convolution*)layer)->weight_data_size;
+    }
+    else if (layer->type == "ConvolutionDepthWise")
+    {
+        num_output = ((const ncnn::ConvolutionDepthWise*)layer)->num_output;
+        weight_data_size = ((const ncnn::ConvolutionDepthWise*)layer)->weight_data_size;
+    }
+    else // if (layer->type == "InnerProduct")
+    {
+        num_output = ((const ncnn::InnerProduct*)layer)->num_output;
+        weight_data_size = ((const ncnn::InnerProduct*)layer)->weight_data_size;
+    }
+
+    return (double)weight_data_size * top_blob.w * top_blob.h * top_blob.d * top_blob.c / num_output;
+}
+
+int NetQuantize::measure_sensitivity(const std::vector<std::vector<ncnn::Mat> >& samples, std::vector<MixedPrecisionCandidate>& candidates) const
+{
+    candidates.clear();
+    std::vector<ncnn::Layer*> int8_layers;
+
+    ncnn::Option opt_int8 = opt;
+    opt_int8.use_int8_inference = true;
+    opt_int8.use_packing_layout = false;
+
+    int ret = 0;
+
+    const int layer_count = static_cast<int>(layers.size());
+    for (int i = 0; i < layer_count; i++)
+    {
+        const ncnn::Layer* layer = layers[i];
+        if (layer->type != "Convolution" && layer->type != "ConvolutionDepthWise" && layer->type != "InnerProduct")
+            continue;
+
+        std::map<std::string, ncnn::Mat>::const_iterator iter_data = blob_int8scale_table.find(layer->name);
+        std::map<std::string, ncnn::Mat>::const_iterator iter = weight_int8scale_table.find(layer->name + "_param_0");
+        if (iter_data == blob_int8scale_table.end() || iter == weight_int8scale_table.end())
+            continue;
+
+        ncnn::Layer* op = 0;
+        ret = create_int8_layer(layer, iter->second, iter_data->second, opt_int8, op);
+        if (ret != 0)
+            break;
+
+        MixedPrecisionCandidate c;
+        c.layer_index = i;
+        c.noise = 0.0;
+        c.energy = 0.0;
+        c.macs = 0.0;
+        candidates.push_back(c);
+
+        int8_layers.push_back(op);
+    }
+
+    const std::vector<const char*>& input_names = this->input_names();
+
+    // each layer alone in int8, fed with the fp32 activations
+    for (size_t i = 0; i < samples.size() && ret == 0; i++)
+    {
+        fprintf(stderr, "measure sensitivity [ %d / %d ]\n", (int)i, (int)samples.size());
+
+        ncnn::Extractor ex = create_extractor();
+        for (size_t j = 0; j < input_names.size(); j++)
+        {
+            ex.input(input_names[j], samples[i][j]);
+        }
+
+        for (size_t j = 0; j < candidates.size(); j++)
+        {
+            MixedPrecisionCandidate& c = candidates[j];
+            const ncnn::Layer* layer = layers[c.layer_index];
+
+            ncnn::Mat bottom_blob;
+            ncnn::Mat top_blob;
+            ret = ex.extract(layer->bottoms[0], bottom_blob);
+            if (ret == 0)
+                ret = ex.extract(layer->tops[0], top_blob);
+            if (ret != 0)
+            {
+                fprintf(stderr, "extract around %s failed\n", layer->name.c_str());
+                break;
+            }
+
+            ncnn::Mat top_blob_int8;
+            ret = int8_layers[j]->forward(bottom_blob, top_blob_int8, opt_int8);
+            if (ret != 0)
+            {
+                fprintf(stderr, "int8 forward %s failed\n", layer->name.c_str());
+                break;
+            }
+
+            accumulate_error(top_blob_int8, top_blob, c.noise, c.energy);
+
+            // the shapes are the same for every sample
+            if (i == 0)
+                c.macs = get_layer_macs(layer, top_blob);
+        }
+    }
+
+    for (size_t j = 0; j < int8_layers.size(); j++)
+    {
+        int8_layers[j]->destroy_pipeline(opt_int8);
+        delete int8_layers[j];
+    }
+
+    if (ret != 0)
+        return ret;
+
+    // the errors of layers add up roughly, the cheapest ones are kept in int8 first
+    std::sort(candidates.begin(), candidates.end());
+
+    return 0;
+}
+
+int NetQuantize::select_mixed_precision(const std::vector<MixedPrecisionCandidate>& candidates, float budget)
+{
+    // keep int8 while the sum of errors stays in budget
+    double error_sum = 0.0;
+    for (size_t j = 0; j < candidates.size(); j++)
+    {
+        const MixedPrecisionCandidate& c = candidates[j];
+        const ncnn::Layer* layer = layers[c.layer_index];
+
+        const double error = c.energy == 0.0 ? 0.0 : c.noise / c.energy;
+        error_sum += error;
+
+        if (error_sum <= budget)
+        {
+            fprintf(stderr, "int8 %-40s error = %f\n", layer->name.c_str(), error);
+            continue;
+        }
+
+        fprintf(stderr, "%-4s %-40s error = %f\n", storage_type_name(storage_type), layer->name.c_str(), error);
+
+        blob_int8scale_table.erase(layer->name);
+        weight_int8scale_table.erase(layer->name + "_param_0");
+    }
+
+    return 0;
+}
+
+static std::vector<std::string> read_file_list(const char* listpath)
+{
+    std::vector<std::string> paths;
+
+    FILE* fp = fopen(listpath, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", listpath);
+        return paths;
+    }
+
+    char line[1024];
+    while (fgets(line, 1024, fp))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] != '\0')
+            paths.push_back(line);
+    }
+
+    fclose(fp);
+
+    return paths;
+}
+
+// the shape comes from the npy file itself, in reversed order as ncnn::Mat w h d c
+static ncnn::Mat read_npy(const std::string& npypath)
+{
+    npy::npy_data<float> d;
+    try
+    {
+        d = npy::read_npy<float>(npypath);
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "npy::read_npy exception: %s\n", e.what());
+        return ncnn::Mat();
+    }
+
+    const std::vector<unsigned long>& shape = d.shape;
+
+    ncnn::Mat m;
+    if (shape.size() == 1)
+        m.create((int)shape[0]);
+    if (shape.size() == 2)
+        m.create((int)shape[1], (int)shape[0]);
+    if (shape.size() == 3)
+        m.create((int)shape[2], (int)shape[1], (int)shape[0]);
+    if (shape.size() == 4)
+        m.create((int)shape[3], (int)shape[2], (int)shape[1], (int)shape[0]);
+    if (m.empty())
+    {
+        fprintf(stderr, "npy %s with %d dims is not supported\n", npypath.c_str(), (int)shape.size());
+        return m;
+    }
+
+    const int size = m.w * m.h * m.d;
+    for (int q = 0; q < m.c; q++)
+    {
+        memcpy(m.channel(q), d.data.data() + (size_t)size * q, size * sizeof(float));
+    }
+
+    return m;
+}
+
 int main(int argc, char** argv)
 {
-    if (argc != 5 && argc != 6)
+    if (argc < 5)
     {
-        fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [calibration table]\n", argv[0]);
+        fprintf(stderr, "usage: %s [inparam] [inbin] [outparam] [outbin] [calibration table] [weightonly=8/4] [groupsize=32] [calib=npylist,...] [budget=0.01]\n", argv[0]);
         return -1;
     }
 
@@ -1077,47 +1628,230 @@ int main(int argc, char** argv)
     const char* inbin = argv[2];
     const char* outparam = argv[3];
     const char* outbin = argv[4];
-    const char* int8scale_table_path = argc == 6 ? argv[5] : NULL;
+    const char* int8scale_table_path = NULL;
+    char* calib_lists = NULL;
+    float budget = 0.01f;
+    int weight_quant_bits = 0;
+    int weight_quant_group_size = 32;
+
+    // weightonly=N quantizes the remaining InnerProduct and constant Gemm weights without calibration data
+    // calib=N lists npy samples of each input, the most sensitive layers are left out of int8 until the output error fits in budget
+    for (int i = 5; i < argc; i++)
+    {
+        if (strncmp(argv[i], "weightonly=", 11) == 0)
+            weight_quant_bits = atoi(argv[i] + 11);
+        else if (strncmp(argv[i], "groupsize=", 10) == 0)
+            weight_quant_group_size = atoi(argv[i] + 10);
+        else if (strncmp(argv[i], "calib=", 6) == 0)
+            calib_lists = argv[i] + 6;
+        else if (strncmp(argv[i], "budget=", 7) == 0)
+            budget = (float)atof(argv[i] + 7);
+        else
+            int8scale_table_path = argv[i];
+    }
 
-    NetQuantize quantizer;
-    quantizer.storage_type = 1; // use fp16 where int8 not applied
+    if (weight_quant_bits != 0 && weight_quant_bits != 4 && weight_quant_bits != 8)
+    {
+        fprintf(stderr, "weightonly must be 4 or 8\n");
+        return -1;
+    }
 
-    // parse the calibration scale table
-    if (int8scale_table_path)
+    if (weight_quant_group_size <= 0 || weight_quant_group_size % 2 != 0)
     {
-        bool s2 = read_int8scale_table(int8scale_table_path, quantizer.blob_int8scale_table, quantizer.weight_int8scale_table);
-        if (!s2)
+        fprintf(stderr, "groupsize must be positive and even\n");
+        return -1;
+    }
+
+    if (calib_lists && !int8scale_table_path)
+    {
+        fprintf(stderr, "calib needs a calibration table\n");
+        return -1;
+    }
+
+    if (budget <= 0.f)
+    {
+        fprintf(stderr, "budget must be positive\n");
+        return -1;
+    }
+
+    // at most 32 samples for mixed precision
+    std::vector<std::vector<ncnn::Mat> > samples;
+    if (calib_lists)
+    {
+        std::vector<std::vector<std::string> > listspaths;
+        for (char* pch = strtok(calib_lists, ","); pch; pch = strtok(NULL, ","))
+        {
+            listspaths.push_back(read_file_list(pch));
+        }
+
+        size_t sample_count = 32;
+        for (size_t j = 0; j < listspaths.size(); j++)
+        {
+            sample_count = std::min(sample_count, listspaths[j].size());
+        }
+
+        samples.resize(sample_count);
+        for (size_t i = 0; i < sample_count; i++)
+        {
+            for (size_t j = 0; j < listspaths.size(); j++)
+            {
+                ncnn::Mat in = read_npy(listspaths[j][i]);
+                if (in.empty())
+                    return -1;
+
+                samples[i].push_back(in);
+            }
+        }
+
+        if (samples.empty())
         {
-            fprintf(stderr, "read_int8scale_table failed\n");
+            fprintf(stderr, "no calibration sample\n");
             return -1;
         }
     }
 
-    quantizer.load_param(inparam);
-    if (strcmp(inbin, "null") == 0)
+    std::vector<std::vector<ncnn::Mat> > references;
+    std::vector<MixedPrecisionCandidate> candidates;
+    float layer_budget = budget;
+
+    for (int attempt = 0;; attempt++)
     {
-        DataReaderFromEmpty dr;
-        quantizer.load_model(dr);
-        quantizer.gen_random_weight = true;
-    }
-    else
-        quantizer.load_model(inbin);
+        NetQuantize quantizer;
+        quantizer.storage_type = 1; // use fp16 where int8 not applied
+        quantizer.weight_quant_bits = weight_quant_bits;
+        quantizer.weight_quant_group_size = weight_quant_group_size;
 
-    quantizer.quantize_convolution();
-    quantizer.quantize_convolutiondepthwise();
-    quantizer.quantize_innerproduct();
+        // parse the calibration scale table
+        if (int8scale_table_path)
+        {
+            bool s2 = read_int8scale_table(int8scale_table_path, quantizer.blob_int8scale_table, quantizer.weight_int8scale_table);
+            if (!s2)
+            {
+                fprintf(stderr, "read_int8scale_table failed\n");
+                return -1;
+            }
+        }
 
-    quantizer.quantize_rnn();
-    quantizer.quantize_lstm();
-    quantizer.quantize_gru();
-    quantizer.quantize_embed();
-    quantizer.quantize_gemm();
-    quantizer.quantize_multiheadattention();
-    quantizer.quantize_sdpa();
+        if (!samples.empty())
+        {
+            // fp32 reference
+            quantizer.opt.use_fp16_packed = false;
+            quantizer.opt.use_fp16_storage = false;
+            quantizer.opt.use_fp16_arithmetic = false;
+            quantizer.opt.use_bf16_storage = false;
+        }
 
-    quantizer.fuse_requantize();
+        if (quantizer.load_param(inparam) != 0)
+        {
+            fprintf(stderr, "load_param %s failed\n", inparam);
+            return -1;
+        }
+        if (strcmp(inbin, "null") == 0)
+        {
+            DataReaderFromEmpty dr;
+            quantizer.load_model(dr);
+            quantizer.gen_random_weight = true;
+        }
+        else if (quantizer.load_model(inbin) != 0)
+        {
+            fprintf(stderr, "load_model %s failed\n", inbin);
+            return -1;
+        }
 
-    quantizer.save(outparam, outbin);
+        if (!samples.empty())
+        {
+            if (quantizer.input_names().size() != samples[0].size())
+            {
+                fprintf(stderr, "expect %d calib lists, but got %d\n", (int)quantizer.input_names().size(), (int)samples[0].size());
+                return -1;
+            }
+
+            if (references.empty())
+            {
+                const std::vector<const char*>& input_names = quantizer.input_names();
+                const std::vector<const char*>& output_names = quantizer.output_names();
+
+                references.resize(samples.size());
+                for (size_t i = 0; i < samples.size(); i++)
+                {
+                    ncnn::Extractor ex = quantizer.create_extractor();
+                    for (size_t j = 0; j < input_names.size(); j++)
+                    {
+                        ex.input(input_names[j], samples[i][j]);
+                    }
+
+                    references[i].resize(output_names.size());
+                    for (size_t j = 0; j < output_names.size(); j++)
+                    {
+                        if (ex.extract(output_names[j], references[i][j]) != 0)
+                        {
+                            fprintf(stderr, "extract %s failed\n", output_names[j]);
+                            return -1;
+                        }
+                    }
+                }
+
+                // the per layer errors do not depend on the budget, measure them once
+                if (quantizer.measure_sensitivity(samples, candidates) != 0)
+                {
+                    fprintf(stderr, "measure sensitivity failed\n");
+                    return -1;
+                }
+            }
+
+            quantizer.select_mixed_precision(candidates, layer_budget);
+        }
+
+        quantizer.quantize_convolution();
+        quantizer.quantize_convolutiondepthwise();
+        quantizer.quantize_innerproduct();
+
+        if (quantizer.weight_quant_bits)
+        {
+            quantizer.quantize_innerproduct_weight_only();
+            quantizer.quantize_gemm_weight_only();
+        }
+
+        quantizer.quantize_rnn();
+        quantizer.quantize_lstm();
+        quantizer.quantize_gru();
+        quantizer.quantize_embed();
+        quantizer.quantize_gemm();
+        quantizer.quantize_multiheadattention();
+        quantizer.quantize_sdpa();
+
+        quantizer.fuse_requantize();
+
+        quantizer.save(outparam, outbin);
+
+        if (samples.empty())
+            break;
+
+        // check the saved model as a whole
+        ncnn::Net net;
+        if (net.load_param(outparam) != 0 || net.load_model(outbin) != 0)
+        {
+            fprintf(stderr, "load quantized model failed\n");
+            return -1;
+        }
+
+        float error = 0.f;
+        if (compute_output_error(net, samples, references, error) != 0)
+            return -1;
+
+        fprintf(stderr, "output error = %f  budget = %f  int8 layers = %d\n", error, budget, (int)quantizer.blob_int8scale_table.size());
+
+        if (error <= budget || quantizer.blob_int8scale_table.empty())
+            break;
+
+        if (attempt == 3)
+        {
+            fprintf(stderr, "output error is still over budget, consider a larger budget or better calibration table\n");
+            break;
+        }
+
+        layer_budget *= 0.5f;
+    }
 
     return 0;
 }
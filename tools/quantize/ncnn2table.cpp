@@ -15,6 +15,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if _WIN32
+#include <windows.h>
+#endif
+
 #if defined(USE_NCNN_SIMPLEOCV)
 #include "simpleocv.h"
 #elif defined(USE_LOCAL_IMREADWRITE)
@@ -23,6 +27,7 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #endif
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -39,6 +44,18 @@
 #include "layer/convolutiondepthwise.h"
 #include "layer/innerproduct.h"
 
+// one value kept by the streaming calibrator, the smallest priorities win
+struct QuantSample
+{
+    uint32_t priority;
+    float value;
+
+    bool operator<(const QuantSample& b) const
+    {
+        return priority < b.priority;
+    }
+};
+
 class QuantBlobStat
 {
 public:
@@ -47,6 +64,7 @@ public:
         threshold = 0.f;
         absmax = 0.f;
         total = 0;
+        seen = 0;
     }
 
 public:
@@ -59,6 +77,10 @@ public:
     // KL
     std::vector<uint64_t> histogram;
     std::vector<float> histogram_normed;
+
+    // percentile and mse
+    uint64_t seen;
+    std::vector<QuantSample> reservoir;
 };
 
 class QuantNet : public ncnn::Net
@@ -77,14 +99,24 @@ public:
     std::vector<int> type_to_pixels;
     int quantize_num_threads;
     int file_type;
+    float percentile;
+    int reservoir_size;
+    std::string checkpoint_path;
 
 public:
     int init();
     void print_quant_info() const;
     int save_table(const char* tablepath);
+    int init_weight_scales();
+    ncnn::Mat read_input(int input_index, int file_index) const;
     int quantize_KL();
     int quantize_ACIQ();
     int quantize_EQ();
+    int quantize_streaming(bool mse);
+
+protected:
+    int load_checkpoint(int& file_done);
+    int save_checkpoint(int file_done) const;
 
 public:
     std::vector<int> input_blobs;
@@ -102,6 +134,8 @@ QuantNet::QuantNet()
     : blobs(mutable_blobs()), layers(mutable_layers())
 {
     quantize_num_threads = ncnn::get_cpu_count();
+    percentile = 99.99f;
+    reservoir_size = 65536;
 }
 
 int QuantNet::init()
@@ -297,19 +331,11 @@ static float compute_kl_divergence(const std::vector<float>& a, const std::vecto
     return result;
 }
 
-int QuantNet::quantize_KL()
+int QuantNet::init_weight_scales()
 {
-    const int input_blob_count = (int)input_blobs.size();
     const int conv_layer_count = (int)conv_layers.size();
-    const int conv_bottom_blob_count = (int)conv_bottom_blobs.size();
-    const int file_count = (int)listspaths[0].size();
 
-    const int num_histogram_bins = 2048;
-
-    std::vector<ncnn::UnlockedPoolAllocator> blob_allocators(quantize_num_threads);
-    std::vector<ncnn::UnlockedPoolAllocator> workspace_allocators(quantize_num_threads);
-
-    // initialize conv weight scales
+    // per output channel absmax
     #pragma omp parallel for num_threads(quantize_num_threads)
     for (int i = 0; i < conv_layer_count; i++)
     {
@@ -407,6 +433,23 @@ int QuantNet::quantize_KL()
         }
     }
 
+    return 0;
+}
+
+int QuantNet::quantize_KL()
+{
+    const int input_blob_count = (int)input_blobs.size();
+    const int conv_layer_count = (int)conv_layers.size();
+    const int conv_bottom_blob_count = (int)conv_bottom_blobs.size();
+    const int file_count = (int)listspaths[0].size();
+
+    const int num_histogram_bins = 2048;
+
+    std::vector<ncnn::UnlockedPoolAllocator> blob_allocators(quantize_num_threads);
+    std::vector<ncnn::UnlockedPoolAllocator> workspace_allocators(quantize_num_threads);
+
+    init_weight_scales();
+
     // count the absmax
     #pragma omp parallel for num_threads(quantize_num_threads) schedule(static, 1)
     for (int i = 0; i < file_count; i++)
@@ -975,6 +1018,320 @@ int QuantNet::quantize_ACIQ()
     return 0;
 }
 
+ncnn::Mat QuantNet::read_input(int input_index, int file_index) const
+{
+    const std::string& path = listspaths[input_index][file_index];
+
+    if (file_type != 0)
+        return read_npy(shapes[input_index], path);
+
+    const int type_to_pixel = type_to_pixels[input_index];
+    const std::vector<float>& mean_vals = means[input_index];
+    const std::vector<float>& norm_vals = norms[input_index];
+
+    int pixel_convert_type = ncnn::Mat::PIXEL_BGR;
+    if (type_to_pixel != pixel_convert_type)
+    {
+        pixel_convert_type = pixel_convert_type | (type_to_pixel << ncnn::Mat::PIXEL_CONVERT_SHIFT);
+    }
+
+    ncnn::Mat in = read_and_resize_image(shapes[input_index], path, pixel_convert_type);
+    in.substract_mean_normalize(mean_vals.data(), norm_vals.data());
+    return in;
+}
+
+static uint32_t hash_uint32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// keep the reservoir_size samples of smallest priority
+// priorities only depend on the file and blob index, the result does not depend on thread scheduling or resuming
+static void shrink_reservoir(std::vector<QuantSample>& reservoir, int reservoir_size)
+{
+    if ((int)reservoir.size() <= reservoir_size)
+        return;
+
+    std::nth_element(reservoir.begin(), reservoir.begin() + reservoir_size, reservoir.end());
+    reservoir.resize(reservoir_size);
+}
+
+static float compute_percentile_threshold(const std::vector<QuantSample>& reservoir, float percentile)
+{
+    std::vector<float> values(reservoir.size());
+    for (size_t i = 0; i < reservoir.size(); i++)
+    {
+        values[i] = reservoir[i].value;
+    }
+
+    const size_t index = (size_t)((values.size() - 1) * (percentile / 100.f));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static float compute_mse_threshold(const std::vector<QuantSample>& reservoir, float absmax)
+{
+    const int search_steps = 128;
+
+    float best_threshold = absmax;
+    double best_error = DBL_MAX;
+
+    // clip from absmax / 4 to absmax
+    for (int s = 0; s < search_steps; s++)
+    {
+        const float threshold = absmax * (0.25f + 0.75f * (s + 1) / search_steps);
+        const float scale = 127 / threshold;
+
+        double error = 0.0;
+        for (size_t i = 0; i < reservoir.size(); i++)
+        {
+            const float v = reservoir[i].value;
+            const float q = std::min(floorf(v * scale + 0.5f), 127.f) / scale;
+            error += (double)(v - q) * (v - q);
+        }
+
+        if (error < best_error)
+        {
+            best_error = error;
+            best_threshold = threshold;
+        }
+    }
+
+    return best_threshold;
+}
+
+int QuantNet::load_checkpoint(int& file_done)
+{
+    file_done = 0;
+
+    FILE* fp = fopen(checkpoint_path.c_str(), "rb");
+    if (!fp)
+        return 0;
+
+    const int conv_bottom_blob_count = (int)conv_bottom_blobs.size();
+
+    int header[3] = {0, 0, 0};
+    if (fread(header, sizeof(int), 3, fp) != 3 || header[0] != conv_bottom_blob_count || header[1] != reservoir_size)
+    {
+        fprintf(stderr, "checkpoint %s does not match the model, start over\n", checkpoint_path.c_str());
+        fclose(fp);
+        return 0;
+    }
+
+    for (int i = 0; i < conv_bottom_blob_count; i++)
+    {
+        QuantBlobStat& stat = quant_blob_stats[i];
+
+        int reservoir_count = 0;
+        int nread = 0;
+        nread += (int)fread(&stat.absmax, sizeof(float), 1, fp);
+        nread += (int)fread(&stat.seen, sizeof(uint64_t), 1, fp);
+        nread += (int)fread(&reservoir_count, sizeof(int), 1, fp);
+        if (nread != 3 || reservoir_count < 0 || reservoir_count > reservoir_size * 2)
+        {
+            fprintf(stderr, "checkpoint %s is truncated, start over\n", checkpoint_path.c_str());
+            fclose(fp);
+            quant_blob_stats.clear();
+            quant_blob_stats.resize(conv_bottom_blob_count);
+            return 0;
+        }
+
+        stat.reservoir.resize(reservoir_count);
+        if (reservoir_count > 0 && fread(stat.reservoir.data(), sizeof(QuantSample), reservoir_count, fp) != (size_t)reservoir_count)
+        {
+            fprintf(stderr, "checkpoint %s is truncated, start over\n", checkpoint_path.c_str());
+            fclose(fp);
+            quant_blob_stats.clear();
+            quant_blob_stats.resize(conv_bottom_blob_count);
+            return 0;
+        }
+    }
+
+    fclose(fp);
+
+    file_done = header[2];
+
+    fprintf(stderr, "resume from checkpoint %s [ %d files done ]\n", checkpoint_path.c_str(), file_done);
+
+    return 0;
+}
+
+int QuantNet::save_checkpoint(int file_done) const
+{
+    // write aside and rename, an interrupted save keeps the previous checkpoint
+    const std::string tmppath = checkpoint_path + ".tmp";
+
+    FILE* fp = fopen(tmppath.c_str(), "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", tmppath.c_str());
+        return -1;
+    }
+
+    const int conv_bottom_blob_count = (int)conv_bottom_blobs.size();
+
+    int header[3] = {conv_bottom_blob_count, reservoir_size, file_done};
+    fwrite(header, sizeof(int), 3, fp);
+
+    for (int i = 0; i < conv_bottom_blob_count; i++)
+    {
+        const QuantBlobStat& stat = quant_blob_stats[i];
+
+        const int reservoir_count = (int)stat.reservoir.size();
+        fwrite(&stat.absmax, sizeof(float), 1, fp);
+        fwrite(&stat.seen, sizeof(uint64_t), 1, fp);
+        fwrite(&reservoir_count, sizeof(int), 1, fp);
+        fwrite(stat.reservoir.data(), sizeof(QuantSample), reservoir_count, fp);
+    }
+
+    fclose(fp);
+
+    // replace the previous checkpoint in one step
+#if _WIN32
+    if (!MoveFileExA(tmppath.c_str(), checkpoint_path.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+    if (rename(tmppath.c_str(), checkpoint_path.c_str()) != 0)
+#endif
+    {
+        fprintf(stderr, "rename %s failed\n", tmppath.c_str());
+        return -1;
+    }
+
+    return 0;
+}
+
+int QuantNet::quantize_streaming(bool mse)
+{
+    const int input_blob_count = (int)input_blobs.size();
+    const int conv_bottom_blob_count = (int)conv_bottom_blobs.size();
+    const int file_count = (int)listspaths[0].size();
+
+    // every file adds at most this many samples to each blob reservoir
+    const int samples_per_file = std::max(reservoir_size / 64, 256);
+
+    // checkpoint after each chunk of files
+    const int chunk_size = checkpoint_path.empty() ? file_count : 1000;
+
+    std::vector<ncnn::UnlockedPoolAllocator> blob_allocators(quantize_num_threads);
+    std::vector<ncnn::UnlockedPoolAllocator> workspace_allocators(quantize_num_threads);
+
+    init_weight_scales();
+
+    int file_done = 0;
+    if (!checkpoint_path.empty())
+    {
+        load_checkpoint(file_done);
+    }
+
+    // each file is decoded and run once, absmax and samples of all blobs are gathered together
+    for (int chunk_start = file_done; chunk_start < file_count; chunk_start += chunk_size)
+    {
+        const int chunk_end = std::min(chunk_start + chunk_size, file_count);
+
+        #pragma omp parallel for num_threads(quantize_num_threads) schedule(dynamic, 1)
+        for (int i = chunk_start; i < chunk_end; i++)
+        {
+            if (i % 100 == 0)
+            {
+                fprintf(stderr, "collect samples %.2f%% [ %d / %d ]\n", i * 100.f / file_count, i, file_count);
+            }
+
+            ncnn::Extractor ex = create_extractor();
+            ex.set_light_mode(true);
+
+            const int thread_num = ncnn::get_omp_thread_num();
+            ex.set_blob_allocator(&blob_allocators[thread_num]);
+            ex.set_workspace_allocator(&workspace_allocators[thread_num]);
+
+            for (int j = 0; j < input_blob_count; j++)
+            {
+                ex.input(input_blobs[j], read_input(j, i));
+            }
+
+            for (int j = 0; j < conv_bottom_blob_count; j++)
+            {
+                ncnn::Mat out;
+                ex.extract(conv_bottom_blobs[j], out);
+
+                const int outc = out.c;
+                const int outsize = out.w * out.h * out.d;
+                const int size = outc * outsize;
+
+                float absmax = 0.f;
+                for (int p = 0; p < outc; p++)
+                {
+                    const float* ptr = out.channel(p);
+                    for (int k = 0; k < outsize; k++)
+                    {
+                        absmax = std::max(absmax, (float)fabs(ptr[k]));
+                    }
+                }
+
+                const uint32_t seed = hash_uint32((uint32_t)i * 0x9e3779b9U + (uint32_t)j);
+                const int sample_count = std::min(size, samples_per_file);
+
+                std::vector<QuantSample> samples(sample_count);
+                for (int k = 0; k < sample_count; k++)
+                {
+                    const uint32_t h = hash_uint32(seed ^ hash_uint32((uint32_t)k));
+                    const int index = size <= samples_per_file ? k : (int)(h % (uint32_t)size);
+
+                    samples[k].priority = hash_uint32(h + 0x85ebca6bU);
+                    samples[k].value = (float)fabs(out.channel(index / outsize)[index % outsize]);
+                }
+
+                #pragma omp critical
+                {
+                    QuantBlobStat& stat = quant_blob_stats[j];
+                    stat.absmax = std::max(stat.absmax, absmax);
+                    stat.seen += size;
+                    stat.total = size;
+                    stat.reservoir.insert(stat.reservoir.end(), samples.begin(), samples.end());
+                    if ((int)stat.reservoir.size() >= reservoir_size * 2)
+                    {
+                        shrink_reservoir(stat.reservoir, reservoir_size);
+                    }
+                }
+            }
+        }
+
+        if (!checkpoint_path.empty())
+        {
+            save_checkpoint(chunk_end);
+        }
+    }
+
+    #pragma omp parallel for num_threads(quantize_num_threads)
+    for (int i = 0; i < conv_bottom_blob_count; i++)
+    {
+        QuantBlobStat& stat = quant_blob_stats[i];
+
+        shrink_reservoir(stat.reservoir, reservoir_size);
+
+        float threshold = stat.absmax;
+        if (!stat.reservoir.empty() && stat.absmax > 0.f)
+        {
+            threshold = mse ? compute_mse_threshold(stat.reservoir, stat.absmax) : compute_percentile_threshold(stat.reservoir, percentile);
+        }
+
+        // all zero blob
+        if (threshold <= 0.f)
+            threshold = stat.absmax > 0.f ? stat.absmax : 1.f;
+
+        stat.threshold = threshold;
+
+        bottom_blob_scales[i].create(1);
+        bottom_blob_scales[i][0] = 127 / threshold;
+    }
+
+    return 0;
+}
+
 static float cosine_similarity(const ncnn::Mat& a, const ncnn::Mat& b)
 {
     const int chanenls = a.c;
@@ -1666,8 +2023,11 @@ static void show_usage()
     fprintf(stderr, "  shape=[224,224,3],...[w,h,c] or [w,h] **[0,0] will not resize\n");
     fprintf(stderr, "  pixel=RAW/RGB/BGR/GRAY/RGBA/BGRA,...\n");
     fprintf(stderr, "  thread=8\n");
-    fprintf(stderr, "  method=kl/aciq/eq\n");
+    fprintf(stderr, "  method=kl/aciq/eq/percentile/mse\n");
     fprintf(stderr, "  type=0/1, 0:image,1:npy\n");
+    fprintf(stderr, "  percentile=99.99\n");
+    fprintf(stderr, "  reservoir=65536\n");
+    fprintf(stderr, "  checkpoint=calib.state\n");
     fprintf(stderr, "Sample usage:\n");
     fprintf(stderr, "  ncnn2table squeezenet.param squeezenet.bin filelist.txt squeezenet.table mean=[104.0,117.0,123.0] norm=[1.0,1.0,1.0] shape=[227,227,3] pixel=BGR method=kl\n");
     fprintf(stderr, "  ncnn2table test.param test.bin filelist.txt squeezenet.table shape=[227,227,3] method=kl type=1\n");
@@ -1747,6 +2107,12 @@ int main(int argc, char** argv)
             method = std::string(value);
         if (memcmp(key, "type", 4) == 0)
             net.file_type = atoi(value);
+        if (memcmp(key, "percentile", 10) == 0)
+            net.percentile = (float)atof(value);
+        if (memcmp(key, "reservoir", 9) == 0)
+            net.reservoir_size = atoi(value);
+        if (memcmp(key, "checkpoint", 10) == 0)
+            net.checkpoint_path = std::string(value);
     }
 
     // sanity check
@@ -1781,6 +2147,16 @@ int main(int argc, char** argv)
         fprintf(stderr, "malformed thread %d\n", net.quantize_num_threads);
         return -1;
     }
+    if (net.percentile <= 0.f || net.percentile > 100.f)
+    {
+        fprintf(stderr, "malformed percentile %f\n", net.percentile);
+        return -1;
+    }
+    if (net.reservoir_size <= 0)
+    {
+        fprintf(stderr, "malformed reservoir %d\n", net.reservoir_size);
+        return -1;
+    }
 
     // print quantnet config
     {
@@ -1798,6 +2174,12 @@ int main(int argc, char** argv)
         fprintf(stderr, "\n");
         fprintf(stderr, "thread = %d\n", net.quantize_num_threads);
         fprintf(stderr, "method = %s\n", method.c_str());
+        if (method == "percentile")
+            fprintf(stderr, "percentile = %f\n", net.percentile);
+        if (method == "percentile" || method == "mse")
+            fprintf(stderr, "reservoir = %d\n", net.reservoir_size);
+        if (!net.checkpoint_path.empty())
+            fprintf(stderr, "checkpoint = %s\n", net.checkpoint_path.c_str());
         fprintf(stderr, "---------------------------------------\n");
     }
 
@@ -1813,10 +2195,18 @@ int main(int argc, char** argv)
     {
         net.quantize_EQ();
     }
+    else if (method == "percentile")
+    {
+        net.quantize_streaming(false);
+    }
+    else if (method == "mse")
+    {
+        net.quantize_streaming(true);
+    }
     else
     {
         fprintf(stderr, "not implemented yet !\n");
-        fprintf(stderr, "unknown method %s, expect kl / aciq / eq\n", method.c_str());
+        fprintf(stderr, "unknown method %s, expect kl / aciq / eq / percentile / mse\n", method.c_str());
         return -1;
     }
 
@@ -0,0 +1,307 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "batcher.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "layer_type.h"
+
+static int get_axis_extent(const ncnn::Mat& m, int axis)
+{
+    // axis counts from the outermost dimension
+    const int positive_axis = axis < 0 ? m.dims + axis : axis;
+
+    if (m.dims == 1)
+        return m.w;
+    if (m.dims == 2)
+        return positive_axis == 0 ? m.h : m.w;
+    if (m.dims == 3)
+        return positive_axis == 0 ? m.c : positive_axis == 1 ? m.h : m.w;
+    return positive_axis == 0 ? m.c : positive_axis == 1 ? m.d : positive_axis == 2 ? m.h : m.w;
+}
+
+DynamicBatcher::Options::Options()
+{
+    max_batch_size = 16;
+    max_latency_us = 2000;
+    batch_axis = 0;
+    num_workers = 1;
+}
+
+DynamicBatcher::DynamicBatcher(const ncnn::Net& _net, const char* _input_name, const char* _output_name, const Options& _opt)
+    : net(_net), input_name(_input_name), output_name(_output_name), opt(_opt)
+{
+    if (opt.max_batch_size < 1)
+        opt.max_batch_size = 1;
+    if (opt.num_workers < 1)
+        opt.num_workers = 1;
+
+    // batch assembly runs on plain unpacked fp32 data
+    opt_concat = net.opt;
+    opt_concat.num_threads = 1;
+    opt_concat.use_packing_layout = false;
+    opt_concat.use_fp16_storage = false;
+    opt_concat.use_bf16_storage = false;
+    opt_concat.blob_allocator = 0;
+    opt_concat.workspace_allocator = 0;
+
+    concat = ncnn::create_layer_cpu(ncnn::LayerType::Concat);
+
+    ncnn::ParamDict pd;
+    pd.set(0, opt.batch_axis);
+    concat->load_param(pd);
+    concat->create_pipeline(opt_concat);
+
+    // each output sample takes an even share of the batch extent, whatever the batch size
+    slice = ncnn::create_layer_cpu(ncnn::LayerType::Slice);
+
+    ncnn::Mat slices(opt.max_batch_size);
+    slices.fill(-233);
+
+    ncnn::ParamDict pd_slice;
+    pd_slice.set(0, slices);
+    pd_slice.set(1, opt.batch_axis);
+    slice->load_param(pd_slice);
+    slice->create_pipeline(opt_concat);
+
+    running = false;
+    active_clients = 0;
+    known_clients = 0;
+    batches = 0;
+    samples = 0;
+}
+
+DynamicBatcher::~DynamicBatcher()
+{
+    stop();
+
+    concat->destroy_pipeline(opt_concat);
+    delete concat;
+
+    slice->destroy_pipeline(opt_concat);
+    delete slice;
+}
+
+int DynamicBatcher::start()
+{
+    std::unique_lock<std::mutex> lock(queue_lock);
+
+    if (running)
+        return 0;
+
+    running = true;
+    for (int i = 0; i < opt.num_workers; i++)
+    {
+        workers.push_back(std::thread(&DynamicBatcher::worker, this));
+    }
+
+    return 0;
+}
+
+void DynamicBatcher::stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(queue_lock);
+        if (!running)
+            return;
+
+        running = false;
+    }
+
+    queue_condition.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+    workers.clear();
+}
+
+int DynamicBatcher::infer(const ncnn::Mat& in, ncnn::Mat& out)
+{
+    if (in.empty())
+        return -1;
+
+    Request request;
+    request.in = in;
+    request.ret = -1;
+    request.done = false;
+
+    std::unique_lock<std::mutex> lock(queue_lock);
+
+    if (!running)
+    {
+        fprintf(stderr, "batcher is not running\n");
+        return -1;
+    }
+
+    active_clients++;
+    known_clients = std::max(known_clients, active_clients);
+
+    request.enqueue_time = std::chrono::steady_clock::now();
+    queue.push_back(&request);
+    queue_condition.notify_one();
+
+    while (!request.done)
+    {
+        done_condition.wait(lock);
+    }
+
+    out = request.out;
+    return request.ret;
+}
+
+size_t DynamicBatcher::batch_count() const
+{
+    std::unique_lock<std::mutex> lock(queue_lock);
+    return batches;
+}
+
+size_t DynamicBatcher::sample_count() const
+{
+    std::unique_lock<std::mutex> lock(queue_lock);
+    return samples;
+}
+
+void DynamicBatcher::worker()
+{
+    std::vector<Request*> batch;
+
+    std::unique_lock<std::mutex> lock(queue_lock);
+    for (;;)
+    {
+        while (running && queue.empty())
+        {
+            queue_condition.wait(lock);
+        }
+
+        if (queue.empty())
+            break;
+
+        // hold the batch open until it is full, the oldest sample hits its deadline
+        // or every client seen so far is blocked in infer and nothing more can arrive
+        const std::chrono::steady_clock::time_point deadline = queue.front()->enqueue_time + std::chrono::microseconds(opt.max_latency_us);
+        while (running && (int)queue.size() < opt.max_batch_size && active_clients < known_clients)
+        {
+            if (queue_condition.wait_until(lock, deadline) == std::cv_status::timeout)
+            {
+                // clients that went away no longer hold batches open
+                known_clients = active_clients;
+                break;
+            }
+        }
+
+        // another worker may have taken them meanwhile
+        if (queue.empty())
+            continue;
+
+        // samples of one batch must share the same shape
+        batch.clear();
+        const ncnn::Mat& first = queue.front()->in;
+        while (!queue.empty() && (int)batch.size() < opt.max_batch_size)
+        {
+            const ncnn::Mat& in = queue.front()->in;
+            if (in.dims != first.dims || in.w != first.w || in.h != first.h || in.d != first.d || in.c != first.c || in.elemsize != first.elemsize)
+                break;
+
+            batch.push_back(queue.front());
+            queue.pop_front();
+        }
+
+        // let another worker pick up what is left
+        if (!queue.empty())
+            queue_condition.notify_one();
+
+        lock.unlock();
+
+        int ret = run_batch(batch);
+
+        lock.lock();
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            batch[i]->ret = ret;
+            batch[i]->done = true;
+        }
+
+        batches += 1;
+        samples += batch.size();
+
+        // the served clients count as free from now on, before they wake up
+        active_clients -= (int)batch.size();
+
+        done_condition.notify_all();
+    }
+}
+
+int DynamicBatcher::run_batch(std::vector<Request*>& batch)
+{
+    const int batch_size = (int)batch.size();
+    const bool is_1d = batch[0]->in.dims == 1;
+
+    // stack samples
+    ncnn::Mat batch_in;
+    if (batch_size == 1)
+    {
+        batch_in = is_1d ? batch[0]->in.reshape(batch[0]->in.w, 1) : batch[0]->in;
+    }
+    else
+    {
+        std::vector<ncnn::Mat> bottoms(batch_size);
+        for (int i = 0; i < batch_size; i++)
+        {
+            bottoms[i] = is_1d ? batch[i]->in.reshape(batch[i]->in.w, 1) : batch[i]->in;
+        }
+
+        std::vector<ncnn::Mat> tops(1);
+        int ret = concat->forward(bottoms, tops, opt_concat);
+        if (ret != 0)
+            return ret;
+
+        batch_in = tops[0];
+    }
+
+    ncnn::Mat batch_out;
+    {
+        ncnn::Extractor ex = net.create_extractor();
+
+        int ret = ex.input(input_name.c_str(), batch_in);
+        if (ret != 0)
+            return ret;
+
+        ret = ex.extract(output_name.c_str(), batch_out);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (batch_size == 1)
+    {
+        batch[0]->out = is_1d && batch_out.dims == 2 && batch_out.h == 1 ? batch_out.reshape(batch_out.w) : batch_out;
+        return 0;
+    }
+
+    // scatter back along the batch axis, every sample contributed the same extent
+    const int out_extent = get_axis_extent(batch_out, opt.batch_axis);
+    if (batch_out.dims != batch_in.dims || out_extent % batch_size != 0)
+    {
+        fprintf(stderr, "output blob does not keep the batch along axis %d\n", opt.batch_axis);
+        return -1;
+    }
+
+    std::vector<ncnn::Mat> bottoms(1);
+    bottoms[0] = batch_out;
+    std::vector<ncnn::Mat> tops(batch_size);
+    int ret = slice->forward(bottoms, tops, opt_concat);
+    if (ret != 0)
+        return ret;
+
+    for (int i = 0; i < batch_size; i++)
+    {
+        batch[i]->out = is_1d && tops[i].h == 1 ? tops[i].reshape(tops[i].w) : tops[i];
+    }
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef NCNN_TOOLS_SERVER_BATCHER_H
+#define NCNN_TOOLS_SERVER_BATCHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "layer.h"
+#include "net.h"
+
+// coalesce single-sample requests into batches and run one extractor per batch
+//
+// samples are concatenated along batch_axis with concat semantics, one dimensional
+// samples are viewed as a single row so that they stack into a matrix
+// the output blob must carry the batch along the same axis, it is sliced back
+// proportionally to the extent each sample contributed
+//
+// typical use for innerproduct and gemm heavy models
+//   sample  [K]        ->  batch  [K x N]  ->  output  [M x N]  ->  sample output [M]
+class DynamicBatcher
+{
+public:
+    struct Options
+    {
+        Options();
+
+        // largest number of samples in one batch
+        int max_batch_size;
+
+        // longest time the first queued sample waits for others
+        // the batch runs earlier when every client calling infer so far is waiting in it
+        int max_latency_us;
+
+        // concat axis of the batch in sample dims
+        int batch_axis;
+
+        // batches in flight, each runs its own extractor
+        int num_workers;
+    };
+
+public:
+    DynamicBatcher(const ncnn::Net& net, const char* input_name, const char* output_name, const Options& opt);
+    ~DynamicBatcher();
+
+    // start and stop the worker threads
+    // pending requests are still served by stop
+    int start();
+    void stop();
+
+    // run one sample through the next batch, called from any thread
+    // return 0 if success
+    int infer(const ncnn::Mat& in, ncnn::Mat& out);
+
+    // statistics
+    size_t batch_count() const;
+    size_t sample_count() const;
+
+private:
+    struct Request
+    {
+        ncnn::Mat in;
+        ncnn::Mat out;
+        int ret;
+        bool done;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    void worker();
+    int run_batch(std::vector<Request*>& batch);
+
+private:
+    DynamicBatcher(const DynamicBatcher&);
+    DynamicBatcher& operator=(const DynamicBatcher&);
+
+private:
+    const ncnn::Net& net;
+    std::string input_name;
+    std::string output_name;
+    Options opt;
+
+    ncnn::Layer* concat;
+    ncnn::Layer* slice;
+    ncnn::Option opt_concat;
+
+    std::vector<std::thread> workers;
+    bool running;
+
+    mutable std::mutex queue_lock;
+    std::condition_variable queue_condition;
+    std::condition_variable done_condition;
+    std::deque<Request*> queue;
+
+    // requests not served yet, and the most seen at once since the last deadline expired
+    int active_clients;
+    int known_clients;
+
+    size_t batches;
+    size_t samples;
+};
+
+#endif // NCNN_TOOLS_SERVER_BATCHER_H
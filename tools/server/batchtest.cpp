@@ -0,0 +1,304 @@
+// Copyright 2025 Tencent
+// SPDX-License-Identifier: BSD-3-Clause
+
+// loopback harness for DynamicBatcher
+// client threads push single samples through the batcher in-process,
+// outputs are checked against unbatched inference and throughput of both is reported
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include "batcher.h"
+#include "benchmark.h"
+#include "datareader.h"
+#include "net.h"
+
+// fill weights with small deterministic values
+class DataReaderFromRandom : public ncnn::DataReader
+{
+public:
+    DataReaderFromRandom()
+        : seed(7767517)
+    {
+    }
+
+    virtual size_t read(void* buf, size_t size) const
+    {
+        if (size == 4)
+        {
+            // raw float tag
+            memset(buf, 0, 4);
+            return size;
+        }
+
+        float* p = (float*)buf;
+        for (size_t i = 0; i < size / 4; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            p[i] = ((int)((seed >> 8) % 2001) - 1000) / 20000.f;
+        }
+        return size;
+    }
+
+public:
+    mutable unsigned int seed;
+};
+
+// innerproduct heavy model used when no model is given
+static const char* g_mlp_param = "7767517\n"
+                                 "4 4\n"
+                                 "Input data 0 1 data 0=512\n"
+                                 "InnerProduct fc1 1 1 data fc1 0=1024 1=1 2=524288 9=1\n"
+                                 "InnerProduct fc2 1 1 fc1 fc2 0=1024 1=1 2=1048576 9=1\n"
+                                 "InnerProduct fc3 1 1 fc2 output 0=256 1=1 2=262144\n";
+
+static ncnn::Mat make_sample(int w, int h, int c, int seed)
+{
+    ncnn::Mat m;
+    if (h == 0)
+        m.create(w);
+    else if (c == 0)
+        m.create(w, h);
+    else
+        m.create(w, h, c);
+
+    for (int i = 0; i < (int)m.total(); i++)
+    {
+        m[i] = ((seed * 31 + i * 7) % 113) / 113.f - 0.5f;
+    }
+
+    return m;
+}
+
+static bool compare_output(const ncnn::Mat& a, const ncnn::Mat& b)
+{
+    if (a.dims != b.dims || a.w != b.w || a.h != b.h || a.c != b.c)
+        return false;
+
+    for (int q = 0; q < a.c; q++)
+    {
+        const float* pa = a.channel(q);
+        const float* pb = b.channel(q);
+        for (int i = 0; i < a.w * a.h; i++)
+        {
+            if (fabs(pa[i] - pb[i]) > 1e-3f * (1.f + fabs(pa[i])))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+struct client_args
+{
+    DynamicBatcher* batcher;
+    const ncnn::Net* net;
+    const char* input_name;
+    const char* output_name;
+    int w;
+    int h;
+    int c;
+    int client_id;
+    int request_count;
+    int check_every;
+    int errors;
+};
+
+static void client_worker(client_args* args)
+{
+    for (int i = 0; i < args->request_count; i++)
+    {
+        ncnn::Mat in = make_sample(args->w, args->h, args->c, args->client_id * 10007 + i);
+
+        ncnn::Mat out;
+        int ret = args->batcher->infer(in, out);
+        if (ret != 0)
+        {
+            args->errors++;
+            continue;
+        }
+
+        if (i % args->check_every != 0)
+            continue;
+
+        ncnn::Mat out_ref;
+        ncnn::Extractor ex = args->net->create_extractor();
+        ex.input(args->input_name, in);
+        ex.extract(args->output_name, out_ref);
+
+        if (!compare_output(out_ref, out))
+            args->errors++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // positional arguments come first, key=value options follow
+    int positional = 1;
+    while (positional < argc && strchr(argv[positional], '=') == 0)
+        positional++;
+
+    if (positional != 1 && positional < 6)
+    {
+        fprintf(stderr, "Usage: %s [param bin input_name output_name w [h [c]]]\n", argv[0]);
+        fprintf(stderr, "          [clients=16] [requests=64] [max_batch_size=16] [max_latency_us=2000] [batch_axis=0] [num_threads=4]\n");
+        return -1;
+    }
+
+    const bool use_builtin_model = positional == 1;
+    const char* input_name = use_builtin_model ? "data" : argv[3];
+    const char* output_name = use_builtin_model ? "output" : argv[4];
+    int w = use_builtin_model ? 512 : atoi(argv[5]);
+    int h = positional > 6 ? atoi(argv[6]) : 0;
+    int c = positional > 7 ? atoi(argv[7]) : 0;
+
+    int client_count = 16;
+    int request_count = 64;
+    int num_threads = 4;
+    DynamicBatcher::Options batch_opt;
+    for (int i = positional; i < argc; i++)
+    {
+        const char* kv = argv[i];
+        if (strncmp(kv, "clients=", 8) == 0)
+            client_count = atoi(kv + 8);
+        else if (strncmp(kv, "requests=", 9) == 0)
+            request_count = atoi(kv + 9);
+        else if (strncmp(kv, "max_batch_size=", 15) == 0)
+            batch_opt.max_batch_size = atoi(kv + 15);
+        else if (strncmp(kv, "max_latency_us=", 15) == 0)
+            batch_opt.max_latency_us = atoi(kv + 15);
+        else if (strncmp(kv, "batch_axis=", 11) == 0)
+            batch_opt.batch_axis = atoi(kv + 11);
+        else if (strncmp(kv, "num_threads=", 12) == 0)
+            num_threads = atoi(kv + 12);
+        else
+            fprintf(stderr, "unknown option %s\n", kv);
+    }
+
+    ncnn::Net net;
+    net.opt.num_threads = num_threads;
+
+    if (use_builtin_model)
+    {
+        net.load_param_mem(g_mlp_param);
+        DataReaderFromRandom dr;
+        net.load_model(dr);
+    }
+    else
+    {
+        if (net.load_param(argv[1]) != 0)
+            return -1;
+
+        if (strcmp(argv[2], "null") == 0)
+        {
+            DataReaderFromRandom dr;
+            net.load_model(dr);
+        }
+        else if (net.load_model(argv[2]) != 0)
+        {
+            return -1;
+        }
+    }
+
+    const int total_requests = client_count * request_count;
+
+    // unbatched baseline, one extractor per sample
+    double unbatched_ms;
+    {
+        double start = ncnn::get_current_time();
+        for (int i = 0; i < total_requests; i++)
+        {
+            ncnn::Mat in = make_sample(w, h, c, i);
+
+            ncnn::Mat out;
+            ncnn::Extractor ex = net.create_extractor();
+            ex.input(input_name, in);
+            ex.extract(output_name, out);
+        }
+        unbatched_ms = ncnn::get_current_time() - start;
+    }
+
+    DynamicBatcher batcher(net, input_name, output_name, batch_opt);
+    batcher.start();
+
+    std::vector<client_args> args(client_count);
+    for (int i = 0; i < client_count; i++)
+    {
+        args[i].batcher = &batcher;
+        args[i].net = &net;
+        args[i].input_name = input_name;
+        args[i].output_name = output_name;
+        args[i].w = w;
+        args[i].h = h;
+        args[i].c = c;
+        args[i].client_id = i;
+        args[i].request_count = request_count;
+        args[i].check_every = 8;
+        args[i].errors = 0;
+    }
+
+    // verify outputs on a sampled subset first
+    {
+        std::vector<std::thread> clients;
+        for (int i = 0; i < client_count; i++)
+        {
+            clients.push_back(std::thread(client_worker, &args[i]));
+        }
+        for (int i = 0; i < client_count; i++)
+        {
+            clients[i].join();
+        }
+    }
+
+    int errors = 0;
+    for (int i = 0; i < client_count; i++)
+    {
+        errors += args[i].errors;
+        args[i].check_every = request_count + 1;
+        args[i].errors = 0;
+    }
+
+    // measure throughput without the reference checks
+    const size_t batch_count0 = batcher.batch_count();
+    double batched_ms;
+    {
+        double start = ncnn::get_current_time();
+
+        std::vector<std::thread> clients;
+        for (int i = 0; i < client_count; i++)
+        {
+            clients.push_back(std::thread(client_worker, &args[i]));
+        }
+        for (int i = 0; i < client_count; i++)
+        {
+            clients[i].join();
+        }
+
+        batched_ms = ncnn::get_current_time() - start;
+    }
+    const size_t batch_count = batcher.batch_count() - batch_count0;
+
+    batcher.stop();
+
+    for (int i = 0; i < client_count; i++)
+    {
+        errors += args[i].errors;
+    }
+
+    fprintf(stderr, "requests %d  clients %d  max_batch_size %d  max_latency_us %d\n", total_requests, client_count, batch_opt.max_batch_size, batch_opt.max_latency_us);
+    fprintf(stderr, "unbatched %8.2f ms  %8.1f samples/s\n", unbatched_ms, total_requests * 1000.0 / unbatched_ms);
+    fprintf(stderr, "batched   %8.2f ms  %8.1f samples/s  avg batch %.2f\n", batched_ms, total_requests * 1000.0 / batched_ms, batch_count ? total_requests / (double)batch_count : 0.0);
+
+    if (errors != 0)
+    {
+        fprintf(stderr, "%d requests failed or mismatched\n", errors);
+        return -1;
+    }
+
+    return 0;
+}